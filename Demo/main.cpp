@@ -5,6 +5,7 @@
 #include <string>
 #include <random>
 #include <filesystem>
+#include <chrono>
 
 #include "neat/General/Window.h"
 #include "neat/Input/InputHandler.h"
@@ -25,6 +26,18 @@
 #endif
 
 neat::InputHandler gInputHandler;
+
+// alt comes in as a system key on windows and never reaches the input handler there
+bool
+IsAltHeld()
+{
+#ifdef _WIN32
+	return GetAsyncKeyState(VK_MENU);
+#else
+	return gInputHandler.IsHeld(VK_MENU);
+#endif
+}
+
 class RenderThread : public neat::Thread
 {
 public:
@@ -33,6 +46,7 @@ public:
 	{
 		myStartFunc = [this, hWND, windowRes]()
 		{
+			neat::Profiler::SetThreadName("render");
 			myReflexInterface.Start(hWND, windowRes, "vkdebug");
 			myTimer.Start();
 		};
@@ -51,6 +65,10 @@ public:
 					{ -.99, .89, 0 },
 					.08f,
 					{ 0,1,1,1 });
+				if (myShowProfiler)
+				{
+					myReflexInterface.PushProfilerOverlay(FontID(0), { -.99, .78, 0 }, .04f);
+				}
 				myReflexInterface.EndPush();
 
 				if (gInputHandler.IsReleased('Q'))
@@ -58,6 +76,14 @@ public:
 					myReflexInterface.ToggleFeature(rflx::Features::FEATURE_DEFERRED);
 					myReflexInterface.ToggleFeature(rflx::Features::FEATURE_RAY_TRACING);
 				}
+				if (gInputHandler.IsReleased('O'))
+				{
+					myShowProfiler = !myShowProfiler;
+				}
+				if (gInputHandler.IsReleased('P'))
+				{
+					myReflexInterface.WriteProfile("profile.json");
+				}
 
 				myReflexInterface.BeginFrame();
 				myReflexInterface.Submit();
@@ -69,6 +95,7 @@ public:
 private:
 	rflx::Reflex	myReflexInterface;
 	Timer			myTimer;
+	bool			myShowProfiler = false;
 };
 
 class LogicThread : public neat::Thread
@@ -82,6 +109,7 @@ public:
 	{
 		myStartFunc = [this]()
 		{
+			neat::Profiler::SetThreadName("logic");
 			myTimer.Start();
 			myReflexInterface.Start(nullptr, {});
 		};
@@ -119,7 +147,7 @@ public:
 				y -= float(gInputHandler.IsReleased(VK_SHIFT));
 
 				distance -= gInputHandler.GetWheelDelta() * 128.f * dt;
-				if (gInputHandler.IsHeld(VK_LBUTTON) && GetAsyncKeyState(VK_MENU))
+				if (gInputHandler.IsHeld(VK_LBUTTON) && IsAltHeld())
 				{
 					auto [dx, dy] = gInputHandler.GetMousePosDelta();
 					yRot += dx * 0.05f * distance * dt;
@@ -144,8 +172,8 @@ public:
 
 				myReflexInterface.EndPush();
 				gInputHandler.EndFrame();
-				const auto count = GetTickCount64();
-				while ((GetTickCount64() - count) < 5)
+				const auto count = std::chrono::steady_clock::now();
+				while ((std::chrono::steady_clock::now() - count) < std::chrono::milliseconds(5))
 				{
 				}
 			}
@@ -165,15 +193,15 @@ bool OnWinProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	return gInputHandler.TakeMessages(msg, wParam, lParam);
 }
 
-int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
-	_In_opt_ HINSTANCE hPrevInstance,
-	_In_ LPWSTR    lpCmdLine,
-	_In_ int       nCmdShow)
+int
+RunDemo(
+	HINSTANCE	hInstance,
+	int			nCmdShow,
+	bool		isVkDebug)
 {
 	int retVal = 0;
-	hPrevInstance;
 	neat::Window window(hInstance, nCmdShow, { L"Demo", 1920, 1080, true, OnWinProc });
-#ifdef _DEVELOPMENT
+#if defined(_DEVELOPMENT) && defined(_WIN32)
 	AllocConsole();
 	freopen_s((FILE**)stdout, "CONOUT$", "w", stdout);
 	HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -202,11 +230,32 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 	}
 
 
-#ifdef _DEBUG
-	if (std::string(_bstr_t(lpCmdLine)).find("vkdebug") != std::string::npos)
+#if defined(_DEBUG) && defined(_WIN32)
+	if (isVkDebug)
 	{
 		system("pause");
 	}
 #endif
 	return retVal;
-}
\ No newline at end of file
+}
+
+#ifdef _WIN32
+int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
+	_In_opt_ HINSTANCE hPrevInstance,
+	_In_ LPWSTR    lpCmdLine,
+	_In_ int       nCmdShow)
+{
+	hPrevInstance;
+	return RunDemo(hInstance, nCmdShow, std::string(_bstr_t(lpCmdLine)).find("vkdebug") != std::string::npos);
+}
+#else
+int main(int argc, char* argv[])
+{
+	bool isVkDebug = false;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		isVkDebug |= std::string(argv[arg]).find("vkdebug") != std::string::npos;
+	}
+	return RunDemo(nullptr, 0, isVkDebug);
+}
+#endif
\ No newline at end of file
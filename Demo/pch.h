@@ -2,8 +2,10 @@
 #pragma once
 
 // WINAPI
+#include "neat/General/Platform.h"
+#ifdef _WIN32
 #include <comutil.h>
-#include <windows.h>
+#endif
 #include <stdio.h>
 
 // STD
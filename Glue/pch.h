@@ -3,7 +3,10 @@
 
 // STD + WINAPI
 #include <mutex>
+#include "neat/General/Platform.h"
+#ifdef _WIN32
 #include <windowsx.h>
+#endif
 #include <array>
 
 // GLM
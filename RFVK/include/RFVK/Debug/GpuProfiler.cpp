@@ -0,0 +1,322 @@
+#include "pch.h"
+#include "GpuProfiler.h"
+
+#include "RFVK/VulkanFramework.h"
+#include "RFVK/Debug/DebugUtils.h"
+
+GpuProfiler::GpuProfiler(
+	VulkanFramework&			vulkanFramework,
+	const QueueFamilyIndices&	familyIndices)
+	: theirVulkanFramework(vulkanFramework)
+	, myFamilyIndices(familyIndices)
+{
+	constexpr const char* trackNames[QUEUE_FAMILY_COUNT] = {"gpu graphics", "gpu compute", "gpu transfer"};
+	for (uint32_t family = 0; family < QUEUE_FAMILY_COUNT; ++family)
+	{
+		const uint32_t validBits = theirVulkanFramework.GetTimestampValidBits(myFamilyIndices[family]);
+		myTimestampMasks[family] = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+		myTracks[family] = neat::Profiler::RegisterTrack(trackNames[family]);
+	}
+	myTimestampPeriod = theirVulkanFramework.GetTimestampPeriod();
+	if (theirVulkanFramework.IsCalibratedTimestamps())
+	{
+		myGetCalibratedTimestamps = (PFN_vkGetCalibratedTimestampsEXT)vkGetDeviceProcAddr(theirVulkanFramework.GetDevice(), "vkGetCalibratedTimestampsEXT");
+	}
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	myHostTicksPerSecond = uint64_t(frequency.QuadPart);
+#endif
+
+	if (!theirVulkanFramework.IsHostQueryReset() || !myTimestampMasks[QUEUE_FAMILY_GRAPHICS])
+	{
+		LOG("gpu timestamps unsupported, gpu profiling disabled");
+		return;
+	}
+
+	VkQueryPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = NumSwapchainImages * MaxGpuZones * 2;
+
+	auto result = vkCreateQueryPool(theirVulkanFramework.GetDevice(), &poolInfo, nullptr, &myQueryPool);
+	if (result)
+	{
+		LOG("failed creating timestamp query pool");
+		myQueryPool = nullptr;
+		return;
+	}
+	DebugSetObjectName("Gpu Profiler Queries", myQueryPool, VK_OBJECT_TYPE_QUERY_POOL, theirVulkanFramework.GetDevice());
+	vkResetQueryPool(theirVulkanFramework.GetDevice(), myQueryPool, 0, poolInfo.queryCount);
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	if (myQueryPool)
+	{
+		vkDestroyQueryPool(theirVulkanFramework.GetDevice(), myQueryPool, nullptr);
+	}
+}
+
+void
+GpuProfiler::BeginFrame(
+	uint32_t	swapchainIndex,
+	VkFence		frameFence)
+{
+	if (!myQueryPool)
+	{
+		return;
+	}
+
+	auto& frame = myFrames[swapchainIndex];
+	if (vkGetFenceStatus(theirVulkanFramework.GetDevice(), frameFence))
+	{
+		frame.isRecording = false;
+		return;
+	}
+
+	Resolve(swapchainIndex);
+	vkResetQueryPool(theirVulkanFramework.GetDevice(), myQueryPool, swapchainIndex * MaxGpuZones * 2, MaxGpuZones * 2);
+
+	frame.numZones = 0;
+	frame.isRecording = true;
+	frame.firstZoneNs = 0;
+	frame.numUsedWrapCmdBuffers = {};
+}
+
+uint32_t
+GpuProfiler::BeginZone(
+	VkCommandBuffer cmdBuffer,
+	uint32_t		swapchainIndex,
+	const char*		name,
+	QueueFamilyType	family)
+{
+	auto& frame = myFrames[swapchainIndex];
+	if (!myQueryPool || !frame.isRecording || !myTimestampMasks[family])
+	{
+		return NoGpuZone;
+	}
+
+	const uint32_t zone = frame.numZones.fetch_add(1);
+	if (zone >= MaxGpuZones)
+	{
+		return NoGpuZone;
+	}
+	if (!zone)
+	{
+		frame.firstZoneNs = neat::Profiler::Now();
+	}
+	frame.zones[zone] = {name, family};
+	vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, myQueryPool, (swapchainIndex * MaxGpuZones + zone) * 2);
+	return zone;
+}
+
+void
+GpuProfiler::EndZone(
+	VkCommandBuffer cmdBuffer,
+	uint32_t		swapchainIndex,
+	uint32_t		zone)
+{
+	if (zone == NoGpuZone)
+	{
+		return;
+	}
+	vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, myQueryPool, (swapchainIndex * MaxGpuZones + zone) * 2 + 1);
+}
+
+void
+GpuProfiler::WrapSubmission(
+	uint32_t		swapchainIndex,
+	const char*		name,
+	QueueFamilyType	family,
+	VkSubmitInfo&	submitInfo)
+{
+	auto& frame = myFrames[swapchainIndex];
+	if (!myQueryPool || !frame.isRecording || !myTimestampMasks[family]
+		|| submitInfo.commandBufferCount + 2 > MaxWrappedCmdBuffers)
+	{
+		return;
+	}
+
+	VkCommandBuffer beginCmdBuffer = NextWrapCmdBuffer(frame, family);
+	VkCommandBuffer endCmdBuffer = NextWrapCmdBuffer(frame, family);
+	if (!beginCmdBuffer || !endCmdBuffer)
+	{
+		return;
+	}
+
+	// RECORD
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(beginCmdBuffer, &beginInfo);
+	const uint32_t zone = BeginZone(beginCmdBuffer, swapchainIndex, name, family);
+	vkEndCommandBuffer(beginCmdBuffer);
+	if (zone == NoGpuZone)
+	{
+		return;
+	}
+
+	vkBeginCommandBuffer(endCmdBuffer, &beginInfo);
+	EndZone(endCmdBuffer, swapchainIndex, zone);
+	vkEndCommandBuffer(endCmdBuffer);
+
+	// PATCH SUBMISSION
+	myWrappedCmdBuffers.clear();
+	myWrappedCmdBuffers.emplace_back(beginCmdBuffer);
+	for (uint32_t cmdIndex = 0; cmdIndex < submitInfo.commandBufferCount; ++cmdIndex)
+	{
+		myWrappedCmdBuffers.emplace_back(submitInfo.pCommandBuffers[cmdIndex]);
+	}
+	myWrappedCmdBuffers.emplace_back(endCmdBuffer);
+
+	submitInfo.pCommandBuffers = myWrappedCmdBuffers.data();
+	submitInfo.commandBufferCount = myWrappedCmdBuffers.size();
+}
+
+const neat::static_vector<neat::ProfileEvent, MaxGpuZones>&
+GpuProfiler::GetResolvedZones() const
+{
+	return myResolvedZones;
+}
+
+bool
+GpuProfiler::IsGpuTrack(
+	uint32_t track) const
+{
+	return std::find(myTracks.begin(), myTracks.end(), track) != myTracks.end();
+}
+
+void
+GpuProfiler::Resolve(
+	uint32_t swapchainIndex)
+{
+	auto& frame = myFrames[swapchainIndex];
+	const uint32_t numZones = std::min(frame.numZones.load(), MaxGpuZones);
+	if (!numZones)
+	{
+		return;
+	}
+
+	// pairs of value and availability, zones that were never submitted stay unavailable
+	vkGetQueryPoolResults(
+		theirVulkanFramework.GetDevice(),
+		myQueryPool,
+		swapchainIndex * MaxGpuZones * 2,
+		numZones * 2,
+		sizeof myQueryResults,
+		myQueryResults.data(),
+		sizeof(uint64_t) * 2,
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	// CLOCK
+	if (!myHasClockOffset || myNumResolvesSinceCalibration >= GpuClockCalibrationInterval)
+	{
+		if (Calibrate() || EstimateClockOffset(swapchainIndex, numZones))
+		{
+			myHasClockOffset = true;
+			myNumResolvesSinceCalibration = 0;
+		}
+		if (!myHasClockOffset)
+		{
+			return;
+		}
+	}
+	++myNumResolvesSinceCalibration;
+
+	// FORWARD
+	myResolvedZones.clear();
+	for (uint32_t zone = 0; zone < numZones; ++zone)
+	{
+		const uint64_t* result = &myQueryResults[zone * 4];
+		if (!result[1] || !result[3])
+		{
+			continue;
+		}
+		const auto& gpuZone = frame.zones[zone];
+		const uint64_t beginNs = uint64_t(TicksToNs(result[0], gpuZone.family) + myClockOffsetNs);
+		const uint64_t endNs = uint64_t(TicksToNs(result[2], gpuZone.family) + myClockOffsetNs);
+		neat::Profiler::Record(gpuZone.name, beginNs, endNs, myTracks[gpuZone.family]);
+		myResolvedZones.push_back({gpuZone.name, beginNs, endNs, myTracks[gpuZone.family]});
+	}
+}
+
+bool
+GpuProfiler::Calibrate()
+{
+	if (!myGetCalibratedTimestamps)
+	{
+		return false;
+	}
+
+	VkCalibratedTimestampInfoEXT infos[2]{};
+	infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+	infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	infos[1].timeDomain = VulkanFramework::HostTimeDomain;
+
+	uint64_t timestamps[2] = {};
+	uint64_t maxDeviation = 0;
+	if (myGetCalibratedTimestamps(theirVulkanFramework.GetDevice(), 2, infos, timestamps, &maxDeviation))
+	{
+		return false;
+	}
+
+	// split so ticks * 1e9 can't overflow
+	const uint64_t hostTicks = timestamps[1];
+	const uint64_t hostNs = hostTicks / myHostTicksPerSecond * 1000000000 + hostTicks % myHostTicksPerSecond * 1000000000 / myHostTicksPerSecond;
+	myClockOffsetNs = int64_t(hostNs) - TicksToNs(timestamps[0], QUEUE_FAMILY_GRAPHICS);
+	return true;
+}
+
+bool
+GpuProfiler::EstimateClockOffset(
+	uint32_t	swapchainIndex,
+	uint32_t	numZones)
+{
+	const auto& frame = myFrames[swapchainIndex];
+	int64_t firstGpuNs = INT64_MAX;
+	for (uint32_t zone = 0; zone < numZones; ++zone)
+	{
+		if (myQueryResults[zone * 4 + 1])
+		{
+			firstGpuNs = std::min(firstGpuNs, TicksToNs(myQueryResults[zone * 4], frame.zones[zone].family));
+		}
+	}
+	if (firstGpuNs == INT64_MAX)
+	{
+		return false;
+	}
+	myClockOffsetNs = int64_t(frame.firstZoneNs) - firstGpuNs;
+	return true;
+}
+
+int64_t
+GpuProfiler::TicksToNs(
+	uint64_t		ticks,
+	QueueFamilyType	family) const
+{
+	return int64_t(double(ticks & myTimestampMasks[family]) * double(myTimestampPeriod));
+}
+
+VkCommandBuffer
+GpuProfiler::NextWrapCmdBuffer(
+	Frame&			frame,
+	QueueFamilyType	family)
+{
+	auto& cmdBuffers = frame.wrapCmdBuffers[family];
+	auto& numUsed = frame.numUsedWrapCmdBuffers[family];
+	if (numUsed == cmdBuffers.size())
+	{
+		auto [result, cmdBuffer] = theirVulkanFramework.RequestCommandBuffer(myFamilyIndices[family]);
+		if (result)
+		{
+			LOG("gpu profiler failed requesting command buffer");
+			return nullptr;
+		}
+		DebugSetObjectName("Gpu Profiler Wrap", cmdBuffer, VK_OBJECT_TYPE_COMMAND_BUFFER, theirVulkanFramework.GetDevice());
+		cmdBuffers.emplace_back(cmdBuffer);
+	}
+	return cmdBuffers[numUsed++];
+}
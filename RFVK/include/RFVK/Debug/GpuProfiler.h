@@ -0,0 +1,109 @@
+#pragma once
+
+constexpr uint32_t MaxGpuZones = 256;
+constexpr uint32_t MaxWrappedCmdBuffers = 16;
+constexpr uint32_t NoGpuZone = ~0u;
+// the gpu and cpu clocks drift apart over a session, the offset between them is taken again this often
+constexpr uint32_t GpuClockCalibrationInterval = 256;
+
+struct GpuZone
+{
+	const char*								name;
+	QueueFamilyType							family;
+};
+
+// timestamps written around worker submissions and render passes
+// read back the next time the same swapchain image comes around, once its frame is known to be done
+// resolved zones go to neat::Profiler on a track per queue, shifted onto the cpu clock
+class GpuProfiler
+{
+public:
+											GpuProfiler(
+												class VulkanFramework&		vulkanFramework,
+												const QueueFamilyIndices&	familyIndices);
+											~GpuProfiler();
+
+	// frameFence covers every submission of the frame that last used this swapchain image
+	// while it is still in flight nothing is read back and this frame goes untimed instead of stalling
+	void									BeginFrame(
+												uint32_t	swapchainIndex,
+												VkFence		frameFence);
+
+	_nodiscard uint32_t						BeginZone(
+												VkCommandBuffer cmdBuffer,
+												uint32_t		swapchainIndex,
+												const char*		name,
+												QueueFamilyType	family = QUEUE_FAMILY_GRAPHICS);
+	void									EndZone(
+												VkCommandBuffer cmdBuffer,
+												uint32_t		swapchainIndex,
+												uint32_t		zone);
+
+	// puts a command buffer before and after the submission's own to time all of it
+	// the patched command buffer list is only valid until the next call
+	void									WrapSubmission(
+												uint32_t		swapchainIndex,
+												const char*		name,
+												QueueFamilyType	family,
+												VkSubmitInfo&	submitInfo);
+
+	// zones of the last frame read back, already on the cpu clock
+	_nodiscard const neat::static_vector<neat::ProfileEvent, MaxGpuZones>&
+											GetResolvedZones() const;
+	_nodiscard bool							IsGpuTrack(uint32_t track) const;
+
+private:
+	struct Frame
+	{
+		std::array<GpuZone, MaxGpuZones>	zones;
+		std::atomic<uint32_t>				numZones = 0;
+		bool								isRecording = false;
+		uint64_t							firstZoneNs = 0;
+
+		std::array<std::vector<VkCommandBuffer>, QUEUE_FAMILY_COUNT>
+											wrapCmdBuffers;
+		std::array<uint32_t, QUEUE_FAMILY_COUNT>
+											numUsedWrapCmdBuffers = {};
+	};
+
+	void									Resolve(uint32_t swapchainIndex);
+	// samples both clocks at once, false without calibrated timestamps
+	bool									Calibrate();
+	// lines the first zone read back up with when it was recorded, the gpu starts on it shortly after
+	bool									EstimateClockOffset(
+												uint32_t	swapchainIndex,
+												uint32_t	numZones);
+	_nodiscard int64_t						TicksToNs(
+												uint64_t		ticks,
+												QueueFamilyType	family) const;
+	VkCommandBuffer							NextWrapCmdBuffer(
+												Frame&			frame,
+												QueueFamilyType	family);
+
+	VulkanFramework&						theirVulkanFramework;
+	QueueFamilyIndices						myFamilyIndices;
+	std::array<uint64_t, QUEUE_FAMILY_COUNT>
+											myTimestampMasks = {};
+	std::array<uint32_t, QUEUE_FAMILY_COUNT>
+											myTracks = {};
+	float									myTimestampPeriod = 1.f;
+
+	VkQueryPool								myQueryPool = nullptr;
+	std::array<Frame, NumSwapchainImages>	myFrames;
+	std::array<uint64_t, MaxGpuZones * 4>	myQueryResults = {};
+	neat::static_vector<VkCommandBuffer, MaxWrappedCmdBuffers>
+											myWrappedCmdBuffers;
+
+	// gpu to cpu clock, retaken every GpuClockCalibrationInterval frames read back
+	PFN_vkGetCalibratedTimestampsEXT		myGetCalibratedTimestamps = nullptr;
+	uint64_t								myHostTicksPerSecond = 1000000000;
+	int64_t									myClockOffsetNs = 0;
+	bool									myHasClockOffset = false;
+	uint32_t								myNumResolvesSinceCalibration = 0;
+	neat::static_vector<neat::ProfileEvent, MaxGpuZones>
+											myResolvedZones;
+
+};
+
+// render passes time themselves through this, null while there is no profiler
+inline GpuProfiler* gGpuProfiler = nullptr;
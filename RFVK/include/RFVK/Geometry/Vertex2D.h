@@ -21,7 +21,7 @@ constexpr VkPipelineInputAssemblyStateCreateInfo Vertex2DIAInfo
 constexpr VkVertexInputBindingDescription Vertex2DBinding =
 {
 	.binding = 0,
-	.stride = sizeof Vertex2D,
+	.stride = sizeof(Vertex2D),
 	.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
 };
 
@@ -24,7 +24,7 @@ constexpr VkPipelineInputAssemblyStateCreateInfo Vertex3DIAInfo
 constexpr VkVertexInputBindingDescription Vertex3DBinding =
 {
 	.binding = 0,
-	.stride = sizeof Vertex3D,
+	.stride = sizeof(Vertex3D),
 	.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
 };
 
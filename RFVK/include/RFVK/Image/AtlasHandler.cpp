@@ -0,0 +1,229 @@
+#include "pch.h"
+#include "AtlasHandler.h"
+
+#include "ImageHandler.h"
+#include "RFVK/VulkanFramework.h"
+#include "RFVK/Memory/ImageAllocator.h"
+
+AtlasHandler::AtlasHandler(
+	VulkanFramework&	vulkanFramework,
+	ImageHandler&		imageHandler)
+	: theirVulkanFramework(vulkanFramework)
+	, theirImageHandler(imageHandler)
+	, myAtlasImageIDKeeper(MaxNumAtlasImages)
+{
+}
+
+AtlasHandler::~AtlasHandler()
+{
+}
+
+AtlasImageID
+AtlasHandler::AddImage(
+	const std::string& path)
+{
+	auto [pixels, width, height, channels] = theirImageHandler.ReadImage(path);
+	if (pixels.empty())
+	{
+		return AtlasImageID(INVALID_ID);
+	}
+	return AddImage(pixels, {width, height});
+}
+
+AtlasImageID
+AtlasHandler::AddImage(
+	const std::vector<uint8_t>&	pixelData,
+	Vec2ui						dimension)
+{
+	const Vec2ui paddedDim = dimension + Vec2ui(AtlasPadding * 2);
+	if (paddedDim.x > AtlasPageDim || paddedDim.y > AtlasPageDim)
+	{
+		LOG("image too large for atlas page: ", dimension.x, "x", dimension.y);
+		return AtlasImageID(INVALID_ID);
+	}
+
+	const AtlasImageID id = myAtlasImageIDKeeper.FetchFreeID();
+	if (BAD_ID(id))
+	{
+		LOG("no more free atlas image slots");
+		return id;
+	}
+
+	std::scoped_lock lock(myMutex);
+
+	// PACK
+	uint32_t pageIndex = 0;
+	Vec2ui position = {};
+	for (; pageIndex < myPages.size(); ++pageIndex)
+	{
+		if (myPages[pageIndex]->reusableFrame > myFrame)
+		{
+			continue;
+		}
+		bool packed;
+		std::tie(packed, position.x, position.y) = myPages[pageIndex]->packer.Pack(paddedDim.x, paddedDim.y);
+		if (packed)
+		{
+			break;
+		}
+	}
+	if (pageIndex == myPages.size())
+	{
+		auto page = std::make_unique<AtlasPage>();
+		page->imageID = theirImageHandler.AddImage2D();
+		if (BAD_ID(page->imageID))
+		{
+			myAtlasImageIDKeeper.ReturnID(id);
+			return AtlasImageID(INVALID_ID);
+		}
+		std::tie(std::ignore, position.x, position.y) = page->packer.Pack(paddedDim.x, paddedDim.y);
+		myPages.emplace_back(std::move(page));
+	}
+
+	// COPY, EDGES CLAMPED INTO PADDING
+	auto& page = *myPages[pageIndex];
+	auto& upload = page.uploads.emplace_back();
+	upload.position = position;
+	upload.dim = paddedDim;
+	upload.pixels.resize(size_t(paddedDim.x) * paddedDim.y * 4);
+	for (uint32_t y = 0; y < paddedDim.y; ++y)
+	{
+		const uint32_t srcY = std::clamp(int(y) - AtlasPadding, 0, int(dimension.y) - 1);
+		for (uint32_t x = 0; x < paddedDim.x; ++x)
+		{
+			const uint32_t srcX = std::clamp(int(x) - AtlasPadding, 0, int(dimension.x) - 1);
+			memcpy(
+				&upload.pixels[(y * paddedDim.x + x) * 4],
+				&pixelData[(srcY * dimension.x + srcX) * 4],
+				4);
+		}
+	}
+	page.numImages++;
+
+	auto [sw, sh] = theirVulkanFramework.GetTargetResolution();
+	auto& image = myImages[int(id)];
+	image.imageID = page.imageID;
+	image.pageIndex = pageIndex;
+	image.dim = dimension;
+	image.scale = {dimension.x / sw * (sw / sh), dimension.y / sh};
+	image.uvRect = {
+		float(position.x + AtlasPadding) / AtlasPageDim,
+		float(position.y + AtlasPadding) / AtlasPageDim,
+		float(dimension.x) / AtlasPageDim,
+		float(dimension.y) / AtlasPageDim};
+
+	return id;
+}
+
+void
+AtlasHandler::RemoveImage(
+	AtlasImageID id)
+{
+	std::scoped_lock lock(myMutex);
+	if (BAD_ID(id)
+		|| uint32_t(id) >= MaxNumAtlasImages
+		|| BAD_ID(myImages[int(id)].imageID)
+		|| myImages[int(id)].pageIndex >= myPages.size())
+	{
+		LOG("tried to remove invalid atlas image id");
+		return;
+	}
+
+	// skyline can't free single rects, pages are reset once empty
+	auto& page = *myPages[myImages[int(id)].pageIndex];
+	if (--page.numImages == 0)
+	{
+		page.packer.Clear();
+		page.uploads.clear();
+		page.reusableFrame = myFrame + NumSwapchainImages + 1;
+	}
+	myImages[int(id)] = {};
+	myAtlasImageIDKeeper.ReturnID(id);
+}
+
+void
+AtlasHandler::Flush()
+{
+	std::scoped_lock lock(myMutex);
+	++myFrame;
+
+	for (auto& page : myPages)
+	{
+		if (page->uploads.empty())
+		{
+			continue;
+		}
+
+		auto& imageAllocator = theirImageHandler.GetImageAllocator();
+		auto allocSubID = imageAllocator.Start();
+		if (!page->isAllocated)
+		{
+			// one mip, the padding only keeps neighbours apart at full resolution
+			// general layout lets later rects be written while the rest of the page is sampled
+			auto executedEvent = theirImageHandler.StreamImage2D(
+				page->imageID,
+				allocSubID,
+				{},
+				{AtlasPageDim, AtlasPageDim},
+				1,
+				VK_FORMAT_R8G8B8A8_UNORM,
+				VK_IMAGE_LAYOUT_GENERAL);
+			if (!executedEvent)
+			{
+				imageAllocator.Queue(std::move(allocSubID));
+				continue;
+			}
+			theirImageHandler.SetImage2DDimension(page->imageID, {AtlasPageDim, AtlasPageDim});
+			theirImageHandler.myImages2D[int(page->imageID)].layers = 1;
+			page->isAllocated = true;
+		}
+
+		// only the rects packed since the last flush go up
+		for (auto& upload : page->uploads)
+		{
+			theirImageHandler.WriteImage2DRegion(
+				page->imageID,
+				allocSubID,
+				upload.pixels,
+				upload.position,
+				upload.dim);
+		}
+		imageAllocator.Queue(std::move(allocSubID));
+		page->uploads.clear();
+	}
+}
+
+float
+AtlasHandler::GetOccupancy() const
+{
+	std::scoped_lock lock(myMutex);
+	if (myPages.empty())
+	{
+		return 0.f;
+	}
+	float occupancy = 0.f;
+	for (auto& page : myPages)
+	{
+		occupancy += page->packer.GetOccupancy();
+	}
+	return occupancy / float(myPages.size());
+}
+
+uint32_t
+AtlasHandler::GetNumPages() const
+{
+	std::scoped_lock lock(myMutex);
+	return uint32_t(myPages.size());
+}
+
+AtlasImage
+AtlasHandler::operator[](
+	AtlasImageID id) const
+{
+	if (BAD_ID(id) || uint32_t(id) >= MaxNumAtlasImages)
+	{
+		return {};
+	}
+	std::scoped_lock lock(myMutex);
+	return myImages[int(id)];
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "neat/Misc/AtlasPacker.h"
+
+struct AtlasImage
+{
+	ImageID			imageID = ImageID(INVALID_ID);
+	Vec4f			uvRect = {0, 0, 1, 1};
+	Vec2f			dim = {};
+	Vec2f			scale = {};
+	uint32_t		pageIndex = 0;
+};
+
+struct AtlasUpload
+{
+	Vec2ui					position = {};
+	Vec2ui					dim = {};
+	std::vector<uint8_t>	pixels;
+};
+
+// pages keep no pixels of their own, each packed image is uploaded into its rect once
+struct AtlasPage
+{
+	ImageID						imageID = ImageID(INVALID_ID);
+	neat::AtlasPacker			packer = {AtlasPageDim, AtlasPageDim};
+	std::vector<AtlasUpload>	uploads;
+	uint32_t					numImages = 0;
+	bool						isAllocated = false;
+	// a cleared page is only packed again once frames that sampled its old rects are done
+	uint64_t					reusableFrame = 0;
+};
+
+class AtlasHandler
+{
+public:
+										AtlasHandler(
+											class VulkanFramework&	vulkanFramework,
+											class ImageHandler&		imageHandler);
+										~AtlasHandler();
+
+	AtlasImageID						AddImage(
+											const std::string&			path);
+	AtlasImageID						AddImage(
+											const std::vector<uint8_t>&	pixelData,
+											Vec2ui						dimension);
+	void								RemoveImage(AtlasImageID id);
+	void								Flush();
+
+	_nodiscard float					GetOccupancy() const;
+	_nodiscard uint32_t					GetNumPages() const;
+
+	AtlasImage							operator[](AtlasImageID id) const;
+
+private:
+	VulkanFramework&					theirVulkanFramework;
+	ImageHandler&						theirImageHandler;
+
+	mutable std::mutex					myMutex;
+	std::vector<std::unique_ptr<AtlasPage>>
+										myPages;
+	std::array<AtlasImage, MaxNumAtlasImages>
+										myImages = {};
+	IDKeeper<AtlasImageID>				myAtlasImageIDKeeper;
+
+	uint64_t							myFrame = 0;
+
+};
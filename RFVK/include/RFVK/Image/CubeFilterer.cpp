@@ -5,6 +5,7 @@
 #include "ImageHandler.h"
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Memory/ImageAllocator.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 #include "RFVK/Pipelines/PipelineBuilder.h"
 #include "RFVK/RenderPass/RenderPassFactory.h"
 #include "RFVK/Shader/Shader.h"
@@ -157,6 +158,12 @@ std::vector<rflx::Features> CubeFilterer::GetImplementedFeatures() const
     return {rflx::Features::FEATURE_CORE};
 }
 
+std::vector<ResourceUse> CubeFilterer::GetResourceUses() const
+{
+	// samples the source cube and writes the filtered mips back into the image set
+	return {theirImageHandler.GetImagesUse(ResourceAccess::ReadWrite)};
+}
+
 void
 CubeFilterer::PushFilterWork(
 	FilterWork&& filterWork)
@@ -227,24 +234,35 @@ CubeFilterer::CreateCubeFilterPass(CubeDimension cubeDim)
 	for (int sliceIndex = 0; sliceIndex < 6; ++sliceIndex)
 	{
 		rpBuilder.EditAttachmentDescription(sliceIndex).finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		rpBuilder.SetImageViews(sliceIndex, mySplitCubes[uint32_t(cubeDim)][sliceIndex]);
+		rpBuilder.SetImageViews(
+			sliceIndex,
+			mySplitCubes[uint32_t(cubeDim)][sliceIndex],
+			cubeImage,
+			{VK_IMAGE_ASPECT_COLOR_BIT, uint32_t(cubeDim), 1, uint32_t(sliceIndex), 1});
 	}
 
+	rpBuilder.SetName("CubeFilterPass");
 	myFilteringRenderPass[uint32_t(cubeDim)] = rpBuilder.Build();
 
 	// PIPELINE
+	// every dimension renders to the same formats and takes its viewport from the render area
+	if (cubeDim != CubeDimension::Dim2048)
+	{
+		myFilteringPipeline[uint32_t(cubeDim)] = myFilteringPipeline[uint32_t(CubeDimension::Dim2048)];
+		return;
+	}
 
-
-	PipelineBuilder pBuilder(6, myFilteringRenderPass[uint32_t(cubeDim)].renderPass, myFilteringShader);
+	PipelineBuilder pBuilder(6, myFilteringRenderPass[uint32_t(cubeDim)], myFilteringShader);
 
 	pBuilder.DefineVertexInput(nullptr)
 		.DefineViewport({res,res}, {0,0,res,res})
+		.SetDynamicViewport()
 		.SetAllBlendStates(GenBlendState::Disabled)
 		.SetDepthEnabled(false);
 	std::tie(result, myFilteringPipeline[uint32_t(cubeDim)]) = pBuilder.Construct({
 		theirImageHandler.GetSamplerSetLayout(),
 		theirImageHandler.GetImageSetLayout()
-																				  }, theirVulkanFramework.GetDevice());
+																				  }, theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache());
 }
 
 void
@@ -258,18 +276,19 @@ CubeFilterer::RenderFiltering(
 
 	BeginRenderPass(myCmdBuffers[swapchainIndex], myFilteringRenderPass[uint32_t(filterDim)], swapchainIndex, {0,0,res,res});
 
-	vkCmdBindPipeline(myCmdBuffers[swapchainIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, myFilteringPipeline[uint32_t(filterDim)].pipeline);
+	CommandRecorder recorder(myCmdBuffers[swapchainIndex]);
+	recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, myFilteringPipeline[uint32_t(filterDim)].pipeline);
 
 	// DESCRIPTORS
-	theirImageHandler.BindSamplers(myCmdBuffers[swapchainIndex], myFilteringPipeline[uint32_t(filterDim)].layout, 0);
-	theirImageHandler.BindImages(swapchainIndex, myCmdBuffers[swapchainIndex], myFilteringPipeline[uint32_t(filterDim)].layout, 1);
+	theirImageHandler.BindSamplers(recorder, myFilteringPipeline[uint32_t(filterDim)].layout, 0);
+	theirImageHandler.BindImages(swapchainIndex, recorder, myFilteringPipeline[uint32_t(filterDim)].layout, 1);
 
 	// DRAW
 	{
 		vkCmdDraw(myCmdBuffers[swapchainIndex], 6, 1, uint32_t(id), mip);
 	}
 
-	vkCmdEndRenderPass(myCmdBuffers[swapchainIndex]);
+	EndRenderPass(myCmdBuffers[swapchainIndex], myFilteringRenderPass[uint32_t(filterDim)], swapchainIndex);
 }
 
 void
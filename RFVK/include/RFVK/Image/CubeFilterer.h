@@ -63,6 +63,8 @@ public:
 	std::array<VkFence, NumSwapchainImages>			GetFences() override;
 	std::vector<rflx::Features>						GetImplementedFeatures() const override;
 	int												GetSubmissionCount() override { return 1; }
+	std::vector<ResourceUse>						GetResourceUses() const override;
+	const char*										GetName() const override { return "CubeFilterer"; }
 
 	void											PushFilterWork(FilterWork&& filterWork);
 private:
@@ -106,6 +108,6 @@ private:
 
 	QueueFamilyIndex								myPresentationQueueIndex = 0;
 
-	concurrency::concurrent_queue<FilterWork>		myToDoFilterWork;
+	conc_queue<FilterWork>							myToDoFilterWork;
 
 };
@@ -3,6 +3,7 @@
 
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Memory/ImageAllocator.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "RFVK/Misc/stb/stb_image.h"
 #include <RFVK/Debug/DebugUtils.h>
@@ -15,6 +16,7 @@ ImageHandler::ImageHandler(
 	, theirImageAllocator(imageAllocator)
 	, myImageIDKeeper(MaxNumImages)
 	, myCubeIDKeeper(MaxNumImagesCube)
+	, myTextureStreamer(std::make_unique<TextureStreamer>(vulkanFramework, *this, imageAllocator))
 {
 	myOwners = {
 		familyIndices[QUEUE_FAMILY_TRANSFER],
@@ -78,6 +80,25 @@ ImageHandler::ImageHandler(
 	imgArrLayoutInfo.bindingCount = bindings.size();
 	imgArrLayoutInfo.pBindings = bindings.data();
 
+	// BINDLESS
+	// slots are rewritten in place while frames reading other slots are still in flight
+	std::vector<VkDescriptorBindingFlags> bindingFlags(bindings.size(),
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+		VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT);
+	// the layout count of the last binding is only an upper bound, each set says how many it holds
+	bindingFlags.back() |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = bindingFlags.size();
+	bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+	if (myIsBindless)
+	{
+		imgArrLayoutInfo.pNext = &bindingFlagsInfo;
+		imgArrLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	}
+
 	auto resultLayout = vkCreateDescriptorSetLayout(theirVulkanFramework.GetDevice(), &imgArrLayoutInfo, nullptr, &myImageSetLayout);
 	assert(!resultLayout && "failed creating image array descriptor set LAYOUT");
 
@@ -102,7 +123,7 @@ ImageHandler::ImageHandler(
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	poolInfo.pNext = nullptr;
-	poolInfo.flags = NULL;
+	poolInfo.flags = myIsBindless ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : NULL;
 
 	poolInfo.poolSizeCount = poolSizes.size();
 	poolInfo.pPoolSizes = poolSizes.data();
@@ -120,7 +141,17 @@ ImageHandler::ImageHandler(
 	imgArrAllocInfo.pSetLayouts = &myImageSetLayout;
 	imgArrAllocInfo.descriptorPool = myDescriptorPool;
 
-	for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+	const uint32_t numStorageImages = MaxNumStorageImages;
+	VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+	variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+	variableCountInfo.descriptorSetCount = 1;
+	variableCountInfo.pDescriptorCounts = &numStorageImages;
+	if (myIsBindless)
+	{
+		imgArrAllocInfo.pNext = &variableCountInfo;
+	}
+
+	for (uint32_t swapchainIndex = 0; swapchainIndex < GetNumDescriptorSets(); ++swapchainIndex)
 	{
 		auto resultAlloc = vkAllocateDescriptorSets(theirVulkanFramework.GetDevice(), &imgArrAllocInfo, &myImageSets[swapchainIndex]);
 		assert(!resultAlloc && "failed creating image array descriptor set");
@@ -213,7 +244,7 @@ ImageHandler::ImageHandler(
 		}
 	}
 	std::vector<uint8_t> checkers(checkersPix.size() * 4);
-	memcpy_s(checkers.data(), checkers.size(), checkersPix.data(), checkersPix.size() * 4);
+	memcpy(checkers.data(), checkersPix.data(), checkers.size());
 
 	{
 		ImageRequestInfo requestInfo;
@@ -246,7 +277,7 @@ ImageHandler::ImageHandler(
 		write.pBufferInfo = nullptr;
 		write.pTexelBufferView = nullptr;
 
-		for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+		for (uint32_t swapchainIndex = 0; swapchainIndex < GetNumDescriptorSets(); ++swapchainIndex)
 		{
 			write.dstSet = myImageSets[swapchainIndex];
 			vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &write, 0, nullptr);
@@ -290,7 +321,7 @@ ImageHandler::ImageHandler(
 			write.pBufferInfo = nullptr;
 			write.pTexelBufferView = nullptr;
 
-			for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+			for (uint32_t swapchainIndex = 0; swapchainIndex < GetNumDescriptorSets(); ++swapchainIndex)
 			{
 				write.dstSet = myImageSets[swapchainIndex];
 				vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &write, 0, nullptr);
@@ -343,7 +374,7 @@ ImageHandler::ImageHandler(
 			write.pBufferInfo = nullptr;
 			write.pTexelBufferView = nullptr;
 
-			for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+			for (uint32_t swapchainIndex = 0; swapchainIndex < GetNumDescriptorSets(); ++swapchainIndex)
 			{
 				write.dstSet = myImageSets[swapchainIndex];
 				vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &write, 0, nullptr);
@@ -409,18 +440,15 @@ ImageHandler::UnloadImage2D(
 		LOG("failed to unload image with id: ", int(imageID), ", already unloaded");
 		return;
 	}
+	myTextureStreamer->Unregister(imageID);
 	const std::shared_ptr<std::counting_semaphore<NumSwapchainImages>> doneSignal = std::make_shared<std::counting_semaphore<NumSwapchainImages>>(0);
-	for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
-	{
-		auto write = myDefaultImage2DWrite;
-		write.dstSet = myImageSets[swapchainIndex];
-		write.dstArrayElement = int(imageID);
-		QueueDescriptorUpdate(
-			swapchainIndex,
-			nullptr,
-			doneSignal,
-			write);
-	}
+	auto write = myDefaultImage2DWrite;
+	write.dstArrayElement = int(imageID);
+	QueueDescriptorUpdates(
+		myImageSets,
+		nullptr,
+		doneSignal,
+		write);
 	theirImageAllocator.QueueDestroy(std::move(myImages2D[int(imageID)].view), doneSignal);
 	myImages2D[int(imageID)] = {};
 }
@@ -484,10 +512,7 @@ ImageHandler::LoadImage2D(
 		LOG("failed loading image 2D, error code: ", result);
 	}
 
-	myImages2D[uint32_t(imageID)].dim = dimension;
-	auto [sw, sh] = theirVulkanFramework.GetTargetResolution();
-	myImages2D[uint32_t(imageID)].scale = {dimension.x / sw, dimension.y / sh};
-	myImages2D[uint32_t(imageID)].scale.x *= sw / sh;
+	SetImage2DDimension(imageID, dimension);
 	myImages2D[uint32_t(imageID)].layers = layers;
 	
 	myImages2D[uint32_t(imageID)].info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -495,24 +520,65 @@ ImageHandler::LoadImage2D(
 
 	auto& allocSub = theirImageAllocator.GetAllocationSubmission(allocSubID);
 	auto executedEvent = allocSub.GetExecutedEvent();
-	for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstBinding = ImageSetImages2DBinding;
+	write.dstArrayElement = uint32_t(imageID);
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	write.pImageInfo = &myImages2D[uint32_t(imageID)].info;
+	QueueDescriptorUpdates(
+		myImageSets,
+		executedEvent,
+		nullptr,
+		write);
+}
+
+void
+ImageHandler::LoadImage2DStreamed(
+	ImageID					imageID,
+	AllocationSubmissionID	allocSubID,
+	const std::string&		path)
+{
+	auto [pixels, width, height, channels] = ReadImage(path);
+	if (pixels.empty())
 	{
-		VkWriteDescriptorSet write = {};
-		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		write.dstBinding = ImageSetImages2DBinding;
-		write.dstArrayElement = uint32_t(imageID);
-		write.descriptorCount = 1;
-		write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		write.pImageInfo = &myImages2D[uint32_t(imageID)].info;
-		write.dstSet = myImageSets[swapchainIndex];
-		QueueDescriptorUpdate(
-			swapchainIndex, 
-			executedEvent,
-			nullptr,
-			write);
-		//myQueuedDescriptorWrites[swapchainIndex].push({ executedEvent, write });
+		return;
 	}
+
+	const Vec2ui fullDim = {width, height};
+	const Vec2ui tailDim = TextureStreamer::MipDimension(fullDim, StreamingMipTailDim);
+	if (tailDim == fullDim)
+	{
+		return LoadImage2D(
+			imageID,
+			allocSubID,
+			std::move(pixels),
+			fullDim,
+			VK_FORMAT_R8G8B8A8_UNORM,
+			4);
+	}
+
+	auto tailPixels = TextureStreamer::Downsample(pixels, fullDim, tailDim);
+	LoadImage2D(
+		imageID,
+		allocSubID,
+		std::vector<uint8_t>(tailPixels),
+		tailDim,
+		VK_FORMAT_R8G8B8A8_UNORM,
+		4);
+	SetImage2DDimension(imageID, fullDim);
+
+	auto& allocSub = theirImageAllocator.GetAllocationSubmission(allocSubID);
+	myTextureStreamer->Register(
+		imageID,
+		path,
+		std::move(tailPixels),
+		tailDim,
+		fullDim,
+		allocSub.GetExecutedEvent());
 }
+
 void
 ImageHandler::LoadImage2DTiled(
 	ImageID					imageID,
@@ -620,23 +686,18 @@ ImageHandler::LoadImageCube(
 	auto& allocSub = theirImageAllocator.GetAllocationSubmission(allocSubID);
 	auto executedEvent = allocSub.GetExecutedEvent();
 	auto doneSignal = std::make_shared<shared_semaphore<NumSwapchainImages>::element_type>(0);
-	for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
-	{
-		VkWriteDescriptorSet write{};
-		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		write.dstBinding = ImageSetImagesCubeBinding;
-		write.dstArrayElement = uint32_t(cubeID);
-		write.descriptorCount = 1;
-		write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		write.pImageInfo = &imageCube.info;
-		write.dstSet = myImageSets[swapchainIndex];
-		QueueDescriptorUpdate(
-			swapchainIndex, 
-			executedEvent,
-			doneSignal,
-			write);
-		//myQueuedDescriptorWrites[swapchainIndex].push({executedEvent, write});
-	}
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstBinding = ImageSetImagesCubeBinding;
+	write.dstArrayElement = uint32_t(cubeID);
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	write.pImageInfo = &imageCube.info;
+	QueueDescriptorUpdates(
+		myImageSets,
+		executedEvent,
+		doneSignal,
+		write);
 
 	return doneSignal;
 }
@@ -677,7 +738,7 @@ ImageHandler::LoadStorageImage(
 	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
 	write.pImageInfo = &imageInfo;
 
-	for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+	for (uint32_t swapchainIndex = 0; swapchainIndex < GetNumDescriptorSets(); ++swapchainIndex)
 	{
 		write.dstSet = myImageSets[swapchainIndex];
 		vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &write, 0, nullptr);
@@ -692,6 +753,12 @@ ImageHandler::GetImageSetLayout() const
 	return myImageSetLayout;
 }
 
+ResourceUse
+ImageHandler::GetImagesUse(ResourceAccess access) const
+{
+	return {uint64_t(this), "images", access, true};
+}
+
 VkDescriptorSetLayout
 ImageHandler::GetSamplerSetLayout() const
 {
@@ -700,37 +767,23 @@ ImageHandler::GetSamplerSetLayout() const
 
 void
 ImageHandler::BindSamplers(
-	VkCommandBuffer		commandBuffer,
+	CommandRecorder&	recorder,
 	VkPipelineLayout	pipelineLayout,
 	uint32_t			setIndex,
 	VkPipelineBindPoint bindPoint)
 {
-	vkCmdBindDescriptorSets(commandBuffer,
-		bindPoint,
-		pipelineLayout,
-		setIndex,
-		1,
-		&mySamplerSet,
-		0,
-		nullptr);
+	recorder.BindDescriptorSet(bindPoint, pipelineLayout, setIndex, mySamplerSet);
 }
 
 void
 ImageHandler::BindImages(
 	int					swapchainIndex,
-	VkCommandBuffer		commandBuffer,
+	CommandRecorder&	recorder,
 	VkPipelineLayout	pipelineLayout,
 	uint32_t			setIndex,
 	VkPipelineBindPoint bindPoint)
 {
-	vkCmdBindDescriptorSets(commandBuffer,
-		bindPoint,
-		pipelineLayout,
-		setIndex,
-		1,
-		&myImageSets[swapchainIndex],
-		0,
-		nullptr);
+	recorder.BindDescriptorSet(bindPoint, pipelineLayout, setIndex, myImageSets[myIsBindless ? 0 : swapchainIndex]);
 }
 
 Image
@@ -753,6 +806,20 @@ ImageHandler::operator[](CubeID id)
 	return myImagesCube[uint32_t(id)];
 }
 
+uint32_t
+ImageHandler::GetGeneration(
+	ImageID id) const
+{
+	return myImageIDKeeper.GetGeneration(id);
+}
+
+uint32_t
+ImageHandler::GetGeneration(
+	CubeID id) const
+{
+	return myCubeIDKeeper.GetGeneration(id);
+}
+
 std::tuple<std::vector<uint8_t>, int, int, int>
 ImageHandler::ReadImage(
 	const std::string& path)
@@ -806,3 +873,101 @@ ImageHandler::GetImageAllocator() const
 {
 	return theirImageAllocator;
 }
+
+TextureStreamer&
+ImageHandler::GetTextureStreamer() const
+{
+	return *myTextureStreamer;
+}
+
+std::shared_ptr<VkEvent>
+ImageHandler::StreamImage2D(
+	ImageID					imageID,
+	AllocationSubmissionID	allocSubID,
+	std::vector<uint8_t>&&	pixelData,
+	Vec2ui					residentDim,
+	uint32_t				mips,
+	VkFormat				format,
+	VkImageLayout			layout,
+	VkComponentMapping		components)
+{
+	auto& image = myImages2D[uint32_t(imageID)];
+	VkImageView prevView = image.view;
+
+	ImageRequestInfo requestInfo;
+	requestInfo.width = residentDim.x;
+	requestInfo.height = residentDim.y;
+	requestInfo.mips = mips ? mips : NUM_MIPS(std::max(residentDim.x, residentDim.y));
+	requestInfo.owners = myOwners;
+	requestInfo.format = format;
+	requestInfo.layout = layout;
+	requestInfo.components = components;
+	auto [result, view] = theirImageAllocator.RequestImageArray(
+		allocSubID,
+		std::move(pixelData),
+		1,
+		requestInfo);
+	if (result)
+	{
+		LOG("failed streaming image 2D, error code: ", result);
+		return nullptr;
+	}
+
+	image.view = view;
+	image.info.imageLayout = layout;
+	image.info.imageView = view;
+
+	auto& allocSub = theirImageAllocator.GetAllocationSubmission(allocSubID);
+	auto executedEvent = allocSub.GetExecutedEvent();
+	const auto doneSignal = std::make_shared<std::counting_semaphore<NumSwapchainImages>>(0);
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstBinding = ImageSetImages2DBinding;
+	write.dstArrayElement = uint32_t(imageID);
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	write.pImageInfo = &image.info;
+	QueueDescriptorUpdates(
+		myImageSets,
+		executedEvent,
+		doneSignal,
+		write);
+	if (prevView)
+	{
+		theirImageAllocator.QueueDestroy(std::move(prevView), doneSignal);
+	}
+	return executedEvent;
+}
+
+VkResult
+ImageHandler::WriteImage2DRegion(
+	ImageID						imageID,
+	AllocationSubmissionID		allocSubID,
+	const std::vector<uint8_t>&	pixelData,
+	Vec2ui						offset,
+	Vec2ui						extent)
+{
+	auto& image = myImages2D[uint32_t(imageID)];
+	assert(image.info.imageLayout == VK_IMAGE_LAYOUT_GENERAL && "image regions can only be written in general layout");
+	return theirImageAllocator.WriteImageRegion(
+		allocSubID,
+		image.view,
+		pixelData.data(),
+		pixelData.size(),
+		offset,
+		extent,
+		myOwners.data(),
+		uint32_t(myOwners.size()));
+}
+
+void
+ImageHandler::SetImage2DDimension(
+	ImageID	imageID,
+	Vec2f	dimension)
+{
+	auto& image = myImages2D[uint32_t(imageID)];
+	image.dim = dimension;
+	auto [sw, sh] = theirVulkanFramework.GetTargetResolution();
+	image.scale = {dimension.x / sw, dimension.y / sh};
+	image.scale.x *= sw / sh;
+}
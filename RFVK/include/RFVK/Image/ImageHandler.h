@@ -1,6 +1,8 @@
 
 #pragma once
 #include "RFVK/Misc/HandlerBase.h"
+#include "TextureStreamer.h"
+#include "RFVK/WorkerSystem/FrameResource.h"
 
 struct Image
 {
@@ -20,6 +22,9 @@ struct ImageCube
 
 class ImageHandler : public HandlerBase
 {
+	friend class TextureStreamer;
+	friend class AtlasHandler;
+	friend class FontHandler;
 
 public:
 													ImageHandler(
@@ -42,6 +47,10 @@ public:
 														Vec2f						dimension,
 														VkFormat					format = VK_FORMAT_R8G8B8A8_UNORM,
 														uint32_t					byteDepth = 4);
+	void											LoadImage2DStreamed(
+														ImageID						imageID,
+														AllocationSubmissionID		allocSubID,
+														const std::string&			path);
 	void											LoadImage2DTiled(
 														ImageID imageID,
 														AllocationSubmissionID		allocSubID,
@@ -60,26 +69,51 @@ public:
 														uint32_t	height);
 
 	void											BindSamplers(
-														VkCommandBuffer		commandBuffer,
+														class CommandRecorder&	recorder,
 														VkPipelineLayout	pipelineLayout,
 														uint32_t			setIndex,
 														VkPipelineBindPoint	bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
 	void											BindImages(
 														int					swapchainIndex,
-														VkCommandBuffer		commandBuffer,
+														class CommandRecorder&	recorder,
 														VkPipelineLayout	pipelineLayout,
 														uint32_t			setIndex,
 														VkPipelineBindPoint	bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
 
 	_nodiscard VkDescriptorSetLayout				GetImageSetLayout() const;
 	_nodiscard VkDescriptorSetLayout				GetSamplerSetLayout() const;
+	// the image set is bound whole, so the frame graph tracks all of its images as one resource
+	_nodiscard ResourceUse							GetImagesUse(ResourceAccess access) const;
 	ImageAllocator&									GetImageAllocator() const;
+	TextureStreamer&								GetTextureStreamer() const;
 
 	Image											operator[](ImageID id);
 	ImageCube										operator[](CubeID id);
+	// odd while the id is in use, changes every time the id is removed or handed out again
+	_nodiscard uint32_t								GetGeneration(ImageID id) const;
+	_nodiscard uint32_t								GetGeneration(CubeID id) const;
 
 private:
 	std::tuple<std::vector<uint8_t>, int, int, int>	ReadImage(const std::string& path);
+	std::shared_ptr<VkEvent>						StreamImage2D(
+														ImageID						imageID,
+														AllocationSubmissionID		allocSubID,
+														std::vector<uint8_t>&&		pixelData,
+														Vec2ui						residentDim,
+														uint32_t					mips = 0,
+														VkFormat					format = VK_FORMAT_R8G8B8A8_UNORM,
+														VkImageLayout				layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+														VkComponentMapping			components = {});
+	// for images streamed in general layout, the view and its descriptor stay as they are
+	VkResult										WriteImage2DRegion(
+														ImageID						imageID,
+														AllocationSubmissionID		allocSubID,
+														const std::vector<uint8_t>&	pixelData,
+														Vec2ui						offset,
+														Vec2ui						extent);
+	void											SetImage2DDimension(
+														ImageID	imageID,
+														Vec2f	dimension);
 	void											CreateSampler(
 														VkFilter				filter, 
 														VkSamplerAddressMode	samplerMode,
@@ -106,8 +140,7 @@ private:
 	std::array<ImageCube, MaxNumImagesCube>			myImagesCube = {};
 	IDKeeper<CubeID>								myCubeIDKeeper;
 
-
-	
+	std::unique_ptr<TextureStreamer>				myTextureStreamer;
 
 
 };
@@ -4,6 +4,7 @@
 
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Shader/Shader.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 #include "RFVK/Pipelines/ComputePipelineBuilder.h"
 #include "RFVK/Memory/ImageAllocator.h"
 #include "RFVK/Debug/DebugUtils.h"
@@ -33,7 +34,7 @@ ImageProcessor::ImageProcessor(
 	builder.AddDescriptorSet(theirImageHandler.GetSamplerSetLayout());
 	builder.AddDescriptorSet(theirImageHandler.GetImageSetLayout());
 	builder.AddDescriptorSet(myDescriptorLayout);
-	std::tie(result, myImageProcessPipeline) = builder.Construct(theirVulkanFramework.GetDevice());
+	std::tie(result, myImageProcessPipeline) = builder.Construct(theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache());
 
 	{
 		auto allocSubId = theirImageAllocator.Start();
@@ -55,6 +56,7 @@ ImageProcessor::ImageProcessor(
 		imgInfo.layout = VK_IMAGE_LAYOUT_GENERAL;
 		auto [result, imageView] = theirImageAllocator.RequestImage2D(allocSubId, pixels.data(), 512 * 512 * 4, imgInfo);
 		assert(!result && "failed creating storage image");
+		myStorageImage = imageView;
 		DebugSetObjectName("img proccess storage img", theirImageAllocator.GetImage(imageView), VK_OBJECT_TYPE_IMAGE_VIEW, theirVulkanFramework.GetDevice());
 
 		VkDescriptorImageInfo imageInfo = {};
@@ -115,18 +117,11 @@ ImageProcessor::RecordSubmit(
 	auto resultBegin = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
 	if (myHasRun)
 	{
-		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, myImageProcessPipeline.pipeline);
-		theirImageHandler.BindSamplers(cmdBuffer, myImageProcessPipeline.layout, 0, VK_PIPELINE_BIND_POINT_COMPUTE);
-		theirImageHandler.BindImages(swapchainImageIndex, cmdBuffer, myImageProcessPipeline.layout, 1, VK_PIPELINE_BIND_POINT_COMPUTE);
-		vkCmdBindDescriptorSets(
-			cmdBuffer,
-			VK_PIPELINE_BIND_POINT_COMPUTE,
-			myImageProcessPipeline.layout,
-			2,
-			1,
-			&myDescriptorSet,
-			0,
-			nullptr);
+		CommandRecorder recorder(cmdBuffer);
+		recorder.BindPipeline(VK_PIPELINE_BIND_POINT_COMPUTE, myImageProcessPipeline.pipeline);
+		theirImageHandler.BindSamplers(recorder, myImageProcessPipeline.layout, 0, VK_PIPELINE_BIND_POINT_COMPUTE);
+		theirImageHandler.BindImages(swapchainImageIndex, recorder, myImageProcessPipeline.layout, 1, VK_PIPELINE_BIND_POINT_COMPUTE);
+		recorder.BindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE, myImageProcessPipeline.layout, 2, myDescriptorSet);
 		vkCmdDispatch(cmdBuffer, 512 / 16, 512 / 16, 1);
 		myHasRun = true;
 	}
@@ -161,6 +156,13 @@ std::vector<rflx::Features> ImageProcessor::GetImplementedFeatures() const
 	return { rflx::Features::FEATURE_CORE };
 }
 
+std::vector<ResourceUse> ImageProcessor::GetResourceUses() const
+{
+	return {
+		theirImageHandler.GetImagesUse(ResourceAccess::Read),
+		{uint64_t(myStorageImage), "img process storage", ResourceAccess::Write, true}};
+}
+
 VkResult ImageProcessor::CreateDescriptorSet()
 {
 	assert(!myDescriptorSet && "create descriptors can only be called once");
@@ -27,6 +27,8 @@ public:
 	std::array<VkFence, NumSwapchainImages>	GetFences() override;
 	std::vector<rflx::Features>				GetImplementedFeatures() const override;
 	int										GetSubmissionCount() override { return 1; }
+	std::vector<ResourceUse>				GetResourceUses() const override;
+	const char*								GetName() const override { return "ImageProcessor"; }
 
 private:
 	VkResult						CreateDescriptorSet();
@@ -34,7 +36,7 @@ private:
 	ImageAllocator& 				theirImageAllocator;
 	ImageHandler& 					theirImageHandler;
 	QueueFamilyIndex				myComputeQueueIndex = 0;
-	concurrency::concurrent_queue<ImageProcessingWork>
+	conc_queue<ImageProcessingWork>
 									myToDoWork;
 
 	std::array<VkPipelineStageFlags, MaxWorkerSubmissions>
@@ -45,6 +47,7 @@ private:
 	VkDescriptorPool				myDescriptorPool = nullptr;
 	VkDescriptorSetLayout			myDescriptorLayout = nullptr;
 	VkDescriptorSet					myDescriptorSet = nullptr;
+	VkImageView						myStorageImage = nullptr;
 
 	std::array<VkCommandBuffer, NumSwapchainImages>	myCmdBuffers;
 	std::array<VkFence, NumSwapchainImages>			myCmdBufferFences;
@@ -0,0 +1,380 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+
+#include "ImageHandler.h"
+#include "RFVK/VulkanFramework.h"
+#include "RFVK/Memory/ImageAllocator.h"
+
+TextureStreamer::TextureStreamer(
+	VulkanFramework&	vulkanFramework,
+	ImageHandler&		imageHandler,
+	ImageAllocator&		imageAllocator)
+	: theirVulkanFramework(vulkanFramework)
+	, theirImageHandler(imageHandler)
+	, theirImageAllocator(imageAllocator)
+{
+	myDecodeThread = std::thread(&TextureStreamer::Decode, this);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	myIsStopping = true;
+	myDecodeSignal.release();
+	myDecodeThread.join();
+}
+
+void
+TextureStreamer::Register(
+	ImageID						imageID,
+	const std::string&			path,
+	std::vector<uint8_t>&&		tailPixels,
+	Vec2ui						tailDim,
+	Vec2ui						fullDim,
+	std::shared_ptr<VkEvent>	tailEvent)
+{
+	if (BAD_ID(imageID))
+	{
+		return;
+	}
+	std::scoped_lock lock(myMutex);
+
+	StreamedImage image;
+	image.path = path;
+	image.tailPixels = std::move(tailPixels);
+	image.fullDim = fullDim;
+	image.tailDim = tailDim;
+	image.residentDim = tailDim;
+	image.residentEvent = std::move(tailEvent);
+
+	if (auto it = myImages.find(imageID); it != myImages.end())
+	{
+		myResidentBytes -= ResidentBytes(it->second.residentDim);
+	}
+	myResidentBytes += ResidentBytes(tailDim);
+	myImages[imageID] = std::move(image);
+}
+
+void
+TextureStreamer::Unregister(
+	ImageID imageID)
+{
+	std::scoped_lock lock(myMutex);
+	auto it = myImages.find(imageID);
+	if (it == myImages.end())
+	{
+		return;
+	}
+	myResidentBytes -= ResidentBytes(it->second.residentDim);
+	myImages.erase(it);
+}
+
+void
+TextureStreamer::RequestResolution(
+	ImageID		imageID,
+	uint32_t	screenDim)
+{
+	if (BAD_ID(imageID))
+	{
+		return;
+	}
+	myRequests.push({imageID, screenDim});
+}
+
+void
+TextureStreamer::Update()
+{
+	std::scoped_lock lock(myMutex);
+	++myFrame;
+
+	// GATHER REQUESTS
+	StreamRequest request;
+	while (myRequests.try_pop(request))
+	{
+		auto it = myImages.find(request.imageID);
+		if (it == myImages.end())
+		{
+			continue;
+		}
+		auto& image = it->second;
+		image.requestedDim = image.lastRequestedFrame == myFrame
+			? std::max(image.requestedDim, request.dim)
+			: request.dim;
+		image.lastRequestedFrame = myFrame;
+	}
+
+	// UPLOAD DECODED
+	int numStreams = 0;
+	StreamDecode decoded;
+	while (numStreams < MaxNumStreamsPerFrame && myDecodedMips.try_pop(decoded))
+	{
+		--myNumDecoding;
+		auto it = myImages.find(decoded.imageID);
+		// unregistered or registered again while it was decoding
+		if (it == myImages.end() || it->second.decodeTicket != decoded.ticket)
+		{
+			continue;
+		}
+		auto& image = it->second;
+		image.decodeTicket = 0;
+		if (decoded.pixels.empty())
+		{
+			continue;
+		}
+		const uint64_t numBytes = ResidentBytes(decoded.dim) - ResidentBytes(image.residentDim);
+		if (myResidentBytes + numBytes > myBudget
+			&& !Evict(myResidentBytes + numBytes - myBudget))
+		{
+			continue;
+		}
+		if (Upload(decoded.imageID, image, std::move(decoded.pixels), decoded.dim))
+		{
+			++numStreams;
+		}
+	}
+
+	// PICK CANDIDATES
+	uint32_t numPending = 0;
+	// rebuilt every frame, so it comes from the frame arena rather than the heap
+	neat::frame_vector<std::tuple<ImageID, Vec2ui, float>> candidates(neat::GetFrameResource());
+	for (auto& [imageID, image] : myImages)
+	{
+		if (IsInFlight(image))
+		{
+			++numPending;
+			continue;
+		}
+		if (image.lastRequestedFrame != myFrame)
+		{
+			continue;
+		}
+		const Vec2ui targetDim = MipDimension(image.fullDim, std::max(image.requestedDim, image.tailDim.x));
+		if (targetDim.x <= image.residentDim.x)
+		{
+			continue;
+		}
+		candidates.emplace_back(imageID, targetDim, float(targetDim.x) / float(image.residentDim.x));
+	}
+	numPending += uint32_t(candidates.size());
+
+	// largest resolution deficit first
+	std::ranges::sort(candidates, [](const auto& left, const auto& right)
+	{
+		return std::get<2>(left) > std::get<2>(right);
+	});
+
+	// DECODE
+	for (auto& [imageID, targetDim, deficit] : candidates)
+	{
+		if (myNumDecoding >= MaxNumStreamsPerFrame)
+		{
+			break;
+		}
+		auto& image = myImages[imageID];
+		const uint64_t numBytes = ResidentBytes(targetDim) - ResidentBytes(image.residentDim);
+		if (myResidentBytes + numBytes > myBudget
+			&& !Evict(myResidentBytes + numBytes - myBudget))
+		{
+			continue;
+		}
+		image.decodeTicket = ++myNextDecodeTicket;
+		myDecodeJobs.push({imageID, image.decodeTicket, image.path, targetDim, {}});
+		myDecodeSignal.release();
+		++myNumDecoding;
+	}
+
+	myNumPendingRequests = numPending;
+}
+
+void
+TextureStreamer::SetBudget(
+	uint64_t numBytes)
+{
+	myBudget = numBytes;
+}
+
+uint64_t
+TextureStreamer::GetBudget() const
+{
+	return myBudget;
+}
+
+uint64_t
+TextureStreamer::GetResidentBytes() const
+{
+	return myResidentBytes;
+}
+
+uint32_t
+TextureStreamer::GetNumPendingRequests() const
+{
+	return myNumPendingRequests;
+}
+
+Vec2ui
+TextureStreamer::MipDimension(
+	Vec2ui		fullDim,
+	uint32_t	targetDim)
+{
+	Vec2ui dim = fullDim;
+	while (std::max(dim.x, dim.y) / 2 >= targetDim
+		&& dim.x > 1 && dim.y > 1)
+	{
+		dim /= 2u;
+	}
+	return dim;
+}
+
+std::vector<uint8_t>
+TextureStreamer::Downsample(
+	const std::vector<uint8_t>&	pixels,
+	Vec2ui						dim,
+	Vec2ui						targetDim)
+{
+	// the first step reads the caller's pixels in place, only the halved levels are owned
+	const uint8_t* src = pixels.data();
+	std::vector<uint8_t> halved;
+	std::vector<uint8_t> dst;
+	while (dim.x > targetDim.x && dim.y > targetDim.y)
+	{
+		const Vec2ui half = dim / 2u;
+		dst.resize(size_t(half.x) * half.y * 4);
+		for (uint32_t y = 0; y < half.y; ++y)
+		{
+			for (uint32_t x = 0; x < half.x; ++x)
+			{
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					const uint32_t sum =
+						src[((y * 2 + 0) * dim.x + x * 2 + 0) * 4 + c] +
+						src[((y * 2 + 0) * dim.x + x * 2 + 1) * 4 + c] +
+						src[((y * 2 + 1) * dim.x + x * 2 + 0) * 4 + c] +
+						src[((y * 2 + 1) * dim.x + x * 2 + 1) * 4 + c];
+					dst[(y * half.x + x) * 4 + c] = uint8_t(sum / 4);
+				}
+			}
+		}
+		std::swap(halved, dst);
+		src = halved.data();
+		dim = half;
+	}
+	if (src == pixels.data())
+	{
+		return pixels;
+	}
+	return halved;
+}
+
+bool
+TextureStreamer::IsInFlight(
+	StreamedImage& image)
+{
+	if (image.decodeTicket)
+	{
+		return true;
+	}
+	if (image.settledFrame != UINT64_MAX)
+	{
+		// descriptor writes are flushed one swapchain image per frame
+		return myFrame < image.settledFrame + NumSwapchainImages;
+	}
+	if (image.residentEvent && *image.residentEvent
+		&& vkGetEventStatus(theirVulkanFramework.GetDevice(), *image.residentEvent) != VK_EVENT_SET)
+	{
+		return true;
+	}
+	image.settledFrame = myFrame;
+	return true;
+}
+
+bool
+TextureStreamer::Evict(
+	uint64_t numBytes)
+{
+	neat::frame_vector<std::pair<ImageID, uint64_t>> evictable(neat::GetFrameResource());
+	for (auto& [imageID, image] : myImages)
+	{
+		if (image.residentDim == image.tailDim
+			|| image.lastRequestedFrame == myFrame
+			|| IsInFlight(image))
+		{
+			continue;
+		}
+		evictable.emplace_back(imageID, image.lastRequestedFrame);
+	}
+	std::ranges::sort(evictable, {}, &std::pair<ImageID, uint64_t>::second);
+
+	uint64_t freedBytes = 0;
+	for (auto& [imageID, lastRequestedFrame] : evictable)
+	{
+		if (freedBytes >= numBytes)
+		{
+			break;
+		}
+		auto& image = myImages[imageID];
+		const uint64_t imageBytes = ResidentBytes(image.residentDim) - ResidentBytes(image.tailDim);
+		if (Upload(imageID, image, std::vector<uint8_t>(image.tailPixels), image.tailDim))
+		{
+			freedBytes += imageBytes;
+		}
+	}
+	return freedBytes >= numBytes;
+}
+
+void
+TextureStreamer::Decode()
+{
+	while (true)
+	{
+		myDecodeSignal.acquire();
+		if (myIsStopping)
+		{
+			return;
+		}
+		StreamDecode job;
+		if (!myDecodeJobs.try_pop(job))
+		{
+			continue;
+		}
+		auto [fullPixels, width, height, channels] = theirImageHandler.ReadImage(job.path);
+		if (!fullPixels.empty())
+		{
+			job.pixels = Downsample(fullPixels, {width, height}, job.dim);
+		}
+		myDecodedMips.push(std::move(job));
+	}
+}
+
+bool
+TextureStreamer::Upload(
+	ImageID					imageID,
+	StreamedImage&			image,
+	std::vector<uint8_t>&&	pixels,
+	Vec2ui					dim)
+{
+	auto allocSubID = theirImageAllocator.Start();
+	auto executedEvent = theirImageHandler.StreamImage2D(
+		imageID,
+		allocSubID,
+		std::move(pixels),
+		dim);
+	theirImageAllocator.Queue(std::move(allocSubID));
+	if (!executedEvent)
+	{
+		return false;
+	}
+
+	myResidentBytes += ResidentBytes(dim);
+	myResidentBytes -= ResidentBytes(image.residentDim);
+	image.residentDim = dim;
+	image.residentEvent = std::move(executedEvent);
+	image.settledFrame = UINT64_MAX;
+	return true;
+}
+
+uint64_t
+TextureStreamer::ResidentBytes(
+	Vec2ui dim)
+{
+	// full mip chain is roughly a third on top of mip 0
+	return uint64_t(dim.x) * dim.y * 4 * 4 / 3;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <thread>
+
+struct StreamedImage
+{
+	std::string					path;
+	std::vector<uint8_t>		tailPixels;
+	Vec2ui						fullDim = {};
+	Vec2ui						tailDim = {};
+	Vec2ui						residentDim = {};
+	uint32_t					requestedDim = 0;
+	uint64_t					lastRequestedFrame = 0;
+	uint64_t					settledFrame = UINT64_MAX;
+	uint64_t					decodeTicket = 0;
+	std::shared_ptr<VkEvent>	residentEvent;
+};
+
+struct StreamRequest
+{
+	ImageID		imageID = ImageID(INVALID_ID);
+	uint32_t	dim = 0;
+};
+
+struct StreamDecode
+{
+	ImageID					imageID = ImageID(INVALID_ID);
+	uint64_t				ticket = 0;
+	std::string				path;
+	Vec2ui					dim = {};
+	std::vector<uint8_t>	pixels;
+};
+
+class TextureStreamer
+{
+public:
+										TextureStreamer(
+											class VulkanFramework&	vulkanFramework,
+											class ImageHandler&		imageHandler,
+											class ImageAllocator&	imageAllocator);
+										~TextureStreamer();
+
+	void								Register(
+											ImageID						imageID,
+											const std::string&			path,
+											std::vector<uint8_t>&&		tailPixels,
+											Vec2ui						tailDim,
+											Vec2ui						fullDim,
+											std::shared_ptr<VkEvent>	tailEvent);
+	void								Unregister(ImageID imageID);
+
+	void								RequestResolution(
+											ImageID		imageID,
+											uint32_t	screenDim);
+	void								Update();
+
+	void								SetBudget(uint64_t numBytes);
+	_nodiscard uint64_t					GetBudget() const;
+	_nodiscard uint64_t					GetResidentBytes() const;
+	_nodiscard uint32_t					GetNumPendingRequests() const;
+
+	static Vec2ui						MipDimension(
+											Vec2ui		fullDim,
+											uint32_t	targetDim);
+	static std::vector<uint8_t>			Downsample(
+											const std::vector<uint8_t>&	pixels,
+											Vec2ui						dim,
+											Vec2ui						targetDim);
+
+private:
+	bool								IsInFlight(StreamedImage& image);
+	bool								Evict(uint64_t numBytes);
+	void								Decode();
+	bool								Upload(
+											ImageID					imageID,
+											StreamedImage&			image,
+											std::vector<uint8_t>&&	pixels,
+											Vec2ui					dim);
+	static uint64_t						ResidentBytes(Vec2ui dim);
+
+	VulkanFramework&					theirVulkanFramework;
+	ImageHandler&						theirImageHandler;
+	ImageAllocator&						theirImageAllocator;
+
+	std::mutex							myMutex;
+	std::unordered_map<ImageID, StreamedImage>
+										myImages;
+	conc_queue<StreamRequest>			myRequests;
+
+	// files are read and downsampled here, the render thread only uploads the result
+	conc_queue<StreamDecode>			myDecodeJobs;
+	conc_queue<StreamDecode>			myDecodedMips;
+	std::counting_semaphore<>			myDecodeSignal{0};
+	std::atomic<bool>					myIsStopping = false;
+	std::thread							myDecodeThread;
+	uint64_t							myNextDecodeTicket = 0;
+	uint32_t							myNumDecoding = 0;
+
+	uint64_t							myFrame = 0;
+	std::atomic<uint64_t>				myBudget = DefaultStreamingBudget;
+	std::atomic<uint64_t>				myResidentBytes = 0;
+	std::atomic<uint32_t>				myNumPendingRequests = 0;
+
+};
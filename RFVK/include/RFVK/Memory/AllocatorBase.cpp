@@ -142,10 +142,9 @@ AllocationSubmitter::StartAllocSubmission()
 	auto& allocSub = myAllocationSubmissions[int(id)];
 
 	//const auto cmdPool = myCommandPools[threadID];
-	while (myCommandBufferQueue[threadID].empty())
+	VkCommandBuffer cmdBuffer = nullptr;
+	while (!myCommandBufferQueue[threadID].try_pop(cmdBuffer))
 	{}
-	auto cmdBuffer = myCommandBufferQueue[threadID].front();
-	myCommandBufferQueue[threadID].pop();
 	allocSub.Start(threadID, theirVulkanFramework.GetDevice(), cmdBuffer);
 
 	return id;
@@ -155,7 +154,7 @@ AllocationSubmissionID
 AllocationSubmitter::StartAllocSubmission(
 	neat::ThreadID threadID)
 {
-	if (myCommandPools.find(threadID) == myCommandPools.cend())
+	if (!myCommandPools.contains(threadID))
 	{
 		RegisterThread(threadID);
 		LOG("start called from unregistered thread!");
@@ -167,11 +166,10 @@ AllocationSubmitter::StartAllocSubmission(
 	}
 	auto& allocSub = myAllocationSubmissions[int(id)];
 
-	while (myCommandBufferQueue[threadID].empty())
+	VkCommandBuffer cmdBuffer = nullptr;
+	while (!myCommandBufferQueue[threadID].try_pop(cmdBuffer))
 	{
 	}
-	const auto cmdBuffer = myCommandBufferQueue[threadID].front();
-	myCommandBufferQueue[threadID].pop();
 	allocSub.Start(threadID, theirVulkanFramework.GetDevice(), cmdBuffer);
 
 	return id;
@@ -205,10 +203,10 @@ AllocationSubmitter::AllocationSubmitter(
 
 AllocationSubmitter::~AllocationSubmitter()
 {
-	for (auto& [threadID, pool] : myCommandPools)
+	myCommandPools.for_each([this](neat::ThreadID, VkCommandPool pool)
 	{
 		vkDestroyCommandPool(theirVulkanFramework.GetDevice(), pool, nullptr);
-	}
+	});
 }
 
 void AllocationSubmitter::RegisterThread(neat::ThreadID threadID)
@@ -11,7 +11,6 @@ constexpr int MaxNumCmdBuffersPerThread = 128;
 class AllocationSubmission
 {
 	friend class AllocationSubmitter;
-	friend class ::concurrency::concurrent_queue<AllocationSubmission>;
 	
 	enum class Status
 	{
@@ -93,7 +92,7 @@ private:
 
 	conc_map<neat::ThreadID, const std::array<VkCommandBuffer, MaxNumAllocationSubmissions>>
 										myCommandBuffers;
-	conc_map<neat::ThreadID, std::queue<VkCommandBuffer>>
+	conc_map<neat::ThreadID, conc_queue<VkCommandBuffer, MaxNumAllocationSubmissions>>
 										myCommandBufferQueue;
 	
 };
@@ -166,6 +166,47 @@ BufferAllocator::RequestUniformBuffer(
 	return {result, buffer};
 }
 
+std::tuple<VkResult, VkBuffer, void*>
+BufferAllocator::RequestMappedBuffer(
+	VkBufferUsageFlags						usage,
+	size_t									size,
+	const std::vector<QueueFamilyIndex>&	owners)
+{
+	auto [result, buffer, memory] = CreateBuffer(
+									AllocationSubmissionID(INVALID_ID),
+									usage,
+									nullptr,
+									size,
+									owners,
+									VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	if (result)
+	{
+		if (buffer)
+		{
+			vkDestroyBuffer(theirVulkanFramework.GetDevice(), buffer, nullptr);
+		}
+		LOG("failed creating mapped buffer");
+		return {result, nullptr, nullptr};
+	}
+
+	void* mappedData = nullptr;
+	auto resultMap = vkMapMemory(theirVulkanFramework.GetDevice(), memory, 0, size, NULL, &mappedData);
+	if (resultMap)
+	{
+		vkDestroyBuffer(theirVulkanFramework.GetDevice(), buffer, nullptr);
+		vkFreeMemory(theirVulkanFramework.GetDevice(), memory, nullptr);
+		LOG("failed mapping buffer memory");
+		return {resultMap, nullptr, nullptr};
+	}
+
+	myRequestedBuffersQueue.push({
+		buffer,
+		memory,
+		size
+		});
+	return {result, buffer, mappedData};
+}
+
 void
 BufferAllocator::RequestBufferView(VkBuffer buffer)
 {
@@ -44,6 +44,11 @@ public:
 														size_t									size,
 														const std::vector<QueueFamilyIndex>&	owners,
 														VkMemoryPropertyFlags					memPropFlags);
+	// host visible and coherent, stays mapped until the allocator is destroyed
+	std::tuple<VkResult, VkBuffer, void*>			RequestMappedBuffer(
+														VkBufferUsageFlags						usage,
+														size_t									size,
+														const std::vector<QueueFamilyIndex>&	owners);
 
 	void											RequestBufferView(VkBuffer	buffer);
 
@@ -132,10 +132,7 @@ ImageAllocator::RequestImage2D(
 	viewInfo.image = image;
 	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
 	viewInfo.format = requestInfo.format;
-	viewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
-	viewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
-	viewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
-	viewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
+	viewInfo.components = requestInfo.components;
 	viewInfo.subresourceRange.aspectMask = EvaluateImageAspect(requestInfo.layout);
 	viewInfo.subresourceRange.baseMipLevel = 0;
 	viewInfo.subresourceRange.levelCount = requestInfo.mips;
@@ -268,10 +265,7 @@ ImageAllocator::RequestImageCube(
 	viewInfo.image = image;
 	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
 	viewInfo.format = requestInfo.format;
-	viewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
-	viewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
-	viewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
-	viewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
+	viewInfo.components = requestInfo.components;
 	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	viewInfo.subresourceRange.baseMipLevel = 0;
 	viewInfo.subresourceRange.levelCount = requestInfo.mips;
@@ -407,10 +401,7 @@ ImageAllocator::RequestImageArray(
 	viewInfo.image = image;
 	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
 	viewInfo.format = requestInfo.format;
-	viewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
-	viewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
-	viewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
-	viewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
+	viewInfo.components = requestInfo.components;
 	viewInfo.subresourceRange.aspectMask = EvaluateImageAspect(requestInfo.layout);
 	viewInfo.subresourceRange.baseMipLevel = 0;
 	viewInfo.subresourceRange.levelCount = requestInfo.mips;
@@ -435,6 +426,80 @@ ImageAllocator::RequestImageArray(
 	return { VK_SUCCESS, view };
 }
 
+VkResult
+ImageAllocator::WriteImageRegion(
+	AllocationSubmissionID	allocSubID,
+	VkImageView				imageView,
+	const uint8_t*			data,
+	size_t					numBytes,
+	Vec2ui					offset,
+	Vec2ui					extent,
+	const QueueFamilyIndex*	firstOwner,
+	uint32_t				numOwners)
+{
+	auto it = myAllocatedImages.find(imageView);
+	if (it == myAllocatedImages.end())
+	{
+		LOG("tried writing region of unknown image");
+		return VK_ERROR_UNKNOWN;
+	}
+	auto [result, stagingBuffer] = CreateStagingBuffer(data, numBytes, firstOwner, numOwners);
+	if (result)
+	{
+		LOG("failed creating staging buffer for image region");
+		return result;
+	}
+	auto& allocSub = theirAllocationSubmitter[allocSubID];
+	auto cmdBuffer = allocSub.Record();
+	allocSub.AddResourceBuffer(stagingBuffer.buffer, stagingBuffer.memory);
+
+	VkImageSubresourceRange range{};
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.baseMipLevel = 0;
+	range.levelCount = 1;
+	range.baseArrayLayer = 0;
+	range.layerCount = 1;
+
+	// the layout never changes, the barriers only order the copy after earlier work in the submission
+	auto beforeCopy = CreateTransition(it->second.image, range, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+	beforeCopy.srcAccessMask = NULL;
+	beforeCopy.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	auto afterCopy = CreateTransition(it->second.image, range, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+	afterCopy.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	afterCopy.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	VkBufferImageCopy copy{};
+	copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copy.imageSubresource.mipLevel = 0;
+	copy.imageSubresource.baseArrayLayer = 0;
+	copy.imageSubresource.layerCount = 1;
+	copy.imageOffset = {int32_t(offset.x), int32_t(offset.y), 0};
+	copy.imageExtent = {extent.x, extent.y, 1};
+
+	vkCmdPipelineBarrier(cmdBuffer,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		NULL,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		1,
+		&beforeCopy);
+	vkCmdCopyBufferToImage(cmdBuffer, stagingBuffer.buffer, it->second.image, VK_IMAGE_LAYOUT_GENERAL, 1, &copy);
+	vkCmdPipelineBarrier(cmdBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		NULL,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		1,
+		&afterCopy);
+	return VK_SUCCESS;
+}
+
 void
 ImageAllocator::QueueDestroy(
 	VkImageView&& imageView,
@@ -570,6 +635,7 @@ ImageAllocator::EvaluateAccessFlags(
 	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
 		return VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
 
+	case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
 	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
 		return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
 
@@ -13,6 +13,7 @@ struct ImageRequestInfo
 	VkImageLayout					layout				= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 	VkImageUsageFlags				usage				= VK_IMAGE_USAGE_SAMPLED_BIT;
 	VkPipelineStageFlags			targetPipelineStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	VkComponentMapping				components			= {};	// identity
 };
 
 struct AllocatedImage
@@ -53,6 +54,18 @@ public:
 														uint32_t				numLayers, 
 														const ImageRequestInfo& requestInfo);
 
+	// copies into mip 0 of an image kept in general layout
+	// texels outside the region can be sampled by frames in flight meanwhile
+	VkResult										WriteImageRegion(
+														AllocationSubmissionID	allocSubID,
+														VkImageView				imageView,
+														const uint8_t*			data,
+														size_t					numBytes,
+														Vec2ui					offset,
+														Vec2ui					extent,
+														const QueueFamilyIndex*	firstOwner,
+														uint32_t				numOwners);
+
 	void											QueueDestroy(
 														VkImageView&&													imageView,
 														std::shared_ptr<std::counting_semaphore<NumSwapchainImages>>	waitSignal);
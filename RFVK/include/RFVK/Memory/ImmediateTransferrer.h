@@ -23,7 +23,7 @@ private:
 	QueueFamilyIndex	myTransQueueIndex;
 	VkQueue				myImmediateTransQueue;
 
-	concurrency::concurrent_queue<SentCommandBuffer>
+	conc_queue<SentCommandBuffer>
 						myImmediateTransCmdBuffers;
 
 };
\ No newline at end of file
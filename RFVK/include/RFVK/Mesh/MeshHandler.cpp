@@ -9,6 +9,7 @@
 
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Memory/ImageAllocator.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 
 MeshHandler::MeshHandler(
 	VulkanFramework&	vulkanFramework,
@@ -33,7 +34,7 @@ MeshHandler::MeshHandler(
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	poolInfo.pNext = nullptr;
-	poolInfo.flags = NULL;
+	poolInfo.flags = myIsBindless ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : NULL;
 
 	poolInfo.poolSizeCount = 1;
 	poolInfo.pPoolSizes = &poolSize;
@@ -79,6 +80,23 @@ MeshHandler::MeshHandler(
 	layoutInfo.bindingCount = ARRAYSIZE(bindings);
 	layoutInfo.pBindings = bindings;
 
+	// BINDLESS
+	// index buffers are the last binding, its set is allocated with a variable count
+	const VkDescriptorBindingFlags bindingFlags[]
+	{
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT,
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT,
+	};
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = ARRAYSIZE(bindingFlags);
+	bindingFlagsInfo.pBindingFlags = bindingFlags;
+	if (myIsBindless)
+	{
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	}
+
 	failure = vkCreateDescriptorSetLayout(theirVulkanFramework.GetDevice(), &layoutInfo, nullptr, &myMeshDataLayout);
 	assert(!failure && "failed creating mesh data layout");
 
@@ -91,7 +109,17 @@ MeshHandler::MeshHandler(
 	allocInfo.descriptorSetCount = 1;
 	allocInfo.pSetLayouts = &myMeshDataLayout;
 
-	for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+	const uint32_t numIndexBuffers = MaxNumMeshesLoaded;
+	VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+	variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+	variableCountInfo.descriptorSetCount = 1;
+	variableCountInfo.pDescriptorCounts = &numIndexBuffers;
+	if (myIsBindless)
+	{
+		allocInfo.pNext = &variableCountInfo;
+	}
+
+	for (uint32_t swapchainIndex = 0; swapchainIndex < GetNumDescriptorSets(); ++swapchainIndex)
 	{
 		failure = vkAllocateDescriptorSets(theirVulkanFramework.GetDevice(), &allocInfo, &myMeshDataSets[swapchainIndex]);
 		assert(!failure && "failed allocating mesh data set");
@@ -176,7 +204,7 @@ MeshHandler::MeshHandler(
 
 		defaultMesh.vertexInfo = vBuffInfo;
 
-		for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+		for (uint32_t swapchainIndex = 0; swapchainIndex < GetNumDescriptorSets(); ++swapchainIndex)
 		{
 			vWrite.dstSet = myMeshDataSets[swapchainIndex];
 			vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &vWrite, 0, nullptr);
@@ -199,7 +227,7 @@ MeshHandler::MeshHandler(
 
 		defaultMesh.indexInfo = iBuffInfo;
 
-		for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+		for (uint32_t swapchainIndex = 0; swapchainIndex < GetNumDescriptorSets(); ++swapchainIndex)
 		{
 			iWrite.dstSet = myMeshDataSets[swapchainIndex];
 			vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &iWrite, 0, nullptr);
@@ -352,6 +380,13 @@ MeshHandler::operator[](MeshID id) const
 	return myMeshes[int(id)];
 }
 
+uint32_t
+MeshHandler::GetGeneration(
+	MeshID id) const
+{
+	return myMeshIDKeeper.GetGeneration(id);
+}
+
 VkDescriptorSetLayout
 MeshHandler::GetMeshDataLayout()
 {
@@ -361,19 +396,12 @@ MeshHandler::GetMeshDataLayout()
 void
 MeshHandler::BindMeshData(
 	int					swapchainIndex,
-	VkCommandBuffer		cmdBuffer,
+	CommandRecorder&	recorder,
 	VkPipelineLayout	layout,
 	uint32_t			setIndex, 
 	VkPipelineBindPoint bindPoint)
 {
-	vkCmdBindDescriptorSets(cmdBuffer,
-		bindPoint,
-		layout,
-		setIndex,
-		1,
-		&myMeshDataSets[swapchainIndex],
-		0,
-		nullptr);
+	recorder.BindDescriptorSet(bindPoint, layout, setIndex, myMeshDataSets[myIsBindless ? 0 : swapchainIndex]);
 }
 
 neat::static_vector<Vec4f, 64>
@@ -402,7 +430,7 @@ MeshHandler::LoadImagesFromDoc(
 				{
 					const std::string path = member.GetString();
 					const ImageID imgID = theirImageHandler.AddImage2D();
-					theirImageHandler.LoadImage2D(imgID, allocSubID, path);
+					theirImageHandler.LoadImage2DStreamed(imgID, allocSubID, path);
 					imgIDs[meshIndex].x = BAD_ID(imgID) ? float(myMissingImageIDs[0]) : float(imgID);
 				}
 			}
@@ -427,7 +455,7 @@ MeshHandler::LoadImagesFromDoc(
 				{
 					const std::string path = member.GetString();
 					const ImageID imgID = theirImageHandler.AddImage2D();
-					theirImageHandler.LoadImage2D(imgID, allocSubID, path);
+					theirImageHandler.LoadImage2DStreamed(imgID, allocSubID, path);
 					imgIDs[meshIndex].y = BAD_ID(imgID) ? float(myMissingImageIDs[1]) : float(imgID);
 				}
 			}
@@ -452,7 +480,7 @@ MeshHandler::LoadImagesFromDoc(
 				{
 					const std::string path = member.GetString();
 					const ImageID imgID = theirImageHandler.AddImage2D();
-					theirImageHandler.LoadImage2D(imgID, allocSubID, path);
+					theirImageHandler.LoadImage2DStreamed(imgID, allocSubID, path);
 					imgIDs[meshIndex].z = BAD_ID(imgID) ? float(myMissingImageIDs[2]) : float(imgID);
 				}
 			}
@@ -476,7 +504,6 @@ MeshHandler::WriteMeshDescriptorData(
 
 		auto& allocSub = theirBufferAllocator.GetAllocationSubmission(allocSubID);
 		const auto executedEvent = allocSub.GetExecutedEvent();
-		for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
 		{
 			VkWriteDescriptorSet write = {};
 			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -485,14 +512,12 @@ MeshHandler::WriteMeshDescriptorData(
 			write.dstArrayElement = uint32_t(meshID);
 			write.dstBinding = 0;
 			write.pBufferInfo = &myMeshes[uint32_t(meshID)].vertexInfo;
-			write.dstSet = myMeshDataSets[swapchainIndex];
-			QueueDescriptorUpdate(
-				swapchainIndex, 
+			QueueDescriptorUpdates(
+				myMeshDataSets, 
 				executedEvent, 
 				nullptr, 
 				write);
 		}
-		for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
 		{
 			VkWriteDescriptorSet write = {};
 			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -501,9 +526,8 @@ MeshHandler::WriteMeshDescriptorData(
 			write.dstArrayElement = uint32_t(meshID);
 			write.dstBinding = 1;
 			write.pBufferInfo = &myMeshes[uint32_t(meshID)].indexInfo;
-			write.dstSet = myMeshDataSets[swapchainIndex];
-			QueueDescriptorUpdate(
-				swapchainIndex, 
+			QueueDescriptorUpdates(
+				myMeshDataSets, 
 				executedEvent, 
 				nullptr, 
 				write);
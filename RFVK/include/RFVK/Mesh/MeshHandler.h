@@ -35,12 +35,14 @@ public:
 	VkDescriptorSetLayout						GetMeshDataLayout();
 	void										BindMeshData(
 													int					swapchainIndex,
-													VkCommandBuffer		cmdBuffer,
+													class CommandRecorder&	recorder,
 													VkPipelineLayout	layout,
 													uint32_t			setIndex, 
 													VkPipelineBindPoint bindPoint);
 
 	Mesh										operator[](MeshID id) const;
+	// odd while the id is in use, changes every time the id is removed or handed out again
+	_nodiscard uint32_t							GetGeneration(MeshID id) const;
 
 private:
 	neat::static_vector<Vec4f, 64>				LoadImagesFromDoc(
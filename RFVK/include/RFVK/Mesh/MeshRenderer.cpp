@@ -9,8 +9,10 @@
 #include "RFVK/Image/ImageHandler.h"
 #include "RFVK/Uniform/UniformHandler.h"
 #include "RFVK/VulkanFramework.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 #include "RFVK/Pipelines/MeshPipeline.h"
 #include "RFVK/Pipelines/PipelineBuilder.h"
+#include "RFVK/Pipelines/PipelineReloader.h"
 #include "RFVK/RenderPass/RenderPassFactory.h"
 #include "RFVK/Scene/SceneGlobals.h"
 
@@ -30,15 +32,10 @@ MeshRenderer::MeshRenderer(
 		sceneGlobals,
 		familyIndices[QUEUE_FAMILY_GRAPHICS])
 	, theirRenderPassFactory(renderPassFactory)
-	, myInstanceData(new UniformInstances{})
 	, myDeferredRenderPass{}
 
 {
 	myWaitStages.fill(VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT);
-	// INSTANCE DATA
-	myInstanceUniformID = theirUniformHandler.RequestUniformBuffer(myInstanceData.get(),
-																	sizeof UniformInstances);
-	assert(!(BAD_ID(myInstanceUniformID)) && "failed creating matrices uniform");
 
 
 	// RENDER PASS
@@ -71,6 +68,8 @@ MeshRenderer::MeshRenderer(
 		{.color = {0,1,1,0}},
 		{.depthStencil = {1,0}},
 							 });
+	// the gbuffer is only read by the lighting subpass
+	rpBuilder.SetTransient({0,1,2,3,4}, {this, 0, 0});
 
 	rpBuilder.AddSubpass()
 		.SetColorAttachments({0,1,2,3})
@@ -81,14 +80,15 @@ MeshRenderer::MeshRenderer(
 		.SetInputAttachments({0,1,2,3});
 
 
+	// transient memory is shared with earlier passes, depth writes have to wait for them as well
 	rpBuilder.AddSubpassDependency(
 		{
 			VK_SUBPASS_EXTERNAL,
 			0,
-			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
-			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
 		});
 	rpBuilder.AddSubpassDependency(
 		{
@@ -97,14 +97,15 @@ MeshRenderer::MeshRenderer(
 			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
 			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-			VK_ACCESS_SHADER_READ_BIT,
+			VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
 		});
 
+	rpBuilder.SetName("MeshDeferredPass");
 	myDeferredRenderPass = rpBuilder.Build();
 
 	// DEFERRED GEO PIPELINE
 	auto globLayout = theirSceneGlobals.GetGlobalsLayout();
-	auto [instLayout, instSet] = theirUniformHandler[myInstanceUniformID];
+	auto instLayout = theirUniformHandler.GetDynamicUniformLayout();
 
 	char shaderPaths[][128]
 	{
@@ -115,16 +116,21 @@ MeshRenderer::MeshRenderer(
 									  _ARRAYSIZE(shaderPaths),
 									  theirVulkanFramework);
 
-	PipelineBuilder pBuilder(4, myDeferredRenderPass.renderPass, myDeferredGeoShader);
-	pBuilder.DefineVertexInput(&Vertex3DInputInfo)
-		.DefineViewport({w, h}, {0,0,w,h})
-		.SetAllBlendStates(GenBlendState::Disabled);
+	auto constructGeoPipeline = [this, w, h, globLayout, instLayout](Shader* shader)
+	{
+		PipelineBuilder pBuilder(4, myDeferredRenderPass, shader);
+		pBuilder.DefineVertexInput(&Vertex3DInputInfo)
+			.DefineViewport({w, h}, {0,0,w,h})
+			.SetAllBlendStates(GenBlendState::Disabled);
+		return pBuilder.Construct({
+			globLayout,
+			theirImageHandler.GetSamplerSetLayout(),
+			theirImageHandler.GetImageSetLayout(),
+			instLayout}, theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache());
+	};
 	VkResult result;
-	std::tie(result, myDeferredGeoPipeline) = pBuilder.Construct({
-		globLayout,
-		theirImageHandler.GetSamplerSetLayout(),
-		theirImageHandler.GetImageSetLayout(),
-		instLayout}, theirVulkanFramework.GetDevice());
+	std::tie(result, myDeferredGeoPipeline) = constructGeoPipeline(myDeferredGeoShader);
+	theirVulkanFramework.GetPipelineReloader().Register(myDeferredGeoPipeline, *myDeferredGeoShader, 0, constructGeoPipeline);
 
 	// DEFERRED LIGHT PIPELINE
 	char shaderPathsLight[][128]
@@ -132,27 +138,40 @@ MeshRenderer::MeshRenderer(
 		"Shaders/fullscreen_vshader.vert",
 		"Shaders/deferred_light_fshader.frag"
 	};
-	myDeferredGeoShader = new Shader(shaderPathsLight,
+	// a dynamic pass samples the gbuffer instead of reading it as input attachments
+	const ShaderPermutation lightPermutation = myDeferredRenderPass.isDynamic ? 1 : 0;
+	myDeferredLightShader = new Shader(shaderPathsLight,
 									  _ARRAYSIZE(shaderPathsLight),
-									  theirVulkanFramework);
+									  theirVulkanFramework,
+									  {SplitSubpassesFeature},
+									  lightPermutation);
 
-	PipelineBuilder pBuilderGeo(1, myDeferredRenderPass.renderPass, myDeferredGeoShader);
-	pBuilderGeo.DefineVertexInput(nullptr)
-		.DefineViewport({w, h}, {0,0,w,h})
-		.SetAllBlendStates(GenBlendState::Disabled)
-		.SetDepthEnabled(false)
-		.SetSubpass(1);
-
-	std::tie(result, myDeferredLightPipeline) = pBuilderGeo.Construct({
-		globLayout,
-		theirImageHandler.GetSamplerSetLayout(),
-		theirImageHandler.GetImageSetLayout(),
-		myDeferredRenderPass.subpasses[1].inputAttachmentLayout}, theirVulkanFramework.GetDevice());
+	auto constructLightPipeline = [this, w, h, globLayout, lightPermutation](Shader* shader)
+	{
+		PipelineBuilder pBuilderGeo(1, myDeferredRenderPass, shader);
+		pBuilderGeo.DefineVertexInput(nullptr)
+			.DefineViewport({w, h}, {0,0,w,h})
+			.SetPermutation(lightPermutation)
+			.SetAllBlendStates(GenBlendState::Disabled)
+			.SetDepthEnabled(false)
+			.SetSubpass(1);
+
+		return pBuilderGeo.Construct({
+			globLayout,
+			theirImageHandler.GetSamplerSetLayout(),
+			theirImageHandler.GetImageSetLayout(),
+			myDeferredRenderPass.subpasses[1].inputAttachmentLayout}, theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache());
+	};
+	std::tie(result, myDeferredLightPipeline) = constructLightPipeline(myDeferredLightShader);
+	theirVulkanFramework.GetPipelineReloader().Register(myDeferredLightPipeline, *myDeferredLightShader, lightPermutation, constructLightPipeline);
 }
 
 MeshRenderer::~MeshRenderer()
 {
+	theirVulkanFramework.GetPipelineReloader().Unregister(myDeferredGeoPipeline);
+	theirVulkanFramework.GetPipelineReloader().Unregister(myDeferredLightPipeline);
 	SAFE_DELETE(myDeferredGeoShader);
+	SAFE_DELETE(myDeferredLightShader);
 }
 
 neat::static_vector<WorkerSubmission, MaxWorkerSubmissions>
@@ -169,6 +188,19 @@ MeshRenderer::RecordSubmit(
 
 	static std::array<std::pair<uint32_t, uint32_t>, MaxNumMeshesLoaded> instanceControl;
 	instanceControl = {};
+	static std::array<float, MaxNumMeshesLoaded> screenSizes;
+	screenSizes = {};
+
+	// INSTANCE DATA
+	// only what is drawn this frame, written straight into the frame's uniform space
+	auto [instanceData, instanceOffset] = theirUniformHandler.AllocateDynamicUniform(
+		swapchainImageIndex,
+		assembledWork.size() * sizeof(Instance));
+	auto* instances = static_cast<Instance*>(instanceData);
+	if (!instances)
+	{
+		assembledWork.clear();
+	}
 
 	MeshID currentID = MeshID(INVALID_ID);
 	uint32_t index = 0;
@@ -181,13 +213,29 @@ MeshRenderer::RecordSubmit(
 		}
 		++instanceControl[int(currentID)].second;
 
-		myInstanceData->instances[index].mat = cmd.transform;
-		myInstanceData->instances[index].objID = uint32_t(cmd.id);
+		instances[index].mat = cmd.transform;
+		instances[index].objID = uint32_t(cmd.id);
+		screenSizes[int(cmd.id)] = std::max(screenSizes[int(cmd.id)], theirSceneGlobals.EstimateScreenSize(cmd.transform));
 
 		index++;
 	}
 
-	theirUniformHandler.UpdateUniformData(myInstanceUniformID, myInstanceData.get());
+	// TEXTURE STREAMING
+	auto& textureStreamer = theirImageHandler.GetTextureStreamer();
+	for (uint32_t meshIndex = 0; meshIndex < MaxNumMeshesLoaded; ++meshIndex)
+	{
+		if (instanceControl[meshIndex].second == 0)
+		{
+			continue;
+		}
+		const uint32_t screenDim = uint32_t(screenSizes[meshIndex]);
+		for (auto& ids : theirMeshHandler[MeshID(meshIndex)].imageIDs)
+		{
+			textureStreamer.RequestResolution(ImageID(ids.x), screenDim);
+			textureStreamer.RequestResolution(ImageID(ids.y), screenDim);
+			textureStreamer.RequestResolution(ImageID(ids.z), screenDim);
+		}
+	}
 
 
 	// RECORD
@@ -205,19 +253,20 @@ MeshRenderer::RecordSubmit(
 	beginInfo.pInheritanceInfo = nullptr;
 
 	auto resultBegin = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+	CommandRecorder recorder(cmdBuffer);
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
 	BeginRenderPass(cmdBuffer,
 		myDeferredRenderPass,
 		swapchainImageIndex,
 		{0,0,w,h});
 
-	vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, myDeferredGeoPipeline.pipeline);
+	recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, myDeferredGeoPipeline.pipeline);
 
 	// DESCRIPTORS
-	theirSceneGlobals.BindGlobals(cmdBuffer, myDeferredGeoPipeline.layout, 0);
-	theirImageHandler.BindSamplers(cmdBuffer, myDeferredGeoPipeline.layout, 1);
-	theirImageHandler.BindImages(swapchainImageIndex, cmdBuffer, myDeferredGeoPipeline.layout, 2);
-	theirUniformHandler.BindUniform(myInstanceUniformID, cmdBuffer, myDeferredGeoPipeline.layout, 3);
+	theirSceneGlobals.BindGlobals(recorder, myDeferredGeoPipeline.layout, 0);
+	theirImageHandler.BindSamplers(recorder, myDeferredGeoPipeline.layout, 1);
+	theirImageHandler.BindImages(swapchainImageIndex, recorder, myDeferredGeoPipeline.layout, 2);
+	theirUniformHandler.BindDynamicUniform(instanceOffset, recorder, myDeferredGeoPipeline.layout, 3);
 
 	// MESHES
 	for (uint32_t i = 0; i < assembledWork.size();)
@@ -232,18 +281,19 @@ MeshRenderer::RecordSubmit(
 		i += num;
 	}
 
-	vkCmdNextSubpass(cmdBuffer, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, myDeferredLightPipeline.pipeline);
+	NextSubpass(cmdBuffer, myDeferredRenderPass, swapchainImageIndex);
+	recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, myDeferredLightPipeline.pipeline);
 
-	theirSceneGlobals.BindGlobals(cmdBuffer, myDeferredGeoPipeline.layout, 0);
-	theirImageHandler.BindSamplers(cmdBuffer, myDeferredGeoPipeline.layout, 1);
-	theirImageHandler.BindImages(swapchainImageIndex, cmdBuffer, myDeferredGeoPipeline.layout, 2);
+	// already bound by the geometry subpass, the recorder skips them
+	theirSceneGlobals.BindGlobals(recorder, myDeferredGeoPipeline.layout, 0);
+	theirImageHandler.BindSamplers(recorder, myDeferredGeoPipeline.layout, 1);
+	theirImageHandler.BindImages(swapchainImageIndex, recorder, myDeferredGeoPipeline.layout, 2);
 
-	BindSubpassInputs(cmdBuffer, myDeferredLightPipeline.layout, 3, myDeferredRenderPass.subpasses[1], swapchainImageIndex);
+	BindSubpassInputs(recorder, myDeferredLightPipeline.layout, 3, myDeferredRenderPass.subpasses[1], swapchainImageIndex);
 
 	vkCmdDraw(cmdBuffer, 6, 1, 0, 0);
 
-	vkCmdEndRenderPass(cmdBuffer);
+	EndRenderPass(cmdBuffer, myDeferredRenderPass, swapchainImageIndex);
 
 	auto resultEnd = vkEndCommandBuffer(cmdBuffer);
 
@@ -274,3 +324,12 @@ std::vector<rflx::Features> MeshRenderer::GetImplementedFeatures() const
 {
     return {rflx::Features::FEATURE_DEFERRED};
 }
+
+std::vector<ResourceUse> MeshRenderer::GetResourceUses() const
+{
+	// the gbuffer lives and dies inside the deferred pass, only its lit result leaves it
+	return {
+		theirImageHandler.GetImagesUse(ResourceAccess::Read),
+		theirRenderPassFactory.GetIntermediateUse(ResourceAccess::Write),
+		theirRenderPassFactory.GetTransientUse()};
+}
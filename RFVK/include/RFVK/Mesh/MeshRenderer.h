@@ -11,11 +11,9 @@ struct Instance
 	Vec3f		padding0;
 	uint32_t	objID;
 };
-static_assert(128 > sizeof Instance);
-struct UniformInstances
-{
-	Instance instances[MaxNumInstances];
-};
+static_assert(128 > sizeof(Instance));
+// the shader declares the full array, a dynamic uniform must be able to bind all of it
+static_assert(MaxNumInstances * sizeof(Instance) <= MaxDynamicUniformRange);
 
 class MeshRenderer final : public MeshRendererBase
 {
@@ -37,15 +35,15 @@ public:
 											const neat::static_vector<VkSemaphore, MaxWorkerSubmissions>& signalSemaphores) override;
 	std::vector<rflx::Features>			GetImplementedFeatures() const override;
 	int									GetSubmissionCount() override { return 1; }
+	std::vector<ResourceUse>			GetResourceUses() const override;
+	const char*							GetName() const override { return "MeshRenderer"; }
 
 private:
 	RenderPassFactory&					theirRenderPassFactory;
 	//const VkPipelineStageFlags			myWaitStage = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
 	std::array<VkPipelineStageFlags, MaxWorkerSubmissions>				
 										myWaitStages;
-	
-	std::unique_ptr<UniformInstances>	myInstanceData;
-	UniformID							myInstanceUniformID = UniformID(INVALID_ID);
+
 
 	RenderPass							myDeferredRenderPass;
 
@@ -1,2 +1,5 @@
 
 #pragma once
+
+// bit i enables the i:th feature key a shader declared
+typedef uint32_t ShaderPermutation;
@@ -2,10 +2,14 @@
 
 // NUMBERS
 constexpr int	NumSwapchainImages = 3;
-constexpr char	FirstFontGlyph = ' ';
-constexpr char	LastFontGlyph = '~';
-static_assert(FirstFontGlyph < LastFontGlyph);
-constexpr int	NumGlyphsPerFont = LastFontGlyph + 1 - FirstFontGlyph;
+constexpr int	GlyphPixelSizes[] = {16, 24, 32, 48, 64, 96, 128};
+
+// PATHS
+constexpr char	PipelineCachePath[] = "pipeline_cache.bin";
+constexpr char	ShaderDirectory[] = "Shaders/";
+constexpr char	ShaderCachePath[] = "Shaders/Cached/shader_cache.bin";
+constexpr char	ShaderBundlePath[] = "Shaders/shader_bundle.bin";
+constexpr char	ShaderPermutationsPath[] = "Shaders/shader_permutations.txt";
 
 // INDICES
 //	SHADER SET BINDINGS
@@ -26,6 +30,8 @@ constexpr int	MaxNumStorageImages = 8;
 constexpr int	MaxNumSamplers = 16;
 constexpr int	MaxNumUniforms = 128;
 constexpr int	MaxNumFonts = 128;
+constexpr int	MaxNumAtlasImages = 4096;
+constexpr int	MaxNumTextLayouts = 1024;
 
 constexpr int	MaxNumShaderModulesPerShader = 8;
 
@@ -33,7 +39,56 @@ constexpr int	MaxNumShaderModulesPerShader = 8;
 constexpr int	MaxNumInstances = 512;
 constexpr int	MaxNumInstanceStructures = 8;
 constexpr int	MaxNumSpriteInstances = 1024;
+constexpr int	MaxNumSDFSpriteInstances = 512;
+constexpr int	MaxDynamicUniformBytesPerFrame = kB(512);
+constexpr int	MaxDynamicUniformRange = kB(64);
 
 constexpr int	MaxNumTransfers = 128;
 constexpr int	MaxNumImmediateTransfers = 32;
 
+//	TEXT
+constexpr int		GlyphPageDim = 1024;
+constexpr int		MaxNumGlyphPages = 4;
+constexpr int		GlyphPadding = 1;
+constexpr int		SDFGlyphPixelSize = 48;
+constexpr int		SDFSpread = 6;
+constexpr int		SDFOversampling = 4;
+// sprite_sdf_fshader.frag's SDF_SPREAD, the plain sprite shaders don't declare it
+constexpr uint32_t	SDFSpreadConstantID = 0;
+constexpr int		TextLayoutLifetime = 240;
+
+//	ATLAS
+constexpr int		AtlasPageDim = 2048;
+constexpr int		AtlasPadding = 1;
+
+//	STREAMING
+constexpr int		StreamingMipTailDim = 64;
+constexpr int		MaxNumStreamsPerFrame = 4;
+constexpr uint64_t	DefaultStreamingBudget = mB(512ull);
+
+//	SHADERS
+constexpr int		ShaderReloadSettleMs = 100;
+
+// RENDERING
+//	SUBPASSES
+// set for fragment shaders of subpasses reading input attachments when their pass is recorded with dynamic rendering
+// inputs are declared with SUBPASS_INPUTS(set, name, count) and read with SUBPASS_LOAD(name[index]) either way
+constexpr char		SplitSubpassesFeature[] = "SPLIT_SUBPASSES";
+// off until deferred_light_fshader.frag and present_fshader.frag declare their inputs through SUBPASS_INPUTS
+// while off, passes with subpasses reading input attachments keep render pass objects under dynamic rendering
+constexpr bool		SplitSubpasses = false;
+
+//	PERMUTATIONS
+// every feature key a renderer constructs each stage with, ShaderCompiler bundles all their combinations
+// release builds only load from the bundle, so a Shader declaring a key missing here asserts
+struct ShaderStageFeatures
+{
+	const char*	path;
+	const char*	features[1];
+};
+constexpr ShaderStageFeatures DeclaredShaderFeatures[]
+{
+	{"Shaders/fullscreen_vshader.vert",			{SplitSubpassesFeature}},
+	{"Shaders/deferred_light_fshader.frag",		{SplitSubpassesFeature}},
+	{"Shaders/present_fshader.frag",			{SplitSubpassesFeature}},
+};
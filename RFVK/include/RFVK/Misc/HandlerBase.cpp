@@ -5,12 +5,20 @@
 HandlerBase::HandlerBase(
 	VulkanFramework& vulkanFramework)
 	: theirVulkanFramework(vulkanFramework)
+	, myIsBindless(vulkanFramework.IsBindless())
 {
 	myFailedWrites.reserve(myMaxUpdates);
+	myReadyWrites.reserve(myMaxUpdates);
 }
 
-void HandlerBase::UpdateDescriptors(int swapchainIndex, VkFence fence)
+void HandlerBase::UpdateDescriptors(int swapchainIndex, const std::array<VkFence, NumSwapchainImages>& frameFences)
 {
+	if (myIsBindless)
+	{
+		UpdateBindlessDescriptors(frameFences);
+		return;
+	}
+	VkFence fence = frameFences[swapchainIndex];
 	if (myQueuedDescriptorWrites[swapchainIndex].empty())
 	{
 		return;
@@ -60,3 +68,89 @@ HandlerBase::QueueDescriptorUpdate(
 	queued.doneSignal	= std::move(doneSignal);
 	myQueuedDescriptorWrites[swapchainIndex].push(queued);
 }
+
+void
+HandlerBase::QueueDescriptorUpdates(
+	const std::array<VkDescriptorSet, NumSwapchainImages>&
+								sets,
+	std::shared_ptr<VkEvent>	waitEvent,
+	std::shared_ptr<std::counting_semaphore<NumSwapchainImages>>
+								doneSignal,
+	VkWriteDescriptorSet		write)
+{
+	if (myIsBindless)
+	{
+		QueuedDescriptorWrite queued;
+		queued.waitEvent	= std::move(waitEvent);
+		queued.write		= write;
+		queued.write.dstSet	= sets[0];
+		queued.doneSignal	= std::move(doneSignal);
+		myQueuedBindlessWrites.push(queued);
+		return;
+	}
+	for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+	{
+		write.dstSet = sets[swapchainIndex];
+		QueueDescriptorUpdate(
+			swapchainIndex,
+			waitEvent,
+			doneSignal,
+			write);
+	}
+}
+
+uint32_t
+HandlerBase::GetNumDescriptorSets() const
+{
+	return myIsBindless ? 1 : NumSwapchainImages;
+}
+
+void
+HandlerBase::UpdateBindlessDescriptors(
+	const std::array<VkFence, NumSwapchainImages>& frameFences)
+{
+	// GATHER
+	QueuedDescriptorWrite queuedWrite;
+	int count = 0;
+	while (count++ < myMaxUpdates
+		&& myQueuedBindlessWrites.try_pop(queuedWrite))
+	{
+		if (queuedWrite.waitEvent && *queuedWrite.waitEvent)
+		{
+			if (vkGetEventStatus(theirVulkanFramework.GetDevice(), *queuedWrite.waitEvent) != VK_EVENT_SET)
+			{
+				myFailedWrites.emplace_back(queuedWrite);
+				continue;
+			}
+		}
+		myReadyWrites.emplace_back(queuedWrite);
+	}
+
+	for (auto& again : myFailedWrites)
+	{
+		myQueuedBindlessWrites.push(again);
+	}
+	myFailedWrites.clear();
+
+	if (myReadyWrites.empty())
+	{
+		return;
+	}
+
+	// WRITE
+	// update after bind only allows writing descriptors no pending command buffer uses, and every frame
+	// in flight may read the slots being replaced, so they all finish first. fences are only reset right
+	// before their submission, so none of them can be waited on without work behind it
+	vkWaitForFences(theirVulkanFramework.GetDevice(), NumSwapchainImages, frameFences.data(), VK_TRUE, UINT64_MAX);
+	for (auto& readyWrite : myReadyWrites)
+	{
+		vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &readyWrite.write, 0, nullptr);
+
+		// no frame in flight is left to read what the write replaced
+		if (readyWrite.doneSignal)
+		{
+			readyWrite.doneSignal->release(NumSwapchainImages);
+		}
+	}
+	myReadyWrites.clear();
+}
\ No newline at end of file
@@ -14,9 +14,11 @@ class HandlerBase
 public:
 								HandlerBase(class VulkanFramework& vulkanFramework);
 	
+	// frameFences cover every frame in flight, a bindless update waits for all of them
 	void						UpdateDescriptors(
 									int							swapchainIndex,
-									VkFence						fence);
+									const std::array<VkFence, NumSwapchainImages>&
+																frameFences);
 	void
 								QueueDescriptorUpdate(
 									int							swapchainIndex,
@@ -24,12 +26,30 @@ public:
 									std::shared_ptr<std::counting_semaphore<NumSwapchainImages>>	
 																doneSignal,
 									VkWriteDescriptorSet		write);
+	// writes each frame's copy of a set, or the single set once when bindless
+	void						QueueDescriptorUpdates(
+									const std::array<VkDescriptorSet, NumSwapchainImages>&
+																sets,
+									std::shared_ptr<VkEvent>	waitEvent, 
+									std::shared_ptr<std::counting_semaphore<NumSwapchainImages>>	
+																doneSignal,
+									VkWriteDescriptorSet		write);
+
 protected:
+	_nodiscard uint32_t			GetNumDescriptorSets() const;
+
 	VulkanFramework&			theirVulkanFramework;
+	const bool					myIsBindless;
 
 private:
+	void						UpdateBindlessDescriptors(const std::array<VkFence, NumSwapchainImages>& frameFences);
+
 	std::array<conc_queue<QueuedDescriptorWrite>, NumSwapchainImages>
 								myQueuedDescriptorWrites;
+	conc_queue<QueuedDescriptorWrite>
+								myQueuedBindlessWrites;
+	std::vector<QueuedDescriptorWrite>
+								myReadyWrites;
 	
 	const int					myMaxUpdates = 128;
 	std::vector<QueuedDescriptorWrite>	myFailedWrites;
@@ -16,6 +16,8 @@ enum class UniformID;
 enum class GeoStructID;
 enum class InstanceStructID;
 enum class FontID;
+enum class AtlasImageID;
+enum class TextLayoutID;
 enum class AllocationSubmissionID;
 
 enum QueueFamilyType
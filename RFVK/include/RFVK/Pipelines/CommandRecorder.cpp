@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "CommandRecorder.h"
+
+std::atomic<uint32_t> CommandRecorder::ourNumBindsRequested = 0;
+std::atomic<uint32_t> CommandRecorder::ourNumBindsRecorded = 0;
+
+CommandRecorder::CommandRecorder(
+	VkCommandBuffer commandBuffer)
+	: myCommandBuffer(commandBuffer)
+{
+}
+
+CommandRecorder::operator VkCommandBuffer() const
+{
+	return myCommandBuffer;
+}
+
+void
+CommandRecorder::BindPipeline(
+	VkPipelineBindPoint	bindPoint,
+	VkPipeline			pipeline)
+{
+	auto& bound = myBoundPipelines[BindPointIndex(bindPoint)];
+	if (bound == pipeline)
+	{
+		return;
+	}
+	bound = pipeline;
+	vkCmdBindPipeline(myCommandBuffer, bindPoint, pipeline);
+}
+
+void
+CommandRecorder::BindDescriptorSet(
+	VkPipelineBindPoint	bindPoint,
+	VkPipelineLayout	layout,
+	uint32_t			setIndex,
+	VkDescriptorSet		set)
+{
+	RecordDescriptorSet(bindPoint, layout, setIndex, set, nullptr);
+}
+
+void
+CommandRecorder::BindDescriptorSet(
+	VkPipelineBindPoint	bindPoint,
+	VkPipelineLayout	layout,
+	uint32_t			setIndex,
+	VkDescriptorSet		set,
+	uint32_t			dynamicOffset)
+{
+	RecordDescriptorSet(bindPoint, layout, setIndex, set, &dynamicOffset);
+}
+
+void
+CommandRecorder::PushConstants(
+	VkPipelineLayout	layout,
+	VkShaderStageFlags	stages,
+	uint32_t			offset,
+	uint32_t			size,
+	const void*			data)
+{
+	vkCmdPushConstants(myCommandBuffer, layout, stages, offset, size, data);
+}
+
+void
+CommandRecorder::RecordDescriptorSet(
+	VkPipelineBindPoint	bindPoint,
+	VkPipelineLayout	layout,
+	uint32_t			setIndex,
+	VkDescriptorSet		set,
+	const uint32_t*		dynamicOffset)
+{
+	assert(setIndex < MaxNumBoundSets && "descriptor set index out of range");
+	++ourNumBindsRequested;
+
+	const uint32_t offset = dynamicOffset ? *dynamicOffset : 0;
+	auto& boundSets = myBoundSets[BindPointIndex(bindPoint)];
+	if (boundSets[setIndex].layout == layout
+		&& boundSets[setIndex].set == set
+		&& boundSets[setIndex].dynamicOffset == offset)
+	{
+		return;
+	}
+
+	// binding through another layout may disturb the other sets, only trust those bound through this one
+	for (auto& bound : boundSets)
+	{
+		if (bound.layout != layout)
+		{
+			bound = {};
+		}
+	}
+	boundSets[setIndex] = {layout, set, offset};
+
+	++ourNumBindsRecorded;
+	vkCmdBindDescriptorSets(myCommandBuffer,
+							bindPoint,
+							layout,
+							setIndex,
+							1,
+							&set,
+							dynamicOffset ? 1 : 0,
+							dynamicOffset);
+}
+
+BindCounts
+CommandRecorder::FetchBindCounts()
+{
+	BindCounts counts;
+	counts.requested = ourNumBindsRequested.exchange(0);
+	counts.recorded = ourNumBindsRecorded.exchange(0);
+	return counts;
+}
+
+uint32_t
+CommandRecorder::BindPointIndex(
+	VkPipelineBindPoint bindPoint)
+{
+	switch (bindPoint)
+	{
+		case VK_PIPELINE_BIND_POINT_GRAPHICS: return 0;
+		case VK_PIPELINE_BIND_POINT_COMPUTE: return 1;
+		case VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR: return 2;
+		default: assert(false && "invalid pipeline bind point");
+	}
+	return 0;
+}
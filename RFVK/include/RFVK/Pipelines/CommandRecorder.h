@@ -0,0 +1,70 @@
+#pragma once
+
+struct BindCounts
+{
+	uint32_t	requested = 0;
+	uint32_t	recorded = 0;
+};
+
+// wraps a command buffer while it records, binds already in place are not recorded again
+class CommandRecorder
+{
+public:
+	explicit							CommandRecorder(VkCommandBuffer commandBuffer);
+
+										operator VkCommandBuffer() const;
+
+	void								BindPipeline(
+											VkPipelineBindPoint	bindPoint,
+											VkPipeline			pipeline);
+	void								BindDescriptorSet(
+											VkPipelineBindPoint	bindPoint,
+											VkPipelineLayout	layout,
+											uint32_t			setIndex,
+											VkDescriptorSet		set);
+	// for sets with one dynamic uniform, a new offset rebinds the same set
+	void								BindDescriptorSet(
+											VkPipelineBindPoint	bindPoint,
+											VkPipelineLayout	layout,
+											uint32_t			setIndex,
+											VkDescriptorSet		set,
+											uint32_t			dynamicOffset);
+	void								PushConstants(
+											VkPipelineLayout	layout,
+											VkShaderStageFlags	stages,
+											uint32_t			offset,
+											uint32_t			size,
+											const void*			data);
+
+	// descriptor set binds since the last call, across every recorder
+	static BindCounts					FetchBindCounts();
+
+private:
+	static constexpr uint32_t			NumBindPoints = 3;
+	static constexpr uint32_t			MaxNumBoundSets = 8;
+
+	struct BoundSet
+	{
+		VkPipelineLayout	layout = nullptr;
+		VkDescriptorSet		set = nullptr;
+		uint32_t			dynamicOffset = 0;
+	};
+
+	void								RecordDescriptorSet(
+											VkPipelineBindPoint	bindPoint,
+											VkPipelineLayout	layout,
+											uint32_t			setIndex,
+											VkDescriptorSet		set,
+											const uint32_t*		dynamicOffset);
+	static uint32_t						BindPointIndex(VkPipelineBindPoint bindPoint);
+
+	VkCommandBuffer						myCommandBuffer;
+	std::array<VkPipeline, NumBindPoints>
+										myBoundPipelines = {};
+	std::array<std::array<BoundSet, MaxNumBoundSets>, NumBindPoints>
+										myBoundSets = {};
+
+	static std::atomic<uint32_t>		ourNumBindsRequested;
+	static std::atomic<uint32_t>		ourNumBindsRecorded;
+
+};
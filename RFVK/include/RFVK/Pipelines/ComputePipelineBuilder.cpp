@@ -18,7 +18,8 @@ ComputePipelineBuilder::AddShader(
 
 std::tuple<VkResult, Pipeline>
 ComputePipelineBuilder::Construct(
-	VkDevice device) const
+	VkDevice		device,
+	VkPipelineCache	pipelineCache) const
 {
 	Pipeline pipeline = {};
 	VkPipelineLayoutCreateInfo layoutCreateInfo = {};
@@ -41,7 +42,7 @@ ComputePipelineBuilder::Construct(
 	assert(boundModules.numModules == 1 && "compute pipeline only accepts one shader module");
 	pipelineCreateInfo.stage = boundModules.modules[0];
 
-	result = vkCreateComputePipelines(device, nullptr, 1, &pipelineCreateInfo, nullptr, &pipeline.pipeline);
+	result = vkCreateComputePipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline.pipeline);
 
 	return {result, pipeline};
 }
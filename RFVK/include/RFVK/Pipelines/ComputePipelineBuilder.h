@@ -8,7 +8,9 @@ public:
 										VkDescriptorSetLayout setLayout);
 	void							AddShader(
 										const std::shared_ptr<class Shader>& shader);
-	std::tuple<VkResult, Pipeline>	Construct(VkDevice device) const;
+	std::tuple<VkResult, Pipeline>	Construct(
+										VkDevice		device,
+										VkPipelineCache	pipelineCache) const;
 private:
 	std::vector<VkDescriptorSetLayout>	myDescriptorSets;
 	std::shared_ptr<class Shader> 		myShader;
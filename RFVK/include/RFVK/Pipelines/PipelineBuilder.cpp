@@ -5,10 +5,10 @@
 #include "RFVK/Shader/Shader.h"
 
 PipelineBuilder::PipelineBuilder(
-	unsigned		numColAttachments, 
-	VkRenderPass	renderPass, 
-	Shader*			shaderPtr)
-	: myRenderPass(renderPass)
+	unsigned			numColAttachments, 
+	const RenderPass&	renderPass, 
+	Shader*				shaderPtr)
+	: theirRenderPass(renderPass)
 	, myShaderPtr(shaderPtr)
 	, myInputAssemblyInfo{}
 	, myVertexInputInfoPtr(nullptr)
@@ -180,6 +180,49 @@ PipelineBuilder::SetSubpass(uint32_t subpassIndex)
 	return *this;
 }
 
+PipelineBuilder& 
+PipelineBuilder::SetPermutation(ShaderPermutation permutation)
+{
+	myPermutation = permutation;
+
+	return *this;
+}
+
+PipelineBuilder& 
+PipelineBuilder::SetSpecializationConstant(
+	uint32_t constantID,
+	uint32_t value)
+{
+	for (const auto& entry : mySpecializationEntries)
+	{
+		if (entry.constantID == constantID)
+		{
+			mySpecializationData[entry.offset / sizeof(uint32_t)] = value;
+			return *this;
+		}
+	}
+
+	VkSpecializationMapEntry entry{};
+	entry.constantID = constantID;
+	entry.offset = uint32_t(mySpecializationData.size() * sizeof(uint32_t));
+	entry.size = sizeof(uint32_t);
+	mySpecializationEntries.emplace_back(entry);
+	mySpecializationData.emplace_back(value);
+
+	return *this;
+}
+
+PipelineBuilder& 
+PipelineBuilder::AddPushConstantRange(
+	VkShaderStageFlags	stages,
+	uint32_t			offset,
+	uint32_t			size)
+{
+	myPushConstantRanges.push_back({stages, offset, size});
+
+	return *this;
+}
+
 PipelineBuilder& 
 PipelineBuilder::DefineViewport(
 	Vec2f resolution, 
@@ -210,10 +253,19 @@ PipelineBuilder::DefineViewport(
 	return *this;
 }
 
+PipelineBuilder& 
+PipelineBuilder::SetDynamicViewport()
+{
+	myHasDynamicViewport = true;
+
+	return *this;
+}
+
 std::tuple<VkResult, Pipeline>
 PipelineBuilder::Construct(
 	std::vector<VkDescriptorSetLayout>&&	descriptorSets, 
-	VkDevice								device) const
+	VkDevice								device,
+	VkPipelineCache							pipelineCache) const
 {
 	Pipeline retPipeline{};
 
@@ -232,6 +284,8 @@ PipelineBuilder::Construct(
 
 	layoutInfo.pSetLayouts = descriptorSets.data();
 	layoutInfo.setLayoutCount = descriptorSets.size();
+	layoutInfo.pPushConstantRanges = myPushConstantRanges.data();
+	layoutInfo.pushConstantRangeCount = uint32_t(myPushConstantRanges.size());
 
 	auto result = vkCreatePipelineLayout(device, &layoutInfo, nullptr, &retPipeline.layout);
 	if (result)
@@ -244,10 +298,55 @@ PipelineBuilder::Construct(
 	VkGraphicsPipelineCreateInfo pipelineInfo{};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 
-	pipelineInfo.renderPass = myRenderPass;
+	pipelineInfo.renderPass = theirRenderPass.renderPass;
 	pipelineInfo.layout = retPipeline.layout;
+	pipelineInfo.subpass = mySubpassIndex;
+
+	// DYNAMIC RENDERING
+	// formats stand in for the render pass, compatible with any pass rendering to the same formats
+	VkPipelineRenderingCreateInfo renderingInfo{};
+	std::array<VkFormat, MaxNumAttachments> colorFormats{};
+	if (theirRenderPass.isDynamic)
+	{
+		auto& subpass = theirRenderPass.dynamicSubpasses[mySubpassIndex];
+		for (uint32_t colorIndex = 0; colorIndex < subpass.numColorAttachments; ++colorIndex)
+		{
+			colorFormats[colorIndex] = theirRenderPass.attachments[subpass.colorAttachments[colorIndex]].format;
+		}
+
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+		renderingInfo.colorAttachmentCount = subpass.numColorAttachments;
+		renderingInfo.pColorAttachmentFormats = colorFormats.data();
+		if (subpass.depthAttachment != VK_ATTACHMENT_UNUSED)
+		{
+			auto& depth = theirRenderPass.attachments[subpass.depthAttachment];
+			renderingInfo.depthAttachmentFormat = depth.format;
+			if (depth.range.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
+			{
+				renderingInfo.stencilAttachmentFormat = depth.format;
+			}
+		}
+
+		pipelineInfo.pNext = &renderingInfo;
+		pipelineInfo.renderPass = nullptr;
+		pipelineInfo.subpass = 0;
+	}
+
+	auto [stages, numStages] = myShaderPtr->Bind(myPermutation);
+
+	VkSpecializationInfo specializationInfo{};
+	specializationInfo.mapEntryCount = uint32_t(mySpecializationEntries.size());
+	specializationInfo.pMapEntries = mySpecializationEntries.data();
+	specializationInfo.dataSize = mySpecializationData.size() * sizeof(uint32_t);
+	specializationInfo.pData = mySpecializationData.data();
+	if (!mySpecializationEntries.empty())
+	{
+		for (uint32_t i = 0; i < numStages; ++i)
+		{
+			stages[i].pSpecializationInfo = &specializationInfo;
+		}
+	}
 
-	auto [stages, numStages] = myShaderPtr->Bind();
 	pipelineInfo.pStages = stages.data();
 	pipelineInfo.stageCount = numStages;
 
@@ -259,9 +358,21 @@ PipelineBuilder::Construct(
 	pipelineInfo.pDepthStencilState = &myDepthStencilInfo;
 	pipelineInfo.pColorBlendState = &myBlendInfo;
 
-	pipelineInfo.subpass = mySubpassIndex;
+	VkDynamicState dynamicStates[]
+	{
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+	VkPipelineDynamicStateCreateInfo dynamicInfo{};
+	dynamicInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicInfo.dynamicStateCount = _ARRAYSIZE(dynamicStates);
+	dynamicInfo.pDynamicStates = dynamicStates;
+	if (myHasDynamicViewport)
+	{
+		pipelineInfo.pDynamicState = &dynamicInfo;
+	}
 
-	result = vkCreateGraphicsPipelines(device, nullptr, 1, &pipelineInfo, nullptr, &retPipeline.pipeline);
+	result = vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &retPipeline.pipeline);
 	if (result)
 	{
 		LOG("failed creating pipeline");
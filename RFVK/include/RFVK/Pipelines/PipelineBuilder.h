@@ -1,5 +1,6 @@
 #pragma once
 #include "Pipeline.h"
+#include "RFVK/RenderPass/RenderPass.h"
 
 enum class GenBlendState
 {
@@ -12,7 +13,7 @@ class PipelineBuilder
 {
 public:
 	PipelineBuilder(unsigned numColAttachments,
-						 VkRenderPass renderPass,
+						 const RenderPass& renderPass,
 						 class Shader* shaderPtr);
 	~PipelineBuilder();
 
@@ -20,6 +21,8 @@ public:
 	PipelineBuilder&	DefineViewport(
 							Vec2f resolution, 
 							Vec4f scissor);
+	// viewport and scissor are taken from BeginRenderPass, one pipeline serves every resolution
+	PipelineBuilder&	SetDynamicViewport();
 
 	PipelineBuilder&	SetPrimitiveTopology(VkPrimitiveTopology primitiveTopology);
 	PipelineBuilder&	SetMultisampleCount(unsigned count);
@@ -34,13 +37,25 @@ public:
 	PipelineBuilder&	SetAllBlendStates(GenBlendState blendState);
 	PipelineBuilder&	SetSubpass(uint32_t subpassIndex);
 
+	PipelineBuilder&	SetPermutation(ShaderPermutation permutation);
+	// constants unused by a stage are ignored by it, so one set serves every stage
+	PipelineBuilder&	SetSpecializationConstant(
+							uint32_t constantID,
+							uint32_t value);
+	// small per-draw data written with CommandRecorder::PushConstants, no descriptor needed
+	PipelineBuilder&	AddPushConstantRange(
+							VkShaderStageFlags	stages,
+							uint32_t			offset,
+							uint32_t			size);
+
 	_NODISCARD std::tuple<VkResult, Pipeline>
 						Construct(
 							std::vector<VkDescriptorSetLayout>&&	descriptorSets, 
-							VkDevice								device) const;
+							VkDevice								device,
+							VkPipelineCache							pipelineCache) const;
 
 private:
-	VkRenderPass		myRenderPass;
+	const RenderPass&	theirRenderPass;
 	class Shader*		myShaderPtr;
 
 	bool				myHasSetVertexInput = false;
@@ -50,6 +65,7 @@ private:
 						myInputAssemblyInfo;
 
 	bool				myHasSetViewport = false;
+	bool				myHasDynamicViewport = false;
 	VkRect2D			myScissor;
 	VkViewport			myViewport;
 	VkPipelineViewportStateCreateInfo
@@ -68,5 +84,14 @@ private:
 
 	uint32_t			mySubpassIndex = 0;
 
+	ShaderPermutation	myPermutation = 0;
+	std::vector<VkSpecializationMapEntry>
+						mySpecializationEntries;
+	std::vector<uint32_t>
+						mySpecializationData;
+
+	std::vector<VkPushConstantRange>
+						myPushConstantRanges;
+
 };
 
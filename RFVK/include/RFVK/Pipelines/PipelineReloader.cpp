@@ -0,0 +1,339 @@
+#include "pch.h"
+#include "PipelineReloader.h"
+
+#include "RFVK/Shader/Shader.h"
+#include "RFVK/Shader/ShaderCache.h"
+#include "RFVK/VulkanFramework.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+PipelineReloader::PipelineReloader(
+	VulkanFramework& vulkanFramework)
+	: theirVulkanFramework(vulkanFramework)
+{
+#ifdef RFVK_SHADER_COMPILATION
+#ifdef _WIN32
+	myStopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+#else
+	myStopEvent = eventfd(0, EFD_CLOEXEC);
+#endif
+	myWatchThread = std::thread(&PipelineReloader::Watch, this);
+#endif
+}
+
+PipelineReloader::~PipelineReloader()
+{
+#ifdef _WIN32
+	if (myStopEvent)
+	{
+		SetEvent(myStopEvent);
+	}
+#else
+	if (myStopEvent >= 0)
+	{
+		const uint64_t stop = 1;
+		write(myStopEvent, &stop, sizeof stop);
+	}
+#endif
+	if (myWatchThread.joinable())
+	{
+		myWatchThread.join();
+	}
+#ifdef _WIN32
+	if (myStopEvent)
+	{
+		CloseHandle(myStopEvent);
+	}
+#else
+	if (myStopEvent >= 0)
+	{
+		close(myStopEvent);
+	}
+#endif
+
+	for (auto& reloaded : myReloadedPipelines)
+	{
+		Destroy(reloaded.pipeline);
+	}
+	for (auto& retired : myRetiredResources)
+	{
+		retired.destroy();
+	}
+}
+
+void
+PipelineReloader::Register(
+	Pipeline&			target,
+	const Shader&		shader,
+	ShaderPermutation		permutation,
+	PipelineConstructor		construct,
+	PipelineSwapCallback	onSwap)
+{
+#ifdef RFVK_SHADER_COMPILATION
+	ReloadablePipeline reloadable;
+	reloadable.target = &target;
+	reloadable.numShaderPaths = shader.GetNumShaderPaths();
+	reloadable.shaderPaths = std::make_unique<char[][128]>(reloadable.numShaderPaths);
+	for (uint32_t pathIndex = 0; pathIndex < reloadable.numShaderPaths; ++pathIndex)
+	{
+		snprintf(reloadable.shaderPaths[pathIndex], sizeof reloadable.shaderPaths[pathIndex], "%s", shader.GetShaderPath(pathIndex));
+	}
+	reloadable.featureKeys = shader.GetFeatureKeys();
+	reloadable.permutation = permutation;
+	reloadable.construct = std::move(construct);
+	reloadable.onSwap = std::move(onSwap);
+	reloadable.binaryHash = BinaryHash(reloadable);
+
+	std::scoped_lock lock(myReloadablesMutex);
+	myReloadables.emplace_back(std::move(reloadable));
+#endif
+}
+
+void
+PipelineReloader::Unregister(
+	Pipeline& target)
+{
+	// waits out a rebuild in progress, its constructor may reference the owner
+	std::scoped_lock lock(myReloadablesMutex, myMutex);
+	std::erase_if(myReloadables, [&target](const ReloadablePipeline& reloadable)
+	{
+		return reloadable.target == &target;
+	});
+	std::erase_if(myReloadedPipelines, [this, &target](const ReloadedPipeline& reloaded)
+	{
+		if (reloaded.target != &target)
+		{
+			return false;
+		}
+		Destroy(reloaded.pipeline);
+		return true;
+	});
+}
+
+void
+PipelineReloader::Retire(
+	std::function<void()> destroy)
+{
+	std::scoped_lock lock(myMutex);
+	myRetiredResources.push_back({std::move(destroy), (1u << NumSwapchainImages) - 1});
+}
+
+void
+PipelineReloader::Update(
+	const std::array<VkFence, NumSwapchainImages>& frameFences)
+{
+	std::vector<ReloadedPipeline> reloadedPipelines;
+	{
+		std::scoped_lock lock(myMutex);
+		reloadedPipelines.swap(myReloadedPipelines);
+	}
+
+	// SWAP
+	// callbacks may retire resources of their own, so the lock isn't held
+	for (auto& reloaded : reloadedPipelines)
+	{
+		std::swap(*reloaded.target, reloaded.pipeline);
+		Retire([this, pipeline = reloaded.pipeline]()
+		{
+			Destroy(pipeline);
+		});
+		if (reloaded.onSwap)
+		{
+			reloaded.onSwap(*reloaded.target);
+		}
+	}
+	if (!reloadedPipelines.empty())
+	{
+		LOG("reloaded", reloadedPipelines.size(), "pipelines");
+	}
+
+	// RETIRE
+	// a signaled fence covers the last frame of its swapchain image and with it every earlier one
+	uint32_t doneFrames = 0;
+	for (uint32_t swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
+	{
+		if (vkGetFenceStatus(theirVulkanFramework.GetDevice(), frameFences[swapchainIndex]) == VK_SUCCESS)
+		{
+			doneFrames |= 1u << swapchainIndex;
+		}
+	}
+
+	std::scoped_lock lock(myMutex);
+	std::erase_if(myRetiredResources, [doneFrames](RetiredResource& retired)
+	{
+		retired.pendingFrames &= ~doneFrames;
+		if (retired.pendingFrames)
+		{
+			return false;
+		}
+		retired.destroy();
+		return true;
+	});
+}
+
+#ifdef _WIN32
+void
+PipelineReloader::Watch()
+{
+	HANDLE change = FindFirstChangeNotificationA(
+		ShaderDirectory,
+		TRUE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	if (change == INVALID_HANDLE_VALUE)
+	{
+		LOG("failed watching shader directory \"", ShaderDirectory, "\"");
+		return;
+	}
+
+	const HANDLE handles[]{myStopEvent, change};
+	while (WaitForMultipleObjects(_ARRAYSIZE(handles), handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+	{
+		// editors often save in several writes, let them settle before compiling
+		if (WaitForSingleObject(myStopEvent, ShaderReloadSettleMs) == WAIT_OBJECT_0)
+		{
+			break;
+		}
+		FindNextChangeNotification(change);
+		Rebuild();
+	}
+	FindCloseChangeNotification(change);
+}
+#else
+void
+PipelineReloader::Watch()
+{
+	const int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notify < 0)
+	{
+		LOG("failed watching shader directory \"", ShaderDirectory, "\"");
+		return;
+	}
+
+	// inotify doesn't recurse, every directory under the shader directory gets its own watch
+	constexpr uint32_t watchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE;
+	if (inotify_add_watch(notify, ShaderDirectory, watchMask) < 0)
+	{
+		LOG("failed watching shader directory \"", ShaderDirectory, "\"");
+		close(notify);
+		return;
+	}
+	std::error_code error;
+	for (auto& entry : std::filesystem::recursive_directory_iterator(ShaderDirectory, error))
+	{
+		if (entry.is_directory())
+		{
+			inotify_add_watch(notify, entry.path().c_str(), watchMask);
+		}
+	}
+
+	pollfd handles[]{{myStopEvent, POLLIN, 0}, {notify, POLLIN, 0}};
+	while (true)
+	{
+		if (poll(handles, std::size(handles), -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+		if (handles[0].revents)
+		{
+			break;
+		}
+
+		// editors often save in several writes, let them settle before compiling
+		if (poll(handles, 1, ShaderReloadSettleMs) > 0)
+		{
+			break;
+		}
+		alignas(inotify_event) char events[4096];
+		while (read(notify, events, sizeof events) > 0)
+		{
+		}
+		Rebuild();
+	}
+	close(notify);
+}
+#endif
+
+void
+PipelineReloader::Rebuild()
+{
+	std::scoped_lock lock(myReloadablesMutex);
+	for (auto& reloadable : myReloadables)
+	{
+		const uint64_t binaryHash = BinaryHash(reloadable);
+		if (!binaryHash)
+		{
+			LOG("shader reload failed, keeping current pipeline for", reloadable.shaderPaths[0]);
+			continue;
+		}
+		if (binaryHash == reloadable.binaryHash)
+		{
+			continue;
+		}
+
+		// shader modules are only needed while the pipeline is created
+		Shader shader(
+			reloadable.shaderPaths.get(),
+			reloadable.numShaderPaths,
+			theirVulkanFramework,
+			reloadable.featureKeys,
+			reloadable.permutation);
+		auto [result, pipeline] = reloadable.construct(&shader);
+		if (result)
+		{
+			LOG("failed rebuilding pipeline for", reloadable.shaderPaths[0]);
+			Destroy(pipeline);
+			continue;
+		}
+		reloadable.binaryHash = binaryHash;
+
+		std::scoped_lock reloadedLock(myMutex);
+		myReloadedPipelines.push_back({reloadable.target, pipeline, reloadable.onSwap});
+	}
+}
+
+uint64_t
+PipelineReloader::BinaryHash(
+	const ReloadablePipeline& reloadable) const
+{
+	auto& shaderCache = theirVulkanFramework.GetShaderCache();
+
+	std::vector<std::string> features;
+	for (uint32_t keyIndex = 0; keyIndex < reloadable.featureKeys.size(); ++keyIndex)
+	{
+		if (reloadable.permutation & (ShaderPermutation(1) << keyIndex))
+		{
+			features.emplace_back(reloadable.featureKeys[keyIndex]);
+		}
+	}
+	const std::string preAmble = ShaderCache::PreAmble(features);
+
+	uint64_t hash = ShaderCache::Hash(nullptr, 0);
+	for (uint32_t pathIndex = 0; pathIndex < reloadable.numShaderPaths; ++pathIndex)
+	{
+		const auto binary = shaderCache.FetchBinary(reloadable.shaderPaths[pathIndex], preAmble);
+		if (binary.empty())
+		{
+			return 0;
+		}
+		hash = ShaderCache::Hash(binary.data(), binary.size() * sizeof(uint32_t), hash);
+	}
+	return hash;
+}
+
+void
+PipelineReloader::Destroy(
+	const Pipeline& pipeline)
+{
+	vkDestroyPipeline(theirVulkanFramework.GetDevice(), pipeline.pipeline, nullptr);
+	vkDestroyPipelineLayout(theirVulkanFramework.GetDevice(), pipeline.layout, nullptr);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "Pipeline.h"
+
+#include <thread>
+
+typedef std::function<std::tuple<VkResult, Pipeline>(class Shader*)> PipelineConstructor;
+// runs on the render thread right after a rebuilt pipeline is swapped in, for state derived from it
+typedef std::function<void(const Pipeline&)> PipelineSwapCallback;
+
+struct ReloadablePipeline
+{
+	Pipeline*						target = nullptr;
+	std::unique_ptr<char[][128]>	shaderPaths;
+	uint32_t						numShaderPaths = 0;
+	std::vector<std::string>		featureKeys;
+	ShaderPermutation				permutation = 0;
+	PipelineConstructor				construct;
+	PipelineSwapCallback			onSwap;
+	uint64_t						binaryHash = 0;
+};
+
+struct ReloadedPipeline
+{
+	Pipeline*				target = nullptr;
+	Pipeline				pipeline = {};
+	PipelineSwapCallback	onSwap;
+};
+
+struct RetiredResource
+{
+	std::function<void()>	destroy;
+	// swapchain images whose last submitted frame may still use the resource
+	uint32_t				pendingFrames = 0;
+};
+
+// rebuilds registered pipelines in the background when their shader sources change
+class PipelineReloader
+{
+public:
+										PipelineReloader(class VulkanFramework& vulkanFramework);
+										~PipelineReloader();
+
+	void								Register(
+											Pipeline&				target,
+											const class Shader&		shader,
+											ShaderPermutation		permutation,
+											PipelineConstructor		construct,
+											PipelineSwapCallback	onSwap = nullptr);
+	void								Unregister(Pipeline& target);
+
+	// destroy runs once every frame recorded until now has finished on the gpu
+	void								Retire(std::function<void()> destroy);
+
+	// swaps in rebuilt pipelines, call at a frame boundary before any recording
+	// frameFences are the presenter's, signaled once everything a swapchain image's frame submitted is done
+	void								Update(const std::array<VkFence, NumSwapchainImages>& frameFences);
+
+private:
+	void								Watch();
+	void								Rebuild();
+	uint64_t							BinaryHash(const ReloadablePipeline& reloadable) const;
+	void								Destroy(const Pipeline& pipeline);
+
+	VulkanFramework&					theirVulkanFramework;
+
+	std::mutex							myReloadablesMutex;
+	std::vector<ReloadablePipeline>		myReloadables;
+
+	std::mutex							myMutex;
+	std::vector<ReloadedPipeline>		myReloadedPipelines;
+	std::vector<RetiredResource>		myRetiredResources;
+
+#ifdef _WIN32
+	HANDLE								myStopEvent = nullptr;
+#else
+	int									myStopEvent = -1;
+#endif
+	std::thread							myWatchThread;
+
+};
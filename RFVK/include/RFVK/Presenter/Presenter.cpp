@@ -4,10 +4,12 @@
 
 #include "RFVK/Image/ImageHandler.h"
 #include "RFVK/Memory/BufferAllocator.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 #include "RFVK/Pipelines/FullscreenPipeline.h"
 #include "RFVK/Shader/Shader.h"
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Pipelines/PipelineBuilder.h"
+#include "RFVK/Pipelines/PipelineReloader.h"
 #include "RFVK/RenderPass/RenderPassFactory.h"
 #include "RFVK/Scene/SceneGlobals.h"
 
@@ -16,6 +18,7 @@ Presenter::Presenter(
 	RenderPassFactory&	renderPassFactory,
 	ImageHandler&		imageHandler,
 	SceneGlobals&		sceneGlobals,
+	BufferAllocator&	bufferAllocator,
 	QueueFamilyIndices	familyIndices)
 	: theirVulkanFramework(vulkanFramework)
 	, theirRenderPassFactory(renderPassFactory)
@@ -60,6 +63,7 @@ Presenter::Presenter(
 		VK_DEPENDENCY_BY_REGION_BIT
 	});
 
+	rpConstructor.SetName("PresentPass");
 	myPresentRenderPass = rpConstructor.Build();
 
 	// SHADER
@@ -68,20 +72,28 @@ Presenter::Presenter(
 		"Shaders/fullscreen_vshader.vert",
 		"Shaders/present_fshader.frag",
 	};
-	myPresentShader = new Shader(paths, 2, theirVulkanFramework);
+	// a dynamic pass samples the intermediate image instead of reading it as input attachment
+	const ShaderPermutation permutation = myPresentRenderPass.isDynamic ? 1 : 0;
+	myPresentShader = new Shader(paths, 2, theirVulkanFramework, {SplitSubpassesFeature}, permutation);
 
 	// PIPELINE
-	PipelineBuilder pipelineConstructor(1, myPresentRenderPass.renderPass, myPresentShader);
-	pipelineConstructor.DefineVertexInput(nullptr);
-	pipelineConstructor.DefineViewport({w,h}, {0,0,w, h});
-	pipelineConstructor.SetDepthEnabled(false);
-
-	std::tie(result, myPresentPipeline) = pipelineConstructor.Construct(
-		{
-		theirSceneGlobals.GetGlobalsLayout(),
-		theirImageHandler.GetImageSetLayout(),
-		myPresentRenderPass.subpasses[0].inputAttachmentLayout
-		}, theirVulkanFramework.GetDevice());
+	auto constructPresentPipeline = [this, w, h, permutation](Shader* shader)
+	{
+		PipelineBuilder pipelineConstructor(1, myPresentRenderPass, shader);
+		pipelineConstructor.SetPermutation(permutation);
+		pipelineConstructor.DefineVertexInput(nullptr);
+		pipelineConstructor.DefineViewport({w,h}, {0,0,w, h});
+		pipelineConstructor.SetDepthEnabled(false);
+
+		return pipelineConstructor.Construct(
+			{
+			theirSceneGlobals.GetGlobalsLayout(),
+			theirImageHandler.GetImageSetLayout(),
+			myPresentRenderPass.subpasses[0].inputAttachmentLayout
+			}, theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache());
+	};
+	std::tie(result, myPresentPipeline) = constructPresentPipeline(myPresentShader);
+	theirVulkanFramework.GetPipelineReloader().Register(myPresentPipeline, *myPresentShader, permutation, constructPresentPipeline);
 
 
 	// COMMANDS
@@ -101,10 +113,26 @@ Presenter::Presenter(
 		auto resultFence = vkCreateFence(theirVulkanFramework.GetDevice(), &fenceInfo, nullptr, &myCmdBufferFences[i]);
 		assert(!resultFence && "failed creating fences");
 	}
+
+	// READBACK
+	if (theirVulkanFramework.IsHeadless())
+	{
+		for (uint32_t i = 0; i < NumSwapchainImages; i++)
+		{
+			auto [resultBuffer, buffer, data] = bufferAllocator.RequestMappedBuffer(
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				size_t(w) * size_t(h) * sizeof(PixelValue),
+				{familyIndices[QUEUE_FAMILY_GRAPHICS]});
+			assert(!resultBuffer && "failed creating readback buffer");
+			myReadbackBuffers[i] = buffer;
+			myReadbackData[i] = data;
+		}
+	}
 }
 
 Presenter::~Presenter()
 {
+	theirVulkanFramework.GetPipelineReloader().Unregister(myPresentPipeline);
 	SAFE_DELETE(myPresentShader);
 
 	for (uint32_t i = 0; i < NumSwapchainImages; i++)
@@ -135,17 +163,18 @@ Presenter::RecordSubmit(
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
 	BeginRenderPass(myCmdBuffers[swapchainImageIndex], myPresentRenderPass, swapchainImageIndex, {0,0,w,h});
 
-	vkCmdBindPipeline(myCmdBuffers[swapchainImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, myPresentPipeline.pipeline);
+	CommandRecorder recorder(myCmdBuffers[swapchainImageIndex]);
+	recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, myPresentPipeline.pipeline);
 
 	// DESCRIPTORS
-	theirSceneGlobals.BindGlobals(myCmdBuffers[swapchainImageIndex], myPresentPipeline.layout, 0);
-	theirImageHandler.BindImages(swapchainImageIndex, myCmdBuffers[swapchainImageIndex], myPresentPipeline.layout, 1);
-	BindSubpassInputs(myCmdBuffers[swapchainImageIndex], myPresentPipeline.layout, 2, myPresentRenderPass.subpasses[0], swapchainImageIndex);
+	theirSceneGlobals.BindGlobals(recorder, myPresentPipeline.layout, 0);
+	theirImageHandler.BindImages(swapchainImageIndex, recorder, myPresentPipeline.layout, 1);
+	BindSubpassInputs(recorder, myPresentPipeline.layout, 2, myPresentRenderPass.subpasses[0], swapchainImageIndex);
 
 	// DRAW 
 	vkCmdDraw(myCmdBuffers[swapchainImageIndex], 6, 1, 0, 0);
 
-	vkCmdNextSubpass(myCmdBuffers[swapchainImageIndex], VK_SUBPASS_CONTENTS_INLINE);
+	NextSubpass(myCmdBuffers[swapchainImageIndex], myPresentRenderPass, swapchainImageIndex);
 
 	VkClearAttachment clearAtt{};
 	clearAtt.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -157,7 +186,49 @@ Presenter::RecordSubmit(
 
 	vkCmdClearAttachments(myCmdBuffers[swapchainImageIndex], 1, &clearAtt, 1, &clearRect);
 
-	vkCmdEndRenderPass(myCmdBuffers[swapchainImageIndex]);
+	EndRenderPass(myCmdBuffers[swapchainImageIndex], myPresentRenderPass, swapchainImageIndex);
+
+	// READBACK
+	if (theirVulkanFramework.IsHeadless())
+	{
+		// the render pass leaves the target in transfer src layout
+		VkMemoryBarrier toTransfer{};
+		toTransfer.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(
+			myCmdBuffers[swapchainImageIndex],
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			NULL,
+			1, &toTransfer,
+			0, nullptr,
+			0, nullptr);
+
+		VkBufferImageCopy region{};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = {uint32_t(w), uint32_t(h), 1};
+		vkCmdCopyImageToBuffer(
+			myCmdBuffers[swapchainImageIndex],
+			theirVulkanFramework.GetSwapchainImages()[swapchainImageIndex],
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			myReadbackBuffers[swapchainImageIndex],
+			1, &region);
+
+		VkMemoryBarrier toHost{};
+		toHost.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(
+			myCmdBuffers[swapchainImageIndex],
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT,
+			NULL,
+			1, &toHost,
+			0, nullptr,
+			0, nullptr);
+	}
 
 	auto resultEnd = vkEndCommandBuffer(myCmdBuffers[swapchainImageIndex]);
 
@@ -180,6 +251,7 @@ Presenter::RecordSubmit(
 	submitInfo.pSignalSemaphores = signalSemaphores.data();
 	submitInfo.signalSemaphoreCount = signalSemaphores.size();
 
+	myLastPresentedIndex = int(swapchainImageIndex);
 	return {{myCmdBufferFences[swapchainImageIndex], submitInfo, VK_QUEUE_GRAPHICS_BIT}};
 }
 
@@ -189,7 +261,37 @@ Presenter::GetFences()
     return myCmdBufferFences;
 }
 
+bool
+Presenter::ReadFrame(
+	std::vector<PixelValue>& outPixels)
+{
+	if (!theirVulkanFramework.IsHeadless() || myLastPresentedIndex < 0)
+	{
+		return false;
+	}
+
+	auto result = vkWaitForFences(theirVulkanFramework.GetDevice(), 1, &myCmdBufferFences[myLastPresentedIndex], VK_TRUE, UINT64_MAX);
+	if (result)
+	{
+		LOG("failed waiting for presented frame");
+		return false;
+	}
+
+	auto [w, h] = theirVulkanFramework.GetTargetResolution();
+	outPixels.resize(size_t(w) * size_t(h));
+	memcpy(outPixels.data(), myReadbackData[myLastPresentedIndex], outPixels.size() * sizeof(PixelValue));
+	return true;
+}
+
 std::vector<rflx::Features> Presenter::GetImplementedFeatures() const
 {
     return {rflx::Features::FEATURE_CORE};
 }
+
+std::vector<ResourceUse> Presenter::GetResourceUses() const
+{
+	return {
+		theirImageHandler.GetImagesUse(ResourceAccess::Read),
+		theirRenderPassFactory.GetIntermediateUse(ResourceAccess::Read),
+		{uint64_t(theirVulkanFramework.GetSwapchainImageViews()[0]), "swapchain", ResourceAccess::Write, true}};
+}
@@ -12,6 +12,7 @@ public:
 														class RenderPassFactory&	renderPassFactory,
 														class ImageHandler&			imageHandler,
 														class SceneGlobals&			sceneGlobals,
+														class BufferAllocator&		bufferAllocator,
 														QueueFamilyIndices			familyIndices);
 													~Presenter();
 
@@ -23,6 +24,11 @@ public:
 	std::array<VkFence, NumSwapchainImages>			GetFences() override;
 	std::vector<rflx::Features>						GetImplementedFeatures() const override;
 	int												GetSubmissionCount() override { return 1; }
+	std::vector<ResourceUse>						GetResourceUses() const override;
+	const char*										GetName() const override { return "Presenter"; }
+
+	// headless only, waits for the last presented frame and copies out its pixels
+	bool											ReadFrame(std::vector<PixelValue>& outPixels);
 
 private:
 	VulkanFramework&								theirVulkanFramework;
@@ -39,4 +45,8 @@ private:
 	std::array<VkCommandBuffer, NumSwapchainImages> myCmdBuffers;
 	std::array<VkFence, NumSwapchainImages>			myCmdBufferFences;
 
+	std::array<VkBuffer, NumSwapchainImages>		myReadbackBuffers = {};
+	std::array<void*, NumSwapchainImages>			myReadbackData = {};
+	int												myLastPresentedIndex = -1;
+
 };
\ No newline at end of file
@@ -200,7 +200,7 @@ AccelerationStructureAllocator::RequestInstanceStructure(
 			| VK_BUFFER_USAGE_TRANSFER_DST_BIT
 			,
 			instanceDesc.data(),
-			uint32_t(instanceDesc.size() * sizeof RTInstances::value_type),
+			uint32_t(instanceDesc.size() * sizeof(RTInstances::value_type)),
 			myOwners,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 	if (resultInstances)
@@ -284,7 +284,7 @@ AccelerationStructureAllocator::RequestInstanceStructure(
 		false,
 		instanceDesc,
 		instancesBuffer,
-		instanceDesc.size() * sizeof VkAccelerationStructureInstanceKHR,
+		instanceDesc.size() * sizeof(VkAccelerationStructureInstanceKHR),
 		instancesAddress,
 		scratchAddress,
 		instanceStructure);
@@ -302,7 +302,7 @@ AccelerationStructureAllocator::RequestInstanceStructure(
 		instStructureAddress,
 		scratchAddress,
 		instancesAddress,
-		instanceDesc.size() * sizeof RTInstances::value_type
+		instanceDesc.size() * sizeof(RTInstances::value_type)
 	});
 	
 	return {VK_SUCCESS, instanceStructure};
@@ -425,7 +425,7 @@ AccelerationStructureAllocator::BuildInstanceStructure(
 	if (!instanceDesc.empty())
 	{
 		VkBufferCopy copy;
-		copy.size = instanceDesc.size() * sizeof RTInstances::value_type;
+		copy.size = instanceDesc.size() * sizeof(RTInstances::value_type);
 		copy.size = copy.size > instancesBufferSize ? instancesBufferSize : copy.size;
 		copy.srcOffset = 0;
 		copy.dstOffset = 0;
@@ -458,11 +458,7 @@ AccelerationStructureAllocator::BuildInstanceStructure(
 
 	VkAccelerationStructureBuildRangeInfoKHR buildRange = {};
 	buildRange.primitiveCount = uint32_t(instanceDesc.size());
-	std::vector ranges
-	{
-		buildRange
-	};
-	auto const pRanges = ranges.data();
+	auto const pRanges = &buildRange;
 
 	auto cmdBuffer = allocSub.Record();
 	VkMemoryBarrier barrier;
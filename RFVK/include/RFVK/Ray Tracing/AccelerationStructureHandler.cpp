@@ -6,6 +6,7 @@
 #include "RFVK/Memory/BufferAllocator.h"
 #include "RFVK/Mesh/LoadMesh.h"
 #include "RFVK/Mesh/MeshHandler.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 
 AccelerationStructureHandler::AccelerationStructureHandler(
 	VulkanFramework& vulkanFramework,
@@ -294,16 +295,13 @@ AccelerationStructureHandler::operator[](
 void
 AccelerationStructureHandler::BindInstanceStructures(
 	int					swapchainIndex,
-	VkCommandBuffer		commandBuffer, 
+	CommandRecorder&	recorder, 
 	VkPipelineLayout	pipelineLayout, 
 	uint32_t			setIndex) const
 {
-	vkCmdBindDescriptorSets(commandBuffer,
-							 VK_PIPELINE_BIND_POINT_RAY_TRACING_NV,
-							 pipelineLayout,
-							 setIndex,
-							 1,
-							 &myInstanceStructDescriptorSets[swapchainIndex],
-							 0,
-							 nullptr);
+	recorder.BindDescriptorSet(
+		VK_PIPELINE_BIND_POINT_RAY_TRACING_NV,
+		pipelineLayout,
+		setIndex,
+		myInstanceStructDescriptorSets[swapchainIndex]);
 }
@@ -51,7 +51,7 @@ public:
 
 	void							BindInstanceStructures(
 										int					swapchainIndex,
-										VkCommandBuffer		commandBuffer,
+										class CommandRecorder&	recorder,
 										VkPipelineLayout	pipelineLayout,
 										uint32_t			setIndex) const;
 
@@ -6,6 +6,8 @@
 #include "RFVK/Image/ImageHandler.h"
 #include "RFVK/Memory/BufferAllocator.h"
 #include "RFVK/Mesh/MeshHandler.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
+#include "RFVK/Pipelines/PipelineReloader.h"
 #include "RFVK/Scene/SceneGlobals.h"
 #include "RFVK/Shader/Shader.h"
 #include "RFVK/VulkanFramework.h"
@@ -51,49 +53,36 @@ RTMeshRenderer::RTMeshRenderer(
 	props.pNext = &rtProps;
 	vkGetPhysicalDeviceProperties2(theirVulkanFramework.GetPhysicalDevice(), &props);
 
-	RTPipelineBuilder builder;
-	builder.AddDescriptorSet(theirSceneGlobals.GetGlobalsLayout());
-	builder.AddDescriptorSet(theirImageHandler.GetSamplerSetLayout());
-	builder.AddDescriptorSet(theirImageHandler.GetImageSetLayout());
-	builder.AddDescriptorSet(theirAccStructHandler.GetInstanceStructuresLayout());
-	builder.AddDescriptorSet(theirMeshHandler.GetMeshDataLayout());
-	builder.AddShaderGroup(0, ShaderGroupType::RayGen);
-	builder.AddShaderGroup(1, ShaderGroupType::Miss);
-	builder.AddShaderGroup(2, ShaderGroupType::Miss);
-	builder.AddShaderGroup(3, ShaderGroupType::ClosestHit);
-	builder.AddShader(myOpaqueShader);
+	auto constructPipeline = [this, rtProps](Shader* shader)
+	{
+		RTPipelineBuilder builder;
+		builder.AddDescriptorSet(theirSceneGlobals.GetGlobalsLayout());
+		builder.AddDescriptorSet(theirImageHandler.GetSamplerSetLayout());
+		builder.AddDescriptorSet(theirImageHandler.GetImageSetLayout());
+		builder.AddDescriptorSet(theirAccStructHandler.GetInstanceStructuresLayout());
+		builder.AddDescriptorSet(theirMeshHandler.GetMeshDataLayout());
+		builder.AddShaderGroup(0, ShaderGroupType::RayGen);
+		builder.AddShaderGroup(1, ShaderGroupType::Miss);
+		builder.AddShaderGroup(2, ShaderGroupType::Miss);
+		builder.AddShaderGroup(3, ShaderGroupType::ClosestHit);
+		builder.AddShader(shader);
+		return builder.Construct(theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache(), rtProps);
+	};
 	VkResult result;
-	std::tie(result, myPipeline) = builder.Construct(theirVulkanFramework.GetDevice(), rtProps);
+	std::tie(result, myPipeline) = constructPipeline(myOpaqueShader.get());
 	assert(!result && "failed creating ray tracing pipeline");
-	
-	size_t shaderProgramSize = rtProps.shaderGroupBaseAlignment;
+	theirVulkanFramework.GetPipelineReloader().Register(myPipeline, *myOpaqueShader, 0, constructPipeline, [this](const Pipeline& pipeline)
+	{
+		SwapShaderBindingTables(pipeline);
+	});
+
 	size_t shaderHandleAlignment = rtProps.shaderGroupHandleAlignment;
 	size_t shaderHandleSize = rtProps.shaderGroupHandleSize;
-	uint32_t alignedSize = AlignedSize(shaderHandleSize, shaderHandleAlignment);
+	myAlignedHandleSize = AlignedSize(shaderHandleSize, shaderHandleAlignment);
 	auto allocSub = theirBufferAllocator.Start();
 
 	// SHADER BINDING TABLE
-	myShaderBindingTables[0] =
-		CreateShaderBindingTable(
-			allocSub,
-			alignedSize,
-			0,
-			1,
-			myPipeline.pipeline);
-	myShaderBindingTables[1] =
-		CreateShaderBindingTable(
-			allocSub,
-			alignedSize,
-			1,
-			2,
-			myPipeline.pipeline);
-	myShaderBindingTables[2] =
-		CreateShaderBindingTable(
-			allocSub,
-			alignedSize,
-			3,
-			1,
-			myPipeline.pipeline);
+	CreateShaderBindingTables(allocSub, myPipeline.pipeline);
 	
 	// STORE IMAGE
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
@@ -118,6 +107,7 @@ RTMeshRenderer::RTMeshRenderer(
 
 RTMeshRenderer::~RTMeshRenderer()
 {
+	theirVulkanFramework.GetPipelineReloader().Unregister(myPipeline);
 	vkDestroyPipeline(theirVulkanFramework.GetDevice(), myPipeline.pipeline, nullptr);
 	vkDestroyPipelineLayout(theirVulkanFramework.GetDevice(), myPipeline.layout, nullptr);
 	//vkDestroyBuffer(theirVulkanFramework.GetDevice(), mySBTBuffer, nullptr);
@@ -165,14 +155,15 @@ RTMeshRenderer::RecordSubmit(
 	auto cmdBuffer = myCmdBuffers[swapchainImageIndex];
 	auto resultBegin = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
 
-	vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, myPipeline.pipeline);
+	CommandRecorder recorder(cmdBuffer);
+	recorder.BindPipeline(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, myPipeline.pipeline);
 
 	// DESCRIPTORS
-	theirSceneGlobals.BindGlobals(cmdBuffer, myPipeline.layout, 0, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
-	theirImageHandler.BindSamplers(cmdBuffer, myPipeline.layout, 1, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
-	theirImageHandler.BindImages(swapchainImageIndex, cmdBuffer, myPipeline.layout, 2, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
-	theirAccStructHandler.BindInstanceStructures(swapchainImageIndex, cmdBuffer, myPipeline.layout, 3);
-	theirMeshHandler.BindMeshData(swapchainImageIndex, cmdBuffer, myPipeline.layout, 4, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	theirSceneGlobals.BindGlobals(recorder, myPipeline.layout, 0, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	theirImageHandler.BindSamplers(recorder, myPipeline.layout, 1, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	theirImageHandler.BindImages(swapchainImageIndex, recorder, myPipeline.layout, 2, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	theirAccStructHandler.BindInstanceStructures(swapchainImageIndex, recorder, myPipeline.layout, 3);
+	theirMeshHandler.BindMeshData(swapchainImageIndex, recorder, myPipeline.layout, 4, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
 
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
 	VkStridedDeviceAddressRegionKHR callableStride = {};
@@ -214,6 +205,42 @@ std::vector<rflx::Features> RTMeshRenderer::GetImplementedFeatures() const
     return {rflx::Features::FEATURE_RAY_TRACING};
 }
 
+std::vector<ResourceUse> RTMeshRenderer::GetResourceUses() const
+{
+	// traces into the storage image held by the image set
+	return {theirImageHandler.GetImagesUse(ResourceAccess::ReadWrite)};
+}
+
+void
+RTMeshRenderer::CreateShaderBindingTables(
+	AllocationSubmissionID	allocSubID,
+	VkPipeline				pipeline)
+{
+	myShaderBindingTables[0] = CreateShaderBindingTable(allocSubID, myAlignedHandleSize, 0, 1, pipeline);
+	myShaderBindingTables[1] = CreateShaderBindingTable(allocSubID, myAlignedHandleSize, 1, 2, pipeline);
+	myShaderBindingTables[2] = CreateShaderBindingTable(allocSubID, myAlignedHandleSize, 3, 1, pipeline);
+}
+
+void
+RTMeshRenderer::SwapShaderBindingTables(
+	const Pipeline& pipeline)
+{
+	// group handles belong to the pipeline, the old tables go once no frame in flight traces with them
+	const auto doneSignal = std::make_shared<std::counting_semaphore<NumSwapchainImages>>(0);
+	for (auto& table : myShaderBindingTables)
+	{
+		theirBufferAllocator.QueueDestroy(std::move(table.buffer), doneSignal);
+	}
+	theirVulkanFramework.GetPipelineReloader().Retire([doneSignal]()
+	{
+		doneSignal->release(NumSwapchainImages);
+	});
+
+	auto allocSub = theirBufferAllocator.Start();
+	CreateShaderBindingTables(allocSub, pipeline.pipeline);
+	theirBufferAllocator.Queue(std::move(allocSub));
+}
+
 ShaderBindingTable
 RTMeshRenderer::CreateShaderBindingTable(
 	AllocationSubmissionID	allocSubID,
@@ -27,8 +27,14 @@ public:
 														signalSemaphores) override;
 	std::vector<rflx::Features>			GetImplementedFeatures() const override;
 	int									GetSubmissionCount() override { return 1; }
+	std::vector<ResourceUse>			GetResourceUses() const override;
+	const char*							GetName() const override { return "RTMeshRenderer"; }
 
 private:
+	void								CreateShaderBindingTables(
+											AllocationSubmissionID	allocSubID,
+											VkPipeline				pipeline);
+	void								SwapShaderBindingTables(const Pipeline& pipeline);
 	ShaderBindingTable					CreateShaderBindingTable(
 											AllocationSubmissionID	allocSubID,
 											size_t					handleSize,
@@ -48,6 +54,7 @@ private:
 	std::shared_ptr<class Shader>		myOpaqueShader;
 
 	std::array<ShaderBindingTable, 3>	myShaderBindingTables;
+	uint32_t							myAlignedHandleSize = 0;
 
 	InstanceStructID					myInstancesID;
 	RTInstances							myInstances;
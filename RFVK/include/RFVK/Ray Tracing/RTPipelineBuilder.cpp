@@ -40,7 +40,7 @@ RTPipelineBuilder::AddShaderGroup(
 
 void
 RTPipelineBuilder::AddShader(
-	const std::shared_ptr<class Shader>& shader)
+	Shader* shader)
 {
 	myShader = shader;
 }
@@ -48,6 +48,7 @@ RTPipelineBuilder::AddShader(
 std::tuple<VkResult, Pipeline>
 RTPipelineBuilder::Construct(
 	VkDevice										device,
+	VkPipelineCache									pipelineCache,
 	VkPhysicalDeviceRayTracingPipelinePropertiesKHR rtProps)
 {
 	VkPipelineLayout layout = nullptr;
@@ -82,7 +83,7 @@ RTPipelineBuilder::Construct(
 	auto result = vkCreateRayTracingPipelines(
 		device,
 		nullptr,
-		nullptr,
+		pipelineCache,
 		1,
 		&rtPipelineInfo,
 		nullptr,
@@ -16,15 +16,16 @@ public:
 	void							AddShaderGroup(
 										int				index, 
 										ShaderGroupType type);
-	void							AddShader(const std::shared_ptr<class Shader>& shader);
+	void							AddShader(class Shader* shader);
 	std::tuple<VkResult, Pipeline>	Construct(
 										VkDevice device,
+										VkPipelineCache pipelineCache,
 										VkPhysicalDeviceRayTracingPipelinePropertiesKHR rtProps);
 
 private:
 	std::vector<VkDescriptorSetLayout>		myDescriptorSets;
 	std::vector<VkRayTracingShaderGroupCreateInfoKHR>
 											myShaderGroups;
-	std::shared_ptr<Shader>			myShader;
+	Shader*							myShader = nullptr;
 	
 };
@@ -1,22 +1,149 @@
 #include "pch.h"
 #include "RenderPass.h"
 
+#include "RFVK/Debug/GpuProfiler.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
+
 void
 BindSubpassInputs(
-	VkCommandBuffer		cmdBuffer,
+	CommandRecorder&	recorder,
 	VkPipelineLayout	pipelineLayout,
 	uint32_t			setIndex,
 	Subpass&			subpass,
 	uint32_t			swapchainIndex)
 {
-	vkCmdBindDescriptorSets(cmdBuffer,
-							 VK_PIPELINE_BIND_POINT_GRAPHICS,
-							 pipelineLayout,
-							 setIndex,
-							 1,
-							 &subpass.inputAttachmentSets[swapchainIndex],
-							 0,
-							 nullptr);
+	recorder.BindDescriptorSet(
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		pipelineLayout,
+		setIndex,
+		subpass.inputAttachmentSets[swapchainIndex]);
+}
+
+static bool
+IsDepthAttachment(
+	const DynamicAttachment& attachment)
+{
+	return attachment.range.aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT;
+}
+
+static VkImageLayout
+AttachmentLayout(
+	const DynamicAttachment& attachment)
+{
+	return IsDepthAttachment(attachment) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+}
+
+static VkImageLayout
+InputLayout(
+	const DynamicAttachment& attachment)
+{
+	return IsDepthAttachment(attachment) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+static VkRenderingAttachmentInfo
+RenderingAttachment(
+	const RenderPass&	renderPass,
+	uint32_t			attachmentIndex,
+	uint32_t			swapchainIndex)
+{
+	auto& attachment = renderPass.attachments[attachmentIndex];
+
+	VkRenderingAttachmentInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	info.imageView = attachment.views[swapchainIndex];
+	info.imageLayout = AttachmentLayout(attachment);
+	info.loadOp = renderPass.currentSubpass == attachment.firstSubpass ? attachment.loadOp : VK_ATTACHMENT_LOAD_OP_LOAD;
+	info.storeOp = renderPass.currentSubpass == attachment.lastSubpass ? attachment.storeOp : VK_ATTACHMENT_STORE_OP_STORE;
+	info.clearValue = renderPass.clearValues[attachmentIndex];
+	return info;
+}
+
+static void
+BeginDynamicSubpass(
+	VkCommandBuffer cmdBuffer,
+	RenderPass&		renderPass,
+	uint32_t		swapchainIndex)
+{
+	auto& subpass = renderPass.dynamicSubpasses[renderPass.currentSubpass];
+
+	// LAYOUTS
+	// stands in for the external and between-subpass dependencies of a render pass object
+	neat::static_vector<VkImageMemoryBarrier, MaxNumAttachments> barriers;
+	auto addBarrier = [&](uint32_t attachmentIndex, VkImageLayout layout, VkAccessFlags dstAccess)
+	{
+		auto& attachment = renderPass.attachments[attachmentIndex];
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = renderPass.currentLayouts[attachmentIndex];
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = attachment.images[swapchainIndex];
+		barrier.subresourceRange = attachment.range;
+		barriers.emplace_back(barrier);
+
+		renderPass.currentLayouts[attachmentIndex] = layout;
+	};
+	for (uint32_t colorIndex = 0; colorIndex < subpass.numColorAttachments; ++colorIndex)
+	{
+		addBarrier(subpass.colorAttachments[colorIndex],
+				   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				   VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+	}
+	if (subpass.depthAttachment != VK_ATTACHMENT_UNUSED)
+	{
+		addBarrier(subpass.depthAttachment,
+				   VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				   VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+	}
+	for (uint32_t inputIndex = 0; inputIndex < subpass.numInputAttachments; ++inputIndex)
+	{
+		const uint32_t attachmentIndex = subpass.inputAttachments[inputIndex];
+		addBarrier(attachmentIndex, InputLayout(renderPass.attachments[attachmentIndex]), VK_ACCESS_SHADER_READ_BIT);
+	}
+	vkCmdPipelineBarrier(cmdBuffer,
+						 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+						 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+						 NULL,
+						 0, nullptr,
+						 0, nullptr,
+						 barriers.size(), barriers.data());
+
+	// RENDERING
+	std::array<VkRenderingAttachmentInfo, MaxNumAttachments> colorInfos{};
+	for (uint32_t colorIndex = 0; colorIndex < subpass.numColorAttachments; ++colorIndex)
+	{
+		colorInfos[colorIndex] = RenderingAttachment(renderPass, subpass.colorAttachments[colorIndex], swapchainIndex);
+	}
+
+	VkRenderingInfo renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderingInfo.renderArea = renderPass.renderArea;
+	renderingInfo.layerCount = 1;
+	renderingInfo.colorAttachmentCount = subpass.numColorAttachments;
+	renderingInfo.pColorAttachments = colorInfos.data();
+
+	VkRenderingAttachmentInfo depthInfo{};
+	VkRenderingAttachmentInfo stencilInfo{};
+	if (subpass.depthAttachment != VK_ATTACHMENT_UNUSED)
+	{
+		depthInfo = RenderingAttachment(renderPass, subpass.depthAttachment, swapchainIndex);
+		renderingInfo.pDepthAttachment = &depthInfo;
+
+		// stencil is never read, but the pipeline is built against the combined format
+		if (renderPass.attachments[subpass.depthAttachment].range.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
+		{
+			stencilInfo = depthInfo;
+			stencilInfo.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			stencilInfo.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			renderingInfo.pStencilAttachment = &stencilInfo;
+		}
+	}
+
+	vkCmdBeginRendering(cmdBuffer, &renderingInfo);
 }
 
 void
@@ -26,9 +153,37 @@ BeginRenderPass(
 	uint32_t		swapchainIndex,
 	Vec4f			renderArea)
 {
+	renderPass.profileZone = gGpuProfiler
+		? gGpuProfiler->BeginZone(cmdBuffer, swapchainIndex, renderPass.name)
+		: NoGpuZone;
+
+	renderPass.currentSubpass = 0;
+	renderPass.renderArea = {int32_t(renderArea.x), int32_t(renderArea.y), uint32_t(renderArea.z), uint32_t(renderArea.w)};
+
+	// pipelines built with a dynamic viewport take the render area, flipped like PipelineBuilder::DefineViewport
+	VkViewport viewport{};
+	viewport.x = renderArea.x;
+	viewport.y = renderArea.y + renderArea.w;
+	viewport.width = renderArea.z;
+	viewport.height = -renderArea.w;
+	viewport.minDepth = 0.f;
+	viewport.maxDepth = 1.f;
+	vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(cmdBuffer, 0, 1, &renderPass.renderArea);
+
+	if (renderPass.isDynamic)
+	{
+		for (uint32_t attachmentIndex = 0; attachmentIndex < renderPass.numAttachments; ++attachmentIndex)
+		{
+			renderPass.currentLayouts[attachmentIndex] = renderPass.attachments[attachmentIndex].initialLayout;
+		}
+		BeginDynamicSubpass(cmdBuffer, renderPass, swapchainIndex);
+		return;
+	}
+
 	VkRenderPassBeginInfo rBeginInfo{};
 	rBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	rBeginInfo.renderArea = {int32_t(renderArea.x), int32_t(renderArea.y), uint32_t(renderArea.z), uint32_t(renderArea.w)};
+	rBeginInfo.renderArea = renderPass.renderArea;
 	rBeginInfo.renderPass = renderPass.renderPass;
 	rBeginInfo.framebuffer = renderPass.frameBuffers[swapchainIndex];
 	rBeginInfo.pClearValues = renderPass.clearValues.data();
@@ -37,6 +192,84 @@ BeginRenderPass(
 	vkCmdBeginRenderPass(cmdBuffer, &rBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 }
 
+void
+NextSubpass(
+	VkCommandBuffer cmdBuffer,
+	RenderPass&		renderPass,
+	uint32_t		swapchainIndex)
+{
+	++renderPass.currentSubpass;
+	if (!renderPass.isDynamic)
+	{
+		vkCmdNextSubpass(cmdBuffer, VK_SUBPASS_CONTENTS_INLINE);
+		return;
+	}
+
+	vkCmdEndRendering(cmdBuffer);
+	BeginDynamicSubpass(cmdBuffer, renderPass, swapchainIndex);
+}
+
+static void
+EndRenderPassZone(
+	VkCommandBuffer cmdBuffer,
+	RenderPass&		renderPass,
+	uint32_t		swapchainIndex)
+{
+	if (gGpuProfiler)
+	{
+		gGpuProfiler->EndZone(cmdBuffer, swapchainIndex, renderPass.profileZone);
+	}
+}
+
+void
+EndRenderPass(
+	VkCommandBuffer cmdBuffer,
+	RenderPass&		renderPass,
+	uint32_t		swapchainIndex)
+{
+	if (!renderPass.isDynamic)
+	{
+		vkCmdEndRenderPass(cmdBuffer);
+		EndRenderPassZone(cmdBuffer, renderPass, swapchainIndex);
+		return;
+	}
+
+	vkCmdEndRendering(cmdBuffer);
+
+	// FINAL LAYOUTS
+	neat::static_vector<VkImageMemoryBarrier, MaxNumAttachments> barriers;
+	for (uint32_t attachmentIndex = 0; attachmentIndex < renderPass.numAttachments; ++attachmentIndex)
+	{
+		auto& attachment = renderPass.attachments[attachmentIndex];
+		if (attachment.firstSubpass == VK_ATTACHMENT_UNUSED)
+		{
+			continue;
+		}
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = IsDepthAttachment(attachment)
+			? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+			: VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.oldLayout = renderPass.currentLayouts[attachmentIndex];
+		barrier.newLayout = attachment.finalLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = attachment.images[swapchainIndex];
+		barrier.subresourceRange = attachment.range;
+		barriers.emplace_back(barrier);
+	}
+	vkCmdPipelineBarrier(cmdBuffer,
+						 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+						 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+						 NULL,
+						 0, nullptr,
+						 0, nullptr,
+						 barriers.size(), barriers.data());
+	EndRenderPassZone(cmdBuffer, renderPass, swapchainIndex);
+}
+
 void
 DestroyRenderPass(
 	RenderPass& renderPass, 
@@ -11,12 +11,39 @@ struct Subpass
 };
 
 void BindSubpassInputs(
-		VkCommandBuffer		cmdBuffer,
+		class CommandRecorder&	recorder,
 		VkPipelineLayout	pipelineLayout,
 		uint32_t			setIndex,
 		Subpass&			subpass,
 		uint32_t			swapchainIndex);
 
+struct DynamicAttachment
+{
+	VkFormat										format;
+	VkAttachmentLoadOp								loadOp;
+	VkAttachmentStoreOp								storeOp;
+	VkImageLayout									initialLayout;
+	VkImageLayout									finalLayout;
+	VkImageSubresourceRange							range;
+	std::array<VkImage, NumSwapchainImages>			images;
+	std::array<VkImageView, NumSwapchainImages>		views;
+
+	// load op applies on first use and store op on last, subpasses in between load and store
+	uint32_t										firstSubpass;
+	uint32_t										lastSubpass;
+};
+
+struct DynamicSubpass
+{
+	uint32_t										numColorAttachments;
+	std::array<uint32_t, MaxNumAttachments>			colorAttachments;
+	uint32_t										depthAttachment;
+
+	// read as textures, the previous subpass' rendering scope has ended and stored them
+	uint32_t										numInputAttachments;
+	std::array<uint32_t, MaxNumAttachments>			inputAttachments;
+};
+
 struct RenderPass
 {
 	VkRenderPass									renderPass;
@@ -27,6 +54,22 @@ struct RenderPass
 	uint32_t										numSubpasses;
 	std::array<Subpass, MaxNumSubpasses>			subpasses;
 
+	// recorded with dynamic rendering, renderPass and frameBuffers stay null
+	// every subpass begins its own rendering scope, so input attachments are sampled instead of read tile locally
+	bool											isDynamic;
+	std::array<DynamicAttachment, MaxNumAttachments>
+													attachments;
+	std::array<DynamicSubpass, MaxNumSubpasses>		dynamicSubpasses;
+	// where each attachment is while recording, dynamic passes transition them between subpasses
+	std::array<VkImageLayout, MaxNumAttachments>	currentLayouts;
+
+	uint32_t										currentSubpass;
+	VkRect2D										renderArea;
+
+	// gpu profiler zone from BeginRenderPass to EndRenderPass
+	const char*										name;
+	uint32_t										profileZone;
+
 };
 
 void BeginRenderPass(
@@ -35,6 +78,16 @@ void BeginRenderPass(
 		uint32_t		swapchainIndex,
 		Vec4f			renderArea);
 
+void NextSubpass(
+		VkCommandBuffer cmdBuffer,
+		RenderPass&		renderPass,
+		uint32_t		swapchainIndex);
+
+void EndRenderPass(
+		VkCommandBuffer cmdBuffer,
+		RenderPass&		renderPass,
+		uint32_t		swapchainIndex);
+
 void DestroyRenderPass(
 		RenderPass& renderPass, 
 		VkDevice	device);
\ No newline at end of file
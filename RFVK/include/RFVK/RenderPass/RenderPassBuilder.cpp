@@ -6,6 +6,7 @@
 #include "RenderPassFactory.h"
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Memory/ImageAllocator.h"
+#include "RFVK/Debug/GpuProfiler.h"
 
 SubpassBuilder::SubpassBuilder()
 : myColorAttachments{}
@@ -88,7 +89,10 @@ RenderPassBuilder::RenderPassBuilder(
 	, theirImageAllocator(imageAllocator)
 	, theirRenderPassFactory(renderPassFactory)
 	, myOwners{}
-
+	, myAttachmentViews{}
+	, myAttachmentImages{}
+	, myAttachmentRanges{}
+	, myAttachmentIsTransient{}
 {
 	myOwners.resize(numOwners);
 	for (uint32_t familyIndex = 0; familyIndex < numOwners; ++familyIndex)
@@ -115,7 +119,7 @@ RenderPassBuilder::DefineAttachments(
 
 	myAttachmentDebugNames.resize(myNumAttachments);
 
-	memcpy(myAttachmentFormats.data(), attachmentFormats.data(), attachmentFormats.size() * sizeof VkFormat);
+	memcpy(myAttachmentFormats.data(), attachmentFormats.data(), attachmentFormats.size() * sizeof(VkFormat));
 
 
 	for (uint32_t attIndex = 0; attIndex < myNumAttachments; attIndex++)
@@ -194,6 +198,18 @@ RenderPassBuilder::SetImageViews(
 	myAttachmentViews[attachmentIndex] = views;
 }
 
+void
+RenderPassBuilder::SetImageViews(
+	uint32_t				attachmentIndex, 
+	VkImageView				view,
+	VkImage					image,
+	VkImageSubresourceRange	range)
+{
+	myAttachmentViews[attachmentIndex].fill(view);
+	myAttachmentImages[attachmentIndex].fill(image);
+	myAttachmentRanges[attachmentIndex] = range;
+}
+
 SubpassBuilder& 
 RenderPassBuilder::AddSubpass()
 {
@@ -206,6 +222,33 @@ RenderPassBuilder::AddSubpassDependency(VkSubpassDependency&& dependency)
 	mySubpassDependencies.emplace_back(dependency);
 }
 
+void
+RenderPassBuilder::SetTransient(
+	std::vector<uint32_t>&&		attachmentIndices,
+	const TransientLifetime&	lifetime)
+{
+	myTransientLifetime = lifetime;
+	for (auto attIndex : attachmentIndices)
+	{
+		if (attIndex >= myNumAttachments
+			|| myAttachmentFormats[attIndex] == IntermediateAttachment
+			|| myAttachmentFormats[attIndex] == SwapchainAttachment)
+		{
+			LOG("failed setting attachment", attIndex, "transient, only attachments owned by the render pass can be");
+			continue;
+		}
+		myAttachmentIsTransient[attIndex] = true;
+		myAttachmentDescriptions[attIndex].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		myAttachmentDescriptions[attIndex].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	}
+}
+
+void
+RenderPassBuilder::SetName(const char* name)
+{
+	myName = name;
+}
+
 VkAttachmentDescription& 
 RenderPassBuilder::EditAttachmentDescription(uint32_t attachmentIndex)
 {
@@ -220,6 +263,30 @@ RenderPassBuilder::Build()
 
 	retPass.numAttachments = myNumAttachments;
 	retPass.clearValues = myAttachmentClearValues;
+	retPass.name = myName;
+	retPass.profileZone = NoGpuZone;
+
+	// ATTACHMENTS
+	auto result = CreateAttachmentImages();
+	if (result)
+	{
+		LOG("failed creating render pass");
+		return retPass;
+	}
+
+	// DYNAMIC RENDERING
+	if (theirVulkanFramework.IsDynamicRendering() && (SplitSubpasses || !HasInputAttachments()))
+	{
+		result = BuildDynamic(retPass);
+		if (!result)
+		{
+			CreateInputDescriptors(retPass);
+			theirRenderPassFactory.RegisterRenderPass(retPass);
+			return retPass;
+		}
+		LOG("attachment images unresolved, falling back to render pass object");
+		retPass.isDynamic = false;
+	}
 
 	std::vector<VkSubpassDescription> subpassDescriptions;
 	for (auto& subpass : mySubpasses)
@@ -242,44 +309,86 @@ RenderPassBuilder::Build()
 	rpInfo.pDependencies = mySubpassDependencies.data();
 	rpInfo.dependencyCount = mySubpassDependencies.size();
 
-	auto result = vkCreateRenderPass(theirVulkanFramework.GetDevice(), &rpInfo, nullptr, &retPass.renderPass);
+	result = vkCreateRenderPass(theirVulkanFramework.GetDevice(), &rpInfo, nullptr, &retPass.renderPass);
 	if (result)
 	{
 		LOG("failed creating render pass");
 		return {};
 	}
+
 	// FRAMEBUFFER
+	result = BuildFramebuffer(retPass);
+	if (result)
 	{
-		result = CreateAttachmentImages();
-		if (result)
-		{
-			LOG("failed creating render pass");
-			return retPass;
-		}
-		result = BuildFramebuffer(retPass);
-		if (result)
-		{
-			LOG("failed creating render pass");
-			return retPass;
-		}
+		LOG("failed creating render pass");
+		return retPass;
 	}
 
-	// INPUT ATTACHMENTS
+	CreateInputDescriptors(retPass);
+	theirRenderPassFactory.RegisterRenderPass(retPass);
+	return retPass;
+}
+
+void
+RenderPassBuilder::CreateInputDescriptors(RenderPass& renderPass)
+{
 	for (uint32_t subpassIndex = 0; subpassIndex < mySubpasses.size(); ++subpassIndex)
 	{
 		if (mySubpasses[subpassIndex].myNumInputAttachments > 0)
 		{
-			theirRenderPassFactory.CreateInputDescriptors(retPass, *this, subpassIndex);
+			theirRenderPassFactory.CreateInputDescriptors(renderPass, *this, subpassIndex);
 		}
 	}
-
-	theirRenderPassFactory.RegisterRenderPass(retPass);
-	return retPass;
 }
 
 VkResult
 RenderPassBuilder::CreateAttachmentImages()
 {
+	// TRANSIENT
+	std::vector<TransientImageRequest> transientRequests;
+	std::vector<uint32_t> transientIndices;
+	for (uint32_t attIndex = 0; attIndex < myNumAttachments; ++attIndex)
+	{
+		if (!myAttachmentIsTransient[attIndex] || myAttachmentViews[attIndex][0])
+		{
+			continue;
+		}
+		const VkFormat format = myAttachmentFormats[attIndex];
+
+		TransientImageRequest request{};
+		request.format = format;
+		request.name = myAttachmentDebugNames[attIndex].c_str();
+		request.range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+		request.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		if (format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D24_UNORM_S8_UINT)
+		{
+			request.range.aspectMask = format == VK_FORMAT_D32_SFLOAT 
+				? VK_IMAGE_ASPECT_DEPTH_BIT 
+				: VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+			request.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		}
+		if (IsSplit() && IsInputAttachment(attIndex))
+		{
+			request.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+		}
+		transientRequests.emplace_back(request);
+		transientIndices.emplace_back(attIndex);
+	}
+	if (!transientRequests.empty())
+	{
+		auto result = theirRenderPassFactory.AllocateTransientImages(transientRequests, myAttachmentRes, myTransientLifetime);
+		if (result)
+		{
+			LOG("render pass creation error: failed creating transient attachments");
+			return result;
+		}
+		for (uint32_t requestIndex = 0; requestIndex < transientRequests.size(); ++requestIndex)
+		{
+			auto& request = transientRequests[requestIndex];
+			SetImageViews(transientIndices[requestIndex], request.view, request.image, request.range);
+		}
+	}
+
 	for (uint32_t attIndex = 0; attIndex < myNumAttachments; ++attIndex)
 	{
 		if (myAttachmentViews[attIndex][0])
@@ -314,6 +423,10 @@ RenderPassBuilder::CreateAttachmentImages()
 			usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
 			stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		}
+		if (IsSplit() && IsInputAttachment(attIndex))
+		{
+			usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+		}
 
 
 		{
@@ -382,4 +495,136 @@ RenderPassBuilder::BuildFramebuffer(RenderPass& renderPass)
 	}
 
 	return VK_SUCCESS;
+}
+
+VkResult
+RenderPassBuilder::BuildDynamic(RenderPass& renderPass)
+{
+	// subpass dependencies are replaced by the barriers recorded around each subpass
+	auto swapchainImages = theirVulkanFramework.GetSwapchainImages();
+	for (uint32_t attIndex = 0; attIndex < myNumAttachments; ++attIndex)
+	{
+		auto& description = myAttachmentDescriptions[attIndex];
+		auto& attachment = renderPass.attachments[attIndex];
+
+		attachment.format = description.format;
+		attachment.loadOp = description.loadOp;
+		attachment.storeOp = description.storeOp;
+		attachment.initialLayout = description.initialLayout;
+		attachment.finalLayout = description.finalLayout;
+		attachment.views = myAttachmentViews[attIndex];
+		attachment.firstSubpass = VK_ATTACHMENT_UNUSED;
+		attachment.lastSubpass = VK_ATTACHMENT_UNUSED;
+
+		attachment.range = myAttachmentRanges[attIndex];
+		if (!attachment.range.aspectMask)
+		{
+			if (description.format == VK_FORMAT_D24_UNORM_S8_UINT)
+			{
+				attachment.range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+			}
+			else if (description.format == VK_FORMAT_D32_SFLOAT)
+			{
+				attachment.range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+			}
+			else
+			{
+				attachment.range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			}
+			attachment.range.levelCount = 1;
+			attachment.range.layerCount = 1;
+		}
+
+		for (uint32_t scIndex = 0; scIndex < NumSwapchainImages; ++scIndex)
+		{
+			VkImage image = myAttachmentImages[attIndex][scIndex];
+			if (!image && myAttachmentFormats[attIndex] == SwapchainAttachment)
+			{
+				image = swapchainImages[scIndex];
+			}
+			else if (!image)
+			{
+				image = theirImageAllocator.GetImage(attachment.views[scIndex]);
+			}
+			if (!image)
+			{
+				return VK_ERROR_INITIALIZATION_FAILED;
+			}
+			attachment.images[scIndex] = image;
+		}
+	}
+
+	auto markUse = [&renderPass](uint32_t attIndex, uint32_t subpassIndex)
+	{
+		auto& attachment = renderPass.attachments[attIndex];
+		if (attachment.firstSubpass == VK_ATTACHMENT_UNUSED)
+		{
+			attachment.firstSubpass = subpassIndex;
+		}
+		attachment.lastSubpass = subpassIndex;
+	};
+	for (uint32_t subpassIndex = 0; subpassIndex < mySubpasses.size(); ++subpassIndex)
+	{
+		auto& subpass = mySubpasses[subpassIndex];
+		auto& dynamicSubpass = renderPass.dynamicSubpasses[subpassIndex];
+
+		dynamicSubpass.numColorAttachments = subpass.myNumColorAttachments;
+		for (uint32_t colorIndex = 0; colorIndex < subpass.myNumColorAttachments; ++colorIndex)
+		{
+			dynamicSubpass.colorAttachments[colorIndex] = subpass.myColorAttachments[colorIndex].attachment;
+			markUse(dynamicSubpass.colorAttachments[colorIndex], subpassIndex);
+		}
+
+		dynamicSubpass.depthAttachment = VK_ATTACHMENT_UNUSED;
+		if (subpass.myDescription.pDepthStencilAttachment)
+		{
+			dynamicSubpass.depthAttachment = subpass.myDepthAttachment.attachment;
+			markUse(dynamicSubpass.depthAttachment, subpassIndex);
+		}
+
+		dynamicSubpass.numInputAttachments = subpass.myNumInputAttachments;
+		for (uint32_t inputIndex = 0; inputIndex < subpass.myNumInputAttachments; ++inputIndex)
+		{
+			dynamicSubpass.inputAttachments[inputIndex] = subpass.myInputAttachments[inputIndex].attachment;
+			markUse(dynamicSubpass.inputAttachments[inputIndex], subpassIndex);
+		}
+	}
+
+	renderPass.isDynamic = true;
+	return VK_SUCCESS;
+}
+
+bool
+RenderPassBuilder::HasInputAttachments() const
+{
+	for (auto& subpass : mySubpasses)
+	{
+		if (subpass.myNumInputAttachments > 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+RenderPassBuilder::IsInputAttachment(uint32_t attachmentIndex) const
+{
+	for (auto& subpass : mySubpasses)
+	{
+		for (uint32_t inputIndex = 0; inputIndex < subpass.myNumInputAttachments; ++inputIndex)
+		{
+			if (subpass.myInputAttachments[inputIndex].attachment == attachmentIndex)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool
+RenderPassBuilder::IsSplit() const
+{
+	return SplitSubpasses && theirVulkanFramework.IsDynamicRendering() && HasInputAttachments();
 }
\ No newline at end of file
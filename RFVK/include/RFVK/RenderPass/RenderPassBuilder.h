@@ -27,6 +27,14 @@ private:
 
 };
 
+// passes are counted in the order the owner records them within a frame
+struct TransientLifetime
+{
+	const void*				owner = nullptr;
+	uint32_t				firstPass = 0;
+	uint32_t				lastPass = 0;
+};
+
 constexpr VkFormat IntermediateAttachment = VK_FORMAT_UNDEFINED;
 constexpr VkFormat SwapchainAttachment = VK_FORMAT_MAX_ENUM;
 class RenderPassBuilder
@@ -49,6 +57,19 @@ public:
 	void										SetImageViews(
 													uint32_t										attachmentIndex, 
 													std::array<VkImageView, NumSwapchainImages>&&	views);
+	// views created outside the image allocator, dynamic rendering transitions the image range itself
+	void										SetImageViews(
+													uint32_t				attachmentIndex, 
+													VkImageView				view,
+													VkImage					image,
+													VkImageSubresourceRange	range);
+
+	// contents are discarded when the pass ends, their memory is aliased with images not alive at the same time
+	void										SetTransient(
+													std::vector<uint32_t>&&		attachmentIndices,
+													const TransientLifetime&	lifetime);
+	// shown by the gpu profiler, has to outlive the render pass
+	void										SetName(const char* name);
 
 	VkAttachmentDescription&					EditAttachmentDescription(uint32_t attachmentIndex);
 
@@ -66,6 +87,12 @@ private:
 
 	VkResult									CreateAttachmentImages();
 	VkResult									BuildFramebuffer(RenderPass& renderPass);
+	VkResult									BuildDynamic(RenderPass& renderPass);
+	void										CreateInputDescriptors(RenderPass& renderPass);
+	bool										HasInputAttachments() const;
+	bool										IsInputAttachment(uint32_t attachmentIndex) const;
+	// dynamic rendering ends the rendering scope before a subpass reading input attachments, they are sampled instead
+	bool										IsSplit() const;
 
 	VulkanFramework&							theirVulkanFramework;
 	ImageAllocator&								theirImageAllocator;
@@ -81,9 +108,16 @@ private:
 												myAttachmentDescriptions;
 	std::array<std::array<VkImageView, NumSwapchainImages>, MaxNumAttachments>
 												myAttachmentViews;
+	std::array<std::array<VkImage, NumSwapchainImages>, MaxNumAttachments>
+												myAttachmentImages;
+	std::array<VkImageSubresourceRange, MaxNumAttachments>
+												myAttachmentRanges;
 	std::array<VkClearValue, MaxNumAttachments>	myAttachmentClearValues;
+	std::array<bool, MaxNumAttachments>			myAttachmentIsTransient;
+	TransientLifetime							myTransientLifetime;
 
 	std::vector<std::string>					myAttachmentDebugNames;
+	const char*									myName = "RenderPass";
 
 	std::vector<SubpassBuilder>					mySubpasses;
 	std::vector<VkSubpassDependency>			mySubpassDependencies;
@@ -5,6 +5,8 @@
 #include "RFVK/Debug/DebugUtils.h"
 #include "RFVK/Memory/ImageAllocator.h"
 
+#include <algorithm>
+
 RenderPassFactory::RenderPassFactory(
 	VulkanFramework&	vulkanFramework,
 	ImageAllocator&		imageAllocator,
@@ -32,7 +34,8 @@ RenderPassFactory::RenderPassFactory(
 		requestInfo.owners = myOwners;
 		requestInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
 		requestInfo.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		requestInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		requestInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT
+			| (SplitSubpasses ? VK_IMAGE_USAGE_SAMPLED_BIT : VkImageUsageFlags(0));
 		requestInfo.targetPipelineStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 		std::tie(result, myIntermediateViews[scIndex]) = theirImageAllocator.RequestImage2D(
 			allocSub, 
@@ -57,20 +60,45 @@ RenderPassFactory::RenderPassFactory(
 	myIntermediateAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
 
 	// INPUT ATTACHMENT POOL
+	// split subpasses of dynamic passes sample their inputs instead
 	VkDescriptorPoolSize inputSz{};
 	inputSz.descriptorCount = 128;
 	inputSz.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+	VkDescriptorPoolSize sampledInputSz{};
+	sampledInputSz.descriptorCount = 128;
+	sampledInputSz.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+	std::array poolSizes
+	{
+		inputSz,
+		sampledInputSz,
+	};
 
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 
 	poolInfo.maxSets = 64;
-	poolInfo.poolSizeCount = 1;
-	poolInfo.pPoolSizes = &inputSz;
+	poolInfo.poolSizeCount = poolSizes.size();
+	poolInfo.pPoolSizes = poolSizes.data();
 
 	result = vkCreateDescriptorPool(theirVulkanFramework.GetDevice(), &poolInfo, nullptr, &myInputAttachmentPool);
 	assert(!result && "failed creating input attachment descriptor pool");
 
+	// INPUT SAMPLER
+	// inputs are fetched per pixel, filtering never applies
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = 0.f;
+
+	result = vkCreateSampler(theirVulkanFramework.GetDevice(), &samplerInfo, nullptr, &myInputSampler);
+	assert(!result && "failed creating input attachment sampler");
+
 }
 
 RenderPassFactory::~RenderPassFactory()
@@ -80,6 +108,20 @@ RenderPassFactory::~RenderPassFactory()
 		DestroyRenderPass(renderPass, theirVulkanFramework.GetDevice());
 	}
 	vkDestroyDescriptorPool(theirVulkanFramework.GetDevice(), myInputAttachmentPool, nullptr);
+	vkDestroySampler(theirVulkanFramework.GetDevice(), myInputSampler, nullptr);
+
+	for (auto view : myTransientViews)
+	{
+		vkDestroyImageView(theirVulkanFramework.GetDevice(), view, nullptr);
+	}
+	for (auto image : myTransientImages)
+	{
+		vkDestroyImage(theirVulkanFramework.GetDevice(), image, nullptr);
+	}
+	for (auto& heap : myTransientHeaps)
+	{
+		vkFreeMemory(theirVulkanFramework.GetDevice(), heap.memory, nullptr);
+	}
 }
 
 RenderPassBuilder
@@ -98,12 +140,265 @@ RenderPassFactory::RegisterRenderPass(const RenderPass& renderPass)
 	}
 }
 
+VkResult
+RenderPassFactory::AllocateTransientImages(
+	std::vector<TransientImageRequest>&	requests,
+	Vec2f								resolution,
+	const TransientLifetime&			lifetime)
+{
+	auto device = theirVulkanFramework.GetDevice();
+
+	// IMAGES
+	std::vector<QueueFamilyIndex> families = myOwners;
+	std::sort(families.begin(), families.end());
+	families.erase(std::unique(families.begin(), families.end()), families.end());
+
+	std::vector<VkMemoryRequirements> memReqs;
+	uint32_t typeBits = UINT_MAX;
+	for (auto& request : requests)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = request.format;
+		imageInfo.extent = {uint32_t(resolution.x), uint32_t(resolution.y), 1};
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		// only contents that never leave the render pass may live in tile memory
+		constexpr VkImageUsageFlags attachmentUsage =
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+			| VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+			| VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		imageInfo.usage = request.usage & ~attachmentUsage
+			? request.usage
+			: request.usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		// shared by every queue, frame graph semaphores order the owners
+		imageInfo.sharingMode = families.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.pQueueFamilyIndices = families.data();
+		imageInfo.queueFamilyIndexCount = families.size();
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		auto result = vkCreateImage(device, &imageInfo, nullptr, &request.image);
+		if (result)
+		{
+			LOG("failed creating transient image", request.name);
+			return result;
+		}
+		myTransientImages.emplace_back(request.image);
+		DebugSetObjectName(request.name, request.image, VK_OBJECT_TYPE_IMAGE, device);
+
+		VkMemoryRequirements memReq;
+		vkGetImageMemoryRequirements(device, request.image, &memReq);
+		memReqs.emplace_back(memReq);
+		typeBits &= memReq.memoryTypeBits;
+		myUnaliasedTransientBytes += memReq.size;
+	}
+
+	// PLACEMENT
+	const MemTypeIndex typeIndex = FindTransientMemoryType(typeBits);
+	if (typeIndex == UINT_MAX)
+	{
+		LOG("failed allocating transient images, no memory type fits all of them");
+		return VK_ERROR_FEATURE_NOT_PRESENT;
+	}
+
+	std::vector<TransientPlacement> placements;
+	auto tryPlace = [&](const std::vector<TransientPlacement>& existing)
+	{
+		placements.clear();
+		auto occupied = existing;
+		for (auto& memReq : memReqs)
+		{
+			const VkDeviceSize offset = PlaceTransient(occupied, memReq, lifetime);
+			placements.emplace_back(TransientPlacement{offset, memReq.size, lifetime});
+			occupied.emplace_back(placements.back());
+		}
+	};
+
+	TransientHeap* heap = nullptr;
+	for (auto& candidate : myTransientHeaps)
+	{
+		if (candidate.typeIndex != typeIndex)
+		{
+			continue;
+		}
+		tryPlace(candidate.placements);
+		bool fits = true;
+		for (auto& placement : placements)
+		{
+			fits &= placement.offset + placement.size <= candidate.size;
+		}
+		if (fits)
+		{
+			heap = &candidate;
+			break;
+		}
+	}
+	if (!heap)
+	{
+		tryPlace({});
+		VkDeviceSize heapSize = 0;
+		for (auto& placement : placements)
+		{
+			heapSize = std::max(heapSize, placement.offset + placement.size);
+		}
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = heapSize;
+		allocInfo.memoryTypeIndex = typeIndex;
+
+		TransientHeap newHeap{nullptr, heapSize, typeIndex};
+		auto result = vkAllocateMemory(device, &allocInfo, nullptr, &newHeap.memory);
+		if (result)
+		{
+			LOG("failed allocating transient heap of", heapSize, "bytes");
+			return result;
+		}
+		heap = &myTransientHeaps.emplace_back(std::move(newHeap));
+	}
+	heap->placements.insert(heap->placements.end(), placements.begin(), placements.end());
+
+	// BIND AND VIEW
+	for (uint32_t requestIndex = 0; requestIndex < requests.size(); ++requestIndex)
+	{
+		auto& request = requests[requestIndex];
+		auto result = vkBindImageMemory(device, request.image, heap->memory, placements[requestIndex].offset);
+		if (result)
+		{
+			LOG("failed binding transient image", request.name);
+			return result;
+		}
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+
+		viewInfo.image = request.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = request.format;
+		viewInfo.subresourceRange = request.range;
+
+		result = vkCreateImageView(device, &viewInfo, nullptr, &request.view);
+		if (result)
+		{
+			LOG("failed creating view for transient image", request.name);
+			return result;
+		}
+		myTransientViews.emplace_back(request.view);
+	}
+
+	return VK_SUCCESS;
+}
+
+VkDeviceSize
+RenderPassFactory::PlaceTransient(
+	const std::vector<TransientPlacement>&	placements,
+	const VkMemoryRequirements&				memReq,
+	const TransientLifetime&				lifetime)
+{
+	// different owners never overlap in the frame graph, one owner's images only conflict while both are alive
+	auto isAliveTogether = [&](const TransientLifetime& other)
+	{
+		return other.owner == lifetime.owner
+			&& other.firstPass <= lifetime.lastPass
+			&& lifetime.firstPass <= other.lastPass;
+	};
+	auto alignUp = [&](VkDeviceSize offset)
+	{
+		return (offset + memReq.alignment - 1) / memReq.alignment * memReq.alignment;
+	};
+
+	// the lowest free offset is either the heap start or right after a conflicting image
+	std::vector<VkDeviceSize> candidates{0};
+	for (auto& placement : placements)
+	{
+		if (isAliveTogether(placement.lifetime))
+		{
+			candidates.emplace_back(alignUp(placement.offset + placement.size));
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	for (auto offset : candidates)
+	{
+		bool isFree = true;
+		for (auto& placement : placements)
+		{
+			isFree &= !isAliveTogether(placement.lifetime)
+				|| offset + memReq.size <= placement.offset
+				|| placement.offset + placement.size <= offset;
+		}
+		if (isFree)
+		{
+			return offset;
+		}
+	}
+	return candidates.back();
+}
+
+void
+RenderPassFactory::LogTransientMemory() const
+{
+	auto [w, h] = theirVulkanFramework.GetTargetResolution();
+	auto memProps = theirVulkanFramework.GetPhysicalDeviceMemProps();
+
+	VkDeviceSize residentBytes = 0;
+	bool isLazy = false;
+	for (auto& heap : myTransientHeaps)
+	{
+		residentBytes += heap.size;
+		isLazy |= memProps.memoryTypes[heap.typeIndex].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+	}
+	LOG("transient images at", w, "x", h, ":",
+		residentBytes / 1024, "kB peak,",
+		myUnaliasedTransientBytes / 1024, "kB unaliased",
+		isLazy ? "(lazily allocated)" : "");
+}
+
+MemTypeIndex
+RenderPassFactory::FindTransientMemoryType(uint32_t typeBits) const
+{
+	// lazily allocated memory is only committed for what a pass actually touches, tilers may never commit it
+	auto memProps = theirVulkanFramework.GetPhysicalDeviceMemProps();
+	const VkMemoryPropertyFlags preferences[]
+	{
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+	};
+	for (auto flags : preferences)
+	{
+		for (MemTypeIndex typeIndex = 0; typeIndex < memProps.memoryTypeCount; ++typeIndex)
+		{
+			if ((typeBits & (1 << typeIndex)) && (memProps.memoryTypes[typeIndex].propertyFlags & flags) == flags)
+			{
+				return typeIndex;
+			}
+		}
+	}
+	return UINT_MAX;
+}
+
 std::array<VkImageView, NumSwapchainImages>
 RenderPassFactory::GetIntermediateAttachmentViews() const
 {
 	return myIntermediateViews;
 }
 
+ResourceUse
+RenderPassFactory::GetIntermediateUse(ResourceAccess access) const
+{
+	return {uint64_t(myIntermediateViews[0]), "intermediate", access};
+}
+
+ResourceUse
+RenderPassFactory::GetTransientUse() const
+{
+	return {uint64_t(&myTransientHeaps), "transient heap", ResourceAccess::Write};
+}
+
 VkAttachmentDescription
 RenderPassFactory::GetIntermediateAttachmentDesc() const
 {
@@ -120,12 +415,20 @@ RenderPassFactory::CreateInputDescriptors(
 	auto inputAttachmentRefs = constructor.mySubpasses[subpassIndex].myInputAttachments;
 	auto& subpass = renderPass.subpasses[subpassIndex];
 
+	// the rendering scope of a dynamic pass ends before the subpass, it samples the stored attachments
+	const VkDescriptorType descriptorType = renderPass.isDynamic
+		? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+		: VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+	std::array<VkSampler, MaxNumAttachments> samplers;
+	samplers.fill(myInputSampler);
+
 	// LAYOUT
 	VkDescriptorSetLayoutBinding binding{};
 	binding.descriptorCount = numInputAttachments;
-	binding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+	binding.descriptorType = descriptorType;
 	binding.binding = 0;
 	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	binding.pImmutableSamplers = renderPass.isDynamic ? samplers.data() : nullptr;
 
 	VkDescriptorSetLayoutCreateInfo layoutInfo{};
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -166,7 +469,7 @@ RenderPassFactory::CreateInputDescriptors(
 			uint32_t attachmentIndex = inputAttachmentRefs[inputIndex].attachment;
 
 			VkDescriptorImageInfo imgInfo{};
-			imgInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imgInfo.imageLayout = inputAttachmentRefs[inputIndex].layout;
 			imgInfo.imageView = constructor.myAttachmentViews[attachmentIndex][scIndex];
 
 			inputImgInfos.emplace_back(imgInfo);
@@ -177,7 +480,7 @@ RenderPassFactory::CreateInputDescriptors(
 
 		write.dstSet = subpass.inputAttachmentSets[scIndex];
 		write.dstBinding = 0;
-		write.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		write.descriptorType = descriptorType;
 		write.descriptorCount = numInputAttachments;
 		write.dstArrayElement = 0;
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "RenderPass.h"
 #include "RenderPassBuilder.h"
+#include "RFVK/WorkerSystem/FrameResource.h"
 
 enum class RenderPassRequestFlags
 {
@@ -10,6 +11,33 @@ enum class RenderPassRequestFlags
 
 };
 
+struct TransientImageRequest
+{
+	VkFormat				format;
+	VkImageUsageFlags		usage;
+	VkImageSubresourceRange	range;
+	const char*				name;
+
+	VkImage					image = nullptr;
+	VkImageView				view = nullptr;
+};
+
+struct TransientPlacement
+{
+	VkDeviceSize			offset;
+	VkDeviceSize			size;
+	TransientLifetime		lifetime;
+};
+
+struct TransientHeap
+{
+	VkDeviceMemory			memory = nullptr;
+	VkDeviceSize			size = 0;
+	MemTypeIndex			typeIndex = 0;
+	std::vector<TransientPlacement>
+							placements;
+};
+
 class RenderPassFactory
 {
 public:
@@ -27,8 +55,19 @@ public:
 													uint32_t			subpassIndex) const;
 	void										RegisterRenderPass(const RenderPass& renderPass);
 
+	// images only share memory with images never alive at the same time, owners are ordered by GetTransientUse
+	// contents that leave their render pass, stored or sampled, are backed by device memory rather than lazily
+	VkResult									AllocateTransientImages(
+													std::vector<TransientImageRequest>&	requests,
+													Vec2f								resolution,
+													const TransientLifetime&			lifetime);
+	void										LogTransientMemory() const;
+	// declared by every system owning transient images, so the frame graph never overlaps two of them
+	_nodiscard ResourceUse						GetTransientUse() const;
+
 	std::array<VkImageView, NumSwapchainImages> GetIntermediateAttachmentViews() const;
 	VkAttachmentDescription						GetIntermediateAttachmentDesc() const;
+	_nodiscard ResourceUse						GetIntermediateUse(ResourceAccess access) const;
 
 
 private:
@@ -38,10 +77,22 @@ private:
 	std::vector<QueueFamilyIndex>				myOwners;
 
 	VkDescriptorPool							myInputAttachmentPool;
+	VkSampler									myInputSampler = nullptr;
 
 	neat::static_vector<RenderPass, 64>			myRenderPasses;
 
 	std::array<VkImageView, NumSwapchainImages>	myIntermediateViews;
 	VkAttachmentDescription						myIntermediateAttachmentDescription;
 
+	MemTypeIndex								FindTransientMemoryType(uint32_t typeBits) const;
+	static VkDeviceSize							PlaceTransient(
+													const std::vector<TransientPlacement>&	placements,
+													const VkMemoryRequirements&				memReq,
+													const TransientLifetime&				lifetime);
+
+	std::vector<TransientHeap>					myTransientHeaps;
+	std::vector<VkImage>						myTransientImages;
+	std::vector<VkImageView>					myTransientViews;
+	VkDeviceSize								myUnaliasedTransientBytes = 0;
+
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Uniform/UniformHandler.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 
 SceneGlobals::SceneGlobals(
 	VulkanFramework&	vulkanFramework,
@@ -25,7 +26,7 @@ SceneGlobals::SceneGlobals(
 
 	QueueFamilyIndex indices[2]{graphicsFamily, transferFamily};
 	myViewProjectionID = theirUniformHandler.RequestUniformBuffer(&myGlobalsData,
-																   sizeof UniformGlobals);
+																   sizeof(UniformGlobals));
 	assert(!(BAD_ID(myViewProjectionID)) && "failed creating view projection uniform");
 
 }
@@ -39,7 +40,7 @@ SceneGlobals::GetGlobalsLayout() const
 
 void
 SceneGlobals::BindGlobals(
-	VkCommandBuffer		commandBuffer,
+	CommandRecorder&	recorder,
 	VkPipelineLayout	pipelineLayout,
 	uint32_t			setIndex,
 	VkPipelineBindPoint	bindPoint)
@@ -47,14 +48,7 @@ SceneGlobals::BindGlobals(
 	theirUniformHandler.UpdateUniformData(myViewProjectionID, &myGlobalsData);
 
 	auto [layout, set] = theirUniformHandler[myViewProjectionID];
-	vkCmdBindDescriptorSets(commandBuffer,
-							 bindPoint,
-							 pipelineLayout,
-							 setIndex,
-							 1,
-							 &set,
-							 0,
-							 nullptr);
+	recorder.BindDescriptorSet(bindPoint, pipelineLayout, setIndex, set);
 
 }
 
@@ -80,3 +74,17 @@ SceneGlobals::SetSkybox(CubeID id)
 {
 	myGlobalsData.skyboxID = uint32_t(id);
 }
+
+float
+SceneGlobals::EstimateScreenSize(
+	const Mat4f& transform) const
+{
+	const float radius = std::max({
+		glm::length(Vec3f(transform[0])),
+		glm::length(Vec3f(transform[1])),
+		glm::length(Vec3f(transform[2]))});
+	const Vec4f viewPos = myGlobalsData.view * transform[3];
+	const float depth = std::max(viewPos.z, radius);
+
+	return radius * myGlobalsData.proj[1][1] / depth * myGlobalsData.resolution.y;
+}
@@ -24,7 +24,7 @@ public:
 
 	VkDescriptorSetLayout	GetGlobalsLayout() const;
 	void					BindGlobals(
-								VkCommandBuffer		commandBuffer,
+								class CommandRecorder&	recorder,
 								VkPipelineLayout	pipelineLayout,
 								uint32_t			setIndex,
 								VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
@@ -36,6 +36,9 @@ public:
 	void					SetSkybox(
 								CubeID id);
 
+	_nodiscard float		EstimateScreenSize(
+								const Mat4f& transform) const;
+
 private:
 	VulkanFramework&		theirVulkanFramework;
 	UniformHandler&			theirUniformHandler;
@@ -1,57 +1,67 @@
 #include "pch.h"
 #include "Shader.h"
 
-#include "VKCompile.h"
+#include "ShaderCache.h"
 
 #include <fstream>
 #include <iostream>
 #include <filesystem>
-#include "neat/FS/FileUtil.h"
 #include "RFVK/VulkanFramework.h"
 
 Shader::Shader(
-	const char			(*firstShaderPath)[128],
-	uint32_t			numShaderPaths,
-	VulkanFramework&	vulkanFramework)
+	const char					(*firstShaderPath)[128],
+	uint32_t					numShaderPaths,
+	VulkanFramework&			vulkanFramework,
+	std::vector<std::string>	featureKeys,
+	ShaderPermutation			permutation)
 	: theirVulkanFramework(vulkanFramework)
-	, myShaderModules{}
+	, myShaderPaths(std::make_unique<char[][128]>(numShaderPaths))
 	, myNumShaderModules(numShaderPaths)
+	, myFeatureKeys(std::move(featureKeys))
 {
-	for (uint32_t i = 0; i < numShaderPaths; ++i)
-	{
-		auto bin = FetchBinaryData(firstShaderPath[i]);
-		assert(!bin.empty() && "shader binary data empty");
-
-		VkShaderModuleCreateInfo vShaderModuleInfo{};
-		vShaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		vShaderModuleInfo.pNext = nullptr;
-
-		vShaderModuleInfo.flags = NULL;
-		vShaderModuleInfo.codeSize = bin.size() * 4;
-		vShaderModuleInfo.pCode = reinterpret_cast<uint32_t*>(bin.data());
-
-		myShaderModules[i].stage = EvaluateShaderStage(firstShaderPath[i]);
+	assert(myFeatureKeys.size() < sizeof(ShaderPermutation) * 8 && "too many shader feature keys");
+	memcpy(myShaderPaths.get(), firstShaderPath, size_t(numShaderPaths) * 128);
 
-		const auto resultVert = vkCreateShaderModule(theirVulkanFramework.GetDevice(), &vShaderModuleInfo, nullptr, &myShaderModules[i].mod);
-		assert(!resultVert && "failed creating shader module");
+#ifdef _DEBUG
+	// the offline bundle only holds declared permutations, catch a missing declaration before a release build does
+	for (uint32_t i = 0; i < myNumShaderModules; ++i)
+	{
+		for (const auto& feature : myFeatureKeys)
+		{
+			if (!ShaderCache::IsDeclared(myShaderPaths[i], feature))
+			{
+				LOG("feature key", feature, "of \"", myShaderPaths[i], "\" is missing from DeclaredShaderFeatures");
+				assert(false && "shader feature key not declared");
+			}
+		}
 	}
+#endif
+
+	// the permutation asked for up front is ready once constructed, others wait until bound
+	FetchVariant(permutation);
 }
 
 
 Shader::~Shader()
 {
-	for (uint32_t i = 0; i < myNumShaderModules; ++i)
+	for (auto& [permutation, variant] : myVariants)
 	{
-		if (myShaderModules[i].mod)
+		for (uint32_t i = 0; i < myNumShaderModules; ++i)
 		{
-			vkDestroyShaderModule(theirVulkanFramework.GetDevice(), myShaderModules[i].mod, nullptr);
+			if (variant[i].mod)
+			{
+				vkDestroyShaderModule(theirVulkanFramework.GetDevice(), variant[i].mod, nullptr);
+			}
 		}
 	}
 }
 
 BoundModules
-Shader::Bind()
+Shader::Bind(
+	ShaderPermutation permutation)
 {
+	const auto& variant = FetchVariant(permutation);
+
 	std::array<VkPipelineShaderStageCreateInfo, MaxNumShaderModulesPerShader> ret{};
 	for (uint32_t i = 0; i < myNumShaderModules; ++i)
 	{
@@ -60,8 +70,8 @@ Shader::Bind()
 		stage.pNext = nullptr;
 		stage.flags = NULL;
 
-		stage.stage = myShaderModules[i].stage;
-		stage.module = myShaderModules[i].mod;
+		stage.stage = variant[i].stage;
+		stage.module = variant[i].mod;
 		stage.pName = "main";
 
 		ret[i] = stage;
@@ -70,79 +80,110 @@ Shader::Bind()
 	return {ret, myNumShaderModules};
 }
 
-std::vector<uint32_t>
-Shader::FetchBinaryData(const char* path) const
+ShaderPermutation
+Shader::GetPermutation(
+	std::initializer_list<const char*> features) const
 {
-	std::vector<uint32_t> retBin;
-
-	if (!std::filesystem::exists("Shaders/Cached/"))
+	ShaderPermutation permutation = 0;
+	for (const char* feature : features)
 	{
-		std::filesystem::create_directory("Shaders/Cached/");
+		auto it = std::find(myFeatureKeys.begin(), myFeatureKeys.end(), feature);
+		if (it == myFeatureKeys.end())
+		{
+			LOG("shader has no feature key", feature, "for", myShaderPaths[0]);
+			continue;
+		}
+		permutation |= ShaderPermutation(1) << (it - myFeatureKeys.begin());
 	}
-	std::string cachedPath = "Shaders/Cached/";
-
-	cachedPath.append(std::filesystem::path(path).filename().replace_extension(".spv").string());
+	return permutation;
+}
 
-	bool recompile = true;
-	if (std::filesystem::exists(cachedPath))
+std::vector<std::string>
+Shader::GetFeatures(
+	ShaderPermutation permutation) const
+{
+	std::vector<std::string> features;
+	for (uint32_t keyIndex = 0; keyIndex < myFeatureKeys.size(); ++keyIndex)
 	{
-		recompile = false;
-		if (neat::FileAgeDiff(cachedPath.c_str(), path) < 0)
+		if (permutation & (ShaderPermutation(1) << keyIndex))
 		{
-			recompile = true;
-		}
-		if (neat::FileAgeDiff(cachedPath.c_str(), "Shaders/common.glsl") < 0)
-		{
-			recompile = true;
-		}
-		if (neat::FileAgeDiff(cachedPath.c_str(), "Shaders/rt_common.glsl") < 0)
-		{
-			recompile = true;
-		}
-		if (!recompile)
-		{
-			LOG("using cached shader for", path);
-			std::ifstream inBin;
-			inBin.open(cachedPath, std::ios::binary | std::ios::ate);
-			if (!inBin.good())
-				return retBin;
-
-			auto size = inBin.tellg();
-			retBin.resize(size / sizeof(uint32_t));
-
-			inBin.seekg(0, std::ios::beg);
-			inBin.read((char*) retBin.data(), retBin.size() * 4);
-			inBin.close();
-			recompile = false;
+			features.emplace_back(myFeatureKeys[keyIndex]);
 		}
 	}
-	if (recompile)
+	return features;
+}
+
+const std::vector<std::string>&
+Shader::GetFeatureKeys() const
+{
+	return myFeatureKeys;
+}
+
+const char*
+Shader::GetShaderPath(
+	uint32_t index) const
+{
+	return myShaderPaths[index];
+}
+
+uint32_t
+Shader::GetNumShaderPaths() const
+{
+	return myNumShaderModules;
+}
+
+Shader::ShaderVariant&
+Shader::FetchVariant(
+	ShaderPermutation permutation)
+{
+	assert(!(permutation >> myFeatureKeys.size()) && "shader permutation uses undeclared feature keys");
+
+	std::scoped_lock lock(myVariantsMutex);
+	if (auto it = myVariants.find(permutation); it != myVariants.end())
 	{
-		LOG("compiling shader", path);
+		return it->second;
+	}
 
-		std::string preAmble;
-		preAmble.append("#define SET_SAMPLERS_COUNT ").append(std::to_string(MaxNumSamplers)).append("\n");
-		preAmble.append("#define SET_TLAS_COUNT ").append(std::to_string(MaxNumInstanceStructures)).append("\n");
-		preAmble.append("#define SAMPLED_IMAGE_2D_COUNT ").append(std::to_string(MaxNumImages)).append("\n");
-		preAmble.append("#define SAMPLED_IMAGE_2D_ARRAY_COUNT ").append(std::to_string(MaxNumImages)).append("\n");
-		preAmble.append("#define SAMPLED_CUBE_COUNT ").append(std::to_string(MaxNumImagesCube)).append("\n");
-		preAmble.append("#define STORAGE_IMAGE_COUNT ").append(std::to_string(MaxNumStorageImages)).append("\n");
-		preAmble.append("#define MAX_NUM_INSTANCES ").append(std::to_string(MaxNumInstances)).append("\n");
-		preAmble.append("#define MAX_NUM_MESHES ").append(std::to_string(MaxNumMeshesLoaded)).append("\n");
+	const auto features = GetFeatures(permutation);
+	const std::string preAmble = ShaderCache::PreAmble(features);
+	auto& shaderCache = theirVulkanFramework.GetShaderCache();
 
-		retBin = VKCompile(path, glslang::EShTargetVulkan_1_3, glslang::EShTargetSpv_1_5, preAmble.c_str());
-		if (!retBin.empty())
+	// all stages compile at once, modules are created as they come back
+	std::array<ShaderBinaryTask, MaxNumShaderModulesPerShader> binaryTasks;
+	for (uint32_t i = 0; i < myNumShaderModules; ++i)
+	{
+		if (permutation)
 		{
-			std::ofstream outBin;
-			outBin.open(cachedPath, std::ios::binary);
-
-			auto size = retBin.size() * sizeof(uint32_t);
-			outBin.write((const char*) retBin.data(), size);
-			outBin.close();
+			shaderCache.RecordPermutation(myShaderPaths[i], features);
 		}
+		binaryTasks[i] = shaderCache.FetchBinaryAsync(myShaderPaths[i], preAmble);
 	}
 
-	return retBin;
+	ShaderVariant& variant = myVariants[permutation];
+	variant = {};
+	for (uint32_t i = 0; i < myNumShaderModules; ++i)
+	{
+		auto bin = binaryTasks[i].get();
+		if (bin.empty())
+		{
+			LOG("FATAL: no binary for shader \"", myShaderPaths[i], "\" permutation", permutation);
+			std::abort();
+		}
+
+		VkShaderModuleCreateInfo vShaderModuleInfo{};
+		vShaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		vShaderModuleInfo.pNext = nullptr;
+
+		vShaderModuleInfo.flags = NULL;
+		vShaderModuleInfo.codeSize = bin.size() * 4;
+		vShaderModuleInfo.pCode = reinterpret_cast<uint32_t*>(bin.data());
+
+		variant[i].stage = EvaluateShaderStage(myShaderPaths[i]);
+
+		const auto resultVert = vkCreateShaderModule(theirVulkanFramework.GetDevice(), &vShaderModuleInfo, nullptr, &variant[i].mod);
+		assert(!resultVert && "failed creating shader module");
+	}
+	return variant;
 }
 
 VkShaderStageFlagBits
@@ -1,4 +1,3 @@
-
 #pragma once
 
 struct ShaderModule
@@ -19,18 +18,33 @@ public:
 															Shader(
 																const char(*firstShaderPath)[128],
 																uint32_t numShaderPaths,
-																class VulkanFramework& vulkanFramework);
+																class VulkanFramework& vulkanFramework,
+																std::vector<std::string> featureKeys = {},
+																ShaderPermutation permutation = 0);
 															~Shader();
 
-	BoundModules											Bind();
+	// compiles or loads the permutation the first time it is bound
+	BoundModules											Bind(ShaderPermutation permutation = 0);
+
+	_nodiscard ShaderPermutation							GetPermutation(std::initializer_list<const char*> features) const;
+	_nodiscard std::vector<std::string>						GetFeatures(ShaderPermutation permutation) const;
+	_nodiscard const std::vector<std::string>&				GetFeatureKeys() const;
+	_nodiscard const char*									GetShaderPath(uint32_t index) const;
+	_nodiscard uint32_t										GetNumShaderPaths() const;
 
 private:
-	std::vector<uint32_t>									FetchBinaryData(const char* path) const;
+	typedef std::array<ShaderModule, MaxNumShaderModulesPerShader> ShaderVariant;
+
+	ShaderVariant&											FetchVariant(ShaderPermutation permutation);
 	static VkShaderStageFlagBits							EvaluateShaderStage(const char* path);
 
 	VulkanFramework&										theirVulkanFramework;
 
-	std::array<ShaderModule, MaxNumShaderModulesPerShader>	myShaderModules;
+	std::unique_ptr<char[][128]>							myShaderPaths;
 	uint32_t												myNumShaderModules;
+	std::vector<std::string>								myFeatureKeys;
 
-};
\ No newline at end of file
+	std::mutex												myVariantsMutex;
+	std::unordered_map<ShaderPermutation, ShaderVariant>	myVariants;
+
+};
@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "ShaderBundle.h"
+
+constexpr uint32_t ShaderBundleMagic = 0x444E4253;
+constexpr uint32_t ShaderBundleVersion = 1;
+
+bool
+ShaderBundle::Load(
+	const char* path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good())
+	{
+		return false;
+	}
+	auto read = [&file](void* data, size_t numBytes)
+	{
+		file.read(static_cast<char*>(data), std::streamsize(numBytes));
+		return file.good();
+	};
+
+	// HEADER
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t numEntries = 0;
+	uint64_t numWords = 0;
+	if (!read(&magic, sizeof magic)
+		|| !read(&version, sizeof version)
+		|| !read(&numEntries, sizeof numEntries)
+		|| !read(&numWords, sizeof numWords)
+		|| magic != ShaderBundleMagic
+		|| version != ShaderBundleVersion)
+	{
+		LOG("discarding shader bundle, unknown format \"", path, "\"");
+		return false;
+	}
+
+	// INDEX
+	std::unordered_map<uint64_t, ShaderBundleEntry> entries;
+	for (uint32_t entryIndex = 0; entryIndex < numEntries; ++entryIndex)
+	{
+		uint64_t key = 0;
+		uint32_t nameLength = 0;
+		uint32_t numDependencies = 0;
+		ShaderBundleEntry entry;
+		if (!read(&key, sizeof key)
+			|| !read(&nameLength, sizeof nameLength))
+		{
+			LOG("shader bundle index truncated \"", path, "\"");
+			return false;
+		}
+		entry.name.resize(nameLength);
+		read(entry.name.data(), nameLength);
+		read(&numDependencies, sizeof numDependencies);
+		entry.dependencies.resize(numDependencies);
+		for (auto& dependency : entry.dependencies)
+		{
+			uint32_t pathLength = 0;
+			read(&pathLength, sizeof pathLength);
+			dependency.path.resize(pathLength);
+			read(dependency.path.data(), pathLength);
+			read(&dependency.contentHash, sizeof dependency.contentHash);
+		}
+		read(&entry.offset, sizeof entry.offset);
+		if (!read(&entry.numWords, sizeof entry.numWords)
+			|| entry.offset + entry.numWords > numWords)
+		{
+			LOG("shader bundle index corrupt \"", path, "\"");
+			return false;
+		}
+		entries[key] = std::move(entry);
+	}
+
+	// BINARIES
+	std::vector<uint32_t> binaries(numWords);
+	if (!read(binaries.data(), numWords * sizeof(uint32_t)))
+	{
+		LOG("shader bundle binaries truncated \"", path, "\"");
+		return false;
+	}
+
+	myEntries = std::move(entries);
+	myBinaries = std::move(binaries);
+	return true;
+}
+
+bool
+ShaderBundle::Save(
+	const char* path) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+	const std::string tempPath = std::string(path) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.good())
+		{
+			LOG("failed writing shader bundle, \"", tempPath, "\"");
+			return false;
+		}
+		auto write = [&file](const void* data, size_t numBytes)
+		{
+			file.write(static_cast<const char*>(data), std::streamsize(numBytes));
+		};
+		auto writeU32 = [&write](uint32_t value)
+		{
+			write(&value, sizeof value);
+		};
+		auto writeU64 = [&write](uint64_t value)
+		{
+			write(&value, sizeof value);
+		};
+
+		// HEADER
+		writeU32(ShaderBundleMagic);
+		writeU32(ShaderBundleVersion);
+		writeU32(uint32_t(myEntries.size()));
+		writeU64(uint64_t(myBinaries.size()));
+
+		// INDEX
+		for (const auto& [key, entry] : myEntries)
+		{
+			writeU64(key);
+			writeU32(uint32_t(entry.name.size()));
+			write(entry.name.data(), entry.name.size());
+			writeU32(uint32_t(entry.dependencies.size()));
+			for (const auto& dependency : entry.dependencies)
+			{
+				writeU32(uint32_t(dependency.path.size()));
+				write(dependency.path.data(), dependency.path.size());
+				writeU64(dependency.contentHash);
+			}
+			writeU64(entry.offset);
+			writeU32(entry.numWords);
+		}
+
+		// BINARIES
+		write(myBinaries.data(), myBinaries.size() * sizeof(uint32_t));
+		if (!file.good())
+		{
+			LOG("failed writing shader bundle, \"", tempPath, "\"");
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		LOG("failed replacing shader bundle,", error.message());
+		return false;
+	}
+	return true;
+}
+
+void
+ShaderBundle::Add(
+	const char*						name,
+	const std::string&				preAmble,
+	std::vector<ShaderDependency>&&	dependencies,
+	const std::vector<uint32_t>&	binary)
+{
+	ShaderBundleEntry entry;
+	entry.name = Name(name);
+	entry.dependencies = std::move(dependencies);
+	entry.offset = myBinaries.size();
+	entry.numWords = uint32_t(binary.size());
+	myBinaries.insert(myBinaries.end(), binary.begin(), binary.end());
+
+	myEntries[Key(entry.name, preAmble)] = std::move(entry);
+}
+
+const ShaderBundleEntry*
+ShaderBundle::Find(
+	const char*			name,
+	const std::string&	preAmble) const
+{
+	auto it = myEntries.find(Key(Name(name), preAmble));
+	return it != myEntries.end() ? &it->second : nullptr;
+}
+
+std::vector<uint32_t>
+ShaderBundle::GetBinary(
+	const ShaderBundleEntry& entry) const
+{
+	const auto first = myBinaries.begin() + ptrdiff_t(entry.offset);
+	return std::vector<uint32_t>(first, first + entry.numWords);
+}
+
+uint32_t
+ShaderBundle::GetNumEntries() const
+{
+	return uint32_t(myEntries.size());
+}
+
+std::string
+ShaderBundle::Name(
+	const char* path)
+{
+	// bundles ship with the game, so names stay relative to the working directory
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+uint64_t
+ShaderBundle::Key(
+	const std::string&	name,
+	const std::string&	preAmble)
+{
+	return ShaderCache::Hash(preAmble.data(), preAmble.size(), ShaderCache::Hash(name.data(), name.size()));
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "ShaderCache.h"
+
+struct ShaderBundleEntry
+{
+	std::string						name;
+	std::vector<ShaderDependency>	dependencies;
+	uint64_t						offset = 0;
+	uint32_t						numWords = 0;
+};
+
+// every shader permutation compiled offline into one file, looked up by name and preamble
+class ShaderBundle
+{
+public:
+	bool								Load(const char* path);
+	bool								Save(const char* path) const;
+
+	void								Add(
+											const char*						name,
+											const std::string&				preAmble,
+											std::vector<ShaderDependency>&&	dependencies,
+											const std::vector<uint32_t>&	binary);
+	const ShaderBundleEntry*			Find(
+											const char*			name,
+											const std::string&	preAmble) const;
+	std::vector<uint32_t>				GetBinary(const ShaderBundleEntry& entry) const;
+
+	_nodiscard uint32_t					GetNumEntries() const;
+
+	static std::string					Name(const char* path);
+
+private:
+	static uint64_t						Key(
+											const std::string&	name,
+											const std::string&	preAmble);
+
+	std::unordered_map<uint64_t, ShaderBundleEntry>
+										myEntries;
+	std::vector<uint32_t>				myBinaries;
+
+};
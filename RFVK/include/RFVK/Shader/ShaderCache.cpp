@@ -0,0 +1,627 @@
+#include "pch.h"
+#include "ShaderCache.h"
+
+#include "ShaderBundle.h"
+
+#include <sstream>
+
+#ifdef RFVK_SHADER_COMPILATION
+#include "VKCompile.h"
+#endif
+
+constexpr uint32_t ShaderCacheMagic = 0x56505352;
+constexpr uint32_t ShaderCacheVersion = 1;
+
+ShaderCache::ShaderCache()
+	: myBundle(std::make_unique<ShaderBundle>())
+{
+	if (!myBundle->Load(ShaderBundlePath))
+	{
+		LOG("no shader bundle at \"", ShaderBundlePath, "\"");
+	}
+#ifdef RFVK_SHADER_COMPILATION
+	Load();
+	for (const auto& record : LoadPermutations(ShaderPermutationsPath))
+	{
+		std::string line = record.path;
+		for (const auto& feature : record.features)
+		{
+			line.append(" ").append(feature);
+		}
+		myPermutations.emplace(std::move(line));
+	}
+#endif
+}
+
+ShaderCache::~ShaderCache()
+{
+	std::vector<ShaderBinaryTask> pendingTasks;
+	{
+		std::scoped_lock lock(myMutex);
+		for (auto& [key, task] : myPendingTasks)
+		{
+			pendingTasks.emplace_back(task);
+		}
+	}
+	for (auto& task : pendingTasks)
+	{
+		task.wait();
+	}
+#ifndef _WIN32
+	{
+		std::scoped_lock lock(myMutex);
+		myIsStopping = true;
+	}
+	myJobsCondition.notify_all();
+	for (auto& worker : myWorkers)
+	{
+		worker.join();
+	}
+#endif
+	Save();
+	SavePermutations();
+}
+
+std::vector<uint32_t>
+ShaderCache::FetchBinary(
+	const char*			path,
+	const std::string&	preAmble)
+{
+	if (const auto* bundled = myBundle->Find(path, preAmble))
+	{
+#ifdef RFVK_SHADER_COMPILATION
+		// sources edited since the bundle was built are compiled instead
+		if (IsUpToDate(bundled->dependencies))
+#endif
+		{
+			return myBundle->GetBinary(*bundled);
+		}
+	}
+
+#ifdef RFVK_SHADER_COMPILATION
+	return Compile(path, preAmble);
+#else
+	// without a compiler there is nothing to fall back to, an empty module would only fail later and vaguer
+	LOG("FATAL: shader \"", path, "\" with preamble\n", preAmble, "is missing from \"", ShaderBundlePath, "\",",
+		"rebuild the bundle with ShaderCompiler and declare its feature keys in DeclaredShaderFeatures");
+	std::abort();
+#endif
+}
+
+#ifdef RFVK_SHADER_COMPILATION
+std::vector<uint32_t>
+ShaderCache::Compile(
+	const char*			path,
+	const std::string&	preAmble)
+{
+	const std::string sourcePath = CanonicalPath(path);
+	const uint64_t key = Key(sourcePath, preAmble);
+	const uint64_t options[]{ShaderCacheVersion, uint64_t(ShaderTargetVulkan), uint64_t(ShaderTargetSpv)};
+
+	{
+		std::scoped_lock lock(myMutex);
+		if (auto it = myEntries.find(key); it != myEntries.end()
+			&& !it->second.binary.empty()
+			&& IsUpToDate(it->second.dependencies))
+		{
+			LOG("using cached shader for", path);
+			return it->second.binary;
+		}
+	}
+
+	// PREPROCESS
+	std::string preprocessed;
+	std::vector<std::string> includes;
+	if (!VKPreprocess(path, ShaderTargetVulkan, ShaderTargetSpv, preAmble.c_str(), preprocessed, includes))
+	{
+		return {};
+	}
+
+	ShaderCacheEntry entry;
+	entry.preprocessedHash = Hash(preprocessed.data(), preprocessed.size(), Hash(options, sizeof options));
+	includes.insert(includes.begin(), sourcePath);
+	for (const auto& include : includes)
+	{
+		ShaderDependency dependency;
+		dependency.path = CanonicalPath(include.c_str());
+		if (!HashFile(dependency.path, dependency.contentHash))
+		{
+			LOG("failed reading shader dependency", dependency.path);
+		}
+		entry.dependencies.emplace_back(std::move(dependency));
+	}
+
+	// edits that don't survive preprocessing, like comments, can reuse any matching binary
+	{
+		std::scoped_lock lock(myMutex);
+		for (const auto& [otherKey, other] : myEntries)
+		{
+			if (other.preprocessedHash == entry.preprocessedHash)
+			{
+				entry.binary = other.binary;
+				break;
+			}
+		}
+	}
+
+	if (entry.binary.empty())
+	{
+		LOG("compiling shader", path);
+		entry.binary = VKCompile(path, ShaderTargetVulkan, ShaderTargetSpv, preAmble.c_str());
+		if (entry.binary.empty())
+		{
+			return {};
+		}
+	}
+	else
+	{
+		LOG("reusing identical shader binary for", path);
+	}
+
+	std::scoped_lock lock(myMutex);
+	auto& stored = myEntries[key];
+	stored = std::move(entry);
+	myIsDirty = true;
+	return stored.binary;
+}
+#endif
+
+ShaderBinaryTask
+ShaderCache::FetchBinaryAsync(
+	const char*			path,
+	const std::string&	preAmble)
+{
+	const std::string sourcePath = CanonicalPath(path);
+	const uint64_t key = Key(sourcePath, preAmble);
+
+	// a shader requested while it is already compiling waits on the same task
+	std::scoped_lock lock(myMutex);
+	if (auto it = myPendingTasks.find(key); it != myPendingTasks.end())
+	{
+		return it->second;
+	}
+#ifdef _WIN32
+	auto task = concurrency::create_task([this, key, sourcePath, preAmble]()
+	{
+		auto binary = FetchBinary(sourcePath.c_str(), preAmble);
+		std::scoped_lock lock(myMutex);
+		myPendingTasks.erase(key);
+		return binary;
+	});
+#else
+	// not std::async, its future would block in its destructor and the task erases its own entry
+	CompileJob job{key, sourcePath, preAmble, {}};
+	ShaderBinaryTask task = job.promise.get_future().share();
+	myJobs.emplace_back(std::move(job));
+	if (myWorkers.empty())
+	{
+		const uint32_t numWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+		for (uint32_t i = 0; i < numWorkers; ++i)
+		{
+			myWorkers.emplace_back(&ShaderCache::WorkerMain, this);
+		}
+	}
+	myJobsCondition.notify_one();
+#endif
+	myPendingTasks[key] = task;
+	return task;
+}
+
+#ifndef _WIN32
+void
+ShaderCache::WorkerMain()
+{
+	while (true)
+	{
+		CompileJob job;
+		{
+			std::unique_lock lock(myMutex);
+			myJobsCondition.wait(lock, [this]() { return myIsStopping || !myJobs.empty(); });
+			if (myJobs.empty())
+			{
+				return;
+			}
+			job = std::move(myJobs.front());
+			myJobs.pop_front();
+		}
+
+		auto binary = FetchBinary(job.sourcePath.c_str(), job.preAmble);
+		{
+			std::scoped_lock lock(myMutex);
+			myPendingTasks.erase(job.key);
+		}
+		job.promise.set_value(std::move(binary));
+	}
+}
+#endif
+
+void
+ShaderCache::Precompile(
+	const char*			directory,
+	const std::string&	preAmble)
+{
+#ifdef RFVK_SHADER_COMPILATION
+	constexpr const char* stageExtensions[]
+	{
+		".vert", ".frag", ".comp", ".rgen", ".rint", ".rahit", ".rchit", ".rmiss", ".rcall"
+	};
+
+	std::error_code error;
+	for (const auto& file : std::filesystem::recursive_directory_iterator(directory, error))
+	{
+		if (!file.is_regular_file())
+		{
+			continue;
+		}
+		const std::string extension = file.path().extension().string();
+		for (const char* stageExtension : stageExtensions)
+		{
+			if (extension == stageExtension)
+			{
+				FetchBinaryAsync(file.path().string().c_str(), preAmble);
+				break;
+			}
+		}
+	}
+#endif
+}
+
+void
+ShaderCache::RecordPermutation(
+	const char*						path,
+	const std::vector<std::string>&	features)
+{
+#ifdef RFVK_SHADER_COMPILATION
+	std::string line = ShaderBundle::Name(path);
+	for (const auto& feature : features)
+	{
+		line.append(" ").append(feature);
+	}
+
+	std::scoped_lock lock(myMutex);
+	if (myPermutations.emplace(std::move(line)).second)
+	{
+		myPermutationsDirty = true;
+	}
+#endif
+}
+
+void
+ShaderCache::Save()
+{
+	std::scoped_lock lock(myMutex);
+	if (!myIsDirty)
+	{
+		return;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(ShaderCachePath).parent_path(), error);
+
+	const std::string tempPath = std::string(ShaderCachePath) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.good())
+		{
+			LOG("failed writing shader cache, \"", tempPath, "\"");
+			return;
+		}
+		auto write = [&file](const void* data, size_t numBytes)
+		{
+			file.write(static_cast<const char*>(data), std::streamsize(numBytes));
+		};
+		auto writeU32 = [&write](uint32_t value)
+		{
+			write(&value, sizeof value);
+		};
+		auto writeU64 = [&write](uint64_t value)
+		{
+			write(&value, sizeof value);
+		};
+
+		// HEADER
+		writeU32(ShaderCacheMagic);
+		writeU32(ShaderCacheVersion);
+		writeU32(uint32_t(myEntries.size()));
+
+		// ENTRIES
+		for (const auto& [key, entry] : myEntries)
+		{
+			writeU64(key);
+			writeU64(entry.preprocessedHash);
+			writeU32(uint32_t(entry.dependencies.size()));
+			for (const auto& dependency : entry.dependencies)
+			{
+				writeU32(uint32_t(dependency.path.size()));
+				write(dependency.path.data(), dependency.path.size());
+				writeU64(dependency.contentHash);
+			}
+			writeU32(uint32_t(entry.binary.size()));
+			write(entry.binary.data(), entry.binary.size() * sizeof(uint32_t));
+		}
+	}
+
+	std::filesystem::rename(tempPath, ShaderCachePath, error);
+	if (error)
+	{
+		LOG("failed replacing shader cache,", error.message());
+		return;
+	}
+	myIsDirty = false;
+}
+
+uint32_t
+ShaderCache::GetNumEntries() const
+{
+	std::scoped_lock lock(myMutex);
+	return uint32_t(myEntries.size());
+}
+
+void
+ShaderCache::SavePermutations()
+{
+	std::scoped_lock lock(myMutex);
+	if (!myPermutationsDirty)
+	{
+		return;
+	}
+
+	// plain text so the list can be checked in and edited by hand
+	std::ofstream file(ShaderPermutationsPath, std::ios::trunc);
+	if (!file.good())
+	{
+		LOG("failed writing shader permutations, \"", ShaderPermutationsPath, "\"");
+		return;
+	}
+	for (const auto& line : myPermutations)
+	{
+		file << line << "\n";
+	}
+	myPermutationsDirty = false;
+}
+
+std::vector<ShaderPermutationRecord>
+ShaderCache::LoadPermutations(
+	const char* path)
+{
+	std::vector<ShaderPermutationRecord> records;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream words(line);
+		ShaderPermutationRecord record;
+		if (!(words >> record.path))
+		{
+			continue;
+		}
+		std::string feature;
+		while (words >> feature)
+		{
+			record.features.emplace_back(std::move(feature));
+		}
+		records.emplace_back(std::move(record));
+	}
+	return records;
+}
+
+std::vector<ShaderPermutationRecord>
+ShaderCache::DeclaredPermutations()
+{
+	std::vector<ShaderPermutationRecord> records;
+	for (const auto& stage : DeclaredShaderFeatures)
+	{
+		uint32_t numFeatures = 0;
+		while (numFeatures < _ARRAYSIZE(stage.features) && stage.features[numFeatures])
+		{
+			++numFeatures;
+		}
+		for (uint32_t permutation = 1; permutation < (1u << numFeatures); ++permutation)
+		{
+			ShaderPermutationRecord record;
+			record.path = stage.path;
+			for (uint32_t keyIndex = 0; keyIndex < numFeatures; ++keyIndex)
+			{
+				if (permutation & (1u << keyIndex))
+				{
+					record.features.emplace_back(stage.features[keyIndex]);
+				}
+			}
+			records.emplace_back(std::move(record));
+		}
+	}
+	return records;
+}
+
+bool
+ShaderCache::IsDeclared(
+	const char*			path,
+	const std::string&	feature)
+{
+	const std::string name = ShaderBundle::Name(path);
+	for (const auto& stage : DeclaredShaderFeatures)
+	{
+		if (name != stage.path)
+		{
+			continue;
+		}
+		for (const char* declared : stage.features)
+		{
+			if (declared && feature == declared)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+std::string
+ShaderCache::PreAmble(
+	const std::vector<std::string>& features)
+{
+	std::string preAmble;
+	preAmble.append("#define SET_SAMPLERS_COUNT ").append(std::to_string(MaxNumSamplers)).append("\n");
+	preAmble.append("#define SET_TLAS_COUNT ").append(std::to_string(MaxNumInstanceStructures)).append("\n");
+	preAmble.append("#define SAMPLED_IMAGE_2D_COUNT ").append(std::to_string(MaxNumImages)).append("\n");
+	preAmble.append("#define SAMPLED_IMAGE_2D_ARRAY_COUNT ").append(std::to_string(MaxNumImages)).append("\n");
+	preAmble.append("#define SAMPLED_CUBE_COUNT ").append(std::to_string(MaxNumImagesCube)).append("\n");
+	preAmble.append("#define STORAGE_IMAGE_COUNT ").append(std::to_string(MaxNumStorageImages)).append("\n");
+	preAmble.append("#define MAX_NUM_INSTANCES ").append(std::to_string(MaxNumInstances)).append("\n");
+	preAmble.append("#define MAX_NUM_MESHES ").append(std::to_string(MaxNumMeshesLoaded)).append("\n");
+	preAmble.append("#define MAX_NUM_SPRITE_INSTANCES ").append(std::to_string(MaxNumSpriteInstances)).append("\n");
+	preAmble.append("#define MAX_NUM_SDF_SPRITE_INSTANCES ").append(std::to_string(MaxNumSDFSpriteInstances)).append("\n");
+	// sorted so a permutation's preamble, and with it its bundle key, ignores the order keys were declared in
+	std::vector<std::string> sortedFeatures = features;
+	std::sort(sortedFeatures.begin(), sortedFeatures.end());
+	bool isSplitSubpass = false;
+	for (const auto& feature : sortedFeatures)
+	{
+		preAmble.append("#define ").append(feature).append(" 1\n");
+		isSplitSubpass |= feature == SplitSubpassesFeature;
+	}
+
+	// input attachments are bound as one array at binding 0, see RenderPassFactory::CreateInputDescriptors
+	if (isSplitSubpass)
+	{
+		preAmble.append("#define SUBPASS_INPUTS(setIndex, name, count) layout(set = setIndex, binding = 0) uniform sampler2D name[count]\n");
+		preAmble.append("#define SUBPASS_LOAD(input) texelFetch(input, ivec2(gl_FragCoord.xy), 0)\n");
+	}
+	else
+	{
+		preAmble.append("#define SUBPASS_INPUTS(setIndex, name, count) layout(input_attachment_index = 0, set = setIndex, binding = 0) uniform subpassInput name[count]\n");
+		preAmble.append("#define SUBPASS_LOAD(input) subpassLoad(input)\n");
+	}
+
+	return preAmble;
+}
+
+uint64_t
+ShaderCache::Hash(
+	const void*	data,
+	size_t		numBytes,
+	uint64_t	seed)
+{
+	// FNV-1a
+	uint64_t hash = seed;
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	for (size_t byteIndex = 0; byteIndex < numBytes; ++byteIndex)
+	{
+		hash ^= bytes[byteIndex];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+uint64_t
+ShaderCache::Key(
+	const std::string&	sourcePath,
+	const std::string&	preAmble)
+{
+	uint64_t key = Hash(sourcePath.data(), sourcePath.size());
+	key = Hash(preAmble.data(), preAmble.size(), key);
+#ifdef RFVK_SHADER_COMPILATION
+	// compiler settings are part of the key so bumping them invalidates old binaries
+	const uint64_t options[]{ShaderCacheVersion, uint64_t(ShaderTargetVulkan), uint64_t(ShaderTargetSpv)};
+	key = Hash(options, sizeof options, key);
+#endif
+	return key;
+}
+
+void
+ShaderCache::Load()
+{
+	std::ifstream file(ShaderCachePath, std::ios::binary);
+	if (!file.good())
+	{
+		return;
+	}
+	auto read = [&file](void* data, size_t numBytes)
+	{
+		file.read(static_cast<char*>(data), std::streamsize(numBytes));
+		return file.good();
+	};
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t numEntries = 0;
+	if (!read(&magic, sizeof magic)
+		|| !read(&version, sizeof version)
+		|| !read(&numEntries, sizeof numEntries)
+		|| magic != ShaderCacheMagic
+		|| version != ShaderCacheVersion)
+	{
+		LOG("discarding shader cache, unknown format");
+		return;
+	}
+
+	for (uint32_t entryIndex = 0; entryIndex < numEntries; ++entryIndex)
+	{
+		uint64_t key = 0;
+		ShaderCacheEntry entry;
+		uint32_t numDependencies = 0;
+		if (!read(&key, sizeof key)
+			|| !read(&entry.preprocessedHash, sizeof entry.preprocessedHash)
+			|| !read(&numDependencies, sizeof numDependencies))
+		{
+			break;
+		}
+		entry.dependencies.resize(numDependencies);
+		for (auto& dependency : entry.dependencies)
+		{
+			uint32_t pathLength = 0;
+			read(&pathLength, sizeof pathLength);
+			dependency.path.resize(pathLength);
+			read(dependency.path.data(), pathLength);
+			read(&dependency.contentHash, sizeof dependency.contentHash);
+		}
+		uint32_t numWords = 0;
+		read(&numWords, sizeof numWords);
+		entry.binary.resize(numWords);
+		if (!read(entry.binary.data(), size_t(numWords) * sizeof(uint32_t)))
+		{
+			LOG("shader cache truncated, keeping", entryIndex, "entries");
+			break;
+		}
+		myEntries[key] = std::move(entry);
+	}
+}
+
+bool
+ShaderCache::IsUpToDate(
+	const std::vector<ShaderDependency>& dependencies)
+{
+	for (const auto& dependency : dependencies)
+	{
+		uint64_t contentHash = 0;
+		if (!HashFile(dependency.path, contentHash)
+			|| contentHash != dependency.contentHash)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool
+ShaderCache::HashFile(
+	const std::string&	path,
+	uint64_t&			outHash)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good())
+	{
+		return false;
+	}
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	outHash = Hash(content.data(), content.size());
+	return true;
+}
+
+std::string
+ShaderCache::CanonicalPath(
+	const char* path)
+{
+	std::error_code error;
+	auto canonical = std::filesystem::weakly_canonical(path, error);
+	return error ? std::string(path) : canonical.generic_string();
+}
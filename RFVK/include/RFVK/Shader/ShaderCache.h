@@ -0,0 +1,115 @@
+#pragma once
+#include <set>
+
+#ifdef _WIN32
+#include <ppltasks.h>
+typedef concurrency::task<std::vector<uint32_t>> ShaderBinaryTask;
+#else
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <thread>
+typedef std::shared_future<std::vector<uint32_t>> ShaderBinaryTask;
+#endif
+
+struct ShaderDependency
+{
+	std::string				path;
+	uint64_t				contentHash = 0;
+};
+
+// a shader stage and the feature keys one of its requested permutations enables
+struct ShaderPermutationRecord
+{
+	std::string					path;
+	std::vector<std::string>	features;
+};
+
+struct ShaderCacheEntry
+{
+	uint64_t						preprocessedHash = 0;
+	std::vector<ShaderDependency>	dependencies;
+	std::vector<uint32_t>			binary;
+};
+
+class ShaderCache
+{
+public:
+										ShaderCache();
+										~ShaderCache();
+
+	std::vector<uint32_t>				FetchBinary(
+											const char*			path,
+											const std::string&	preAmble);
+	ShaderBinaryTask					FetchBinaryAsync(
+											const char*			path,
+											const std::string&	preAmble);
+	void								Precompile(
+											const char*			directory,
+											const std::string&	preAmble);
+	// remembers a permutation was used so the offline bundle includes it
+	void								RecordPermutation(
+											const char*						path,
+											const std::vector<std::string>&	features);
+	void								Save();
+
+	_nodiscard uint32_t					GetNumEntries() const;
+
+	static std::string					PreAmble(const std::vector<std::string>& features = {});
+	static std::vector<ShaderPermutationRecord>
+										LoadPermutations(const char* path);
+	// every combination of the keys in DeclaredShaderFeatures, the base permutation excluded
+	static std::vector<ShaderPermutationRecord>
+										DeclaredPermutations();
+	static bool							IsDeclared(
+											const char*			path,
+											const std::string&	feature);
+	static uint64_t						Hash(
+											const void*	data,
+											size_t		numBytes,
+											uint64_t	seed = 14695981039346656037ull);
+	static bool							HashFile(
+											const std::string&	path,
+											uint64_t&			outHash);
+
+private:
+	std::vector<uint32_t>				Compile(
+											const char*			path,
+											const std::string&	preAmble);
+	void								Load();
+	void								SavePermutations();
+	static uint64_t						Key(
+											const std::string&	sourcePath,
+											const std::string&	preAmble);
+	static bool							IsUpToDate(const std::vector<ShaderDependency>& dependencies);
+	static std::string					CanonicalPath(const char* path);
+#ifndef _WIN32
+	struct CompileJob
+	{
+		uint64_t								key;
+		std::string								sourcePath;
+		std::string								preAmble;
+		std::promise<std::vector<uint32_t>>		promise;
+	};
+	void								WorkerMain();
+#endif
+
+	std::unique_ptr<class ShaderBundle>	myBundle;
+
+	mutable std::mutex					myMutex;
+	std::unordered_map<uint64_t, ShaderCacheEntry>
+										myEntries;
+	std::unordered_map<uint64_t, ShaderBinaryTask>
+										myPendingTasks;
+	bool								myIsDirty = false;
+	std::set<std::string>				myPermutations;
+	bool								myPermutationsDirty = false;
+#ifndef _WIN32
+	// a fixed set of workers started with the first request, so precompiling a directory doesn't spawn a thread per file
+	std::vector<std::thread>			myWorkers;
+	std::deque<CompileJob>				myJobs;
+	std::condition_variable				myJobsCondition;
+	bool								myIsStopping = false;
+#endif
+
+};
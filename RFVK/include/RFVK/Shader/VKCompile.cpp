@@ -1,4 +1,6 @@
 #include "pch.h"
+
+#ifdef RFVK_SHADER_COMPILATION
 #include "VKCompile.h"
 
 #include <fstream>
@@ -6,7 +8,7 @@
 
 #include "glslang/SPIRV/GlslangToSpv.h"
 #include "DirStackFileIncluder.h"
-#include "glslang/public/ResourceLimits.h"
+#include "glslang/Public/ResourceLimits.h"
 
 #ifdef _DEBUG
 #pragma comment(lib, "GenericCodeGend.lib")
@@ -38,116 +40,216 @@
 #pragma comment(lib, "SPIRV-Tools-opt.lib")
 #endif
 
-bool glslangInit = false;
+std::once_flag glslangInit;
 
-std::vector<uint32_t>
-VKCompile(
-	const char*							shaderPath,
-	glslang::EShTargetClientVersion		vkVersion,
-	glslang::EShTargetLanguageVersion	spvVersion,
-	const char*							preAmble)
+// keeps track of every file pulled in through #include
+class RecordingIncluder : public DirStackFileIncluder
 {
-	if (!glslangInit)
+public:
+	IncludeResult* includeLocal(
+		const char* headerName,
+		const char* includerName,
+		size_t		inclusionDepth) override
 	{
-		glslang::InitializeProcess();
-		glslangInit = true;
+		return Record(DirStackFileIncluder::includeLocal(headerName, includerName, inclusionDepth));
+	}
+	IncludeResult* includeSystem(
+		const char* headerName,
+		const char* includerName,
+		size_t		inclusionDepth) override
+	{
+		return Record(DirStackFileIncluder::includeSystem(headerName, includerName, inclusionDepth));
 	}
-	std::vector<uint32_t> spvBin;
 
-	std::ifstream file;
-	file.open(shaderPath);
-	if (!file.good())
+	std::vector<std::string> myIncludes;
+
+private:
+	IncludeResult* Record(IncludeResult* result)
 	{
-		LOG("failed opening shader file :", shaderPath);
-		return spvBin;
+		if (result && !result->headerName.empty())
+		{
+			myIncludes.emplace_back(result->headerName);
+		}
+		return result;
 	}
+};
 
-	std::string glslBuffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-	const char* rawGLSL = glslBuffer.c_str();
+static bool
+EvaluateStage(
+	const char*		shaderPath,
+	EShLanguage&	outStage)
+{
 	auto ext = std::filesystem::path(shaderPath).extension().string();
-
-	EShLanguage stage;
 	if (ext.find(".vert") != std::string::npos)
 	{
-		stage = EShLangVertex;
+		outStage = EShLangVertex;
 	}
 	else if (ext.find(".frag") != std::string::npos)
 	{
-		stage = EShLangFragment;
+		outStage = EShLangFragment;
 	}
 	else if (ext.find(".comp") != std::string::npos)
 	{
-		stage = EShLangCompute;
+		outStage = EShLangCompute;
 	}
 	else if (ext.find(".rgen") != std::string::npos)
 	{
-		stage = EShLangRayGenNV;
+		outStage = EShLangRayGenNV;
 	}
 	else if (ext.find(".rint") != std::string::npos)
 	{
-		stage = EShLangIntersectNV;
+		outStage = EShLangIntersectNV;
 	}
 	else if (ext.find(".rahit") != std::string::npos)
 	{
-		stage = EShLangAnyHitNV;
+		outStage = EShLangAnyHitNV;
 	}
 	else if (ext.find(".rchit") != std::string::npos)
 	{
-		stage = EShLangClosestHitNV;
+		outStage = EShLangClosestHitNV;
 	}
 	else if (ext.find(".rmiss") != std::string::npos)
 	{
-		stage = EShLangMissNV;
+		outStage = EShLangMissNV;
 	}
 	else if (ext.find(".rcall") != std::string::npos)
 	{
-		stage = EShLangCallableNV;
+		outStage = EShLangCallableNV;
 	}
 	else
 	{
 		LOG("shader stage not supported for :", shaderPath);
-		return spvBin;
+		return false;
+	}
+	return true;
+}
+
+static bool
+SetupShader(
+	glslang::TShader&					shader,
+	std::string&						outSource,
+	const char*							shaderPath,
+	glslang::EShTargetClientVersion		vkVersion,
+	glslang::EShTargetLanguageVersion	spvVersion,
+	const char*							preAmble)
+{
+	// every thread builds its own TShader, only process setup is shared
+	std::call_once(glslangInit, []()
+	{
+		glslang::InitializeProcess();
+	});
+
+	std::ifstream file;
+	file.open(shaderPath);
+	if (!file.good())
+	{
+		LOG("failed opening shader file :", shaderPath);
+		return false;
 	}
 
-	glslang::TShader shader(stage);
-	std::string ambled(rawGLSL);
+	outSource.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 	if (preAmble)
 	{
-		uint32_t pos = ambled.rfind("enable");
-		if (pos != std::string::npos && pos < ambled.size())
+		uint32_t pos = outSource.rfind("enable");
+		if (pos != std::string::npos && pos < outSource.size())
 		{
-			ambled.insert(pos + 7, preAmble);
+			outSource.insert(pos + 7, preAmble);
 		}
 		else
 		{
-			uint32_t pos = ambled.rfind("require");
+			uint32_t pos = outSource.rfind("require");
 			assert(pos != std::string::npos);
-			ambled.insert(pos + 8, preAmble);
+			outSource.insert(pos + 8, preAmble);
 		}
-		const char* rawAmbled = ambled.c_str();
-		int len = ambled.length();
-		const char* names[]
-		{
-			""
-		};
-		shader.setStrings(&rawAmbled, 1);
-	}
-	else
-	{
-		shader.setStrings(&rawGLSL, 1);
 	}
+	const char* rawSource = outSource.c_str();
+	shader.setStrings(&rawSource, 1);
 
+	EShLanguage stage = shader.getStage();
 	auto vkVer = int(VK_VERSION_MAJOR(vkVersion) * 100 + VK_VERSION_MINOR(vkVersion) * 10);
 	shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, vkVer);
 	shader.setEnvClient(glslang::EShClientVulkan, vkVersion);
 	shader.setEnvTarget(glslang::EshTargetSpv, spvVersion);
+	return true;
+}
+
+bool
+VKPreprocess(
+	const char*							shaderPath,
+	glslang::EShTargetClientVersion		vkVersion,
+	glslang::EShTargetLanguageVersion	spvVersion,
+	const char*							preAmble,
+	std::string&						outPreprocessed,
+	std::vector<std::string>&			outIncludes)
+{
+	EShLanguage stage;
+	if (!EvaluateStage(shaderPath, stage))
+	{
+		return false;
+	}
+
+	glslang::TShader shader(stage);
+	std::string source;
+	if (!SetupShader(shader, source, shaderPath, vkVersion, spvVersion, preAmble))
+	{
+		return false;
+	}
+
+	const auto* resources = GetDefaultResources();
+	if (!resources)
+	{
+		return false;
+	}
+
+	EShMessages messages = (EShMessages) (EShMsgSpvRules | EShMsgVulkanRules);
+	RecordingIncluder includer;
+	bool resultPreProcess = shader.preprocess(
+									resources,
+									460,
+									ENoProfile,
+									false,
+									true,
+									messages,
+									&outPreprocessed,
+									includer);
+	if (!resultPreProcess)
+	{
+		LOG("failed to pre-process :", shaderPath, '\n', shader.getInfoLog(), '\n', shader.getInfoDebugLog());
+		return false;
+	}
+
+	outIncludes = std::move(includer.myIncludes);
+	return true;
+}
+
+std::vector<uint32_t>
+VKCompile(
+	const char*							shaderPath,
+	glslang::EShTargetClientVersion		vkVersion,
+	glslang::EShTargetLanguageVersion	spvVersion,
+	const char*							preAmble,
+	bool								optimize)
+{
+	std::vector<uint32_t> spvBin;
+
+	EShLanguage stage;
+	if (!EvaluateStage(shaderPath, stage))
+	{
+		return spvBin;
+	}
+
+	glslang::TShader shader(stage);
+	std::string source;
+	if (!SetupShader(shader, source, shaderPath, vkVersion, spvVersion, preAmble))
+	{
+		return spvBin;
+	}
 
 	EShMessages messages = (EShMessages) (EShMsgSpvRules | EShMsgVulkanRules);
 
 
 	// PRE PROCESS
 	DirStackFileIncluder includer;
-	auto folder = std::filesystem::path(shaderPath).parent_path().string();
 	
 	std::string preprocessed;
 	const auto* resources = GetDefaultResources();
@@ -191,7 +293,10 @@ VKCompile(
 
 	spv::SpvBuildLogger logger;
 	glslang::SpvOptions options;
+	options.disableOptimizer = !optimize;
+	options.stripDebugInfo = optimize;
 	glslang::GlslangToSpv(*program.getIntermediate(stage), spvBin, &logger, &options);
 
 	return spvBin;
 }
+#endif
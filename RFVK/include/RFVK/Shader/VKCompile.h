@@ -3,10 +3,24 @@
 #define ENABLE_OPT
 
 #include <vector>
-#include "glslang/public/ShaderLang.h"
+#include "glslang/Public/ShaderLang.h"
 
+constexpr auto ShaderTargetVulkan = glslang::EShTargetVulkan_1_3;
+constexpr auto ShaderTargetSpv = glslang::EShTargetSpv_1_5;
+
+// optimize runs the SPIRV-Tools performance passes and strips debug info
 std::vector<uint32_t> VKCompile(
 						const char *						shaderPath,
                         glslang::EShTargetClientVersion		vkVersion,
                         glslang::EShTargetLanguageVersion	spvVersion, 
-                        const char*							preAmble = nullptr );
\ No newline at end of file
+                        const char*							preAmble = nullptr,
+						bool								optimize = false );
+
+// expands includes and the preamble without compiling, outIncludes receives every included file
+bool VKPreprocess(
+						const char*							shaderPath,
+						glslang::EShTargetClientVersion		vkVersion,
+						glslang::EShTargetLanguageVersion	spvVersion,
+						const char*							preAmble,
+						std::string&						outPreprocessed,
+						std::vector<std::string>&			outIncludes);
\ No newline at end of file
@@ -1,19 +1,15 @@
 #pragma once
 
 // WINAPI
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
+#include "neat/General/Platform.h"
 
-#include <windows.h>
-
-#include <concurrent_queue.h>
-#include <concurrent_priority_queue.h>
-#include <concurrent_unordered_map.h>
+#include "neat/Containers/concurrent_queue.h"
+#include "neat/Containers/concurrent_map.h"
 
 template<typename key, typename value>
-using conc_map = concurrency::concurrent_unordered_map<key, value>;
-template<typename type>
-using conc_queue = concurrency::concurrent_queue<type>;
+using conc_map = neat::concurrent_map<key, value>;
+template<typename type, unsigned capacity = 256>
+using conc_queue = neat::concurrent_queue<type, capacity>;
 
 // STL
 #include <functional>
@@ -45,7 +41,9 @@ using shared_semaphore = std::shared_ptr<std::counting_semaphore<max>>;
 // VULKAN
 #include "vulkan/vulkan.h"
 #include "vulkan/vulkan_core.h"
+#ifdef _WIN32
 #include "vulkan/vulkan_win32.h"
+#endif
 #include "vulkan/vk_layer.h"
 // GLM
 #include "glm/glm.hpp"
@@ -69,6 +67,9 @@ using Vec2ui = glm::vec<2, uint32_t>;
 #include "neat/Containers/static_vector.h"
 #include "neat/Image/ImageReader.h"
 #include "neat/Misc/IDKeeper.h"
+#include "neat/Misc/FrameArena.h"
+#include "neat/Misc/AllocationCounter.h"
+#include "neat/Misc/Profiler.h"
 #include "neat/General/Thread.h"
 
 // rapidjson
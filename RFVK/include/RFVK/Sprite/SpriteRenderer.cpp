@@ -3,24 +3,27 @@
 
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Image/ImageHandler.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 #include "RFVK/Pipelines/PipelineBuilder.h"
+#include "RFVK/Pipelines/PipelineReloader.h"
 #include "RFVK/RenderPass/RenderPassFactory.h"
-#include "RFVK/Scene/SceneGlobals.h"
 #include "RFVK/Shader/Shader.h"
+#include "RFVK/Text/FontHandler.h"
 #include "RFVK/Uniform/UniformHandler.h"
 
 
 SpriteRenderer::SpriteRenderer(
 	VulkanFramework&	vulkanFramework,
-	SceneGlobals&		sceneGlobals,
 	ImageHandler&		imageHandler,
+	FontHandler&		fontHandler,
 	RenderPassFactory&	renderPassFactory,
 	UniformHandler&		uniformHandler,
 	QueueFamilyIndices	familyIndices)
 	: theirVulkanFramework(vulkanFramework)
-	, theirSceneGlobals(sceneGlobals)
 	, theirImageHandler(imageHandler)
+	, theirFontHandler(fontHandler)
 	, theirUniformHandler(uniformHandler)
+	, theirRenderPassFactory(renderPassFactory)
 {
 	myWaitStages.fill(VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT);
 	myOwners = {
@@ -28,10 +31,6 @@ SpriteRenderer::SpriteRenderer(
 		familyIndices[QUEUE_FAMILY_GRAPHICS],
 	};
 
-	//	UNIFORM
-	mySpriteInstancesID = theirUniformHandler.RequestUniformBuffer(nullptr, MaxNumSpriteInstances * sizeof SpriteInstance);
-	assert(!BAD_ID(mySpriteInstancesID) && "failed creating glyph instance uniform");
-
 	// RENDER PASS
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
 	auto rpBuilder = renderPassFactory.GetConstructor();
@@ -54,6 +53,7 @@ SpriteRenderer::SpriteRenderer(
 		VK_DEPENDENCY_BY_REGION_BIT
 	});
 
+	rpBuilder.SetName("SpritePass");
 	myRenderPass = rpBuilder.Build();
 
 	// PIPELINE
@@ -66,25 +66,14 @@ SpriteRenderer::SpriteRenderer(
 							  _ARRAYSIZE(shaderPaths),
 							  theirVulkanFramework);
 
-	PipelineBuilder pBuilder(1, myRenderPass.renderPass, mySpriteShader);
-	pBuilder
-		.SetDepthEnabled(false)
-		.SetSubpass(0)
-		.SetPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
-		.SetAllBlendStates(GenBlendState::Alpha)
-		.DefineViewport({w,h}, {0,0,w,h})
-		.DefineVertexInput(nullptr);
-
-	auto [glyphLayout, glyphSet] = theirUniformHandler[mySpriteInstancesID];
-
-	VkResult result;
-	std::tie(result, mySpritePipeline) = pBuilder.Construct(
+	auto constructPipeline = [this](Shader* shader)
 	{
-		theirSceneGlobals.GetGlobalsLayout(),
-		theirImageHandler.GetSamplerSetLayout(),
-		theirImageHandler.GetImageSetLayout(),
-		glyphLayout
-	}, theirVulkanFramework.GetDevice());
+		return ConstructPipeline(shader);
+	};
+	VkResult result;
+	std::tie(result, mySpritePipeline) = ConstructPipeline(mySpriteShader);
+	theirVulkanFramework.GetPipelineReloader().Register(mySpritePipeline, *mySpriteShader, 0, constructPipeline);
+	BuildSDFPipeline();
 
 	// COMMANDS
 	for (uint32_t i = 0; i < NumSwapchainImages; i++)
@@ -106,6 +95,17 @@ SpriteRenderer::SpriteRenderer(
 
 }
 
+SpriteRenderer::~SpriteRenderer()
+{
+	theirVulkanFramework.GetPipelineReloader().Unregister(mySpritePipeline);
+	SAFE_DELETE(mySpriteShader);
+	if (mySDFPipeline.pipeline)
+	{
+		theirVulkanFramework.GetPipelineReloader().Unregister(mySDFPipeline);
+	}
+	SAFE_DELETE(mySDFShader);
+}
+
 neat::static_vector<WorkerSubmission, MaxWorkerSubmissions>
 SpriteRenderer::RecordSubmit(
 	uint32_t	swapchainImageIndex,
@@ -121,6 +121,7 @@ SpriteRenderer::RecordSubmit(
 
 	// ACQUIRE RENDER COMMAND BUFFER
 	const auto& assembledWork = myWorkScheduler.AssembleScheduledWork();
+	const auto& assembledTextWork = myTextWorkScheduler.AssembleScheduledWork();
 
 	auto cmdBuffer = myCmdBuffers[swapchainImageIndex];
 
@@ -132,39 +133,128 @@ SpriteRenderer::RecordSubmit(
 	beginInfo.pInheritanceInfo = nullptr;
 
 	auto resultBegin = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+	CommandRecorder recorder(cmdBuffer);
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
 	BeginRenderPass(cmdBuffer,
 					myRenderPass,
 					swapchainImageIndex,
 					{0,0,w,h});
 
-	vkCmdBindPipeline(myCmdBuffers[swapchainImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, mySpritePipeline.pipeline);
+	recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, mySpritePipeline.pipeline);
+
+	// COUNT INSTANCES
+	// sized up front so instances are written straight into the frame's uniform space
+	auto& layoutCache = theirFontHandler.GetLayoutCache();
+	uint32_t maxInstances = 0;
+	uint32_t maxSDFInstances = 0;
+	for (auto& cmd : assembledWork)
+	{
+		++(cmd.signedDistance ? maxSDFInstances : maxInstances);
+	}
+	for (auto& textCmd : assembledTextWork)
+	{
+		layoutCache.ForEachQuad(textCmd.layoutID, [&](const TextQuad& quad)
+		{
+			++(quad.signedDistance ? maxSDFInstances : maxInstances);
+		});
+	}
+	maxInstances = std::min<uint32_t>(maxInstances, MaxNumSpriteInstances);
+	maxSDFInstances = std::min<uint32_t>(maxSDFInstances, MaxNumSDFSpriteInstances);
+
+	auto [spriteData, spriteOffset] = theirUniformHandler.AllocateDynamicUniform(swapchainImageIndex, maxInstances * sizeof(SpriteInstance));
+	auto [sdfData, sdfOffset] = theirUniformHandler.AllocateDynamicUniform(swapchainImageIndex, maxSDFInstances * sizeof(SDFSpriteInstance));
+	auto* spriteInstances = static_cast<SpriteInstance*>(spriteData);
+	auto* sdfInstances = static_cast<SDFSpriteInstance*>(sdfData);
+	if (!spriteInstances)
+	{
+		maxInstances = 0;
+	}
+	if (!sdfInstances)
+	{
+		maxSDFInstances = 0;
+	}
 
 	// UPDATE INSTANCE DATA
+	// a layout rebuilt since it was counted can come up short or over, the excess waits a frame
 	uint32_t numInstances = 0;
-	std::array<SpriteInstance, MaxNumSpriteInstances> spriteInstances{};
-	for (auto& cmd : assembledWork)
+	uint32_t numSDFInstances = 0;
+	auto pushInstance = [&](const SpriteRenderCommand& cmd)
 	{
 		if (BAD_ID(cmd.imgArrID) || int(cmd.imgArrID) > MaxNumImages)
 		{
-			continue;
+			return;
+		}
+		if (cmd.signedDistance)
+		{
+			if (numSDFInstances >= maxSDFInstances)
+			{
+				return;
+			}
+			auto& instance = sdfInstances[numSDFInstances++];
+			instance.uvRect = cmd.uvRect;
+			instance.color = cmd.color;
+			instance.outlineColor = cmd.outlineColor;
+			instance.shadowColor = cmd.shadowColor;
+			instance.pos = cmd.position;
+			instance.pivot = cmd.pivot;
+			instance.scale = cmd.scale;
+			instance.shadowOffset = cmd.shadowOffset;
+			instance.imgArrID = float(cmd.imgArrID);
+			instance.outlineWidth = cmd.outlineWidth;
+			instance.padding0 = 0;
+			instance.padding1 = 0;
+			return;
+		}
+		if (numInstances >= maxInstances)
+		{
+			return;
 		}
-		spriteInstances[numInstances] = {};
-		spriteInstances[numInstances].color = cmd.color;
-		spriteInstances[numInstances].pos = cmd.position;
-		spriteInstances[numInstances].pivot = cmd.pivot;
-		spriteInstances[numInstances].scale = cmd.scale;
-		spriteInstances[numInstances].imgArrID = float(cmd.imgArrID);
-		spriteInstances[numInstances].imgArrIndex = float(cmd.imgArrIndex);
-		numInstances++;
+		auto& instance = spriteInstances[numInstances++];
+		instance.uvRect = cmd.uvRect;
+		instance.color = cmd.color;
+		instance.pos = cmd.position;
+		instance.pivot = cmd.pivot;
+		instance.scale = cmd.scale;
+		instance.imgArrID = float(cmd.imgArrID);
+		instance.imgArrIndex = float(cmd.imgArrIndex);
+	};
+
+	for (auto& cmd : assembledWork)
+	{
+		pushInstance(cmd);
+	}
+
+	// EXPAND TEXT
+	const float ratio = float(h) / float(w);
+	for (auto& textCmd : assembledTextWork)
+	{
+		SpriteRenderCommand cmd{};
+		cmd.pivot = { 0, -1 };
+		cmd.color = textCmd.color;
+		cmd.outlineColor = textCmd.outlineColor;
+		cmd.outlineWidth = textCmd.outlineWidth;
+		cmd.shadowColor = textCmd.shadowColor;
+		cmd.shadowOffset = textCmd.shadowOffset;
+		layoutCache.ForEachQuad(textCmd.layoutID, [&](const TextQuad& quad)
+		{
+			cmd.imgArrID = quad.imageID;
+			cmd.imgArrIndex = 0;
+			cmd.uvRect = quad.uvRect;
+			cmd.signedDistance = quad.signedDistance;
+			cmd.position = {
+				textCmd.position.x + quad.offset.x * textCmd.scale * ratio,
+				textCmd.position.y + quad.offset.y * textCmd.scale};
+			cmd.scale = quad.size * textCmd.scale;
+			pushInstance(cmd);
+		});
 	}
-	theirUniformHandler.UpdateUniformData(mySpriteInstancesID, spriteInstances.data());
 
 	// DESCRIPTORS
-	theirSceneGlobals.BindGlobals(cmdBuffer, mySpritePipeline.layout, 0);
-	theirImageHandler.BindSamplers(cmdBuffer, mySpritePipeline.layout, 1);
-	theirImageHandler.BindImages(swapchainImageIndex, cmdBuffer, mySpritePipeline.layout, 2);
-	theirUniformHandler.BindUniform(mySpriteInstancesID, cmdBuffer, mySpritePipeline.layout, 3);
+	SpriteDrawConstants drawConstants{ratio};
+	recorder.PushConstants(mySpritePipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(drawConstants), &drawConstants);
+	theirImageHandler.BindSamplers(recorder, mySpritePipeline.layout, 0);
+	theirImageHandler.BindImages(swapchainImageIndex, recorder, mySpritePipeline.layout, 1);
+	theirUniformHandler.BindDynamicUniform(spriteOffset, recorder, mySpritePipeline.layout, 2);
 
 	// DRAW
 	if (numInstances > 0)
@@ -172,7 +262,18 @@ SpriteRenderer::RecordSubmit(
 		vkCmdDraw(myCmdBuffers[swapchainImageIndex], 6, numInstances, 0, 0);
 	}
 
-	vkCmdEndRenderPass(myCmdBuffers[swapchainImageIndex]);
+	// DRAW SDF
+	if (numSDFInstances > 0 && mySDFPipeline.pipeline)
+	{
+		recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, mySDFPipeline.pipeline);
+		recorder.PushConstants(mySDFPipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(drawConstants), &drawConstants);
+		theirImageHandler.BindSamplers(recorder, mySDFPipeline.layout, 0);
+		theirImageHandler.BindImages(swapchainImageIndex, recorder, mySDFPipeline.layout, 1);
+		theirUniformHandler.BindDynamicUniform(sdfOffset, recorder, mySDFPipeline.layout, 2);
+		vkCmdDraw(cmdBuffer, 6, numSDFInstances, 0, 0);
+	}
+
+	EndRenderPass(myCmdBuffers[swapchainImageIndex], myRenderPass, swapchainImageIndex);
 
 	auto resultEnd = vkEndCommandBuffer(myCmdBuffers[swapchainImageIndex]);
 
@@ -199,14 +300,81 @@ SpriteRenderer::RecordSubmit(
 	return {{myCmdBufferFences[swapchainImageIndex], submitInfo, VK_QUEUE_GRAPHICS_BIT}};
 }
 
+void
+SpriteRenderer::AddSchedule(
+	neat::ThreadID threadID)
+{
+	myWorkScheduler.AddSchedule(threadID);
+	myTextWorkScheduler.AddSchedule(threadID);
+}
+
 std::array<VkFence, NumSwapchainImages>
 SpriteRenderer::GetFences()
 {
     return myCmdBufferFences;
 }
 
+std::tuple<VkResult, Pipeline>
+SpriteRenderer::ConstructPipeline(
+	Shader* shader)
+{
+	auto [w, h] = theirVulkanFramework.GetTargetResolution();
+	PipelineBuilder pBuilder(1, myRenderPass, shader);
+	pBuilder
+		.SetDepthEnabled(false)
+		.SetSubpass(0)
+		.SetPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+		.SetAllBlendStates(GenBlendState::Alpha)
+		.DefineViewport({w,h}, {0,0,w,h})
+		.DefineVertexInput(nullptr)
+		.SetSpecializationConstant(SDFSpreadConstantID, SDFSpread)
+		.AddPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SpriteDrawConstants));
+
+	return pBuilder.Construct(
+	{
+		theirImageHandler.GetSamplerSetLayout(),
+		theirImageHandler.GetImageSetLayout(),
+		theirUniformHandler.GetDynamicUniformLayout()
+	}, theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache());
+}
+
+void
+SpriteRenderer::BuildSDFPipeline()
+{
+	// built up front with the sprite pipeline, so the first distance field text doesn't stall recording
+	char shaderPaths[][128]
+	{
+		"Shaders/sprite_sdf_vshader.vert",
+		"Shaders/sprite_sdf_fshader.frag"
+	};
+	mySDFShader = new Shader(shaderPaths,
+							_ARRAYSIZE(shaderPaths),
+							theirVulkanFramework);
+
+	auto [result, pipeline] = ConstructPipeline(mySDFShader);
+	if (result)
+	{
+		LOG("failed building sdf sprite pipeline, distance field text is skipped");
+		mySDFPipeline = {};
+		return;
+	}
+	mySDFPipeline = pipeline;
+	theirVulkanFramework.GetPipelineReloader().Register(mySDFPipeline, *mySDFShader, 0, [this](Shader* shader)
+	{
+		return ConstructPipeline(shader);
+	});
+}
+
 std::vector<rflx::Features> SpriteRenderer::GetImplementedFeatures() const
 {
     return {rflx::Features::FEATURE_SPRITES};
 }
 
+std::vector<ResourceUse> SpriteRenderer::GetResourceUses() const
+{
+	// blends on top of whatever was drawn to the intermediate before it
+	return {
+		theirImageHandler.GetImagesUse(ResourceAccess::Read),
+		theirRenderPassFactory.GetIntermediateUse(ResourceAccess::ReadWrite)};
+}
+
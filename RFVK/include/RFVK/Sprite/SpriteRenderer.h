@@ -13,11 +13,31 @@ struct SpriteRenderCommand
 	Vec2f			scale;
 	ImageID			imgArrID;
 	uint32_t		imgArrIndex;
+	Vec4f			uvRect = {0, 0, 1, 1};
+
+	// distance field text only
+	bool			signedDistance = false;
+	Vec4f			outlineColor = {0, 0, 0, 0};
+	Vec4f			shadowColor = {0, 0, 0, 0};
+	Vec2f			shadowOffset = {0, 0};
+	float			outlineWidth = 0;
+};
+
+struct TextRenderCommand
+{
+	TextLayoutID	layoutID;
+	Vec2f			position;
+	float			scale;
+	Vec4f			color;
+	Vec4f			outlineColor;
+	Vec4f			shadowColor;
+	Vec2f			shadowOffset;
+	float			outlineWidth;
 };
 
 struct SpriteInstance
 {
-	Vec4f padding0;
+	Vec4f uvRect;
 	Vec4f color;
 	Vec2f pos;
 	Vec2f pivot;
@@ -26,6 +46,31 @@ struct SpriteInstance
 	float imgArrIndex;
 };
 
+struct SDFSpriteInstance
+{
+	Vec4f uvRect;
+	Vec4f color;
+	Vec4f outlineColor;
+	Vec4f shadowColor;
+	Vec2f pos;
+	Vec2f pivot;
+	Vec2f scale;
+	Vec2f shadowOffset;
+	float imgArrID;
+	float outlineWidth;
+	float padding0;
+	float padding1;
+};
+// the only per-draw value, pushed so sprites don't bind and update the scene globals
+struct SpriteDrawConstants
+{
+	float aspectRatio;
+};
+
+// the shaders declare the full arrays, a dynamic uniform must be able to bind all of them
+static_assert(MaxNumSpriteInstances * sizeof(SpriteInstance) <= MaxDynamicUniformRange);
+static_assert(MaxNumSDFSpriteInstances * sizeof(SDFSpriteInstance) <= MaxDynamicUniformRange);
+
 struct SpriteRenderSchedule
 {
 	std::array<neat::static_vector<SpriteRenderCommand, MaxNumInstances>, 3> renderCommands;
@@ -39,11 +84,12 @@ class SpriteRenderer : public WorkerSystem
 public:
 															SpriteRenderer(
 																class VulkanFramework&		vulkanFramework,
-																class SceneGlobals&			sceneGlobals,
 																class ImageHandler&			imageHandler,
+																class FontHandler&			fontHandler,
 																class RenderPassFactory&	renderPassFactory,
 																class UniformHandler&		uniformHandler,
 																QueueFamilyIndices			familyIndices);
+															~SpriteRenderer();
 
 	neat::static_vector<WorkerSubmission, MaxWorkerSubmissions>
 															RecordSubmit(
@@ -52,18 +98,25 @@ public:
 																			waitSemaphores, 
 																const neat::static_vector<VkSemaphore, MaxWorkerSubmissions>& 
 																			signalSemaphores) override;
-	void													AddSchedule(neat::ThreadID threadID) override { myWorkScheduler.AddSchedule(threadID); }
+	void													AddSchedule(neat::ThreadID threadID) override;
 	std::array<VkFence, NumSwapchainImages>					GetFences() override;
 	std::vector<rflx::Features>								GetImplementedFeatures() const override;
 	int														GetSubmissionCount() override { return 1; }
+	std::vector<ResourceUse>								GetResourceUses() const override;
+	const char*												GetName() const override { return "SpriteRenderer"; }
 	
 	WorkScheduler<SpriteRenderCommand, 1024, 1024>			myWorkScheduler;
+	WorkScheduler<TextRenderCommand, 256, 256>				myTextWorkScheduler;
 
 private:
+	std::tuple<VkResult, Pipeline>							ConstructPipeline(class Shader* shader);
+	void													BuildSDFPipeline();
+
 	VulkanFramework&										theirVulkanFramework;
-	SceneGlobals&											theirSceneGlobals;
 	ImageHandler&											theirImageHandler;
+	FontHandler&											theirFontHandler;
 	UniformHandler&											theirUniformHandler;
+	RenderPassFactory&										theirRenderPassFactory;
 
 	neat::static_vector<QueueFamilyIndex, 8>				myOwners;
 
@@ -72,11 +125,12 @@ private:
 	RenderPass												myRenderPass;
 	class Shader*											mySpriteShader;
 	Pipeline												mySpritePipeline;
+	class Shader*											mySDFShader = nullptr;
+	Pipeline												mySDFPipeline = {};
 
 	std::array<VkCommandBuffer, NumSwapchainImages>			myCmdBuffers;
 	std::array<VkFence, NumSwapchainImages>					myCmdBufferFences;
 
-	UniformID												mySpriteInstancesID;
 
 	
 };
@@ -6,6 +6,7 @@
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Memory/ImageAllocator.h"
 #include "RFVK/Image/ImageHandler.h"
+#include "UTF8.h"
 
 #ifdef _DEBUG
 #pragma comment(lib, "freetype-d.lib")
@@ -23,6 +24,7 @@ FontHandler::FontHandler(
 	: theirVulkanFramework(vulkanFramework)
 	, theirImageHandler(imageHandler)
 	, myFontIDKeeper(MaxNumFonts)
+	, myLayoutCache(std::make_unique<TextLayoutCache>(*this))
 {
 	myOwners.resize(numOwners);
 	for (uint32_t ownerIndex = 0; ownerIndex < numOwners; ++ownerIndex)
@@ -33,19 +35,24 @@ FontHandler::FontHandler(
 	auto result = FT_Init_FreeType(&FTLibrary);
 	assert(!result && "failed initializing free type");
 
-	auto allocSub = theirImageHandler.GetImageAllocator().Start();
-	AddFont(allocSub, "open_sans_reg.ttf");
-	theirImageHandler.GetImageAllocator().Queue(std::move(allocSub));
+	AddFont("open_sans_reg.ttf");
 }
 
 FontHandler::~FontHandler()
 {
+	for (auto& font : myFonts)
+	{
+		if (font.face)
+		{
+			FT_Done_Face(font.face);
+		}
+	}
 }
 
 FontID
 FontHandler::AddFont(
-	AllocationSubmissionID allocSubID,
-	const char* path)
+	const char*	path,
+	FontMode	mode)
 {
 	const FontID id = myFontIDKeeper.FetchFreeID();
 	if (BAD_ID(id))
@@ -56,121 +63,637 @@ FontHandler::AddFont(
 
 	Font& font = myFonts[int(id)];
 
-	FT_Face face;
-
-	auto result = FT_New_Face(FTLibrary, path, 0, &face);
+	std::scoped_lock lock(myMutex);
+	auto result = FT_New_Face(FTLibrary, path, 0, &font.face);
 	if (result)
 	{
+		LOG("failed loading font, \"", path, "\"");
+		font = {};
 		myFontIDKeeper.ReturnID(id);
 		return FontID(INVALID_ID);
 	}
+	FT_Select_Charmap(font.face, FT_ENCODING_UNICODE);
+	font.hasKerning = FT_HAS_KERNING(font.face);
+	font.mode = mode;
+	font.facePixelSize = 0;
 
-	std::vector<uint8_t> fontData;
-	int res = 512;
-	int numLayers = 0;
-	for (char c = FirstFontGlyph; c <= LastFontGlyph; ++c)
+	return id;
+}
+
+Glyph
+FontHandler::GetGlyph(
+	FontID		id,
+	uint32_t	codepoint,
+	uint32_t	pixelSize)
+{
+	if (BAD_ID(id) || !myFonts[int(id)].face)
 	{
-		auto rawGlyph = DrawGlyph(face, res, c);
-		font.metrics[c - FirstFontGlyph] = rawGlyph.metrics;
-		fontData.insert(fontData.end(), rawGlyph.bmp.begin(), rawGlyph.bmp.end());
-		numLayers++;
+		return {};
 	}
+	pixelSize = GlyphPixelSize(id, pixelSize);
 
-	font.imgArrID = theirImageHandler.AddImage2D();
-	theirImageHandler.LoadImage2D(
-		font.imgArrID,
-		allocSubID,
-		std::move(fontData), 
-		{res,res}, 
-		VK_FORMAT_R8G8B8A8_UNORM, 
-		4);
-	
-	return id;
+	std::scoped_lock lock(myMutex);
+	const uint64_t key = GlyphKey(id, codepoint, pixelSize);
+	if (auto it = myGlyphs.find(key); it != myGlyphs.end())
+	{
+		if (!BAD_ID(it->second.imageID))
+		{
+			myPages[it->second.pageIndex].lastUsedFrame = myFrame;
+		}
+		return it->second;
+	}
+	if (HasFailed(key))
+	{
+		return {};
+	}
+
+	RasterizedGlyph rasterized;
+	if (!Rasterize(id, codepoint, pixelSize, rasterized))
+	{
+		return {};
+	}
+	if (rasterized.glyph.signedDistance)
+	{
+		BuildDistanceField(rasterized);
+	}
+	return Insert(std::move(rasterized));
+}
+
+void
+FontHandler::PrepareGlyphs(
+	FontID		id,
+	const char*	text,
+	uint32_t	pixelSize)
+{
+	if (BAD_ID(id) || !myFonts[int(id)].face)
+	{
+		return;
+	}
+	pixelSize = GlyphPixelSize(id, pixelSize);
+
+	std::scoped_lock lock(myMutex);
+	std::vector<RasterizedGlyph> rasterized;
+	std::unordered_set<uint64_t> queued;
+	const char* cursor = text;
+	while (const uint32_t codepoint = DecodeUTF8(cursor))
+	{
+		const uint64_t key = GlyphKey(id, codepoint, pixelSize);
+		if (myGlyphs.contains(key) || HasFailed(key) || !queued.insert(key).second)
+		{
+			continue;
+		}
+		RasterizedGlyph glyph;
+		if (Rasterize(id, codepoint, pixelSize, glyph))
+		{
+			rasterized.emplace_back(std::move(glyph));
+		}
+	}
+
+	// freetype faces aren't thread safe, but the distance transforms are independent
+	if (myFonts[int(id)].mode == FontMode::SDF)
+	{
+		neat::ParallelFor(0, rasterized.size(), [&rasterized](size_t glyphIndex)
+		{
+			BuildDistanceField(rasterized[glyphIndex]);
+		});
+	}
+
+	for (auto& glyph : rasterized)
+	{
+		Insert(std::move(glyph));
+	}
+}
+
+float
+FontHandler::GetKerning(
+	FontID		id,
+	uint32_t	leftGlyphIndex,
+	uint32_t	rightGlyphIndex,
+	uint32_t	pixelSize)
+{
+	if (BAD_ID(id) || !myFonts[int(id)].hasKerning
+		|| leftGlyphIndex == 0 || rightGlyphIndex == 0)
+	{
+		return 0.f;
+	}
+
+	std::scoped_lock lock(myMutex);
+	// a layout asks for every pair at one size, so the face is only rescaled when the size changes
+	Font& font = myFonts[int(id)];
+	FT_Vector kerning;
+	if (!SetFaceSize(font, pixelSize)
+		|| FT_Get_Kerning(font.face, leftGlyphIndex, rightGlyphIndex, FT_KERNING_DEFAULT, &kerning))
+	{
+		return 0.f;
+	}
+	return float(kerning.x >> 6) / float(pixelSize);
 }
 
+void
+FontHandler::MarkPagesUsed(
+	uint32_t pageMask)
+{
+	std::scoped_lock lock(myMutex);
+	for (uint32_t pageIndex = 0; pageIndex < myPages.size(); ++pageIndex)
+	{
+		if (pageMask & (1u << pageIndex))
+		{
+			myPages[pageIndex].lastUsedFrame = myFrame;
+		}
+	}
+}
 
-GlyphMetrics
-FontHandler::GetGlyphMetrics(
-	FontID		id, 
-	uint32_t	glyphIndex) const
+void
+FontHandler::Flush()
 {
-	return myFonts[int(id)].metrics[glyphIndex];
+	myLayoutCache->Update();
+
+	std::scoped_lock lock(myMutex);
+	++myFrame;
+
+	for (auto& page : myPages)
+	{
+		if (page.dirtyMin.x >= page.dirtyMax.x)
+		{
+			continue;
+		}
+
+		auto& imageAllocator = theirImageHandler.GetImageAllocator();
+		auto allocSubID = imageAllocator.Start();
+		if (!page.isAllocated)
+		{
+			// general layout lets later glyphs be written while the rest of the page is sampled
+			// the view swizzles color to white, only coverage is stored
+			auto executedEvent = theirImageHandler.StreamImage2D(
+				page.imageID,
+				allocSubID,
+				{},
+				{GlyphPageDim, GlyphPageDim},
+				1,
+				VK_FORMAT_R8_UNORM,
+				VK_IMAGE_LAYOUT_GENERAL,
+				{VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_R});
+			if (!executedEvent)
+			{
+				imageAllocator.Queue(std::move(allocSubID));
+				continue;
+			}
+			theirImageHandler.SetImage2DDimension(page.imageID, {GlyphPageDim, GlyphPageDim});
+			theirImageHandler.myImages2D[int(page.imageID)].layers = 1;
+			page.isAllocated = true;
+		}
+
+		// only the rect holding this frame's glyphs goes up, padding included
+		const Vec2ui extent = page.dirtyMax - page.dirtyMin;
+		std::vector<uint8_t> region(size_t(extent.x) * extent.y);
+		for (uint32_t y = 0; y < extent.y; ++y)
+		{
+			const auto row = page.pixels.begin() + size_t(page.dirtyMin.y + y) * GlyphPageDim + page.dirtyMin.x;
+			std::copy(row, row + extent.x, region.begin() + size_t(y) * extent.x);
+		}
+		theirImageHandler.WriteImage2DRegion(
+			page.imageID,
+			allocSubID,
+			region,
+			page.dirtyMin,
+			extent);
+		imageAllocator.Queue(std::move(allocSubID));
+
+		page.dirtyMin = {UINT32_MAX, UINT32_MAX};
+		page.dirtyMax = {};
+	}
 }
 
-ImageHandler& 
+uint32_t
+FontHandler::SelectPixelSize(
+	float screenPixels)
+{
+	for (const int pixelSize : GlyphPixelSizes)
+	{
+		if (float(pixelSize) >= screenPixels)
+		{
+			return pixelSize;
+		}
+	}
+	return std::end(GlyphPixelSizes)[-1];
+}
+
+FontMode
+FontHandler::GetFontMode(
+	FontID id) const
+{
+	if (BAD_ID(id))
+	{
+		return FontMode::Bitmap;
+	}
+	return myFonts[int(id)].mode;
+}
+
+uint32_t
+FontHandler::GetNumCachedGlyphs() const
+{
+	std::scoped_lock lock(myMutex);
+	return uint32_t(myGlyphs.size());
+}
+
+uint64_t
+FontHandler::GetGlyphGeneration() const
+{
+	return myGlyphGeneration;
+}
+
+ImageHandler&
 FontHandler::GetImageHandler()
 {
 	return theirImageHandler;
 }
 
-Font
-FontHandler::operator[](
-	FontID id)
+TextLayoutCache&
+FontHandler::GetLayoutCache() const
 {
-	return myFonts[int(id)];
+	return *myLayoutCache;
 }
 
-RawGlyph
-FontHandler::DrawGlyph(
-	FT_FaceRec_*	fontFace,
-	int				resolution,
-	char			glyph)
+std::vector<uint8_t>
+FontHandler::GenerateDistanceField(
+	const std::vector<uint8_t>&	coverage,
+	Vec2ui						dim,
+	uint32_t					spread)
 {
-	auto result = FT_Set_Pixel_Sizes(fontFace, resolution, resolution);
-	if (result)
+	constexpr int Far = 1 << 14;
+	const int width = int(dim.x);
+	const int height = int(dim.y);
+
+	// 8SSEDT, each cell tracks the offset to its nearest seed
+	auto propagate = [width, height](std::vector<glm::ivec2>& grid)
 	{
-		return {};
+		auto compare = [&grid, width, height](glm::ivec2& offset, int x, int y, int dx, int dy)
+		{
+			if (x + dx < 0 || x + dx >= width || y + dy < 0 || y + dy >= height)
+			{
+				return;
+			}
+			const glm::ivec2 other = grid[(y + dy) * width + x + dx] + glm::ivec2(dx, dy);
+			if (other.x * other.x + other.y * other.y < offset.x * offset.x + offset.y * offset.y)
+			{
+				offset = other;
+			}
+		};
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				auto& offset = grid[y * width + x];
+				compare(offset, x, y, -1, 0);
+				compare(offset, x, y, -1, -1);
+				compare(offset, x, y, 0, -1);
+				compare(offset, x, y, 1, -1);
+			}
+			for (int x = width - 1; x >= 0; --x)
+			{
+				compare(grid[y * width + x], x, y, 1, 0);
+			}
+		}
+		for (int y = height - 1; y >= 0; --y)
+		{
+			for (int x = width - 1; x >= 0; --x)
+			{
+				auto& offset = grid[y * width + x];
+				compare(offset, x, y, 1, 0);
+				compare(offset, x, y, 1, 1);
+				compare(offset, x, y, 0, 1);
+				compare(offset, x, y, -1, 1);
+			}
+			for (int x = 0; x < width; ++x)
+			{
+				compare(grid[y * width + x], x, y, -1, 0);
+			}
+		}
+	};
+
+	std::vector<glm::ivec2> toInside(coverage.size());
+	std::vector<glm::ivec2> toOutside(coverage.size());
+	for (size_t pixel = 0; pixel < coverage.size(); ++pixel)
+	{
+		const bool inside = coverage[pixel] >= 128;
+		toInside[pixel] = inside ? glm::ivec2(0) : glm::ivec2(Far);
+		toOutside[pixel] = inside ? glm::ivec2(Far) : glm::ivec2(0);
 	}
+	propagate(toInside);
+	propagate(toOutside);
 
-	// RAW GLYPH
+	// 0.5 is the outline, values above are inside
+	std::vector<uint8_t> field(coverage.size());
+	for (size_t pixel = 0; pixel < coverage.size(); ++pixel)
+	{
+		const float distance = coverage[pixel] >= 128
+			? -(glm::length(glm::vec2(toOutside[pixel])) - 0.5f)
+			: glm::length(glm::vec2(toInside[pixel])) - 0.5f;
+		const float value = 0.5f - distance / (2.f * float(spread));
+		field[pixel] = uint8_t(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+	}
+	return field;
+}
 
-	auto slot = fontFace->glyph;
+uint32_t
+FontHandler::GlyphPixelSize(
+	FontID		id,
+	uint32_t	pixelSize) const
+{
+	// distance fields scale freely, one size serves every bucket
+	return myFonts[int(id)].mode == FontMode::SDF ? SDFGlyphPixelSize : pixelSize;
+}
 
-	std::vector<PixelValue> rawPixels;
-	rawPixels.resize(resolution * resolution, {255,255,255,0});
+bool
+FontHandler::Rasterize(
+	FontID				id,
+	uint32_t			codepoint,
+	uint32_t			pixelSize,
+	RasterizedGlyph&	outGlyph)
+{
+	FT_Face face = myFonts[int(id)].face;
+	const bool signedDistance = myFonts[int(id)].mode == FontMode::SDF;
+	const uint32_t renderSize = signedDistance ? pixelSize * SDFOversampling : pixelSize;
+	if (!SetFaceSize(myFonts[int(id)], renderSize))
+	{
+		return false;
+	}
+	const auto charIndex = FT_Get_Char_Index(face, codepoint);
+	if (FT_Load_Glyph(face, charIndex, FT_LOAD_DEFAULT)
+		|| FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL))
+	{
+		return false;
+	}
 
-	auto charIndex = FT_Get_Char_Index(fontFace, glyph);
+	const auto slot = face->glyph;
+	const auto& bitmap = slot->bitmap;
+	const float emScale = 1.f / float(renderSize);
 
-	result = FT_Load_Glyph(fontFace, charIndex, FT_LOAD_DEFAULT);
-	if (result)
+	outGlyph.key = GlyphKey(id, codepoint, pixelSize);
+	outGlyph.codepoint = codepoint;
+	outGlyph.glyph.glyphIndex = charIndex;
+	outGlyph.glyph.signedDistance = signedDistance;
+	outGlyph.glyph.advance = float(slot->advance.x >> 6) * emScale;
+
+	// whitespace only needs metrics
+	if (bitmap.width == 0 || bitmap.rows == 0)
 	{
-		return {};
+		return true;
 	}
-	result = FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL);
-	if (result)
+
+	// distance fields need room to fall off outside the outline
+	const uint32_t margin = signedDistance ? SDFSpread * SDFOversampling : 0;
+	const uint32_t alignment = signedDistance ? SDFOversampling : 1;
+	outGlyph.dim = {
+		(bitmap.width + alignment - 1) / alignment * alignment + margin * 2,
+		(bitmap.rows + alignment - 1) / alignment * alignment + margin * 2};
+	outGlyph.coverage.resize(size_t(outGlyph.dim.x) * outGlyph.dim.y, 0);
+	for (uint32_t y = 0; y < bitmap.rows; ++y)
 	{
+		for (uint32_t x = 0; x < bitmap.width; ++x)
+		{
+			outGlyph.coverage[size_t(y + margin) * outGlyph.dim.x + x + margin] = bitmap.buffer[y * bitmap.pitch + x];
+		}
+	}
+
+	outGlyph.glyph.bearing = {
+		float(slot->bitmap_left - int(margin)) * emScale,
+		float(slot->bitmap_top + int(margin)) * emScale};
+	outGlyph.glyph.size = {float(outGlyph.dim.x) * emScale, float(outGlyph.dim.y) * emScale};
+	return true;
+}
+
+void
+FontHandler::BuildDistanceField(
+	RasterizedGlyph& glyph)
+{
+	if (glyph.coverage.empty())
+	{
+		return;
+	}
+
+	const auto field = GenerateDistanceField(glyph.coverage, glyph.dim, SDFSpread * SDFOversampling);
+
+	// box filter the oversampled field down to the stored size
+	const Vec2ui dim = glyph.dim / uint32_t(SDFOversampling);
+	glyph.coverage.assign(size_t(dim.x) * dim.y, 0);
+	for (uint32_t y = 0; y < dim.y; ++y)
+	{
+		for (uint32_t x = 0; x < dim.x; ++x)
+		{
+			uint32_t sum = 0;
+			for (uint32_t sy = 0; sy < SDFOversampling; ++sy)
+			{
+				for (uint32_t sx = 0; sx < SDFOversampling; ++sx)
+				{
+					sum += field[size_t(y * SDFOversampling + sy) * glyph.dim.x + x * SDFOversampling + sx];
+				}
+			}
+			glyph.coverage[size_t(y) * dim.x + x] = uint8_t(sum / (SDFOversampling * SDFOversampling));
+		}
+	}
+	glyph.dim = dim;
+}
+
+Glyph
+FontHandler::Insert(
+	RasterizedGlyph&& rasterized)
+{
+	Glyph glyph = rasterized.glyph;
+	if (rasterized.coverage.empty())
+	{
+		myGlyphs[rasterized.key] = glyph;
+		return glyph;
+	}
+
+	// PACK
+	const Vec2ui paddedSize = rasterized.dim + Vec2ui(GlyphPadding * 2);
+	auto [packed, pageIndex, position] = AllocateGlyphRect(paddedSize);
+	if (!packed)
+	{
+		LOG("no room for glyph in glyph pages, codepoint: ", rasterized.codepoint);
+		myFailedGlyphs[rasterized.key] = myGlyphGeneration;
 		return {};
 	}
+	myFailedGlyphs.erase(rasterized.key);
+
+	auto& page = myPages[pageIndex];
+	for (uint32_t y = 0; y < rasterized.dim.y; ++y)
+	{
+		for (uint32_t x = 0; x < rasterized.dim.x; ++x)
+		{
+			const size_t dst = size_t(position.y + GlyphPadding + y) * GlyphPageDim + position.x + GlyphPadding + x;
+			page.pixels[dst] = rasterized.coverage[size_t(y) * rasterized.dim.x + x];
+		}
+	}
+	page.dirtyMin = glm::min(page.dirtyMin, position);
+	page.dirtyMax = glm::max(page.dirtyMax, position + paddedSize);
+	page.lastUsedFrame = myFrame;
 
-	auto* const bitmap = &slot->bitmap;
+	glyph.pageIndex = pageIndex;
+	glyph.imageID = page.imageID;
+	glyph.uvRect = {
+		float(position.x + GlyphPadding) / GlyphPageDim,
+		float(position.y + GlyphPadding) / GlyphPageDim,
+		float(rasterized.dim.x) / GlyphPageDim,
+		float(rasterized.dim.y) / GlyphPageDim};
 
-	const int advance = slot->metrics.horiAdvance >> 6;
-	const int bearingX = slot->metrics.horiBearingX >> 6;
-	const int bearingY = slot->metrics.horiBearingY >> 6;
-	
-	const int stride = advance - bearingX;
-	const int yOffset = bitmap->rows - bearingY;
-	float strideF = float(stride) / float(resolution);
-	float yOffsetF = float(yOffset) / float(resolution);
+	myGlyphs[rasterized.key] = glyph;
+	return glyph;
+}
 
-	const int yMax = std::min(int(bitmap->rows), resolution);
-	const int xMax = int(bitmap->width);
+std::tuple<bool, uint32_t, Vec2ui>
+FontHandler::AllocateGlyphRect(
+	Vec2ui size)
+{
+	if (size.x > GlyphPageDim || size.y > GlyphPageDim)
+	{
+		return {false, 0, {}};
+	}
 
-	for (int y = 0; y < yMax; y++)
+	for (uint32_t pageIndex = 0; pageIndex < myPages.size(); ++pageIndex)
 	{
-		for (int x = 0; x < xMax; x++)
+		auto [packed, position] = AllocateOnPage(myPages[pageIndex], size);
+		if (packed)
 		{
-			int iy = resolution - y - 1;
-			rawPixels[iy * resolution + x].a = bitmap->buffer[(yMax - y - 1) * bitmap->width + x];
+			return {true, pageIndex, position};
 		}
 	}
 
-	GlyphMetrics metrics;
-	metrics.xStride = strideF;
-	metrics.yOffset = -abs(yOffsetF);
+	uint32_t pageIndex;
+	if (myPages.size() < MaxNumGlyphPages)
+	{
+		GlyphPage page;
+		page.imageID = theirImageHandler.AddImage2D();
+		if (BAD_ID(page.imageID))
+		{
+			return {false, 0, {}};
+		}
+		ClearPage(page);
+		pageIndex = uint32_t(myPages.size());
+		myPages.emplace_back(std::move(page));
+	}
+	else
+	{
+		pageIndex = EvictPage();
+		if (pageIndex == UINT32_MAX)
+		{
+			return {false, 0, {}};
+		}
+	}
+
+	auto [packed, position] = AllocateOnPage(myPages[pageIndex], size);
+	return {packed, pageIndex, position};
+}
+
+std::tuple<bool, Vec2ui>
+FontHandler::AllocateOnPage(
+	GlyphPage&	page,
+	Vec2ui		size)
+{
+	// SHELF FIRST FIT
+	for (auto& shelf : page.shelves)
+	{
+		if (shelf.height >= size.y
+			&& shelf.height <= size.y + size.y / 4
+			&& shelf.x + size.x <= GlyphPageDim)
+		{
+			const Vec2ui position = {shelf.x, shelf.y};
+			shelf.x += size.x;
+			return {true, position};
+		}
+	}
+
+	// NEW SHELF
+	if (page.nextShelfY + size.y > GlyphPageDim)
+	{
+		return {false, {}};
+	}
+	GlyphShelf shelf;
+	shelf.y = page.nextShelfY;
+	shelf.height = size.y;
+	shelf.x = size.x;
+	page.shelves.emplace_back(shelf);
+	page.nextShelfY += size.y;
+	return {true, {0, shelf.y}};
+}
+
+uint32_t
+FontHandler::EvictPage()
+{
+	// the page is overwritten in place, so frames still in flight must not sample it, the glyph is dropped instead
+	uint32_t lruIndex = UINT32_MAX;
+	for (uint32_t pageIndex = 0; pageIndex < myPages.size(); ++pageIndex)
+	{
+		if (myPages[pageIndex].lastUsedFrame + NumSwapchainImages > myFrame)
+		{
+			continue;
+		}
+		if (lruIndex == UINT32_MAX || myPages[pageIndex].lastUsedFrame < myPages[lruIndex].lastUsedFrame)
+		{
+			lruIndex = pageIndex;
+		}
+	}
+	if (lruIndex == UINT32_MAX)
+	{
+		return lruIndex;
+	}
+
+	std::erase_if(myGlyphs, [lruIndex](const auto& entry)
+	{
+		return entry.second.pageIndex == lruIndex && !BAD_ID(entry.second.imageID);
+	});
+
+	ClearPage(myPages[lruIndex]);
+	// cached layouts hold uv rects into the cleared page
+	++myGlyphGeneration;
+	return lruIndex;
+}
+
+void
+FontHandler::ClearPage(
+	GlyphPage& page)
+{
+	// nothing is uploaded for the clear, every glyph written later carries its own cleared padding
+	page.pixels.assign(size_t(GlyphPageDim) * GlyphPageDim, 0);
+	page.shelves.clear();
+	page.nextShelfY = 0;
+	page.dirtyMin = {UINT32_MAX, UINT32_MAX};
+	page.dirtyMax = {};
+}
+
+bool
+FontHandler::SetFaceSize(
+	Font&		font,
+	uint32_t	pixelSize)
+{
+	if (font.facePixelSize == pixelSize)
+	{
+		return true;
+	}
+	if (FT_Set_Pixel_Sizes(font.face, 0, pixelSize))
+	{
+		font.facePixelSize = 0;
+		return false;
+	}
+	font.facePixelSize = pixelSize;
+	return true;
+}
+
+bool
+FontHandler::HasFailed(
+	uint64_t key) const
+{
+	auto it = myFailedGlyphs.find(key);
+	return it != myFailedGlyphs.end() && it->second == myGlyphGeneration;
+}
 
-	std::vector<uint8_t> rawImg;
-	rawImg.resize(rawPixels.size() * 4);
-	memcpy(rawImg.data(), rawPixels.data(), rawImg.size());
-	return { rawImg, metrics};
+uint64_t
+FontHandler::GlyphKey(
+	FontID		id,
+	uint32_t	codepoint,
+	uint32_t	pixelSize)
+{
+	return uint64_t(id) << 40 | uint64_t(pixelSize) << 24 | codepoint;
 }
@@ -1,22 +1,61 @@
-
 #pragma once
+#include "TextLayoutCache.h"
 
-struct GlyphMetrics
+enum class FontMode
 {
-	float				xStride;
-	float				yOffset;
+	Bitmap,
+	SDF,
+};
+
+struct Glyph
+{
+	ImageID		imageID = ImageID(INVALID_ID);
+	Vec4f		uvRect = {};
+	Vec2f		size = {};
+	Vec2f		bearing = {};
+	float		advance = 0;
+	uint32_t	glyphIndex = 0;
+	uint32_t	pageIndex = 0;
+	bool		signedDistance = false;
 };
 
 struct Font
 {
-	ImageID										imgArrID;
-	std::array<GlyphMetrics, NumGlyphsPerFont>	metrics;
+	struct FT_FaceRec_*	face = nullptr;
+	FontMode			mode = FontMode::Bitmap;
+	bool				hasKerning = false;
+	// the size the face is set to, changing it rescales the whole face
+	uint32_t			facePixelSize = 0;
+};
+
+struct RasterizedGlyph
+{
+	uint64_t				key = 0;
+	Glyph					glyph;
+	uint32_t				codepoint = 0;
+	std::vector<uint8_t>	coverage;
+	Vec2ui					dim = {};
+};
+
+struct GlyphShelf
+{
+	uint32_t	y = 0;
+	uint32_t	height = 0;
+	uint32_t	x = 0;
 };
 
-struct RawGlyph
+struct GlyphPage
 {
-	std::vector<uint8_t>	bmp;
-	GlyphMetrics			metrics;
+	ImageID						imageID = ImageID(INVALID_ID);
+	// one byte of coverage or distance per pixel
+	std::vector<uint8_t>		pixels;
+	std::vector<GlyphShelf>		shelves;
+	uint32_t					nextShelfY = 0;
+	bool						isAllocated = false;
+	// bounds of the glyphs written since the last flush, only they are uploaded
+	Vec2ui						dirtyMin = {UINT32_MAX, UINT32_MAX};
+	Vec2ui						dirtyMax = {};
+	uint64_t					lastUsedFrame = 0;
 };
 
 class FontHandler
@@ -30,32 +69,82 @@ public:
 												~FontHandler();
 
 	FontID										AddFont(
-													AllocationSubmissionID allocSubID,
-													const char* path);
-	
-	
-	GlyphMetrics								GetGlyphMetrics(
+													const char*	path,
+													FontMode	mode = FontMode::Bitmap);
+
+	Glyph										GetGlyph(
+													FontID		id,
+													uint32_t	codepoint,
+													uint32_t	pixelSize);
+	void										PrepareGlyphs(
+													FontID		id,
+													const char*	text,
+													uint32_t	pixelSize);
+	float										GetKerning(
 													FontID		id,
-													uint32_t	glyphIndex) const;
+													uint32_t	leftGlyphIndex,
+													uint32_t	rightGlyphIndex,
+													uint32_t	pixelSize);
+	// cached layouts skip the glyph lookups, this keeps their pages from being evicted under them
+	void										MarkPagesUsed(uint32_t pageMask);
+	void										Flush();
+
+	_nodiscard static uint32_t					SelectPixelSize(float screenPixels);
+	_nodiscard FontMode							GetFontMode(FontID id) const;
+	_nodiscard uint32_t							GetNumCachedGlyphs() const;
+	_nodiscard uint64_t							GetGlyphGeneration() const;
 
 	ImageHandler&								GetImageHandler();
+	TextLayoutCache&							GetLayoutCache() const;
 
-	Font										operator[](FontID id);
+	static std::vector<uint8_t>					GenerateDistanceField(
+													const std::vector<uint8_t>&	coverage,
+													Vec2ui						dim,
+													uint32_t					spread);
 
 private:
-	static RawGlyph								DrawGlyph(
-													struct FT_FaceRec_* fontFace,
-													int					resolution,
-													char				glyph);
-	
+	uint32_t									GlyphPixelSize(
+													FontID		id,
+													uint32_t	pixelSize) const;
+	bool										Rasterize(
+													FontID				id,
+													uint32_t			codepoint,
+													uint32_t			pixelSize,
+													RasterizedGlyph&	outGlyph);
+	static void									BuildDistanceField(RasterizedGlyph& glyph);
+	Glyph										Insert(RasterizedGlyph&& glyph);
+	std::tuple<bool, uint32_t, Vec2ui>			AllocateGlyphRect(Vec2ui size);
+	std::tuple<bool, Vec2ui>					AllocateOnPage(
+													GlyphPage&	page,
+													Vec2ui		size);
+	uint32_t									EvictPage();
+	static void									ClearPage(GlyphPage& page);
+	static bool									SetFaceSize(
+													Font&		font,
+													uint32_t	pixelSize);
+	bool										HasFailed(uint64_t key) const;
+	static uint64_t								GlyphKey(
+													FontID		id,
+													uint32_t	codepoint,
+													uint32_t	pixelSize);
+
 	VulkanFramework&							theirVulkanFramework;
 	ImageHandler&								theirImageHandler;
 
 	std::array<Font, MaxNumFonts>				myFonts;
-	
 	IDKeeper<FontID>							myFontIDKeeper;
 
+	mutable std::mutex							myMutex;
+	std::unordered_map<uint64_t, Glyph>		myGlyphs;
+	// glyphs that found no room, keyed to the glyph generation they failed in, retried once a page is evicted
+	std::unordered_map<uint64_t, uint64_t>		myFailedGlyphs;
+	std::vector<GlyphPage>						myPages;
+	uint64_t									myFrame = 0;
+	std::atomic<uint64_t>						myGlyphGeneration = 0;
+
+	std::unique_ptr<TextLayoutCache>			myLayoutCache;
+
 	neat::static_vector<QueueFamilyIndex, 16>	myOwners;
 
 
-};
\ No newline at end of file
+};
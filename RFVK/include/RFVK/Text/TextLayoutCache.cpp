@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "TextLayoutCache.h"
+
+#include "FontHandler.h"
+#include "UTF8.h"
+
+TextLayoutCache::TextLayoutCache(
+	FontHandler& fontHandler)
+	: theirFontHandler(fontHandler)
+	, myLayoutIDKeeper(MaxNumTextLayouts)
+{
+	myLayouts.resize(MaxNumTextLayouts);
+}
+
+TextLayoutID
+TextLayoutCache::GetLayout(
+	FontID		fontID,
+	const char*	text,
+	uint32_t	pixelSize)
+{
+	if (BAD_ID(fontID) || !text)
+	{
+		return TextLayoutID(INVALID_ID);
+	}
+
+	const uint64_t hash = LayoutHash(fontID, text, pixelSize);
+	const uint64_t glyphGeneration = theirFontHandler.GetGlyphGeneration();
+	TextLayoutID id = TextLayoutID(INVALID_ID);
+	{
+		std::scoped_lock lock(myMutex);
+		if (auto it = myLayoutLookup.find(hash); it != myLayoutLookup.end())
+		{
+			auto& layout = myLayouts[int(it->second)];
+			if (layout.fontID == fontID
+				&& layout.pixelSize == pixelSize
+				&& layout.text == text)
+			{
+				layout.lastUsedFrame = myFrame;
+				if (layout.glyphGeneration == glyphGeneration)
+				{
+					theirFontHandler.MarkPagesUsed(layout.pageMask);
+					return it->second;
+				}
+				id = it->second;
+			}
+		}
+	}
+
+	// glyph lookups take the font lock, so build outside of ours
+	TextLayout layout;
+	layout.fontID = fontID;
+	layout.pixelSize = pixelSize;
+	layout.hash = hash;
+	layout.glyphGeneration = glyphGeneration;
+	layout.text = text;
+	Build(layout);
+
+	std::scoped_lock lock(myMutex);
+	if (BAD_ID(id))
+	{
+		id = myLayoutIDKeeper.FetchFreeID();
+		if (BAD_ID(id))
+		{
+			return id;
+		}
+		if (auto it = myLayoutLookup.find(hash); it != myLayoutLookup.end())
+		{
+			myLayouts[int(it->second)] = {};
+			myLayoutIDKeeper.ReturnID(it->second);
+		}
+		myLayoutLookup[hash] = id;
+	}
+	layout.lastUsedFrame = myFrame;
+	myLayouts[int(id)] = std::move(layout);
+	return id;
+}
+
+void
+TextLayoutCache::Update()
+{
+	std::scoped_lock lock(myMutex);
+	++myFrame;
+
+	// commands referencing a layout are at most a few frames old
+	std::erase_if(myLayoutLookup, [this](const auto& entry)
+	{
+		auto& layout = myLayouts[int(entry.second)];
+		if (layout.lastUsedFrame + TextLayoutLifetime >= myFrame)
+		{
+			return false;
+		}
+		layout = {};
+		myLayoutIDKeeper.ReturnID(entry.second);
+		return true;
+	});
+}
+
+uint32_t
+TextLayoutCache::GetNumLayouts() const
+{
+	std::scoped_lock lock(myMutex);
+	return uint32_t(myLayoutLookup.size());
+}
+
+void
+TextLayoutCache::Build(
+	TextLayout& layout)
+{
+	theirFontHandler.PrepareGlyphs(layout.fontID, layout.text.c_str(), layout.pixelSize);
+
+	// in units of the text scale, x is corrected for aspect when expanded
+	Vec2f pen = {0, 0};
+	uint32_t prevGlyphIndex = 0;
+	const char* cursor = layout.text.c_str();
+	while (const uint32_t codepoint = DecodeUTF8(cursor))
+	{
+		if (codepoint == '\n')
+		{
+			pen.x = 0;
+			pen.y += 1.f;
+			prevGlyphIndex = 0;
+			continue;
+		}
+
+		const Glyph glyph = theirFontHandler.GetGlyph(layout.fontID, codepoint, layout.pixelSize);
+		pen.x += theirFontHandler.GetKerning(layout.fontID, prevGlyphIndex, glyph.glyphIndex, layout.pixelSize);
+		prevGlyphIndex = glyph.glyphIndex;
+
+		if (!BAD_ID(glyph.imageID))
+		{
+			TextQuad quad;
+			quad.imageID = glyph.imageID;
+			quad.uvRect = glyph.uvRect;
+			quad.offset = {pen.x + glyph.bearing.x, pen.y + glyph.size.y - glyph.bearing.y};
+			quad.size = glyph.size;
+			quad.signedDistance = glyph.signedDistance;
+			layout.quads.emplace_back(quad);
+			layout.pageMask |= 1u << glyph.pageIndex;
+		}
+
+		pen.x += glyph.advance;
+	}
+}
+
+uint64_t
+TextLayoutCache::LayoutHash(
+	FontID				fontID,
+	std::string_view	text,
+	uint32_t			pixelSize)
+{
+	const uint64_t textHash = std::hash<std::string_view>{}(text);
+	return textHash ^ (uint64_t(fontID) << 48 | uint64_t(pixelSize) << 32);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+struct TextQuad
+{
+	ImageID		imageID = ImageID(INVALID_ID);
+	Vec4f		uvRect = {};
+	Vec2f		offset = {};
+	Vec2f		size = {};
+	bool		signedDistance = false;
+};
+
+struct TextLayout
+{
+	FontID					fontID = FontID(INVALID_ID);
+	uint32_t				pixelSize = 0;
+	uint64_t				hash = 0;
+	uint64_t				glyphGeneration = 0;
+	uint64_t				lastUsedFrame = 0;
+	uint32_t				pageMask = 0;
+	std::string				text;
+	std::vector<TextQuad>	quads;
+};
+static_assert(MaxNumGlyphPages <= 32, "layout page masks are 32 bit");
+
+class TextLayoutCache
+{
+public:
+										TextLayoutCache(class FontHandler& fontHandler);
+
+	TextLayoutID						GetLayout(
+											FontID		fontID,
+											const char*	text,
+											uint32_t	pixelSize);
+	void								Update();
+
+	template<typename Func>
+	void								ForEachQuad(
+											TextLayoutID	id,
+											Func&&			func);
+
+	_nodiscard uint32_t					GetNumLayouts() const;
+
+private:
+	void								Build(TextLayout& layout);
+	static uint64_t						LayoutHash(
+											FontID				fontID,
+											std::string_view	text,
+											uint32_t			pixelSize);
+
+	FontHandler&						theirFontHandler;
+
+	mutable std::mutex					myMutex;
+	std::unordered_map<uint64_t, TextLayoutID>
+										myLayoutLookup;
+	std::vector<TextLayout>				myLayouts;
+	IDKeeper<TextLayoutID>				myLayoutIDKeeper;
+
+	uint64_t							myFrame = 0;
+
+};
+
+template<typename Func>
+inline void
+TextLayoutCache::ForEachQuad(
+	TextLayoutID	id,
+	Func&&			func)
+{
+	if (BAD_ID(id))
+	{
+		return;
+	}
+	std::scoped_lock lock(myMutex);
+	for (const auto& quad : myLayouts[int(id)].quads)
+	{
+		func(quad);
+	}
+}
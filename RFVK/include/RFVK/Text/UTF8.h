@@ -0,0 +1,63 @@
+#pragma once
+
+constexpr uint32_t ReplacementCodepoint = 0xFFFD;
+
+// Decodes one codepoint and advances the cursor, returns 0 at the terminator
+inline uint32_t
+DecodeUTF8(
+	const char*& cursor)
+{
+	const uint8_t lead = uint8_t(*cursor);
+	if (lead == 0)
+	{
+		return 0;
+	}
+	++cursor;
+	if (lead < 0x80)
+	{
+		return lead;
+	}
+
+	uint32_t numTrailing;
+	uint32_t codepoint;
+	if ((lead & 0xE0) == 0xC0)
+	{
+		numTrailing = 1;
+		codepoint = lead & 0x1F;
+	}
+	else if ((lead & 0xF0) == 0xE0)
+	{
+		numTrailing = 2;
+		codepoint = lead & 0x0F;
+	}
+	else if ((lead & 0xF8) == 0xF0)
+	{
+		numTrailing = 3;
+		codepoint = lead & 0x07;
+	}
+	else
+	{
+		return ReplacementCodepoint;
+	}
+
+	for (uint32_t i = 0; i < numTrailing; ++i)
+	{
+		const uint8_t trail = uint8_t(*cursor);
+		if ((trail & 0xC0) != 0x80)
+		{
+			return ReplacementCodepoint;
+		}
+		codepoint = (codepoint << 6) | (trail & 0x3F);
+		++cursor;
+	}
+
+	// overlong forms would let e.g. a second encoding of '/' or '\0' past validation
+	constexpr uint32_t minCodepoints[] = {0, 0x80, 0x800, 0x10000};
+	if (codepoint < minCodepoints[numTrailing]
+		|| codepoint > 0x10FFFF
+		|| (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+	{
+		return ReplacementCodepoint;
+	}
+	return codepoint;
+}
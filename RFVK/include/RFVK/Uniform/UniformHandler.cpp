@@ -2,6 +2,7 @@
 #include "UniformHandler.h"
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Memory/BufferAllocator.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 
 UniformHandler::UniformHandler(
 	VulkanFramework&		vulkanFramework,
@@ -9,25 +10,25 @@ UniformHandler::UniformHandler(
 	QueueFamilyIndices		familyIndices)
 	: theirVulkanFramework(vulkanFramework)
 	, theirBufferAllocator(bufferAllocator)
+	, myFreeIDs(MaxNumUniforms)
 {
 	myOwners = {
 		familyIndices[QUEUE_FAMILY_TRANSFER],
 		familyIndices[QUEUE_FAMILY_GRAPHICS],
 		familyIndices[QUEUE_FAMILY_COMPUTE],
 	};
-
-	for (uint32_t i = 0; i < MaxNumUniforms; ++i)
-	{
-		myFreeIDs.push(UniformID(i));
-	}
 }
 
 UniformHandler::~UniformHandler()
 {
-	for (auto& [buffer, layout] : myUniformLayouts)
+	for (auto& layout : myUniformLayouts)
 	{
-		vkDestroyDescriptorSetLayout(theirVulkanFramework.GetDevice(), layout, nullptr);
+		if (layout)
+		{
+			vkDestroyDescriptorSetLayout(theirVulkanFramework.GetDevice(), layout, nullptr);
+		}
 	}
+	vkDestroyDescriptorSetLayout(theirVulkanFramework.GetDevice(), myDynamicLayout, nullptr);
 
 	vkDestroyDescriptorPool(theirVulkanFramework.GetDevice(), myDescriptorPool, nullptr);
 }
@@ -40,18 +41,106 @@ UniformHandler::Init()
 	info.pNext = nullptr;
 	info.flags = NULL;
 
-	VkDescriptorPoolSize size;
-	size.descriptorCount = 128;
-	size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	VkDescriptorPoolSize sizes[2];
+	sizes[0].descriptorCount = MaxNumUniforms;
+	sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	sizes[1].descriptorCount = 1;
+	sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 
-	info.pPoolSizes = &size;
-	info.poolSizeCount = 1;
-	info.maxSets = 128;
+	info.pPoolSizes = sizes;
+	info.poolSizeCount = _ARRAYSIZE(sizes);
+	info.maxSets = MaxNumUniforms + 1;
 
 	auto resultPool = vkCreateDescriptorPool(theirVulkanFramework.GetDevice(), &info, nullptr, &myDescriptorPool);
 	VK_FALLTHROUGH(resultPool);
+	if (resultPool)
+	{
+		return resultPool;
+	}
+
+	return InitDynamicUniforms();
+}
+
+VkResult
+UniformHandler::InitDynamicUniforms()
+{
+	VkPhysicalDeviceProperties props;
+	vkGetPhysicalDeviceProperties(theirVulkanFramework.GetPhysicalDevice(), &props);
+	myDynamicAlignment = uint32_t(props.limits.minUniformBufferOffsetAlignment);
+	myDynamicRange = std::min(uint32_t(MaxDynamicUniformRange), props.limits.maxUniformBufferRange);
+
+	// BUFFER
+	// every offset in a frame may be bound with the full range, so the tail leaves room for the last one
+	const size_t bufferSize = size_t(MaxDynamicUniformBytesPerFrame) * NumSwapchainImages + myDynamicRange;
+	auto [resultBuffer, buffer, data] = theirBufferAllocator.RequestMappedBuffer(
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		bufferSize,
+		myOwners);
+	if (resultBuffer)
+	{
+		LOG("failed to get dynamic uniform buffer");
+		return resultBuffer;
+	}
+	myDynamicBuffer = buffer;
+	myDynamicData = static_cast<uint8_t*>(data);
+
+	// LAYOUT
+	VkDescriptorSetLayoutBinding binding = {};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	binding.descriptorCount = 1;
+	binding.pImmutableSamplers = nullptr;
+	binding.stageFlags =
+		VK_SHADER_STAGE_FRAGMENT_BIT |
+		VK_SHADER_STAGE_VERTEX_BIT |
+		VK_SHADER_STAGE_COMPUTE_BIT |
+		VK_SHADER_STAGE_CLOSEST_HIT_BIT_NV |
+		VK_SHADER_STAGE_ANY_HIT_BIT_NV |
+		VK_SHADER_STAGE_RAYGEN_BIT_NV |
+		VK_SHADER_STAGE_MISS_BIT_NV;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
 
+	auto resultLayout = vkCreateDescriptorSetLayout(theirVulkanFramework.GetDevice(), &layoutInfo, nullptr, &myDynamicLayout);
+	if (resultLayout)
+	{
+		LOG("failed to create dynamic uniform layout");
+		return resultLayout;
+	}
 
+	// SET
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = myDescriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &myDynamicLayout;
+
+	auto resultSet = vkAllocateDescriptorSets(theirVulkanFramework.GetDevice(), &allocInfo, &myDynamicSet);
+	if (resultSet)
+	{
+		LOG("failed to create dynamic uniform set");
+		return resultSet;
+	}
+
+	// UPDATE DESCRIPTOR
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = myDynamicBuffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = myDynamicRange;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	write.dstBinding = 0;
+	write.dstArrayElement = 0;
+	write.dstSet = myDynamicSet;
+	write.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &write, 0, nullptr);
 
 	return VK_SUCCESS;
 }
@@ -61,6 +150,13 @@ UniformHandler::RequestUniformBuffer(
 	const void* startData,
 	size_t		size)
 {
+	const UniformID id = myFreeIDs.FetchFreeID();
+	if (BAD_ID(id))
+	{
+		LOG("no more free uniform slots");
+		return UniformID(INVALID_ID);
+	}
+
 	// BUFFER
 	auto allocSub = theirBufferAllocator.Start();
 	auto [resultUB, buffer] = theirBufferAllocator.RequestUniformBuffer(
@@ -74,6 +170,7 @@ UniformHandler::RequestUniformBuffer(
 	if (resultUB)
 	{
 		LOG("failed to get uniform buffer");
+		myFreeIDs.ReturnID(id);
 		return UniformID(INVALID_ID);
 	}
 
@@ -105,6 +202,7 @@ UniformHandler::RequestUniformBuffer(
 	if (resultLayout)
 	{
 		LOG("failed to create desc set layout");
+		myFreeIDs.ReturnID(id);
 		return UniformID(INVALID_ID);
 	}
 
@@ -122,11 +220,13 @@ UniformHandler::RequestUniformBuffer(
 	if (resultSet)
 	{
 		LOG("failed to create set");
+		vkDestroyDescriptorSetLayout(theirVulkanFramework.GetDevice(), layout, nullptr);
+		myFreeIDs.ReturnID(id);
 		return UniformID(INVALID_ID);
 	}
 
-	myUniformSets[buffer] = set;
-	myUniformLayouts[buffer] = layout;
+	myUniformSets[int(id)] = set;
+	myUniformLayouts[int(id)] = layout;
 	
 	// UPDATE DESCRIPTOR
 	VkDescriptorBufferInfo bufferInfo{};
@@ -147,9 +247,6 @@ UniformHandler::RequestUniformBuffer(
 
 	vkUpdateDescriptorSets(theirVulkanFramework.GetDevice(), 1, &write, 0, nullptr);
 
-	UniformID id;
-	bool success = myFreeIDs.try_pop(id);
-	assert(success && "failed attaining id");
 	myUniforms[int(id)] = buffer;
 	return id;
 }
@@ -178,23 +275,65 @@ std::tuple<VkDescriptorSetLayout, VkDescriptorSet>
 	{
 		return {nullptr, nullptr};
 	}
-	return {myUniformLayouts[myUniforms[int(id)]], myUniformSets[myUniforms[int(id)]]};
+	return {myUniformLayouts[int(id)], myUniformSets[int(id)]};
 }
 
 void
 UniformHandler::BindUniform(
 	UniformID			id,
-	VkCommandBuffer		cmdBuffer,
+	CommandRecorder&	recorder,
+	VkPipelineLayout	layout,
+	uint32_t			setSlot,
+	VkPipelineBindPoint bindPoint)
+{
+	recorder.BindDescriptorSet(bindPoint, layout, setSlot, myUniformSets[int(id)]);
+}
+
+std::tuple<void*, uint32_t>
+UniformHandler::AllocateDynamicUniform(
+	uint32_t	swapchainIndex,
+	size_t		size)
+{
+	if (size > myDynamicRange)
+	{
+		LOG("dynamic uniform of", size, "bytes exceeds the bindable range of", myDynamicRange);
+		return {nullptr, 0};
+	}
+
+	const uint32_t alignedSize = (uint32_t(size) + myDynamicAlignment - 1) / myDynamicAlignment * myDynamicAlignment;
+	const uint32_t offset = myDynamicOffsets[swapchainIndex].fetch_add(alignedSize);
+	if (offset + alignedSize > MaxDynamicUniformBytesPerFrame)
+	{
+		LOG("out of dynamic uniform space this frame");
+		return {nullptr, 0};
+	}
+
+	const uint32_t dynamicOffset = swapchainIndex * MaxDynamicUniformBytesPerFrame + offset;
+	return {myDynamicData + dynamicOffset, dynamicOffset};
+}
+
+void
+UniformHandler::ResetDynamicUniforms(
+	uint32_t	swapchainIndex,
+	VkFence		frameDoneFence)
+{
+	vkWaitForFences(theirVulkanFramework.GetDevice(), 1, &frameDoneFence, VK_TRUE, UINT64_MAX);
+	myDynamicOffsets[swapchainIndex] = 0;
+}
+
+VkDescriptorSetLayout
+UniformHandler::GetDynamicUniformLayout() const
+{
+	return myDynamicLayout;
+}
+
+void
+UniformHandler::BindDynamicUniform(
+	uint32_t			dynamicOffset,
+	CommandRecorder&	recorder,
 	VkPipelineLayout	layout,
 	uint32_t			setSlot,
 	VkPipelineBindPoint bindPoint)
 {
-	vkCmdBindDescriptorSets(cmdBuffer,
-							bindPoint,
-							layout,
-							setSlot,
-							1,
-							&myUniformSets[myUniforms[int(id)]],
-							0,
-							nullptr);
+	recorder.BindDescriptorSet(bindPoint, layout, setSlot, myDynamicSet, dynamicOffset);
 }
@@ -24,26 +24,52 @@ public:
 
 	void										BindUniform(
 													UniformID			id,
-													VkCommandBuffer		cmdBuffer,
+													class CommandRecorder&	recorder,
+													VkPipelineLayout	layout,
+													uint32_t			setSlot,
+													VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+	// DYNAMIC UNIFORMS
+	// small per-draw data, sub-allocated from one mapped buffer and bound with a dynamic offset
+	// returns where to write the data and the offset to bind it with, nullptr once the frame is full
+	std::tuple<void*, uint32_t>					AllocateDynamicUniform(
+													uint32_t	swapchainIndex,
+													size_t		size);
+	// waits out the last frame that read the swapchain index before its space is handed out again
+	void										ResetDynamicUniforms(
+													uint32_t	swapchainIndex,
+													VkFence		frameDoneFence);
+	_nodiscard VkDescriptorSetLayout			GetDynamicUniformLayout() const;
+	void										BindDynamicUniform(
+													uint32_t			dynamicOffset,
+													class CommandRecorder&	recorder,
 													VkPipelineLayout	layout,
 													uint32_t			setSlot,
 													VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
 
 private:
+	VkResult									InitDynamicUniforms();
+
 	VulkanFramework&							theirVulkanFramework;
 	BufferAllocator&							theirBufferAllocator;
 
 	std::vector<QueueFamilyIndex>				myOwners;
 
 	std::array<VkBuffer, MaxNumUniforms>		myUniforms;
-	concurrency::concurrent_priority_queue<UniformID, std::greater<>>
-												myFreeIDs;
+	IDKeeper<UniformID>							myFreeIDs;
 
 	VkDescriptorPool							myDescriptorPool;
-	std::unordered_map<VkBuffer, VkDescriptorSetLayout>
-												myUniformLayouts;
-	std::unordered_map<VkBuffer, VkDescriptorSet>
-												myUniformSets;
+	std::array<VkDescriptorSetLayout, MaxNumUniforms>
+												myUniformLayouts = {};
+	std::array<VkDescriptorSet, MaxNumUniforms>	myUniformSets = {};
 
+	VkBuffer									myDynamicBuffer = nullptr;
+	uint8_t*									myDynamicData = nullptr;
+	uint32_t									myDynamicAlignment = 1;
+	uint32_t									myDynamicRange = MaxDynamicUniformRange;
+	std::array<std::atomic<uint32_t>, NumSwapchainImages>
+												myDynamicOffsets = {};
+	VkDescriptorSetLayout						myDynamicLayout = nullptr;
+	VkDescriptorSet								myDynamicSet = nullptr;
 
 };
\ No newline at end of file
@@ -2,11 +2,20 @@
 #include "VulkanFramework.h"
 #include "Ray Tracing/NVRayTracing.h"
 #include "Debug/DebugUtils.h"
+#include "Shader/ShaderCache.h"
+#include "Pipelines/PipelineReloader.h"
 #include <string>
 
+#ifndef _WIN32
+#include "neat/General/Platform.h"
+#include <X11/Xlib.h>
+#include "vulkan/vulkan_xlib.h"
+#endif
+
 #pragma comment (lib, "vulkan-1.lib")
 
 VulkanFramework::VulkanFramework()
+	: myShaderCache(std::make_unique<ShaderCache>())
 {
 	myClearColor.color = {.1,.1,.133,1};
 	myDepthClearColor.depthStencil = {1.f,0};
@@ -24,6 +33,17 @@ VulkanFramework::~VulkanFramework()
 	{
 		vkDestroyImageView(myDevice, imageView, nullptr);
 	}
+	if (myIsHeadless)
+	{
+		for (auto& image : mySwapchainImages)
+		{
+			vkDestroyImage(myDevice, image, nullptr);
+		}
+		for (auto& memory : myOffscreenMemory)
+		{
+			vkFreeMemory(myDevice, memory, nullptr);
+		}
+	}
 	vkDestroySwapchainKHR(myDevice, mySwapchain, nullptr);
 	vkDestroySurfaceKHR(myInstance, mySurface, nullptr);
 
@@ -49,6 +69,9 @@ VulkanFramework::~VulkanFramework()
 	}
 
 	vkDeviceWaitIdle(myDevice);
+	myPipelineReloader.reset();
+	SavePipelineCache();
+	vkDestroyPipelineCache(myDevice, myPipelineCache, nullptr);
 	vkDestroyDevice(myDevice, nullptr);
 	vkDestroyInstance(myInstance, nullptr);
 }
@@ -61,8 +84,13 @@ VulkanFramework::Init(
 	bool			useDebugLayers)
 {
 	myMainThread = threadID;
+	myIsHeadless = !hWND;
 	
 	LOG("Debug Layers", useDebugLayers ? "ON" : "OFF");
+	if (myIsHeadless)
+	{
+		LOG("no window, rendering headless");
+	}
 	gUseDebugLayers = useDebugLayers;
 
 	VK_FALLTHROUGH(InitInstance());
@@ -70,9 +98,18 @@ VulkanFramework::Init(
 	VK_FALLTHROUGH(EnumeratePhysDevices());
 	VK_FALLTHROUGH(EnumerateQueueFamilies());
 	VK_FALLTHROUGH(InitDevice());
+	VK_FALLTHROUGH(InitPipelineCache());
+	myPipelineReloader = std::make_unique<PipelineReloader>(*this);
 	VK_FALLTHROUGH(InitCmdPoolAndBuffer());
-	VK_FALLTHROUGH(InitSurface(hWND));
-	VK_FALLTHROUGH(InitSwapchain(windowRes));
+	if (myIsHeadless)
+	{
+		VK_FALLTHROUGH(InitOffscreenTargets(windowRes));
+	}
+	else
+	{
+		VK_FALLTHROUGH(InitSurface(hWND));
+		VK_FALLTHROUGH(InitSwapchain(windowRes));
+	}
 	VK_FALLTHROUGH(InitSwapchainImageViews());
 	VK_FALLTHROUGH(InitRenderPasses());
 	VK_FALLTHROUGH(InitViewport(windowRes));
@@ -190,7 +227,7 @@ VulkanFramework::CreatePipeline(
 
 	VkPipeline pipeline;
 	auto resultPipeline = vkCreateGraphicsPipelines(myDevice,
-													 VK_NULL_HANDLE,
+													 myPipelineCache,
 													 1,
 													 &pipelineCreateInfoCompl,
 													 nullptr,
@@ -212,6 +249,109 @@ VulkanFramework::GetDevice()
 	return myDevice;
 }
 
+VkPipelineCache
+VulkanFramework::GetPipelineCache()
+{
+	return myPipelineCache;
+}
+
+ShaderCache&
+VulkanFramework::GetShaderCache()
+{
+	return *myShaderCache;
+}
+
+PipelineReloader&
+VulkanFramework::GetPipelineReloader()
+{
+	return *myPipelineReloader;
+}
+
+bool
+VulkanFramework::IsBindless() const
+{
+	return myIsBindless;
+}
+
+bool
+VulkanFramework::IsDynamicRendering() const
+{
+	return myIsDynamicRendering;
+}
+
+bool
+VulkanFramework::IsHostQueryReset() const
+{
+	return myIsHostQueryReset;
+}
+
+bool
+VulkanFramework::IsCalibratedTimestamps() const
+{
+	return myIsCalibratedTimestamps;
+}
+
+float
+VulkanFramework::GetTimestampPeriod() const
+{
+	return myPhysicalDeviceProperties[myChosenPhysicalDevice].limits.timestampPeriod;
+}
+
+uint32_t
+VulkanFramework::GetTimestampValidBits(
+	QueueFamilyIndex index) const
+{
+	return index < myQueueFamilyProps.size() ? myQueueFamilyProps[index].timestampValidBits : 0;
+}
+
+bool
+VulkanFramework::IsHeadless() const
+{
+	return myIsHeadless;
+}
+
+VkResult
+VulkanFramework::SavePipelineCache()
+{
+	if (!myPipelineCache)
+	{
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	size_t numBytes = 0;
+	auto result = vkGetPipelineCacheData(myDevice, myPipelineCache, &numBytes, nullptr);
+	std::vector<char> cacheData(numBytes);
+	if (!result)
+	{
+		result = vkGetPipelineCacheData(myDevice, myPipelineCache, &numBytes, cacheData.data());
+	}
+	if (result)
+	{
+		LOG("failed reading pipeline cache data");
+		return result;
+	}
+
+	// write next to the old cache and swap, a crash mid write leaves the old one intact
+	const std::string tempPath = std::string(PipelineCachePath) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.good())
+		{
+			LOG("failed writing pipeline cache, \"", tempPath, "\"");
+			return VK_ERROR_INITIALIZATION_FAILED;
+		}
+		file.write(cacheData.data(), std::streamsize(numBytes));
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, PipelineCachePath, error);
+	if (error)
+	{
+		LOG("failed replacing pipeline cache,", error.message());
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+	return VK_SUCCESS;
+}
+
 VkPhysicalDevice
 VulkanFramework::GetPhysicalDevice()
 {
@@ -245,9 +385,25 @@ VulkanFramework::BeginBackBufferRenderPass(
 }
 
 int
-VulkanFramework::AcquireNextSwapchainImage(VkSemaphore signalSemaphore)
+VulkanFramework::AcquireNextSwapchainImage(
+	VkSemaphore signalSemaphore,
+	VkQueue		signalQueue)
 {
-	vkAcquireNextImageKHR(myDevice, mySwapchain, UINT64_MAX, signalSemaphore, nullptr, &myCurrentSwapchainIndex);
+	if (!myIsHeadless)
+	{
+		vkAcquireNextImageKHR(myDevice, mySwapchain, UINT64_MAX, signalSemaphore, nullptr, &myCurrentSwapchainIndex);
+		return myCurrentSwapchainIndex;
+	}
+
+	// the ring is reused in order, the frame fences already keep an image from being overwritten in flight
+	myCurrentSwapchainIndex = (myCurrentSwapchainIndex + 1) % NumSwapchainImages;
+
+	VkSubmitInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	info.signalSemaphoreCount = 1;
+	info.pSignalSemaphores = &signalSemaphore;
+	vkQueueSubmit(signalQueue, 1, &info, nullptr);
+
 	return myCurrentSwapchainIndex;
 }
 
@@ -256,6 +412,19 @@ VulkanFramework::Present(
 	VkSemaphore waitSemaphore, 
 	VkQueue		presentationQueue)
 {
+	if (myIsHeadless)
+	{
+		// nothing to present, consume the frame done signal so the semaphore can be reused
+		const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &waitSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		vkQueueSubmit(presentationQueue, 1, &submitInfo, nullptr);
+		return;
+	}
+
 	VkPresentInfoKHR info{};
 	info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	info.pNext = nullptr;
@@ -293,7 +462,15 @@ std::array<VkImageView, NumSwapchainImages>
 VulkanFramework::GetSwapchainImageViews() const
 {
 	std::array<VkImageView, NumSwapchainImages> ret;
-	memcpy(ret.data(), mySwapchainImageViews.data(), NumSwapchainImages * sizeof VkImageView);
+	memcpy(ret.data(), mySwapchainImageViews.data(), NumSwapchainImages * sizeof(VkImageView));
+	return ret;
+}
+
+std::array<VkImage, NumSwapchainImages>
+VulkanFramework::GetSwapchainImages() const
+{
+	std::array<VkImage, NumSwapchainImages> ret;
+	memcpy(ret.data(), mySwapchainImages.data(), NumSwapchainImages * sizeof(VkImage));
 	return ret;
 }
 
@@ -320,12 +497,19 @@ VulkanFramework::InitInstance()
 	// INSTANCE INFO
 
 	// EXTENSIONS
-	const char* extensionNames[] =
+	std::vector<const char*> extensionNames =
 	{
-		VK_KHR_SURFACE_EXTENSION_NAME,
-		VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
 		VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
 	};
+	if (!myIsHeadless)
+	{
+		extensionNames.emplace_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#ifdef _WIN32
+		extensionNames.emplace_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#else
+		extensionNames.emplace_back(VK_KHR_XLIB_SURFACE_EXTENSION_NAME);
+#endif
+	}
 
 	VkInstanceCreateInfo instanceInfo{};
 	// INSTANCE LAYERS
@@ -350,8 +534,8 @@ VulkanFramework::InitInstance()
 	instanceInfo.pApplicationInfo = &appInfo;
 
 
-	instanceInfo.enabledExtensionCount = ARRAYSIZE(extensionNames);
-	instanceInfo.ppEnabledExtensionNames = extensionNames;
+	instanceInfo.enabledExtensionCount = static_cast<uint32_t>(extensionNames.size());
+	instanceInfo.ppEnabledExtensionNames = extensionNames.data();
 
 	// CREATE INSTANCE
 	auto resultInstance = vkCreateInstance(&instanceInfo, nullptr, &myInstance);
@@ -457,6 +641,12 @@ VulkanFramework::EnumeratePhysDevices()
 			break;
 		}
 	}
+	if (myChosenPhysicalDevice == UINT_MAX && myIsHeadless && gpuCount)
+	{
+		// servers and CI often only have a software implementation such as lavapipe
+		myChosenPhysicalDevice = 0;
+		LOG("no dedicated GPU found, falling back to", myPhysicalDeviceProperties[0].deviceName);
+	}
 	if (myChosenPhysicalDevice == UINT_MAX)
 	{
 		LOG("no dedicated GPU found");
@@ -558,9 +748,8 @@ VulkanFramework::InitDevice()
 
 
 	// DEVICE EXTENSIONS
-	const char* extensionNames[] =
+	std::vector<const char*> extensionNames =
 	{
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 		VK_KHR_MAINTENANCE3_EXTENSION_NAME,
 		VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME,
 		VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
@@ -568,8 +757,54 @@ VulkanFramework::InitDevice()
 		VK_KHR_RAY_QUERY_EXTENSION_NAME,
 		VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
 		VK_EXT_ROBUSTNESS_2_EXTENSION_NAME,
+		VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
 		
 	};
+	if (!myIsHeadless)
+	{
+		extensionNames.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
+
+	uint32_t availableCount = 0;
+	vkEnumerateDeviceExtensionProperties(myPhysicalDevices[myChosenPhysicalDevice], nullptr, &availableCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(availableCount);
+	vkEnumerateDeviceExtensionProperties(myPhysicalDevices[myChosenPhysicalDevice], nullptr, &availableCount, availableExtensions.data());
+	for (auto& extensionName : extensionNames)
+	{
+		const bool isAvailable = std::any_of(availableExtensions.begin(), availableExtensions.end(), [extensionName](const VkExtensionProperties& props)
+		{
+			return !strcmp(props.extensionName, extensionName);
+		});
+		if (!isAvailable)
+		{
+			LOG("device lacks required extension", extensionName);
+		}
+	}
+
+	// OPTIONAL EXTENSIONS
+	const bool hasCalibratedTimestamps = std::any_of(availableExtensions.begin(), availableExtensions.end(), [](const VkExtensionProperties& props)
+	{
+		return !strcmp(props.extensionName, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	});
+	auto getTimeDomains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)vkGetInstanceProcAddr(myInstance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+	if (hasCalibratedTimestamps && getTimeDomains)
+	{
+		uint32_t numTimeDomains = 0;
+		getTimeDomains(myPhysicalDevices[myChosenPhysicalDevice], &numTimeDomains, nullptr);
+		std::vector<VkTimeDomainEXT> timeDomains(numTimeDomains);
+		getTimeDomains(myPhysicalDevices[myChosenPhysicalDevice], &numTimeDomains, timeDomains.data());
+		myIsCalibratedTimestamps =
+			std::find(timeDomains.begin(), timeDomains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != timeDomains.end() &&
+			std::find(timeDomains.begin(), timeDomains.end(), HostTimeDomain) != timeDomains.end();
+	}
+	if (myIsCalibratedTimestamps)
+	{
+		extensionNames.emplace_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	}
+	else
+	{
+		LOG("calibrated timestamps unsupported, the gpu profiler estimates its clock offset");
+	}
 
 	//vkGetDeviceProcAddr(myDevice, "vkCreateAccelerationStructureNV");
 
@@ -580,8 +815,8 @@ VulkanFramework::InitDevice()
 	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
 	deviceInfo.pQueueCreateInfos = queueInfos.data();
-	deviceInfo.enabledExtensionCount = ARRAYSIZE(extensionNames);
-	deviceInfo.ppEnabledExtensionNames = extensionNames;
+	deviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensionNames.size());
+	deviceInfo.ppEnabledExtensionNames = extensionNames.data();
 	deviceInfo.enabledLayerCount = 0;
 	deviceInfo.ppEnabledLayerNames = nullptr;
 
@@ -599,14 +834,45 @@ VulkanFramework::InitDevice()
 	//meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
 	VkPhysicalDeviceRobustness2FeaturesEXT robustnessFeatures = {};
 	robustnessFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ROBUSTNESS_2_FEATURES_EXT;
+	VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {};
+	descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures = {};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+	VkPhysicalDeviceHostQueryResetFeatures hostQueryResetFeatures = {};
+	hostQueryResetFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES;
 	
 	features.pNext = &featuresBufferAddress;
 	featuresBufferAddress.pNext = &rayPipeFeatures;
 	rayPipeFeatures.pNext = &rayQueryFeatures;
 	rayQueryFeatures.pNext = &accelerationStructureFeatures;
 	accelerationStructureFeatures.pNext = &robustnessFeatures;
+	robustnessFeatures.pNext = &descriptorIndexingFeatures;
+	descriptorIndexingFeatures.pNext = &dynamicRenderingFeatures;
+	dynamicRenderingFeatures.pNext = &hostQueryResetFeatures;
 	vkGetPhysicalDeviceFeatures2(myPhysicalDevices[myChosenPhysicalDevice], &features);
 
+	myIsBindless =
+		descriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+		descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+		descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+		descriptorIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind &&
+		descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+		descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount;
+	if (!myIsBindless)
+	{
+		LOG("descriptor indexing unsupported, falling back to per frame descriptor sets");
+	}
+	myIsDynamicRendering = dynamicRenderingFeatures.dynamicRendering;
+	if (!myIsDynamicRendering)
+	{
+		LOG("dynamic rendering unsupported, falling back to render pass objects");
+	}
+	myIsHostQueryReset = hostQueryResetFeatures.hostQueryReset;
+	if (!myIsHostQueryReset)
+	{
+		LOG("host query reset unsupported, gpu profiling disabled");
+	}
+
 	deviceInfo.pNext = &features;
 
 	// CREATE DEVICE
@@ -649,6 +915,7 @@ VkResult
 VulkanFramework::InitSurface(
 	void* hWND)
 {
+#ifdef _WIN32
 	const HMODULE hModule = GetModuleHandle(nullptr);
 
 	VkWin32SurfaceCreateInfoKHR surfaceInfo;
@@ -662,6 +929,18 @@ VulkanFramework::InitSurface(
 
 	auto resultSurface = vkCreateWin32SurfaceKHR(myInstance, &surfaceInfo, nullptr, &mySurface);
 	VK_FALLTHROUGH(resultSurface);
+#else
+	// neat windows hand out their display connection and xlib window as the handle
+	const auto* nativeWindow = static_cast<const neat::NativeWindow*>(hWND);
+
+	VkXlibSurfaceCreateInfoKHR surfaceInfo{};
+	surfaceInfo.sType = VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR;
+	surfaceInfo.dpy = static_cast<Display*>(nativeWindow->display);
+	surfaceInfo.window = nativeWindow->window;
+
+	auto resultSurface = vkCreateXlibSurfaceKHR(myInstance, &surfaceInfo, nullptr, &mySurface);
+	VK_FALLTHROUGH(resultSurface);
+#endif
 
 	for (auto& index : myQueueFlagsIndices[VK_QUEUE_GRAPHICS_BIT])
 	{
@@ -757,21 +1036,94 @@ VulkanFramework::InitSwapchain(
 }
 
 VkResult
-VulkanFramework::InitSwapchainImageViews()
+VulkanFramework::InitOffscreenTargets(
+	const Vec2ui& windowRes)
 {
-	std::vector<VkSurfaceFormatKHR> formats;
-	uint32_t count = 0;
-	vkGetPhysicalDeviceSurfaceFormatsKHR(myPhysicalDevices[myChosenPhysicalDevice], mySurface, &count, nullptr);
-	formats.resize(count);
-	vkGetPhysicalDeviceSurfaceFormatsKHR(myPhysicalDevices[myChosenPhysicalDevice], mySurface, &count, formats.data());
+	// matches PixelValue so frames read back without swizzling
+	const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
 
-	uint32_t imageCount;
-	std::vector<VkImage> swapChainImages;
-	vkGetSwapchainImagesKHR(myDevice, mySwapchain, &imageCount, nullptr);
-	swapChainImages.resize(imageCount);
-	vkGetSwapchainImagesKHR(myDevice, mySwapchain, &imageCount, swapChainImages.data());
+	for (uint32_t i = 0; i < NumSwapchainImages; ++i)
+	{
+		// IMAGE
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = format;
+		imageInfo.extent = {windowRes.x, windowRes.y, 1};
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		VkImage image = nullptr;
+		VK_FALLTHROUGH(vkCreateImage(myDevice, &imageInfo, nullptr, &image));
+		mySwapchainImages.emplace_back(image);
+
+		// MEM ALLOC
+		VkMemoryRequirements memReq{};
+		vkGetImageMemoryRequirements(myDevice, image, &memReq);
+
+		int chosenIndex = -1;
+		for (int typeIndex = 0; typeIndex < myPhysicalDeviceMemProperties.memoryTypeCount; ++typeIndex)
+		{
+			const bool isDeviceLocal = myPhysicalDeviceMemProperties.memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			if ((1 << typeIndex) & memReq.memoryTypeBits && (isDeviceLocal || chosenIndex == -1))
+			{
+				chosenIndex = typeIndex;
+				if (isDeviceLocal)
+				{
+					break;
+				}
+			}
+		}
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memReq.size;
+		allocInfo.memoryTypeIndex = chosenIndex;
+
+		myOffscreenMemory.emplace_back();
+		VK_FALLTHROUGH(vkAllocateMemory(myDevice, &allocInfo, nullptr, &myOffscreenMemory.back()));
+		VK_FALLTHROUGH(vkBindImageMemory(myDevice, image, myOffscreenMemory.back(), 0));
+	}
+
+	// SWAPCHAIN ATTACHMENT DESC
+	mySwapchainAttachmentDesc = {};
+	mySwapchainAttachmentDesc.format = format;
+	mySwapchainAttachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT;
+
+	mySwapchainAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	mySwapchainAttachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+	mySwapchainAttachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	mySwapchainAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-	for (auto& image : swapChainImages)
+	mySwapchainAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	mySwapchainAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+	return VK_SUCCESS;
+}
+
+VkResult
+VulkanFramework::InitSwapchainImageViews()
+{
+	if (!myIsHeadless)
+	{
+		uint32_t imageCount;
+		std::vector<VkImage> swapChainImages;
+		vkGetSwapchainImagesKHR(myDevice, mySwapchain, &imageCount, nullptr);
+		swapChainImages.resize(imageCount);
+		vkGetSwapchainImagesKHR(myDevice, mySwapchain, &imageCount, swapChainImages.data());
+		for (auto& image : swapChainImages)
+		{
+			mySwapchainImages.emplace_back(image);
+		}
+	}
+
+	for (auto& image : mySwapchainImages)
 	{
 		VkImageViewCreateInfo viewInfo;
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -780,7 +1132,7 @@ VulkanFramework::InitSwapchainImageViews()
 		viewInfo.flags = NULL;
 		viewInfo.image = image;
 		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.format = formats[0].format;
+		viewInfo.format = mySwapchainAttachmentDesc.format;
 		viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
 		viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
 		viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -802,18 +1154,11 @@ VulkanFramework::InitSwapchainImageViews()
 VkResult
 VulkanFramework::InitRenderPasses()
 {
-	std::vector<VkSurfaceFormatKHR> formats;
-	uint32_t formatCount = 0;
-	vkGetPhysicalDeviceSurfaceFormatsKHR(myPhysicalDevices[myChosenPhysicalDevice], mySurface, &formatCount, nullptr);
-	formats.resize(formatCount);
-	vkGetPhysicalDeviceSurfaceFormatsKHR(myPhysicalDevices[myChosenPhysicalDevice], mySurface, &formatCount, formats.data());
-
-
 	// ATTACHMENTS
 
 	// COLOR
 	VkAttachmentDescription colorAttachment = {};
-	colorAttachment.format = formats[0].format;
+	colorAttachment.format = mySwapchainAttachmentDesc.format;
 	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 
 	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
@@ -823,7 +1168,7 @@ VulkanFramework::InitRenderPasses()
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachment.finalLayout = mySwapchainAttachmentDesc.finalLayout;
 
 	// DEPTH
 	VkAttachmentDescription depthAttachment = {};
@@ -988,6 +1333,66 @@ VulkanFramework::InitDepthImage(
 	return VK_SUCCESS;
 }
 
+VkResult
+VulkanFramework::InitPipelineCache()
+{
+	std::vector<char> cacheData;
+	std::ifstream file(PipelineCachePath, std::ios::binary | std::ios::ate);
+	if (file.good())
+	{
+		cacheData.resize(size_t(file.tellg()));
+		file.seekg(0);
+		file.read(cacheData.data(), std::streamsize(cacheData.size()));
+	}
+	if (!cacheData.empty() && !IsPipelineCacheCompatible(cacheData))
+	{
+		LOG("discarding pipeline cache, built for another device or driver");
+		cacheData.clear();
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo{};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = cacheData.size();
+	cacheInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+	auto result = vkCreatePipelineCache(myDevice, &cacheInfo, nullptr, &myPipelineCache);
+	if (result && !cacheData.empty())
+	{
+		LOG("driver rejected pipeline cache, starting empty");
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(myDevice, &cacheInfo, nullptr, &myPipelineCache);
+	}
+	if (result)
+	{
+		LOG("failed creating pipeline cache");
+		return result;
+	}
+
+	LOG("pipeline cache", cacheData.empty() ? "cold" : "warm", cacheData.size(), "bytes");
+	return VK_SUCCESS;
+}
+
+bool
+VulkanFramework::IsPipelineCacheCompatible(
+	const std::vector<char>& cacheData) const
+{
+	if (cacheData.size() < sizeof(PipelineCacheHeader))
+	{
+		return false;
+	}
+	PipelineCacheHeader header;
+	memcpy(&header, cacheData.data(), sizeof header);
+
+	// the cache uuid changes with the driver build
+	const auto& props = myPhysicalDeviceProperties[myChosenPhysicalDevice];
+	return header.headerSize >= sizeof(PipelineCacheHeader)
+		&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& header.vendorID == props.vendorID
+		&& header.deviceID == props.deviceID
+		&& !memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
 VkResult
 VulkanFramework::InitFramebuffers(
 	const Vec2ui& windowRes)
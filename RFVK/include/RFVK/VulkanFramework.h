@@ -1,12 +1,30 @@
 
 #pragma once
 
+// layout of the header every VkPipelineCache blob starts with
+struct PipelineCacheHeader
+{
+	uint32_t	headerSize;
+	uint32_t	headerVersion;
+	uint32_t	vendorID;
+	uint32_t	deviceID;
+	uint8_t		pipelineCacheUUID[VK_UUID_SIZE];
+};
+
 class VulkanFramework
 {
 public:
+	// the clock behind std::chrono::steady_clock and so neat::Profiler::Now
+#ifdef _WIN32
+	static constexpr VkTimeDomainEXT	HostTimeDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+	static constexpr VkTimeDomainEXT	HostTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
 										VulkanFramework();
 										~VulkanFramework();
 
+	// a null window renders headless into an offscreen image ring instead of a swapchain
 	VkResult							Init(
 											neat::ThreadID	threadID, 
 											void*			hWND,
@@ -23,13 +41,33 @@ public:
 											const VkPipelineLayoutCreateInfo&	layoutCreateInfo);
 
 	VkDevice							GetDevice();
+	VkPipelineCache						GetPipelineCache();
+	class ShaderCache&					GetShaderCache();
+	class PipelineReloader&				GetPipelineReloader();
+	VkResult							SavePipelineCache();
 	VkPhysicalDevice					GetPhysicalDevice();
 	VkPhysicalDeviceMemoryProperties	GetPhysicalDeviceMemProps();
+	// descriptor sets can be updated in place while bound, one set serves every frame in flight
+	bool								IsBindless() const;
+	// render passes record with vkCmdBeginRendering, pipelines are built without render pass objects
+	bool								IsDynamicRendering() const;
+	// queries can be reset from the host, the gpu profiler needs it
+	bool								IsHostQueryReset() const;
+	// nanoseconds per timestamp tick
+	float								GetTimestampPeriod() const;
+	// gpu timestamps can be sampled together with HostTimeDomain through VK_EXT_calibrated_timestamps
+	bool								IsCalibratedTimestamps() const;
+	// zero when the family does not support timestamps
+	uint32_t							GetTimestampValidBits(QueueFamilyIndex index) const;
+	// no surface, frames end in transfer src layout for readback instead of being presented
+	bool								IsHeadless() const;
 	void								BeginBackBufferRenderPass(
 											VkCommandBuffer buffer, 
 											uint32_t framebufferIndex);
 
-	int									AcquireNextSwapchainImage(VkSemaphore signalSemaphore);
+	int									AcquireNextSwapchainImage(
+											VkSemaphore signalSemaphore,
+											VkQueue		signalQueue);
 	void								Present(
 											VkSemaphore waitSemaphore, 
 											VkQueue		presentationQueue);
@@ -47,6 +85,8 @@ public:
 	VkAttachmentDescription				GetSwapchainAttachmentDesc() const;
 	std::array<VkImageView, NumSwapchainImages>
 										GetSwapchainImageViews() const;
+	std::array<VkImage, NumSwapchainImages>
+										GetSwapchainImages() const;
 	neat::ThreadID						GetMainThread() const;
 
 private:
@@ -55,9 +95,12 @@ private:
 	VkResult							EnumeratePhysDevices();
 	VkResult							EnumerateQueueFamilies();
 	VkResult							InitDevice();
+	VkResult							InitPipelineCache();
+	bool								IsPipelineCacheCompatible(const std::vector<char>& cacheData) const;
 	VkResult							InitCmdPoolAndBuffer();
 	VkResult							InitSurface(void* hWND);
 	VkResult							InitSwapchain(const Vec2ui& windowRes);
+	VkResult							InitOffscreenTargets(const Vec2ui& windowRes);
 	VkResult							InitSwapchainImageViews();
 
 	VkResult							InitRenderPasses();
@@ -79,15 +122,27 @@ private:
 	VkInstance							myInstance = nullptr;
 	VkDebugUtilsMessengerEXT			myDebugMessenger = nullptr;
 	VkDevice							myDevice = nullptr;
+	VkPipelineCache						myPipelineCache = nullptr;
+	std::unique_ptr<ShaderCache>		myShaderCache;
+	std::unique_ptr<PipelineReloader>	myPipelineReloader;
 
 	VkPhysicalDeviceMemoryProperties	myPhysicalDeviceMemProperties = {};
+	bool								myIsBindless = false;
+	bool								myIsDynamicRendering = false;
+	bool								myIsHostQueryReset = false;
+	bool								myIsCalibratedTimestamps = false;
+	bool								myIsHeadless = false;
 
 	VkSurfaceKHR						mySurface = nullptr;
 	VkSwapchainKHR						mySwapchain = nullptr;
 
 	VkAttachmentDescription				mySwapchainAttachmentDesc = {};
+	neat::static_vector<VkImage, NumSwapchainImages>
+										mySwapchainImages;
 	neat::static_vector<VkImageView, NumSwapchainImages>
 										mySwapchainImageViews;
+	neat::static_vector<VkDeviceMemory, NumSwapchainImages>
+										myOffscreenMemory;
 	neat::static_vector<VkFramebuffer, NumSwapchainImages>
 										myFrameBuffers;
 	uint32_t							myCurrentSwapchainIndex = 0;
@@ -8,17 +8,22 @@
 #include "Memory/ImageAllocator.h"
 
 #include "Image/ImageHandler.h"
+#include "Image/AtlasHandler.h"
 #include "Memory/ImmediateTransferrer.h"
 #include "Ray Tracing/AccelerationStructureAllocator.h"
 #include "Ray Tracing/AccelerationStructureHandler.h"
 #include "Scene/SceneGlobals.h"
 
 #include "Debug/DebugUtils.h"
+#include "Debug/GpuProfiler.h"
 #include "Image/CubeFilterer.h"
 #include "Image/ImageProcessor.h"
 #include "Presenter/Presenter.h"
 #include "RenderPass/RenderPassFactory.h"
 #include "Text/FontHandler.h"
+#include "Shader/ShaderCache.h"
+#include "Pipelines/PipelineReloader.h"
+#include "WorkerSystem/FrameGraph.h"
 
 #ifdef _DEBUG
 #pragma comment (lib, "NEAT_Debugx64.lib")
@@ -38,22 +43,10 @@ VulkanImplementation::~VulkanImplementation()
 	{
 		vkDestroySemaphore(myVulkanFramework.GetDevice(), myImageAvailableSemaphore[i], nullptr);
 		vkDestroySemaphore(myVulkanFramework.GetDevice(), myFrameDoneSemaphore[i], nullptr);
-		vkDestroySemaphore(myVulkanFramework.GetDevice(), myHasTransferredSemaphore[i], nullptr);
-	}
-
-	for (auto& wSys : myWorkerSystems)
-	{
-		for (int scIndex = 0; scIndex < NumSwapchainImages; ++scIndex)
-		{
-			for (int subIndex = 0; subIndex < wSys.system->GetSubmissionCount(); ++subIndex)
-			{
-				if (wSys.signalSemaphores[scIndex][subIndex] != myFrameDoneSemaphore[scIndex])
-				{
-					vkDestroySemaphore(myVulkanFramework.GetDevice(), wSys.signalSemaphores[scIndex][subIndex], nullptr);
-				}
-			}
-		}
 	}
+	myFrameGraph.reset();
+	gGpuProfiler = nullptr;
+	myGpuProfiler.reset();
 
 	for (int swapchainIndex = 0; swapchainIndex < NumSwapchainImages; ++swapchainIndex)
 	{
@@ -68,6 +61,9 @@ VulkanImplementation::Initialize(
 	const Vec2ui&		windowRes,
 	bool				useDebugLayers)
 {
+	// compiling needs no device, let the shaders build while vulkan comes up
+	myVulkanFramework.GetShaderCache().Precompile(ShaderDirectory, ShaderCache::PreAmble());
+
 	VK_FALLTHROUGH(myVulkanFramework.Init(threadID, hWND, windowRes, useDebugLayers));
 	VK_FALLTHROUGH(InitSync());
 
@@ -95,6 +91,10 @@ VulkanImplementation::Initialize(
 
 	DebugSetObjectName("Compute Queue", myComputeQueue, VK_OBJECT_TYPE_QUEUE, myVulkanFramework.GetDevice());
 
+	myGpuProfiler = std::make_unique<GpuProfiler>(myVulkanFramework, myQueueFamilyIndices);
+	gGpuProfiler = myGpuProfiler.get();
+	myFrameGraph = std::make_unique<FrameGraph>(myVulkanFramework, *myGpuProfiler, myGraphicsQueue, myComputeQueue, myTransferQueue);
+
 	// CORE, MEMORY
 	myImmediateTransferrer = std::make_unique<ImmediateTransferrer>(myVulkanFramework);
 
@@ -141,6 +141,8 @@ VulkanImplementation::Initialize(
 	myImageHandler = std::make_shared<ImageHandler>(myVulkanFramework,
 									   *myImageAllocator,
 									   myQueueFamilyIndices);
+	myAtlasHandler = std::make_shared<AtlasHandler>(myVulkanFramework,
+									   *myImageHandler);
 	myFontHandler = std::make_shared<FontHandler>(myVulkanFramework,
 									*myImageHandler,
 									myQueueFamilyIndices.data(),
@@ -166,6 +168,7 @@ VulkanImplementation::Initialize(
 												*myRenderPassFactory,
 												*myImageHandler,
 												*mySceneGlobals,
+												*myBufferAllocator,
 												myQueueFamilyIndices);
 
 	myCubeFilterer = std::make_shared<CubeFilterer>(myVulkanFramework,
@@ -215,10 +218,6 @@ VulkanImplementation::InitSync()
 		resultSemaphore = vkCreateSemaphore(myVulkanFramework.GetDevice(), &semaphoreInfo, nullptr, &myFrameDoneSemaphore[i]);
 		DebugSetObjectName(std::string("Has Rendered Sem " + std::to_string(i)).c_str(), myFrameDoneSemaphore[i], VK_OBJECT_TYPE_SEMAPHORE, myVulkanFramework.GetDevice());
 		VK_FALLTHROUGH(resultSemaphore);
-
-		resultSemaphore = vkCreateSemaphore(myVulkanFramework.GetDevice(), &semaphoreInfo, nullptr, &myHasTransferredSemaphore[i]);
-		DebugSetObjectName(std::string("Has Transferred Sem " + std::to_string(i)).c_str(), myHasTransferredSemaphore[i], VK_OBJECT_TYPE_SEMAPHORE, myVulkanFramework.GetDevice());
-		VK_FALLTHROUGH(resultSemaphore);
 	}
 
 	return VK_SUCCESS;
@@ -227,6 +226,7 @@ VulkanImplementation::InitSync()
 void
 VulkanImplementation::SubmitTransferCmds()
 {
+	PROFILE_ZONE("SubmitTransferCmds");
 	while (vkGetFenceStatus(myVulkanFramework.GetDevice(), myTransferFences[mySwapchainImageIndex]))
 	{
 	}
@@ -258,8 +258,9 @@ VulkanImplementation::SubmitTransferCmds()
 
 	transferSubmitInfo.commandBufferCount = 1;
 	transferSubmitInfo.pCommandBuffers = &myTransferCmdBuffer[mySwapchainImageIndex];
-	transferSubmitInfo.signalSemaphoreCount = 1;
-	transferSubmitInfo.pSignalSemaphores = &myHasTransferredSemaphore[mySwapchainImageIndex];
+	auto& transferSignals = myFrameGraph->GetTransferSignals(mySwapchainImageIndex);
+	transferSubmitInfo.signalSemaphoreCount = transferSignals.size();
+	transferSubmitInfo.pSignalSemaphores = transferSignals.data();
 
 	vkResetFences(myVulkanFramework.GetDevice(), 1, &myTransferFences[mySwapchainImageIndex]);
 	auto result = vkQueueSubmit(myTransferQueue, 1, &transferSubmitInfo, myTransferFences[mySwapchainImageIndex]);
@@ -269,64 +270,31 @@ VulkanImplementation::SubmitTransferCmds()
 void
 VulkanImplementation::SubmitWorkerCmds()
 {
-	neat::static_vector<VkSemaphore, MaxWorkerSubmissions> waitSemaphores = {myHasTransferredSemaphore[mySwapchainImageIndex]};
-	for (auto iter = myWorkersOrder.begin(); iter != myWorkersOrder.end() - 1; ++iter)
-	{
-		int index = *iter;
-		auto& wSys = myWorkerSystems[index];
-		auto submissions = wSys.system->RecordSubmit(
-			mySwapchainImageIndex,
-			waitSemaphores,
-			wSys.signalSemaphores[mySwapchainImageIndex]);
-		VkQueue queue = nullptr;
-		for (auto& submission : submissions)
-		{
-			switch (submission.desiredQueue)
-			{
-				case VK_QUEUE_GRAPHICS_BIT: queue = myGraphicsQueue; break;
-				case VK_QUEUE_COMPUTE_BIT: queue = myComputeQueue; break;
-				case VK_QUEUE_TRANSFER_BIT: queue = myTransferQueue; break;
-			}
-			vkResetFences(myVulkanFramework.GetDevice(), 1, &submission.fence);
-			const auto resultSubmit = vkQueueSubmit(queue, 1, &submission.submitInfo, submission.fence);
-			assert(!resultSubmit && "failed submission");
-		}
-		waitSemaphores = wSys.signalSemaphores[mySwapchainImageIndex];
-	}
-	{
-		auto& wSys = myWorkerSystems.back();
-		waitSemaphores.emplace_back(myImageAvailableSemaphore[mySwapchainImageIndex]);
-		auto submissions = wSys.system->RecordSubmit(
-			mySwapchainImageIndex,
-			waitSemaphores,
-			wSys.signalSemaphores[mySwapchainImageIndex]);
-
-		VkQueue queue = nullptr;
-		for (auto& submission : submissions)
-		{
-			switch (submission.desiredQueue)
-			{
-				case VK_QUEUE_GRAPHICS_BIT: queue = myGraphicsQueue; break;
-				case VK_QUEUE_COMPUTE_BIT: queue = myComputeQueue; break;
-				case VK_QUEUE_TRANSFER_BIT: queue = myTransferQueue; break;
-			}
-			vkResetFences(myVulkanFramework.GetDevice(), 1, &submission.fence);
-			const auto resultSubmit = vkQueueSubmit(queue, 1, &submission.submitInfo, submission.fence);
-			assert(!resultSubmit && "failed submission");
-		}
-	}
+	myFrameGraph->Submit(mySwapchainImageIndex);
 }
 
 void
 VulkanImplementation::BeginFrame()
 {
 	assert(myWorkerSystemsLocked && "worker systems not locked");
+	myFrameStartHeapAllocations = neat::GetNumHeapAllocations();
+	myPrevFrameBeginNs = myFrameBeginNs;
+	myFrameBeginNs = neat::Profiler::Now();
+	PROFILE_ZONE("BeginFrame");
+
 	static int fnr = -1;
-	mySwapchainImageIndex = myVulkanFramework.AcquireNextSwapchainImage(myImageAvailableSemaphore[++fnr % NumSwapchainImages]);
+	mySwapchainImageIndex = myVulkanFramework.AcquireNextSwapchainImage(myImageAvailableSemaphore[++fnr % NumSwapchainImages], myGraphicsQueue);
+	myGpuProfiler->BeginFrame(mySwapchainImageIndex, myWorkerSystemsFences[mySwapchainImageIndex]);
 
 	const int swapchainIndexToUpdate = (fnr + 1) % NumSwapchainImages;
-	myImageHandler->UpdateDescriptors(swapchainIndexToUpdate, myWorkerSystemsFences[swapchainIndexToUpdate]);
-	myMeshHandler->UpdateDescriptors(swapchainIndexToUpdate, myWorkerSystemsFences[swapchainIndexToUpdate]);
+	myBindCounts = CommandRecorder::FetchBindCounts();
+	myUniformHandler->ResetDynamicUniforms(mySwapchainImageIndex, myWorkerSystemsFences[mySwapchainImageIndex]);
+	myVulkanFramework.GetPipelineReloader().Update(myWorkerSystemsFences);
+	myImageHandler->GetTextureStreamer().Update();
+	myAtlasHandler->Flush();
+	myFontHandler->Flush();
+	myImageHandler->UpdateDescriptors(swapchainIndexToUpdate, myWorkerSystemsFences);
+	myMeshHandler->UpdateDescriptors(swapchainIndexToUpdate, myWorkerSystemsFences);
 	myImageAllocator->DoCleanUp(128);
 	myBufferAllocator->DoCleanUp(128);
 	myAccelerationStructureAllocator->DoCleanUp(128);
@@ -335,6 +303,7 @@ VulkanImplementation::BeginFrame()
 void
 VulkanImplementation::Submit()
 {
+	PROFILE_ZONE("Submit");
 	SubmitTransferCmds();
 	SubmitWorkerCmds();
 }
@@ -342,82 +311,37 @@ VulkanImplementation::Submit()
 void
 VulkanImplementation::EndFrame()
 {
+	PROFILE_ZONE("EndFrame");
 	myVulkanFramework.Present(myFrameDoneSemaphore[mySwapchainImageIndex], myGraphicsQueue);
 	myAllocationSubmitter->TryReleasing();
+	myFrameHeapAllocations = neat::GetNumHeapAllocations() - myFrameStartHeapAllocations;
+	neat::FrameArena::EndFrame();
 }
 
 void
 VulkanImplementation::RegisterWorkerSystem(
 	std::shared_ptr<WorkerSystem>	system)
 {
-	SlottedWorkerSystem toSlot{};
-	toSlot.system = system;
-	// SIGNAL SEMAPHORES
-	VkSemaphoreCreateInfo semaphoreInfo{};
-	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-	semaphoreInfo.pNext = nullptr;
-	semaphoreInfo.flags = NULL;
-
-	int subCount = system->GetSubmissionCount();
-	
-	for (uint32_t scIndex = 0; scIndex < NumSwapchainImages; ++scIndex)
-	{
-		toSlot.signalSemaphores[scIndex].resize(subCount);
-		for (int submissionIndex = 0; submissionIndex < subCount; ++submissionIndex)
-		{
-			auto resultSemaphore = vkCreateSemaphore(myVulkanFramework.GetDevice(), &semaphoreInfo, nullptr, &toSlot.signalSemaphores[scIndex][submissionIndex]);
-
-			DebugSetObjectName(std::string("WorkerSystem no.  " + std::to_string(scIndex)).c_str(),
-				toSlot.signalSemaphores[scIndex][submissionIndex],
-				VK_OBJECT_TYPE_SEMAPHORE,
-				myVulkanFramework.GetDevice());
-			VK_FALLTHROUGH(resultSemaphore);
-		}
-	}
-
-	// WAIT SEMAPHORES
-	//if (myWorkerSystems.empty())
-	//{
-	//	toSlot.AddWaitSemaphore(myHasTransferredSemaphore, waitStage);
-	//}
-	//else
-	//{
-	//	SlottedWorkerSystem& pre = myWorkerSystems.back();
-	//	toSlot.AddWaitSemaphore(pre.signalSemaphores, waitStage);
-	//}
-
-	myWorkerSystems.emplace_back(toSlot);
+	myWorkerSystems.emplace_back(std::move(system));
 }
 
 void
 VulkanImplementation::LockWorkerSystems()
 {
 	RegisterWorkerSystem(myPresenter);
-
-	for (int scIndex = 0; scIndex < NumSwapchainImages; ++scIndex)
-	{
-		int subCount = myWorkerSystems.back().system->GetSubmissionCount();
-		for (int subIndex = 0; subIndex < subCount; ++subIndex)
-		{
-			vkDestroySemaphore(myVulkanFramework.GetDevice(), myWorkerSystems.back().signalSemaphores[scIndex][subIndex], nullptr);
-			myWorkerSystems.back().signalSemaphores[scIndex][subIndex] = myFrameDoneSemaphore[scIndex];
-		}
-	}
 	myWorkerSystemsLocked = true;
 
-	myWorkerSystemsFences = myWorkerSystems.back().system->GetFences();
+	myWorkerSystemsFences = myPresenter->GetFences();
+	myRenderPassFactory->LogTransientMemory();
 
-	int index = 0;
 	for (auto& worker : myWorkerSystems)
 	{
-		myWorkersOrder.emplace_back(index);
-		for (auto& feature : worker.system->GetImplementedFeatures())
+		for (auto& feature : worker->GetImplementedFeatures())
 		{
 			myActiveFeatures[feature] = true;
 		}
-		index++;
 	}
-	int val = 0;
+	CompileFrameGraph();
 }
 
 void VulkanImplementation::RegisterThread(
@@ -430,7 +354,7 @@ void VulkanImplementation::RegisterThread(
 	}
 	for (auto& workerSystem : myWorkerSystems)
 	{
-		workerSystem.system->AddSchedule(threadID);
+		workerSystem->AddSchedule(threadID);
 	}
 	myAllocationSubmitter->RegisterThread(threadID);
 }
@@ -453,13 +377,17 @@ VulkanImplementation::ToggleFeature(
 		return;
 	}
 	myActiveFeatures[feature] = !myActiveFeatures[feature];
-	myWorkersOrder.clear();
-	int index = 0;
+	CompileFrameGraph();
+}
+
+void
+VulkanImplementation::CompileFrameGraph()
+{
+	std::vector<std::shared_ptr<WorkerSystem>> activeSystems;
 	for (auto& worker : myWorkerSystems)
 	{
-		const auto implementedFeatures = worker.system->GetImplementedFeatures();
 		bool inactiveFeature = false;
-		for (auto& implemented : implementedFeatures)
+		for (auto& implemented : worker->GetImplementedFeatures())
 		{
 			if (!myActiveFeatures[implemented])
 			{
@@ -467,12 +395,45 @@ VulkanImplementation::ToggleFeature(
 				break;
 			}
 		}
-		if (inactiveFeature)
+		if (!inactiveFeature)
 		{
-			index++;
-			continue;
+			activeSystems.emplace_back(worker);
 		}
-		myWorkersOrder.emplace_back(index++);
 	}
+
+	auto result = myFrameGraph->Compile(std::move(activeSystems), myImageAvailableSemaphore, myFrameDoneSemaphore);
+	assert(!result && "failed compiling frame graph");
+	LOG("compiled frame graph\n", myFrameGraph->Dump());
+}
+
+BindCounts
+VulkanImplementation::GetBindCounts() const
+{
+	return myBindCounts;
+}
+
+uint64_t
+VulkanImplementation::GetFrameHeapAllocations() const
+{
+	return myFrameHeapAllocations;
+}
+
+void
+VulkanImplementation::CollectFrameProfile(
+	std::vector<neat::ProfileEvent>&	outCpuEvents,
+	std::vector<neat::ProfileEvent>&	outGpuEvents) const
+{
+	// the gpu zones forwarded to the profiler are frames old, they come from the profiler's own copy instead
+	const size_t firstEvent = outCpuEvents.size();
+	neat::Profiler::Collect(outCpuEvents, myPrevFrameBeginNs);
+	outCpuEvents.erase(std::remove_if(outCpuEvents.begin() + firstEvent, outCpuEvents.end(), [this](const neat::ProfileEvent& event)
+	{
+		return event.beginNs < myPrevFrameBeginNs
+			|| event.endNs > myFrameBeginNs
+			|| myGpuProfiler->IsGpuTrack(event.track);
+	}), outCpuEvents.end());
+
+	const auto& gpuZones = myGpuProfiler->GetResolvedZones();
+	outGpuEvents.insert(outGpuEvents.end(), gpuZones.begin(), gpuZones.end());
 }
 
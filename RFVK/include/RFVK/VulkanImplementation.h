@@ -5,6 +5,7 @@
 #include "WorkerSystem/WorkerSystem.h"
 #include "neat/General/Thread.h"
 #include "Features.h"
+#include "Pipelines/CommandRecorder.h"
 
 namespace rflx
 {
@@ -36,11 +37,22 @@ public:
 	bool										CheckFeature(rflx::Features feature);
 	void										ToggleFeature(rflx::Features feature);
 
+	// descriptor set binds requested and actually recorded during the last frame
+	_nodiscard BindCounts						GetBindCounts() const;
+	// heap allocations the calling thread made between the last BeginFrame and EndFrame
+	_nodiscard uint64_t							GetFrameHeapAllocations() const;
+	// cpu events of the last whole frame, from its BeginFrame to the current one, and the gpu zones read back most recently
+	void										CollectFrameProfile(
+													std::vector<neat::ProfileEvent>&	outCpuEvents,
+													std::vector<neat::ProfileEvent>&	outGpuEvents) const;
+
 private:
 	VkResult									InitSync();
 
 	void										SubmitTransferCmds();
 	void										SubmitWorkerCmds();
+	// rebuilt whenever the set of active worker systems changes
+	void										CompileFrameGraph();
 
 	VulkanFramework								myVulkanFramework;
 	VkQueue										myGraphicsQueue = nullptr;
@@ -55,8 +67,6 @@ private:
 												myTransferCmdBuffer = {};
 	std::array<VkFence, NumSwapchainImages>		myTransferFences = {};
 
-	std::array<VkSemaphore, NumSwapchainImages> myHasTransferredSemaphore = {};
-
 	std::array<VkSemaphore, NumSwapchainImages> myImageAvailableSemaphore = {};
 	std::array<VkSemaphore, NumSwapchainImages> myFrameDoneSemaphore = {};
 
@@ -76,6 +86,7 @@ private:
 	// OBJECT HANDLERS
 	std::shared_ptr<class UniformHandler>		myUniformHandler;
 	std::shared_ptr<class ImageHandler>			myImageHandler;
+	std::shared_ptr<class AtlasHandler>			myAtlasHandler;
 	std::shared_ptr<class FontHandler>			myFontHandler;
 	std::shared_ptr<class MeshHandler>			myMeshHandler;
 	std::shared_ptr<class AccelerationStructureHandler>
@@ -85,15 +96,20 @@ private:
 	std::shared_ptr<class SceneGlobals>			mySceneGlobals;
 
 	// WORKERS
-	std::vector<SlottedWorkerSystem>
-												myWorkerSystems;
+	std::vector<std::shared_ptr<WorkerSystem>>	myWorkerSystems;
 	std::array<VkFence, NumSwapchainImages>		myWorkerSystemsFences = {};
-	std::vector<int>							myWorkersOrder;
+	std::unique_ptr<class FrameGraph>			myFrameGraph;
+	std::unique_ptr<class GpuProfiler>			myGpuProfiler;
 	
 	std::shared_ptr<class CubeFilterer>			myCubeFilterer;
 	std::shared_ptr<class Presenter>			myPresenter;
 	std::shared_ptr<class ImageProcessor>		myImageProcessor;
 	bool										myWorkerSystemsLocked = false;
+	BindCounts									myBindCounts = {};
+	uint64_t									myFrameStartHeapAllocations = 0;
+	uint64_t									myFrameHeapAllocations = 0;
+	uint64_t									myFrameBeginNs = 0;
+	uint64_t									myPrevFrameBeginNs = 0;
 
 	conc_map<rflx::Features, bool>				myActiveFeatures;
 
@@ -0,0 +1,412 @@
+#include "pch.h"
+#include "FrameGraph.h"
+
+#include "RFVK/VulkanFramework.h"
+#include "RFVK/Debug/DebugUtils.h"
+#include "RFVK/Debug/GpuProfiler.h"
+
+static bool
+IsRead(ResourceAccess access)
+{
+	return access == ResourceAccess::Read || access == ResourceAccess::ReadWrite;
+}
+
+static bool
+IsWrite(ResourceAccess access)
+{
+	return access == ResourceAccess::Write || access == ResourceAccess::ReadWrite;
+}
+
+// name of the first resource the later pass has to wait for, nullptr when the passes are independent
+// carriesData is set when the later pass reads what the earlier one wrote
+static const char*
+Conflict(
+	const FramePass&	earlier,
+	const FramePass&	later,
+	bool&				carriesData)
+{
+	carriesData = false;
+	if (earlier.uses.empty() || later.uses.empty())
+	{
+		carriesData = true;
+		return "undeclared";
+	}
+
+	const char* conflict = nullptr;
+	for (auto& earlierUse : earlier.uses)
+	{
+		for (auto& laterUse : later.uses)
+		{
+			if (earlierUse.resource != laterUse.resource)
+			{
+				continue;
+			}
+			if (IsWrite(earlierUse.access) && IsRead(laterUse.access))
+			{
+				carriesData = true;
+				return laterUse.name;
+			}
+			if (!conflict && (IsWrite(earlierUse.access) || IsWrite(laterUse.access)))
+			{
+				conflict = laterUse.name;
+			}
+		}
+	}
+	return conflict;
+}
+
+FrameGraph::FrameGraph(
+	VulkanFramework&	vulkanFramework,
+	GpuProfiler&		gpuProfiler,
+	VkQueue				graphicsQueue,
+	VkQueue				computeQueue,
+	VkQueue				transferQueue)
+	: theirVulkanFramework(vulkanFramework)
+	, theirGpuProfiler(gpuProfiler)
+	, myGraphicsQueue(graphicsQueue)
+	, myComputeQueue(computeQueue)
+	, myTransferQueue(transferQueue)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+	DestroySemaphores();
+}
+
+VkResult
+FrameGraph::Compile(
+	std::vector<std::shared_ptr<WorkerSystem>>&&		systems,
+	const std::array<VkSemaphore, NumSwapchainImages>&	imageAvailable,
+	const std::array<VkSemaphore, NumSwapchainImages>&	frameDone)
+{
+	DestroySemaphores();
+	myPasses.clear();
+
+	if (systems.empty() || systems.size() > MaxFramePasses)
+	{
+		LOG("failed compiling frame graph,", systems.size(), "systems, max is", MaxFramePasses);
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	for (auto& system : systems)
+	{
+		FramePass pass;
+		pass.uses = system->GetResourceUses();
+		pass.numSubmissions = system->GetSubmissionCount();
+		pass.system = std::move(system);
+		myPasses.emplace_back(std::move(pass));
+	}
+
+	Cull();
+	FindEdges();
+	ReduceEdges();
+
+	return CreateSemaphores(imageAvailable, frameDone);
+}
+
+void
+FrameGraph::Submit(uint32_t swapchainIndex)
+{
+	for (auto& pass : myPasses)
+	{
+		if (pass.isCulled)
+		{
+			continue;
+		}
+
+		auto& passSignals = pass.signalSemaphores[swapchainIndex];
+		neat::static_vector<VkSemaphore, MaxWorkerSubmissions> signals;
+		for (int submissionIndex = 0; submissionIndex < pass.numSubmissions; ++submissionIndex)
+		{
+			signals.emplace_back(passSignals[submissionIndex].size() ? passSignals[submissionIndex][0] : VK_NULL_HANDLE);
+		}
+
+		neat::static_vector<WorkerSubmission, MaxWorkerSubmissions> submissions;
+		{
+			PROFILE_ZONE(pass.system->GetName());
+			submissions = pass.system->RecordSubmit(
+				swapchainIndex,
+				pass.waitSemaphores[swapchainIndex],
+				signals);
+		}
+		assert(int(submissions.size()) == pass.numSubmissions && "worker system submitted a different count than declared");
+
+		for (uint32_t submissionIndex = 0; submissionIndex < submissions.size(); ++submissionIndex)
+		{
+			auto& submission = submissions[submissionIndex];
+			submission.submitInfo.pSignalSemaphores = passSignals[submissionIndex].data();
+			submission.submitInfo.signalSemaphoreCount = passSignals[submissionIndex].size();
+			if (submissionIndex > 0)
+			{
+				submission.submitInfo.pWaitSemaphores = &pass.chainSemaphores[swapchainIndex][submissionIndex - 1];
+				submission.submitInfo.waitSemaphoreCount = 1;
+			}
+
+			VkQueue queue = nullptr;
+			QueueFamilyType family = QUEUE_FAMILY_GRAPHICS;
+			switch (submission.desiredQueue)
+			{
+				case VK_QUEUE_GRAPHICS_BIT: queue = myGraphicsQueue; family = QUEUE_FAMILY_GRAPHICS; break;
+				case VK_QUEUE_COMPUTE_BIT: queue = myComputeQueue; family = QUEUE_FAMILY_COMPUTE; break;
+				case VK_QUEUE_TRANSFER_BIT: queue = myTransferQueue; family = QUEUE_FAMILY_TRANSFER; break;
+			}
+			theirGpuProfiler.WrapSubmission(swapchainIndex, pass.system->GetName(), family, submission.submitInfo);
+			vkResetFences(theirVulkanFramework.GetDevice(), 1, &submission.fence);
+			const auto resultSubmit = vkQueueSubmit(queue, 1, &submission.submitInfo, submission.fence);
+			assert(!resultSubmit && "failed submission");
+		}
+	}
+}
+
+const neat::static_vector<VkSemaphore, MaxWorkerSubmissions>&
+FrameGraph::GetTransferSignals(uint32_t swapchainIndex) const
+{
+	return myTransferSignals[swapchainIndex];
+}
+
+std::string
+FrameGraph::Dump() const
+{
+	std::string dot = "digraph frame {\n";
+	for (uint32_t passIndex = 0; passIndex < myPasses.size(); ++passIndex)
+	{
+		auto& pass = myPasses[passIndex];
+		dot += "\tp" + std::to_string(passIndex) + " [label=\"" + pass.system->GetName() + "\"";
+		if (pass.isCulled)
+		{
+			dot += ", style=dashed";
+		}
+		dot += "];\n";
+	}
+	for (uint32_t passIndex = 0; passIndex < myPasses.size(); ++passIndex)
+	{
+		for (auto& edge : myPasses[passIndex].waits)
+		{
+			dot += "\tp" + std::to_string(edge.producer) + " -> p" + std::to_string(passIndex) + " [label=\"" + edge.reason + "\"];\n";
+		}
+	}
+	dot += "}";
+	return dot;
+}
+
+void
+FrameGraph::Cull()
+{
+	// kept passes keep the passes whose writes they read, walking back from the sink
+	const uint32_t sink = myPasses.size() - 1;
+	for (uint32_t passIndex = 0; passIndex < myPasses.size(); ++passIndex)
+	{
+		auto& pass = myPasses[passIndex];
+		bool isKept = passIndex == sink || pass.uses.empty();
+		for (auto& use : pass.uses)
+		{
+			isKept |= use.isPersistent && IsWrite(use.access);
+		}
+		pass.isCulled = !isKept;
+	}
+
+	for (int32_t laterIndex = sink; laterIndex >= 0; --laterIndex)
+	{
+		if (myPasses[laterIndex].isCulled)
+		{
+			continue;
+		}
+		for (int32_t earlierIndex = 0; earlierIndex < laterIndex; ++earlierIndex)
+		{
+			bool carriesData = false;
+			Conflict(myPasses[earlierIndex], myPasses[laterIndex], carriesData);
+			if (carriesData)
+			{
+				myPasses[earlierIndex].isCulled = false;
+			}
+		}
+	}
+}
+
+void
+FrameGraph::FindEdges()
+{
+	const uint32_t sink = myPasses.size() - 1;
+	std::vector<bool> hasConsumer(myPasses.size(), false);
+	for (uint32_t laterIndex = 0; laterIndex < myPasses.size(); ++laterIndex)
+	{
+		if (myPasses[laterIndex].isCulled)
+		{
+			continue;
+		}
+		for (uint32_t earlierIndex = 0; earlierIndex < laterIndex; ++earlierIndex)
+		{
+			if (myPasses[earlierIndex].isCulled)
+			{
+				continue;
+			}
+			bool carriesData = false;
+			if (const char* reason = Conflict(myPasses[earlierIndex], myPasses[laterIndex], carriesData))
+			{
+				myPasses[laterIndex].waits.push_back({earlierIndex, reason});
+				hasConsumer[earlierIndex] = true;
+			}
+		}
+	}
+
+	// leaves feed the sink so its fence covers them
+	for (uint32_t passIndex = 0; passIndex < sink; ++passIndex)
+	{
+		if (!myPasses[passIndex].isCulled && !hasConsumer[passIndex])
+		{
+			myPasses[sink].waits.push_back({passIndex, "frame"});
+		}
+	}
+}
+
+void
+FrameGraph::ReduceEdges()
+{
+	// an edge is dropped when another path between the same passes already orders them
+	std::vector<std::vector<uint32_t>> consumers(myPasses.size());
+	for (uint32_t passIndex = 0; passIndex < myPasses.size(); ++passIndex)
+	{
+		for (auto& edge : myPasses[passIndex].waits)
+		{
+			consumers[edge.producer].push_back(passIndex);
+		}
+	}
+
+	std::vector<uint64_t> reachable(myPasses.size(), 0);
+	for (int32_t passIndex = int32_t(myPasses.size()) - 1; passIndex >= 0; --passIndex)
+	{
+		for (uint32_t consumer : consumers[passIndex])
+		{
+			reachable[passIndex] |= (uint64_t(1) << consumer) | reachable[consumer];
+		}
+	}
+
+	for (uint32_t passIndex = 0; passIndex < myPasses.size(); ++passIndex)
+	{
+		std::erase_if(myPasses[passIndex].waits, [&](const FrameEdge& edge)
+		{
+			for (uint32_t consumer : consumers[edge.producer])
+			{
+				if (consumer != passIndex && (reachable[consumer] & (uint64_t(1) << passIndex)))
+				{
+					return true;
+				}
+			}
+			return false;
+		});
+	}
+}
+
+VkResult
+FrameGraph::CreateSemaphores(
+	const std::array<VkSemaphore, NumSwapchainImages>&	imageAvailable,
+	const std::array<VkSemaphore, NumSwapchainImages>&	frameDone)
+{
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	auto createSemaphore = [this, &semaphoreInfo](const std::string& name, VkSemaphore& semaphore)
+	{
+		auto result = vkCreateSemaphore(theirVulkanFramework.GetDevice(), &semaphoreInfo, nullptr, &semaphore);
+		if (!result)
+		{
+			DebugSetObjectName(name.c_str(), semaphore, VK_OBJECT_TYPE_SEMAPHORE, theirVulkanFramework.GetDevice());
+			myOwnedSemaphores.emplace_back(semaphore);
+		}
+		return result;
+	};
+
+	const uint32_t sink = myPasses.size() - 1;
+	for (uint32_t passIndex = 0; passIndex < myPasses.size(); ++passIndex)
+	{
+		auto& pass = myPasses[passIndex];
+		if (pass.isCulled)
+		{
+			continue;
+		}
+
+		for (uint32_t scIndex = 0; scIndex < NumSwapchainImages; ++scIndex)
+		{
+			bool fits = true;
+
+			// WAITS
+			for (auto& edge : pass.waits)
+			{
+				auto& producer = myPasses[edge.producer];
+				for (int submissionIndex = 0; submissionIndex < producer.numSubmissions; ++submissionIndex)
+				{
+					VkSemaphore semaphore = nullptr;
+					auto result = createSemaphore(
+						std::string(producer.system->GetName()) + " to " + pass.system->GetName() + " no. " + std::to_string(scIndex),
+						semaphore);
+					if (result)
+					{
+						LOG("failed creating frame graph semaphore");
+						return result;
+					}
+					edge.semaphores[scIndex].emplace_back(semaphore);
+					fits &= pass.waitSemaphores[scIndex].emplace_back(semaphore);
+					fits &= producer.signalSemaphores[scIndex][submissionIndex].emplace_back(semaphore);
+				}
+			}
+			if (pass.waits.empty())
+			{
+				VkSemaphore semaphore = nullptr;
+				auto result = createSemaphore("Has Transferred Sem " + std::to_string(scIndex), semaphore);
+				if (result)
+				{
+					LOG("failed creating frame graph semaphore");
+					return result;
+				}
+				fits &= myTransferSignals[scIndex].emplace_back(semaphore);
+				fits &= pass.waitSemaphores[scIndex].emplace_back(semaphore);
+			}
+
+			// CHAIN
+			for (int submissionIndex = 1; submissionIndex < pass.numSubmissions; ++submissionIndex)
+			{
+				VkSemaphore semaphore = nullptr;
+				auto result = createSemaphore(
+					std::string(pass.system->GetName()) + " chain " + std::to_string(submissionIndex) + " no. " + std::to_string(scIndex),
+					semaphore);
+				if (result)
+				{
+					LOG("failed creating frame graph semaphore");
+					return result;
+				}
+				fits &= pass.chainSemaphores[scIndex].emplace_back(semaphore);
+				fits &= pass.signalSemaphores[scIndex][submissionIndex - 1].emplace_back(semaphore);
+			}
+
+			// SWAPCHAIN
+			if (passIndex == sink)
+			{
+				fits &= pass.waitSemaphores[scIndex].emplace_back(imageAvailable[scIndex]);
+				fits &= pass.signalSemaphores[scIndex][pass.numSubmissions - 1].emplace_back(frameDone[scIndex]);
+			}
+
+			if (!fits)
+			{
+				LOG("failed compiling frame graph,", pass.system->GetName(), "has more than", MaxWorkerSubmissions, "semaphores");
+				return VK_ERROR_TOO_MANY_OBJECTS;
+			}
+		}
+	}
+
+	return VK_SUCCESS;
+}
+
+void
+FrameGraph::DestroySemaphores()
+{
+	for (auto semaphore : myOwnedSemaphores)
+	{
+		vkDestroySemaphore(theirVulkanFramework.GetDevice(), semaphore, nullptr);
+	}
+	myOwnedSemaphores.clear();
+	for (auto& signals : myTransferSignals)
+	{
+		signals.clear();
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "WorkerSystem.h"
+
+constexpr uint32_t MaxFramePasses = 64;
+
+typedef std::array<neat::static_vector<VkSemaphore, MaxWorkerSubmissions>, NumSwapchainImages> FrameSemaphores;
+
+struct FrameEdge
+{
+	uint32_t								producer;
+	const char*								reason;
+	// one per producer submission
+	FrameSemaphores							semaphores;
+};
+
+struct FramePass
+{
+	std::shared_ptr<class WorkerSystem>		system;
+	std::vector<ResourceUse>				uses;
+	int										numSubmissions = 0;
+	bool									isCulled = false;
+
+	std::vector<FrameEdge>					waits;
+	FrameSemaphores							waitSemaphores;
+	// submission i waits on chainSemaphores[i - 1], so a pass's submissions run in order across queues
+	FrameSemaphores							chainSemaphores;
+	std::array<std::array<neat::static_vector<VkSemaphore, MaxWorkerSubmissions>, MaxWorkerSubmissions>, NumSwapchainImages>
+											signalSemaphores;
+};
+
+// orders worker systems by the resources they declare instead of registration alone
+// passes only wait on the passes they conflict with, independent passes overlap across queues
+class FrameGraph
+{
+public:
+											FrameGraph(
+												class VulkanFramework&	vulkanFramework,
+												class GpuProfiler&		gpuProfiler,
+												VkQueue					graphicsQueue,
+												VkQueue					computeQueue,
+												VkQueue					transferQueue);
+											~FrameGraph();
+
+	// the last system is the sink, it waits for the swapchain image and signals frame done
+	// every other kept pass reaches it, so its fences cover the whole frame
+	VkResult								Compile(
+												std::vector<std::shared_ptr<WorkerSystem>>&&		systems,
+												const std::array<VkSemaphore, NumSwapchainImages>&	imageAvailable,
+												const std::array<VkSemaphore, NumSwapchainImages>&	frameDone);
+	// every submission is timed on the gpu under its system's name
+	void									Submit(uint32_t swapchainIndex);
+
+	// signalled by the transfer submission, one per pass without producers
+	_nodiscard const neat::static_vector<VkSemaphore, MaxWorkerSubmissions>&
+											GetTransferSignals(uint32_t swapchainIndex) const;
+	// graphviz dot of the compiled graph, culled passes are dashed
+	_nodiscard std::string					Dump() const;
+
+private:
+	void									FindEdges();
+	void									Cull();
+	void									ReduceEdges();
+	VkResult								CreateSemaphores(
+												const std::array<VkSemaphore, NumSwapchainImages>&	imageAvailable,
+												const std::array<VkSemaphore, NumSwapchainImages>&	frameDone);
+	void									DestroySemaphores();
+
+	VulkanFramework&						theirVulkanFramework;
+	GpuProfiler&							theirGpuProfiler;
+	VkQueue									myGraphicsQueue = nullptr;
+	VkQueue									myComputeQueue = nullptr;
+	VkQueue									myTransferQueue = nullptr;
+
+	std::vector<FramePass>					myPasses;
+	FrameSemaphores							myTransferSignals;
+	std::vector<VkSemaphore>				myOwnedSemaphores;
+
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+enum class ResourceAccess
+{
+	Read,
+	Write,
+	ReadWrite,
+};
+
+// resources are named by a handle unique to them, usually the VkImageView or VkBuffer
+struct ResourceUse
+{
+	uint64_t		resource;
+	const char*		name;
+	ResourceAccess	access;
+	// outlives the frame, its writer is kept even when nothing reads it this frame
+	bool			isPersistent = false;
+};
@@ -1,5 +1,6 @@
 
 #pragma once
+#include "FrameResource.h"
 #include "WorkScheduler.h"
 #include "RFVK/Features.h"
 
@@ -10,12 +11,6 @@ struct WaitSemaphores
 };
 
 constexpr int MaxWorkerSubmissions = 8;
-struct SlottedWorkerSystem
-{
-	std::array<neat::static_vector<VkSemaphore, MaxWorkerSubmissions>, NumSwapchainImages>
-													signalSemaphores;
-	std::shared_ptr<class WorkerSystem>				system;
-};
 
 struct WorkerSubmission
 {
@@ -26,6 +21,8 @@ struct WorkerSubmission
 class WorkerSystem
 {
 public:
+	// signalSemaphores[i] is signalled by submission i, the frame graph adds one more per extra consumer
+	// waitSemaphores are for the first submission, every later one waits on the one before it
 	[[nodiscard]] virtual neat::static_vector<WorkerSubmission, MaxWorkerSubmissions>
 															RecordSubmit(
 																uint32_t				swapchainImageIndex,
@@ -37,6 +34,9 @@ public:
 	virtual std::array<VkFence, NumSwapchainImages>			GetFences() = 0;
 	virtual int												GetSubmissionCount() = 0;
 	virtual std::vector<rflx::Features>						GetImplementedFeatures() const = 0;
+	// systems declaring nothing are ordered after every system registered before them
+	virtual std::vector<ResourceUse>						GetResourceUses() const { return {}; }
+	virtual const char*										GetName() const { return "WorkerSystem"; }
 private:
 	
 	
@@ -6,7 +6,9 @@
 #include "RFVK/Image/ImageHandler.h"
 #include "RFVK/Mesh/Mesh.h"
 #include "RFVK/Mesh/MeshHandler.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
 #include "RFVK/Pipelines/PipelineBuilder.h"
+#include "RFVK/Pipelines/PipelineReloader.h"
 #include "RFVK/RenderPass/RenderPassFactory.h"
 #include "RFVK/Scene/SceneGlobals.h"
 #include "RFVK/Shader/Shader.h"
@@ -20,6 +22,7 @@ DeferredGeoRenderer::DeferredGeoRenderer(
 	SceneGlobals& sceneGlobals, 
 	RenderPassFactory& renderPassFactory, 
 	GBuffer gBuffer, 
+	const TransientLifetime& depthLifetime,
 	QueueFamilyIndices familyIndices)
 	: theirVulkanFramework(vulkanFramework)
 	, theirUniformHandler(uniformHandler)
@@ -40,10 +43,13 @@ DeferredGeoRenderer::DeferredGeoRenderer(
 			VK_FORMAT_R8G8B8A8_UNORM,
 			VK_FORMAT_D24_UNORM_S8_UINT
 		}, {sw, sh});
-	rpBuilder.SetImageViews(0, gBuffer.albedo);
-	rpBuilder.SetImageViews(1, gBuffer.position);
-	rpBuilder.SetImageViews(2, gBuffer.normal);
-	rpBuilder.SetImageViews(3, gBuffer.material);
+	const VkImageSubresourceRange colorRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	rpBuilder.SetImageViews(0, gBuffer.albedo, gBuffer.images[0], colorRange);
+	rpBuilder.SetImageViews(1, gBuffer.position, gBuffer.images[1], colorRange);
+	rpBuilder.SetImageViews(2, gBuffer.normal, gBuffer.images[2], colorRange);
+	rpBuilder.SetImageViews(3, gBuffer.material, gBuffer.images[3], colorRange);
+	// depth is only tested against while the gbuffer is drawn
+	rpBuilder.SetTransient({4}, depthLifetime);
 	rpBuilder.SetClearValues({
 		{.color = {1,0,0,0}},
 		{.color = {0,1,0,0}},
@@ -79,13 +85,11 @@ DeferredGeoRenderer::DeferredGeoRenderer(
 	rpBuilder.EditAttachmentDescription(2).finalLayout = VK_IMAGE_LAYOUT_GENERAL;
 	rpBuilder.EditAttachmentDescription(3).finalLayout = VK_IMAGE_LAYOUT_GENERAL;
 	
+	rpBuilder.SetName("DeferredGeoPass");
 	myDeferredRenderPass = rpBuilder.Build();
 	renderPassFactory.RegisterRenderPass(myDeferredRenderPass);
 
 	// PIPELINE
-	myInstanceData = std::make_unique<UniformInstances>();
-	myInstanceUniformID =  theirUniformHandler.RequestUniformBuffer(nullptr, sizeof UniformInstances);
-	
 	char shaderPaths[][128]
 	{
 		"Shaders/base_vshader.vert",
@@ -94,23 +98,29 @@ DeferredGeoRenderer::DeferredGeoRenderer(
 	myDeferredGeoShader = std::make_shared<Shader>(shaderPaths,
 		_ARRAYSIZE(shaderPaths),
 		theirVulkanFramework);
-	PipelineBuilder pBuilder(4, myDeferredRenderPass.renderPass, myDeferredGeoShader.get());
-	pBuilder.DefineVertexInput(&Vertex3DInputInfo)
-		.DefineViewport({sw, sh}, {0,0,sw,sh})
-		.SetAllBlendStates(GenBlendState::Disabled);
+	auto instLayout = theirUniformHandler.GetDynamicUniformLayout();
+	auto constructGeoPipeline = [this, sw, sh, instLayout](Shader* shader)
+	{
+		PipelineBuilder pBuilder(4, myDeferredRenderPass, shader);
+		pBuilder.DefineVertexInput(&Vertex3DInputInfo)
+			.DefineViewport({sw, sh}, {0,0,sw,sh})
+			.SetAllBlendStates(GenBlendState::Disabled);
 
-	auto [instLayout, instSet] = theirUniformHandler[myInstanceUniformID];
+		return pBuilder.Construct({
+			theirSceneGlobals.GetGlobalsLayout(),
+			theirImageHandler.GetSamplerSetLayout(),
+			theirImageHandler.GetImageSetLayout(),
+			instLayout}, theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache());
+	};
 	VkResult result;
-	std::tie(result, myDeferredGeoPipeline) = pBuilder.Construct({
-		sceneGlobals.GetGlobalsLayout(),
-		theirImageHandler.GetSamplerSetLayout(),
-		theirImageHandler.GetImageSetLayout(),
-		instLayout}, theirVulkanFramework.GetDevice());
+	std::tie(result, myDeferredGeoPipeline) = constructGeoPipeline(myDeferredGeoShader.get());
+	theirVulkanFramework.GetPipelineReloader().Register(myDeferredGeoPipeline, *myDeferredGeoShader, 0, constructGeoPipeline);
 	
 }
 
 DeferredGeoRenderer::~DeferredGeoRenderer()
 {
+	theirVulkanFramework.GetPipelineReloader().Unregister(myDeferredGeoPipeline);
 	vkDestroyPipeline(
 		theirVulkanFramework.GetDevice(),
 		myDeferredGeoPipeline.pipeline,
@@ -130,10 +140,16 @@ DeferredGeoRenderer::Record(
 	static std::array<std::pair<uint32_t, uint32_t>, MaxNumMeshesLoaded> instanceControl;
 	instanceControl = {};
 
+	auto [instanceData, instanceOffset] = theirUniformHandler.AllocateDynamicUniform(
+		swapchainIndex,
+		assembledWork.size() * sizeof(Instance));
+	auto* instances = static_cast<Instance*>(instanceData);
+	const uint32_t numDrawn = instances ? uint32_t(assembledWork.size()) : 0;
+
 	MeshID currentID = MeshID(INVALID_ID);
-	uint32_t index = 0;
-	for (auto& cmd : assembledWork)
+	for (uint32_t index = 0; index < numDrawn; ++index)
 	{
+		auto& cmd = assembledWork[index];
 		if (cmd.id != currentID)
 		{
 			currentID = cmd.id;
@@ -141,14 +157,10 @@ DeferredGeoRenderer::Record(
 		}
 		++instanceControl[int(currentID)].second;
 
-		myInstanceData->instances[index].mat = cmd.transform;
-		myInstanceData->instances[index].objID = uint32_t(cmd.id);
-
-		index++;
+		instances[index].mat = cmd.transform;
+		instances[index].objID = uint32_t(cmd.id);
 	}
 
-	theirUniformHandler.UpdateUniformData(myInstanceUniformID, myInstanceData.get());
-
 	// RECORD
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
 	BeginRenderPass(cmdBuffer,
@@ -156,16 +168,17 @@ DeferredGeoRenderer::Record(
 		swapchainIndex,
 		{0,0,w,h});
 
-	vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, myDeferredGeoPipeline.pipeline);
+	CommandRecorder recorder(cmdBuffer);
+	recorder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, myDeferredGeoPipeline.pipeline);
 
 	// DESCRIPTORS
-	theirSceneGlobals.BindGlobals(cmdBuffer, myDeferredGeoPipeline.layout, 0);
-	theirImageHandler.BindSamplers(cmdBuffer, myDeferredGeoPipeline.layout, 1);
-	theirImageHandler.BindImages(swapchainIndex, cmdBuffer, myDeferredGeoPipeline.layout, 2);
-	theirUniformHandler.BindUniform(myInstanceUniformID, cmdBuffer, myDeferredGeoPipeline.layout, 3);
+	theirSceneGlobals.BindGlobals(recorder, myDeferredGeoPipeline.layout, 0);
+	theirImageHandler.BindSamplers(recorder, myDeferredGeoPipeline.layout, 1);
+	theirImageHandler.BindImages(swapchainIndex, recorder, myDeferredGeoPipeline.layout, 2);
+	theirUniformHandler.BindDynamicUniform(instanceOffset, recorder, myDeferredGeoPipeline.layout, 3);
 
 	// MESHES
-	for (uint32_t i = 0; i < assembledWork.size();)
+	for (uint32_t i = 0; i < numDrawn;)
 	{
 		auto& cmd = assembledWork[i];
 		auto [first, num] = instanceControl[int(cmd.id)];
@@ -177,5 +190,5 @@ DeferredGeoRenderer::Record(
 		i += num;
 	}
 	
-	vkCmdEndRenderPass(cmdBuffer);
+	EndRenderPass(cmdBuffer, myDeferredRenderPass, swapchainIndex);
 }
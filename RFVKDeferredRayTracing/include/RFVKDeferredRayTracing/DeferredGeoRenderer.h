@@ -16,11 +16,8 @@ class DeferredGeoRenderer final
 		Vec3f		padding0;
 		uint32_t	objID;
 	};
-	static_assert(128 > sizeof Instance);
-	struct UniformInstances
-	{
-		Instance instances[MaxNumInstances];
-	};
+	static_assert(128 > sizeof(Instance));
+	static_assert(MaxNumInstances * sizeof(Instance) <= MaxDynamicUniformRange);
 
 public:
 			DeferredGeoRenderer(
@@ -31,6 +28,7 @@ public:
 				class SceneGlobals&			sceneGlobals,
 				class RenderPassFactory&	renderPassFactory,
 				GBuffer						gBuffer,
+				const TransientLifetime&	depthLifetime,
 				QueueFamilyIndices			familyIndices);
 			~DeferredGeoRenderer();
 
@@ -49,9 +47,6 @@ private:
 	SceneGlobals&		theirSceneGlobals;
 	RenderPassFactory&	theirRenderPassFactory;
 
-	std::unique_ptr<UniformInstances>	myInstanceData;
-	UniformID							myInstanceUniformID = UniformID(INVALID_ID);
-
 	RenderPass							myDeferredRenderPass;
 
 	std::shared_ptr<class Shader>		myDeferredGeoShader;
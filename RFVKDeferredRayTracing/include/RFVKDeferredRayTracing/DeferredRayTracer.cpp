@@ -5,7 +5,7 @@
 #include "RayTracer.h"
 #include "RFVK/VulkanFramework.h"
 #include "RFVK/Image/ImageHandler.h"
-#include "RFVK/Memory/ImageAllocator.h"
+#include "RFVK/RenderPass/RenderPassFactory.h"
 
 DeferredRayTracer::DeferredRayTracer(
 	VulkanFramework&	vulkanFramework, 
@@ -19,43 +19,37 @@ DeferredRayTracer::DeferredRayTracer(
 						accStructHandler,
 	QueueFamilyIndices	familyIndices)
 	: theirVulkanFramework(vulkanFramework)
+	, theirImageHandler(imageHandler)
+	, theirRenderPassFactory(renderPassFactory)
 {
 	myGeoWaitStages.fill(VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT);
 	myRTWaitStages.fill(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
 
 	// GBUFFER
-	auto& imageAllocator = imageHandler.GetImageAllocator();
-	auto allocSubID = imageAllocator.Start();
+	// written by the geo pass and read by the trace pass every frame, so it is transient to the frame
+	// it aliases the mesh renderer's gbuffer, the frame graph orders both systems by the transient heap
 	auto [sw, sh] = vulkanFramework.GetTargetResolution();
-
-	ImageRequestInfo imageInfo = {};
-	imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-	imageInfo.width = sw;
-	imageInfo.height = sh;
-	imageInfo.layout = VK_IMAGE_LAYOUT_GENERAL;
-	imageInfo.targetPipelineStage = 
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
-		| VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
-	imageInfo.usage =
+	const VkImageUsageFlags gBufferUsage =
 		VK_IMAGE_USAGE_STORAGE_BIT
 		| VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-	imageInfo.owners = {
-		familyIndices[QUEUE_FAMILY_TRANSFER],
-		familyIndices[QUEUE_FAMILY_COMPUTE],
-		familyIndices[QUEUE_FAMILY_GRAPHICS],
+	const VkImageSubresourceRange colorRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	std::vector<TransientImageRequest> gBufferRequests
+	{
+		{VK_FORMAT_R8G8B8A8_UNORM, gBufferUsage, colorRange, "DRT GBuffer Albedo"},
+		{VK_FORMAT_R32G32B32A32_SFLOAT, gBufferUsage, colorRange, "DRT GBuffer Position"},
+		{VK_FORMAT_R32G32B32A32_SFLOAT, gBufferUsage, colorRange, "DRT GBuffer Normal"},
+		{VK_FORMAT_R8G8B8A8_UNORM, gBufferUsage, colorRange, "DRT GBuffer Material"},
 	};
-	
-	VkResult result;
-	std::tie(result, myGBuffer.albedo) =
-		imageAllocator.RequestImage2D(allocSubID,nullptr,0,imageInfo);
-	imageInfo.format = VK_FORMAT_R32G32B32A32_SFLOAT;
-	std::tie(result, myGBuffer.normal) =
-		imageAllocator.RequestImage2D(allocSubID, nullptr, 0, imageInfo);
-	std::tie(result, myGBuffer.position) =
-		imageAllocator.RequestImage2D(allocSubID, nullptr, 0, imageInfo);
-	imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-	std::tie(result, myGBuffer.material) =
-		imageAllocator.RequestImage2D(allocSubID, nullptr, 0, imageInfo);
+	VkResult result = renderPassFactory.AllocateTransientImages(gBufferRequests, {sw, sh}, {this, 0, 1});
+	assert(!result && "failed allocating gbuffer");
+	myGBuffer.albedo = gBufferRequests[0].view;
+	myGBuffer.position = gBufferRequests[1].view;
+	myGBuffer.normal = gBufferRequests[2].view;
+	myGBuffer.material = gBufferRequests[3].view;
+	for (uint32_t imageIndex = 0; imageIndex < myGBuffer.images.size(); ++imageIndex)
+	{
+		myGBuffer.images[imageIndex] = gBufferRequests[imageIndex].image;
+	}
 
 	
 	// GBUFFER DESCRIPTORS
@@ -111,7 +105,7 @@ DeferredRayTracer::DeferredRayTracer(
 
 	// WRITE DESCRIPTOR SETS
 	VkDescriptorImageInfo imageDescInfo = {};
-	imageDescInfo.imageLayout = imageInfo.layout;
+	imageDescInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 	VkWriteDescriptorSet write = {};
 	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
@@ -161,6 +155,7 @@ DeferredRayTracer::DeferredRayTracer(
 		sceneGlobals,
 		renderPassFactory,
 		myGBuffer,
+		{this, 0, 0},
 		familyIndices);
 	myRayTracer = std::make_shared<RayTracer>(
 		vulkanFramework,
@@ -233,6 +228,7 @@ DeferredRayTracer::RecordSubmit(
 
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &cmdBuffer;
+		// the frame graph makes it wait on the geo submission
 		submitInfo.pWaitDstStageMask = myRTWaitStages.data();
 		submitInfo.pWaitSemaphores = waitSemaphores.data();
 		submitInfo.waitSemaphoreCount = 0;
@@ -253,6 +249,14 @@ std::vector<rflx::Features> DeferredRayTracer::GetImplementedFeatures() const
 	return {rflx::Features::FEATURE_RAY_TRACING};
 }
 
+std::vector<ResourceUse> DeferredRayTracer::GetResourceUses() const
+{
+	// the gbuffer is passed between its own submissions, only the traced storage image leaves it
+	return {
+		theirImageHandler.GetImagesUse(ResourceAccess::ReadWrite),
+		theirRenderPassFactory.GetTransientUse()};
+}
+
 std::array<VkFence, NumSwapchainImages> DeferredRayTracer::GetFences()
 {
 	return myGeoCmdBufferFences;
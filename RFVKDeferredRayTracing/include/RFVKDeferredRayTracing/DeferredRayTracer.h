@@ -26,12 +26,16 @@ public:
 	std::vector<rflx::Features>					GetImplementedFeatures() const override;
 	std::array<VkFence, NumSwapchainImages>		GetFences() override;
 	int											GetSubmissionCount() override { return 2; }
+	std::vector<ResourceUse>					GetResourceUses() const override;
+	const char*									GetName() const override { return "DeferredRayTracer"; }
 
 	void										AddSchedule(neat::ThreadID threadID) override { myWorkScheduler.AddSchedule(threadID); }
 	MeshRenderSchedule							myWorkScheduler;
 
 private:
 	VulkanFramework&								theirVulkanFramework;
+	ImageHandler&									theirImageHandler;
+	RenderPassFactory&								theirRenderPassFactory;
 
 	VkDescriptorPool								myDescriptorPool = nullptr;
 	GBuffer											myGBuffer = {};
@@ -4,6 +4,8 @@
 #include "RFVK/Image/ImageHandler.h"
 #include "RFVK/Memory/BufferAllocator.h"
 #include "RFVK/Mesh/MeshHandler.h"
+#include "RFVK/Pipelines/CommandRecorder.h"
+#include "RFVK/Pipelines/PipelineReloader.h"
 #include "RFVK/Scene/SceneGlobals.h"
 #include "RFVK/Shader/Shader.h"
 #include "RFVK/VulkanFramework.h"
@@ -50,51 +52,38 @@ RayTracer::RayTracer(
 	props.pNext = &rtProps;
 	vkGetPhysicalDeviceProperties2(theirVulkanFramework.GetPhysicalDevice(), &props);
 
-	RTPipelineBuilder builder;
-	builder.AddDescriptorSet(theirSceneGlobals.GetGlobalsLayout());
-	builder.AddDescriptorSet(theirImageHandler.GetSamplerSetLayout());
-	builder.AddDescriptorSet(theirImageHandler.GetImageSetLayout());
-	builder.AddDescriptorSet(theirAccStructHandler.GetInstanceStructuresLayout());
-	builder.AddDescriptorSet(theirMeshHandler.GetMeshDataLayout());
-	builder.AddDescriptorSet(myGBuffer.layout);
-	
-	builder.AddShaderGroup(0, ShaderGroupType::RayGen);
-	builder.AddShaderGroup(1, ShaderGroupType::Miss);
-	builder.AddShaderGroup(2, ShaderGroupType::Miss);
-	builder.AddShaderGroup(3, ShaderGroupType::ClosestHit);
-	builder.AddShader(myOpaqueShader);
+	auto constructPipeline = [this, rtProps](Shader* shader)
+	{
+		RTPipelineBuilder builder;
+		builder.AddDescriptorSet(theirSceneGlobals.GetGlobalsLayout());
+		builder.AddDescriptorSet(theirImageHandler.GetSamplerSetLayout());
+		builder.AddDescriptorSet(theirImageHandler.GetImageSetLayout());
+		builder.AddDescriptorSet(theirAccStructHandler.GetInstanceStructuresLayout());
+		builder.AddDescriptorSet(theirMeshHandler.GetMeshDataLayout());
+		builder.AddDescriptorSet(myGBuffer.layout);
+
+		builder.AddShaderGroup(0, ShaderGroupType::RayGen);
+		builder.AddShaderGroup(1, ShaderGroupType::Miss);
+		builder.AddShaderGroup(2, ShaderGroupType::Miss);
+		builder.AddShaderGroup(3, ShaderGroupType::ClosestHit);
+		builder.AddShader(shader);
+		return builder.Construct(theirVulkanFramework.GetDevice(), theirVulkanFramework.GetPipelineCache(), rtProps);
+	};
 	VkResult result;
-	std::tie(result, myPipeline) = builder.Construct(theirVulkanFramework.GetDevice(), rtProps);
+	std::tie(result, myPipeline) = constructPipeline(myOpaqueShader.get());
 	assert(!result && "failed creating ray tracing pipeline");
+	theirVulkanFramework.GetPipelineReloader().Register(myPipeline, *myOpaqueShader, 0, constructPipeline, [this](const Pipeline& pipeline)
+	{
+		SwapShaderBindingTables(pipeline);
+	});
 
-	uint32_t shaderProgramSize = rtProps.shaderGroupBaseAlignment;
 	uint32_t shaderHandleAlignment = rtProps.shaderGroupHandleAlignment;
 	uint32_t shaderHandleSize = rtProps.shaderGroupHandleSize;
-	uint32_t alignedSize = AlignedSize(shaderHandleSize, shaderHandleAlignment);
+	myAlignedHandleSize = AlignedSize(shaderHandleSize, shaderHandleAlignment);
 	auto allocSub = theirBufferAllocator.Start();
 
 	// SHADER BINDING TABLE
-	myShaderBindingTables[0] =
-		CreateShaderBindingTable(
-			allocSub,
-			alignedSize,
-			0,
-			1,
-			myPipeline.pipeline);
-	myShaderBindingTables[1] =
-		CreateShaderBindingTable(
-			allocSub,
-			alignedSize,
-			1,
-			2,
-			myPipeline.pipeline);
-	myShaderBindingTables[2] =
-		CreateShaderBindingTable(
-			allocSub,
-			alignedSize,
-			3,
-			1,
-			myPipeline.pipeline);
+	CreateShaderBindingTables(allocSub, myPipeline.pipeline);
 
 	// STORE IMAGE
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
@@ -119,6 +108,7 @@ RayTracer::RayTracer(
 
 RayTracer::~RayTracer()
 {
+	theirVulkanFramework.GetPipelineReloader().Unregister(myPipeline);
 	//vkDestroyPipeline(theirVulkanFramework.GetDevice(), myPipeline.pipeline, nullptr);
 	//vkDestroyPipelineLayout(theirVulkanFramework.GetDevice(), myPipeline.layout, nullptr);
 	//vkDestroyBuffer(theirVulkanFramework.GetDevice(), mySBTBuffer, nullptr);
@@ -151,23 +141,16 @@ RayTracer::Record(
 
 	theirAccStructHandler.UpdateInstanceStructure(swapchainIndex, myInstancesID, myInstances);
 
-	vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, myPipeline.pipeline);
+	CommandRecorder recorder(cmdBuffer);
+	recorder.BindPipeline(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, myPipeline.pipeline);
 
 	// DESCRIPTORS
-	theirSceneGlobals.BindGlobals(cmdBuffer, myPipeline.layout, 0, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
-	theirImageHandler.BindSamplers(cmdBuffer, myPipeline.layout, 1, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
-	theirImageHandler.BindImages(swapchainIndex, cmdBuffer, myPipeline.layout, 2, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
-	theirAccStructHandler.BindInstanceStructures(swapchainIndex, cmdBuffer, myPipeline.layout, 3);
-	theirMeshHandler.BindMeshData(swapchainIndex, cmdBuffer, myPipeline.layout, 4, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
-	vkCmdBindDescriptorSets(
-		cmdBuffer,
-		VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
-		myPipeline.layout,
-		5,
-		1,
-		&myGBuffer.set,
-		0,
-		nullptr);
+	theirSceneGlobals.BindGlobals(recorder, myPipeline.layout, 0, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	theirImageHandler.BindSamplers(recorder, myPipeline.layout, 1, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	theirImageHandler.BindImages(swapchainIndex, recorder, myPipeline.layout, 2, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	theirAccStructHandler.BindInstanceStructures(swapchainIndex, recorder, myPipeline.layout, 3);
+	theirMeshHandler.BindMeshData(swapchainIndex, recorder, myPipeline.layout, 4, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+	recorder.BindDescriptorSet(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, myPipeline.layout, 5, myGBuffer.set);
 
 	auto [w, h] = theirVulkanFramework.GetTargetResolution();
 	VkStridedDeviceAddressRegionKHR callableStride = {};
@@ -180,6 +163,36 @@ RayTracer::Record(
 		uint32_t(w), uint32_t(h), 1);
 }
 
+void
+RayTracer::CreateShaderBindingTables(
+	AllocationSubmissionID	allocSubID,
+	VkPipeline				pipeline)
+{
+	myShaderBindingTables[0] = CreateShaderBindingTable(allocSubID, myAlignedHandleSize, 0, 1, pipeline);
+	myShaderBindingTables[1] = CreateShaderBindingTable(allocSubID, myAlignedHandleSize, 1, 2, pipeline);
+	myShaderBindingTables[2] = CreateShaderBindingTable(allocSubID, myAlignedHandleSize, 3, 1, pipeline);
+}
+
+void
+RayTracer::SwapShaderBindingTables(
+	const Pipeline& pipeline)
+{
+	// group handles belong to the pipeline, the old tables go once no frame in flight traces with them
+	const auto doneSignal = std::make_shared<std::counting_semaphore<NumSwapchainImages>>(0);
+	for (auto& table : myShaderBindingTables)
+	{
+		theirBufferAllocator.QueueDestroy(std::move(table.buffer), doneSignal);
+	}
+	theirVulkanFramework.GetPipelineReloader().Retire([doneSignal]()
+	{
+		doneSignal->release(NumSwapchainImages);
+	});
+
+	auto allocSub = theirBufferAllocator.Start();
+	CreateShaderBindingTables(allocSub, pipeline.pipeline);
+	theirBufferAllocator.Queue(std::move(allocSub));
+}
+
 ShaderBindingTable
 RayTracer::CreateShaderBindingTable(
 	AllocationSubmissionID	allocSubID,
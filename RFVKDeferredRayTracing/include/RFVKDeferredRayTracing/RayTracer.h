@@ -25,6 +25,10 @@ public:
 								assembledWork);
 
 private:
+	void								CreateShaderBindingTables(
+		AllocationSubmissionID	allocSubID,
+		VkPipeline				pipeline);
+	void								SwapShaderBindingTables(const Pipeline& pipeline);
 	ShaderBindingTable					CreateShaderBindingTable(
 		AllocationSubmissionID	allocSubID,
 		size_t					handleSize,
@@ -47,6 +51,7 @@ private:
 	std::shared_ptr<class Shader>		myOpaqueShader;
 
 	std::array<ShaderBindingTable, 3>	myShaderBindingTables;
+	uint32_t							myAlignedHandleSize = 0;
 
 	InstanceStructID					myInstancesID = InstanceStructID(-1);
 	RTInstances							myInstances;
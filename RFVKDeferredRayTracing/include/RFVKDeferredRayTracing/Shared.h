@@ -9,6 +9,8 @@ struct GBuffer
 	VkImageView				position;
 	VkImageView				normal;
 	VkImageView				material;
+	// in the same order as the views
+	std::array<VkImage, 4>	images;
 	VkDescriptorSetLayout	layout;
 	VkDescriptorSet			set;
 };
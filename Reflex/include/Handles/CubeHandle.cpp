@@ -16,10 +16,16 @@ float rflx::CubeHandle::GetDim() const
 void
 rflx::CubeHandle::SetAsSkybox() const
 {
+	if (gImageHandler->GetGeneration(myID) != myGeneration)
+	{
+		LOG("setting skybox through a cube handle whose cube was removed");
+		return;
+	}
 	gSceneGlobals->SetSkybox(myID);
 }
 
 rflx::CubeHandle::CubeHandle(CubeID	id)
 : myID(id)
+, myGeneration(gImageHandler->GetGeneration(id))
 {
 }
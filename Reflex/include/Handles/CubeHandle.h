@@ -17,7 +17,8 @@ namespace rflx
 	private:
 				CubeHandle(CubeID id);
 
-		CubeID	myID;
+		CubeID		myID;
+		uint32_t	myGeneration;
 
 	};
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "RFVK/Scene/SceneGlobals.h"
 #include "RFVK/Image/ImageHandler.h"
+#include "RFVK/Image/AtlasHandler.h"
 #include "RFVK/Mesh/MeshHandler.h"
 #include "RFVK/Text/FontHandler.h"
 #include "RFVK/Image/CubeFilterer.h"
@@ -13,6 +14,7 @@
 inline std::shared_ptr<SceneGlobals>					gSceneGlobals;
 inline std::shared_ptr<MeshHandler>						gMeshHandler;
 inline std::shared_ptr<ImageHandler>					gImageHandler;
+inline std::shared_ptr<AtlasHandler>					gAtlasHandler;
 inline std::shared_ptr<FontHandler>						gFontHandler;
 inline std::shared_ptr<CubeFilterer>					gCubeFilterer;
 inline std::shared_ptr<AccelerationStructureHandler>	gAccStructHandler;
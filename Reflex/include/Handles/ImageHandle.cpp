@@ -24,6 +24,11 @@ rflx::ImageHandle::GetLayers() const
 void
 rflx::ImageHandle::Load() const
 {
+	if (gImageHandler->GetGeneration(myID) != myGeneration)
+	{
+		LOG("loading through an image handle whose image was removed");
+		return;
+	}
 	const int threadID = int(theirReflex.GetThreadID());
 	gImageHandler->LoadImage2D(myID, gAllocationSubmissionIDs[threadID], myPath);
 }
@@ -31,6 +36,11 @@ rflx::ImageHandle::Load() const
 void
 rflx::ImageHandle::Unload() const
 {
+	if (gImageHandler->GetGeneration(myID) != myGeneration)
+	{
+		LOG("unloading through an image handle whose image was removed");
+		return;
+	}
 	gImageHandler->UnloadImage2D(myID);
 }
 
@@ -40,6 +50,7 @@ rflx::ImageHandle::ImageHandle(
 	std::string path)
 	: theirReflex(reflex)
 	, myID(id)
+	, myGeneration(gImageHandler->GetGeneration(id))
 	, myPath(path)
 {
 }
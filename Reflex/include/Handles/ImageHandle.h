@@ -25,6 +25,7 @@ namespace rflx
 
 		Reflex&		theirReflex;
 		ImageID		myID;
+		uint32_t	myGeneration;
 		std::string	myPath;
 
 	};
@@ -12,12 +12,22 @@ MeshID rflx::MeshHandle::GetID() const
 void
 rflx::MeshHandle::Load() const
 {
+	if (gMeshHandler->GetGeneration(myMeshID) != myGeneration)
+	{
+		LOG("loading through a mesh handle whose mesh was removed");
+		return;
+	}
 	gMeshHandler->LoadMesh(myMeshID, gAllocationSubmissionIDs[int(theirReflex.GetThreadID())], myPath);
 	gAccStructHandler->LoadGeometryStructure(myGeoID, gAllocationSubmissionIDs[int(theirReflex.GetThreadID())], (*gMeshHandler)[myMeshID].geo);
 }
 
 void rflx::MeshHandle::Unload() const
 {
+	if (gMeshHandler->GetGeneration(myMeshID) != myGeneration)
+	{
+		LOG("unloading through a mesh handle whose mesh was removed");
+		return;
+	}
 	gMeshHandler->UnloadMesh(myMeshID);
 	gAccStructHandler->UnloadGeometryStructure(myGeoID);
 }
@@ -30,6 +40,7 @@ rflx::MeshHandle::MeshHandle(
 	: theirReflex(reflex)
 	, myMeshID(id)
 	, myGeoID(geoID)
+	, myGeneration(gMeshHandler->GetGeneration(id))
 	, myPath(std::move(path))
 {
 }
@@ -24,6 +24,7 @@ namespace rflx
 		Reflex&			theirReflex;
 		MeshID			myMeshID;
 		GeoStructID		myGeoID;
+		uint32_t		myGeneration;
 		std::string		myPath;
 
 	};
@@ -8,15 +8,21 @@
 #include "RFVK/Image/ImageHandler.h"
 #include "RFVK/Mesh/MeshHandler.h"
 #include "RFVK/Mesh/MeshRenderCommand.h"
+#include "RFVK/Presenter/Presenter.h"
 #include "RFVK/Ray Tracing/AccelerationStructureHandler.h"
 #include "RFVK/Ray Tracing/RTMeshRenderer.h"
+#include "RFVK/Shader/ShaderCache.h"
 #include "RFVK/Sprite/SpriteRenderer.h"
 #include "RFVK/Text/FontHandler.h"
+#include "RFVK/Text/UTF8.h"
 #include "Handles/CubeHandle.h"
 #include "Handles/ImageHandle.h"
 #include "RFVK/Memory/AllocatorBase.h"
 #include "RFVKDeferredRayTracing/DeferredRayTracer.h"
 
+#include <algorithm>
+#include <chrono>
+
 #ifdef _DEBUG
 #pragma comment(lib, "RFVK_Debugx64.lib")
 #pragma comment(lib, "RFVKDeferredRayTracing_Debugx64.lib")
@@ -50,6 +56,7 @@ rflx::Reflex::~Reflex()
 		gSceneGlobals = nullptr;
 		gMeshHandler = nullptr;
 		gImageHandler = nullptr;
+		gAtlasHandler = nullptr;
 		gFontHandler = nullptr;
 		gCubeFilterer = nullptr;
 		gAccStructHandler = nullptr;
@@ -77,16 +84,21 @@ rflx::Reflex::Start(
 		return true;
 	}
 	
-	assert(IsWindow((HWND)hWND) && "invalid window handle passed");
+	const auto startTime = std::chrono::high_resolution_clock::now();
 
 	bool useDebugLayers = false;
+	bool headless = !hWND;
 	if (cmdArgs)
 	{
 		useDebugLayers = std::string(cmdArgs).find("vkdebug") != std::string::npos;
+		headless |= std::string(cmdArgs).find("headless") != std::string::npos;
 	}
+#ifdef _WIN32
+	assert((headless || IsWindow((HWND)hWND)) && "invalid window handle passed");
+#endif
 
 	ourVKImplementation = new VulkanImplementation;
-	const auto result = ourVKImplementation->Initialize(myThreadID, hWND, windowRes, useDebugLayers);
+	const auto result = ourVKImplementation->Initialize(myThreadID, headless ? nullptr : hWND, windowRes, useDebugLayers);
 	if (result)
 	{
 		return false;
@@ -112,8 +124,8 @@ rflx::Reflex::Start(
 
 	auto tr = std::make_shared<SpriteRenderer>(
 		ourVKImplementation->myVulkanFramework,
-		*ourVKImplementation->mySceneGlobals,
 		*ourVKImplementation->myImageHandler,
+		*ourVKImplementation->myFontHandler,
 		*ourVKImplementation->myRenderPassFactory,
 		*ourVKImplementation->myUniformHandler,
 		ourVKImplementation->myQueueFamilyIndices);
@@ -149,12 +161,17 @@ rflx::Reflex::Start(
 	gAccStructHandler = ourVKImplementation->myAccStructHandler;
 	//gRTMeshRenderer = rtmr;
 	gImageHandler = ourVKImplementation->myImageHandler;
+	gAtlasHandler = ourVKImplementation->myAtlasHandler;
 	gCubeFilterer = ourVKImplementation->myCubeFilterer;
 	gSpriteRenderer = tr;
 	gFontHandler = ourVKImplementation->myFontHandler;
 	gDeferredRayTracer = drt;
 
 	gVulkanFramework = &ourVKImplementation->myVulkanFramework;
+	gVulkanFramework->GetShaderCache().Save();
+
+	using ms = std::chrono::duration<float, std::milli>;
+	LOG("startup took", ms(std::chrono::high_resolution_clock::now() - startTime).count(), "ms");
 	return true;
 }
 
@@ -183,6 +200,13 @@ rflx::Reflex::EndFrame()
 	ourVKImplementation->EndFrame();
 }
 
+bool
+rflx::Reflex::ReadFrame(
+	std::vector<PixelValue>& outPixels)
+{
+	return ourVKImplementation->myPresenter->ReadFrame(outPixels);
+}
+
 rflx::MeshHandle
 rflx::Reflex::CreateMesh(
 	const std::string&			path,
@@ -224,18 +248,117 @@ rflx::Reflex::CreateImage(
 {
 	tiling = tiling; // TODO: IMPLEMENT
 	std::vector<uint8_t> dataAligned(data.size() * 4);
-	memcpy(dataAligned.data(), data.data(), data.size() * sizeof PixelValue);
+	memcpy(dataAligned.data(), data.data(), data.size() * sizeof(PixelValue));
 	float dim = sqrtf(float(data.size()));
 	const ImageID id = gImageHandler->AddImage2D();
 	gImageHandler->LoadImage2D(id, gAllocationSubmissionIDs[int(myThreadID)], std::move(dataAligned), { dim, dim });
 	return ImageHandle(*this, id, "");
 }
 
+AtlasImageID
+rflx::Reflex::CreateAtlasImage(
+	const std::string& path)
+{
+	return gAtlasHandler->AddImage(path);
+}
+
+FontID
+rflx::Reflex::LoadFont(
+	const std::string&	path,
+	bool				signedDistance)
+{
+	return gFontHandler->AddFont(path.c_str(), signedDistance ? FontMode::SDF : FontMode::Bitmap);
+}
+
 neat::ThreadID rflx::Reflex::GetThreadID() const
 {
 	return myThreadID;
 }
 
+void
+rflx::Reflex::SetTextureBudget(
+	uint64_t numBytes)
+{
+	gImageHandler->GetTextureStreamer().SetBudget(numBytes);
+}
+
+uint64_t
+rflx::Reflex::GetResidentTextureBytes() const
+{
+	return gImageHandler->GetTextureStreamer().GetResidentBytes();
+}
+
+uint32_t
+rflx::Reflex::GetPendingTextureStreams() const
+{
+	return gImageHandler->GetTextureStreamer().GetNumPendingRequests();
+}
+
+uint64_t
+rflx::Reflex::GetFrameHeapAllocations() const
+{
+	return ourVKImplementation->GetFrameHeapAllocations();
+}
+
+bool
+rflx::Reflex::WriteProfile(
+	const std::string& path)
+{
+	std::vector<neat::ProfileEvent> events;
+	neat::Profiler::Collect(events);
+	if (!neat::Profiler::WriteChromeTrace(path.c_str(), events))
+	{
+		LOG("failed writing profile to", path);
+		return false;
+	}
+	return true;
+}
+
+void
+rflx::Reflex::PushProfilerOverlay(
+	FontID			fontID,
+	const Vec3f&	position,
+	float			scale,
+	const Vec4f&	color)
+{
+	constexpr uint32_t MaxOverlayLines = 32;
+
+	myOverlayCpuEvents.clear();
+	myOverlayGpuEvents.clear();
+	ourVKImplementation->CollectFrameProfile(myOverlayCpuEvents, myOverlayGpuEvents);
+
+	auto byBegin = [](const neat::ProfileEvent& a, const neat::ProfileEvent& b)
+	{
+		return a.beginNs < b.beginNs;
+	};
+	std::sort(myOverlayCpuEvents.begin(), myOverlayCpuEvents.end(), byBegin);
+	std::sort(myOverlayGpuEvents.begin(), myOverlayGpuEvents.end(), byBegin);
+
+	// one line per zone, nested zones follow the zone they are in
+	myOverlayText.clear();
+	uint32_t numLines = 0;
+	char line[128];
+	auto appendLines = [&](const char* prefix, const std::vector<neat::ProfileEvent>& events)
+	{
+		for (auto& event : events)
+		{
+			if (numLines++ >= MaxOverlayLines)
+			{
+				return;
+			}
+			snprintf(line, sizeof line, "%s %s %.2f ms\n", prefix, event.name ? event.name : "unnamed", double(event.endNs - event.beginNs) / 1000000.0);
+			myOverlayText += line;
+		}
+	};
+	appendLines("cpu", myOverlayCpuEvents);
+	appendLines("gpu", myOverlayGpuEvents);
+
+	if (!myOverlayText.empty())
+	{
+		PushRenderCommand(fontID, myOverlayText.c_str(), position, scale, color);
+	}
+}
+
 rflx::CubeHandle
 rflx::Reflex::CreateImageCube(
 	const std::string& path)
@@ -256,6 +379,7 @@ rflx::Reflex::BeginPush()
 	//gRTMeshRenderer->myWorkScheduler.BeginPush(myThreadID);
 	gMeshRenderer->myWorkScheduler.BeginPush(myThreadID);
 	gSpriteRenderer->myWorkScheduler.BeginPush(myThreadID);
+	gSpriteRenderer->myTextWorkScheduler.BeginPush(myThreadID);
 	gDeferredRayTracer->myWorkScheduler.BeginPush(myThreadID);
 
 	AllocationSubmissionID id = ourVKImplementation->myAllocationSubmitter->StartAllocSubmission(myThreadID);
@@ -272,6 +396,7 @@ rflx::Reflex::EndPush()
 	//gRTMeshRenderer->myWorkScheduler.EndPush(myThreadID);
 	gMeshRenderer->myWorkScheduler.EndPush(myThreadID);
 	gSpriteRenderer->myWorkScheduler.EndPush(myThreadID);
+	gSpriteRenderer->myTextWorkScheduler.EndPush(myThreadID);
 	gDeferredRayTracer->myWorkScheduler.EndPush(myThreadID);
 
 	ourVKImplementation->myAllocationSubmitter->QueueAllocSubmission(std::move(gAllocationSubmissionIDs[int(myThreadID)]));
@@ -301,48 +426,78 @@ rflx::Reflex::PushRenderCommand(
 void
 rflx::Reflex::PushRenderCommand(
 	FontID			fontID,
-	const char* text,
-	const Vec3f& position,
+	const char*		text,
+	const Vec3f&	position,
 	float			scale,
-	const Vec4f& color)
+	const Vec4f&	color,
+	const Vec4f&	outlineColor,
+	float			outlineWidth,
+	const Vec4f&	shadowColor,
+	const Vec2f&	shadowOffset)
 {
-
-
 	auto [tw, th] = gVulkanFramework->GetTargetResolution();
-	float ratio = th / tw;
-	float colOffset = 0;
-	float rowOffset = 0;
-	for (int charIndex = 0; charIndex < 128; ++charIndex)
+	const float ratio = th / tw;
+	const uint32_t pixelSize = FontHandler::SelectPixelSize(scale * th);
+
+	// unchanged strings reuse their layout and expand on the render side
+	const TextLayoutID layoutID = gFontHandler->GetLayoutCache().GetLayout(fontID, text, pixelSize);
+	if (!BAD_ID(layoutID))
 	{
-		if (text[charIndex] == '\0')
-		{
-			break;
-		}
+		TextRenderCommand cmd{};
+		cmd.layoutID = layoutID;
+		cmd.position = { position.x, position.y };
+		cmd.scale = scale;
+		cmd.color = color;
+		cmd.outlineColor = outlineColor;
+		cmd.outlineWidth = outlineWidth;
+		cmd.shadowColor = shadowColor;
+		cmd.shadowOffset = shadowOffset;
+		gSpriteRenderer->myTextWorkScheduler.PushWork(myThreadID, cmd);
+		return;
+	}
+
+	// layout cache is full, lay out per glyph
+	gFontHandler->PrepareGlyphs(fontID, text, pixelSize);
 
-		if (text[charIndex] == '\n')
+	Vec2f pen = {0, 0};
+	uint32_t prevGlyphIndex = 0;
+	const char* cursor = text;
+	while (const uint32_t codepoint = DecodeUTF8(cursor))
+	{
+		if (codepoint == '\n')
 		{
-			colOffset = 0;
-			rowOffset += scale;
+			pen.x = 0;
+			pen.y += scale;
+			prevGlyphIndex = 0;
 			continue;
 		}
 
-		Font font = (*gFontHandler)[fontID];
-		SpriteRenderCommand cmd{};
-		cmd.imgArrID = font.imgArrID;
-		cmd.imgArrIndex = text[charIndex] - FirstFontGlyph;
-
-		GlyphMetrics metrics = font.metrics[cmd.imgArrIndex];
-		metrics.xStride *= scale;
-		metrics.yOffset *= scale;
-		cmd.position = { position.x + colOffset * ratio, position.y + metrics.yOffset + rowOffset };
+		const Glyph glyph = gFontHandler->GetGlyph(fontID, codepoint, pixelSize);
+		pen.x += gFontHandler->GetKerning(fontID, prevGlyphIndex, glyph.glyphIndex, pixelSize) * scale;
+		prevGlyphIndex = glyph.glyphIndex;
 
-		cmd.pivot = { 0, -1 };
-		cmd.color = color;
-		cmd.scale = { scale, scale };
-
-		colOffset += metrics.xStride;
+		if (!BAD_ID(glyph.imageID))
+		{
+			SpriteRenderCommand cmd{};
+			cmd.imgArrID = glyph.imageID;
+			cmd.imgArrIndex = 0;
+			cmd.uvRect = glyph.uvRect;
+			cmd.position = {
+				position.x + (pen.x + glyph.bearing.x * scale) * ratio,
+				position.y + pen.y + (glyph.size.y - glyph.bearing.y) * scale};
+			cmd.pivot = { 0, -1 };
+			cmd.color = color;
+			cmd.scale = glyph.size * scale;
+			cmd.signedDistance = glyph.signedDistance;
+			cmd.outlineColor = outlineColor;
+			cmd.outlineWidth = outlineWidth;
+			cmd.shadowColor = shadowColor;
+			cmd.shadowOffset = shadowOffset;
+
+			gSpriteRenderer->myWorkScheduler.PushWork(myThreadID, cmd);
+		}
 
-		gSpriteRenderer->myWorkScheduler.PushWork(myThreadID, cmd);
+		pen.x += glyph.advance * scale;
 	}
 }
 
@@ -367,6 +522,32 @@ rflx::Reflex::PushRenderCommand(
 	gSpriteRenderer->myWorkScheduler.PushWork(myThreadID, cmd);
 }
 
+void
+rflx::Reflex::PushRenderCommand(
+	AtlasImageID	id,
+	Vec2f			position,
+	Vec2f			scale,
+	Vec2f			pivot,
+	Vec4f			color)
+{
+	const AtlasImage image = (*gAtlasHandler)[id];
+	if (BAD_ID(image.imageID))
+	{
+		return;
+	}
+
+	SpriteRenderCommand cmd{};
+	cmd.imgArrID = image.imageID;
+	cmd.imgArrIndex = 0;
+	cmd.uvRect = image.uvRect;
+	cmd.position = { position.x * my2DScaleRef.x, position.y * my2DScaleRef.y };
+	cmd.scale = scale * image.scale;
+	cmd.pivot = pivot;
+	cmd.color = color;
+
+	gSpriteRenderer->myWorkScheduler.PushWork(myThreadID, cmd);
+}
+
 void
 rflx::Reflex::SetView(
 	const Vec3f& position,
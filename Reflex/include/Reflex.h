@@ -10,6 +10,7 @@ using Mat3f = glm::mat3x3;
 using Mat4f = glm::mat4x4;
 
 #include "neat/General/Thread.h"
+#include "neat/Misc/Profiler.h"
 #include "RFVK/Features.h"
 #include "RFVK/Misc/Identities.h"
 #include "Handles/MeshHandle.h"
@@ -27,6 +28,7 @@ namespace rflx
 										Reflex(neat::ThreadID threadID);
 										~Reflex();
 
+		// a null window or "headless" in cmdArgs renders offscreen, fetch frames with ReadFrame
 		bool							Start(
 											void*			hWND, 
 											const Vec2ui&	windowRes, 
@@ -36,6 +38,8 @@ namespace rflx
 		void							BeginFrame();
 		void							Submit();
 		void							EndFrame();
+		// pixels of the last submitted frame, top row first, false unless headless
+		bool							ReadFrame(std::vector<PixelValue>& outPixels);
 
 		void							BeginPush();
 		void							EndPush();
@@ -47,10 +51,14 @@ namespace rflx
 											float				rotation = 0);
 		void							PushRenderCommand(
 											FontID			fontID,
-											const char* text,
-											const Vec3f& position,
+											const char*		text,
+											const Vec3f&	position,
 											float			scale,
-											const Vec4f& color);
+											const Vec4f&	color,
+											const Vec4f&	outlineColor = { 0,0,0,0 },
+											float			outlineWidth = 0,
+											const Vec4f&	shadowColor = { 0,0,0,0 },
+											const Vec2f&	shadowOffset = { 0,0 });
 		void							PushRenderCommand(
 											ImageHandle		handle,
 											uint32_t		subImg,
@@ -58,6 +66,12 @@ namespace rflx
 											Vec2f			scale,
 											Vec2f			pivot = { 0,0 },
 											Vec4f			color = { 1,1,1,1 });
+		void							PushRenderCommand(
+											AtlasImageID	id,
+											Vec2f			position,
+											Vec2f			scale,
+											Vec2f			pivot = { 0,0 },
+											Vec4f			color = { 1,1,1,1 });
 
 		void							SetView(
 											const Vec3f&	position,
@@ -68,6 +82,21 @@ namespace rflx
 											Vec2f			coefficient);
 
 		neat::ThreadID					GetThreadID() const;
+
+		void							SetTextureBudget(uint64_t numBytes);
+		uint64_t						GetResidentTextureBytes() const;
+		uint32_t						GetPendingTextureStreams() const;
+		// heap allocations made on this thread during the last frame, always zero unless neat counts them
+		uint64_t						GetFrameHeapAllocations() const;
+		// every zone the profiler still holds as chrome trace json, for chrome://tracing or ui.perfetto.dev
+		bool							WriteProfile(const std::string& path);
+		// zone times of the last frame through the text path, gpu times are a few frames older
+		// push from the thread running the frames, between BeginPush and EndPush
+		void							PushProfilerOverlay(
+											FontID			fontID,
+											const Vec3f&	position,
+											float			scale,
+											const Vec4f&	color = { 1,1,1,1 });
 		
 		CubeHandle						CreateImageCube(
 											const std::string& path);
@@ -77,6 +106,11 @@ namespace rflx
 		ImageHandle						CreateImage(
 											std::vector<PixelValue>&& pixelData, 
 											Vec2f tiling = { 1,1 });
+		AtlasImageID					CreateAtlasImage(
+											const std::string& path);
+		FontID							LoadFont(
+											const std::string& path,
+											bool signedDistance = false);
 		MeshHandle						CreateMesh(
 											const std::string& path,
 											std::vector<class ImageHandle>&& imgHandles = {});
@@ -84,6 +118,9 @@ namespace rflx
 	private:
 		neat::ThreadID					myThreadID;
 		Vec2f							my2DScaleRef = {};
+		std::vector<neat::ProfileEvent>	myOverlayCpuEvents;
+		std::vector<neat::ProfileEvent>	myOverlayGpuEvents;
+		std::string						myOverlayText;
 
 	};
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "pch.h"
+
+#include "RFVK/Shader/ShaderBundle.h"
+#include "RFVK/Shader/ShaderCache.h"
+#include "RFVK/Shader/VKCompile.h"
+
+// compiles every shader under the shader directory into one bundle, run from the directory the engine runs in
+// each stage also gets every permutation of its DeclaredShaderFeatures and those recorded in the permutations file
+// usage: ShaderCompiler [shader directory] [bundle path] [permutations path]
+
+struct CompileJob
+{
+	std::string						path;
+	std::string						preAmble;
+	std::vector<ShaderDependency>	dependencies;
+	std::vector<uint32_t>			binary;
+};
+
+static bool
+IsShaderStage(
+	const std::filesystem::path& path)
+{
+	constexpr const char* stageExtensions[]
+	{
+		".vert", ".frag", ".comp", ".rgen", ".rint", ".rahit", ".rchit", ".rmiss", ".rcall"
+	};
+	const std::string extension = path.extension().string();
+	for (const char* stageExtension : stageExtensions)
+	{
+		if (extension == stageExtension)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+Compile(
+	CompileJob& job)
+{
+	// DEPENDENCIES
+	std::string preprocessed;
+	std::vector<std::string> includes;
+	if (!VKPreprocess(job.path.c_str(), ShaderTargetVulkan, ShaderTargetSpv, job.preAmble.c_str(), preprocessed, includes))
+	{
+		return false;
+	}
+	includes.insert(includes.begin(), job.path);
+	for (const auto& include : includes)
+	{
+		ShaderDependency dependency;
+		dependency.path = ShaderBundle::Name(include.c_str());
+		if (!ShaderCache::HashFile(dependency.path, dependency.contentHash))
+		{
+			LOG("failed reading shader dependency", dependency.path);
+		}
+		job.dependencies.emplace_back(std::move(dependency));
+	}
+
+	// COMPILE
+	job.binary = VKCompile(job.path.c_str(), ShaderTargetVulkan, ShaderTargetSpv, job.preAmble.c_str(), true);
+	return !job.binary.empty();
+}
+
+int
+main(
+	int		argc,
+	char**	argv)
+{
+	const char* shaderDirectory = argc > 1 ? argv[1] : ShaderDirectory;
+	const char* bundlePath = argc > 2 ? argv[2] : ShaderBundlePath;
+	const char* permutationsPath = argc > 3 ? argv[3] : ShaderPermutationsPath;
+
+	// BASE PERMUTATIONS
+	std::vector<CompileJob> jobs;
+	const std::string basePreAmble = ShaderCache::PreAmble();
+	std::error_code error;
+	for (const auto& file : std::filesystem::recursive_directory_iterator(shaderDirectory, error))
+	{
+		if (!file.is_regular_file() || !IsShaderStage(file.path()))
+		{
+			continue;
+		}
+		CompileJob job;
+		job.path = ShaderBundle::Name(file.path().string().c_str());
+		job.preAmble = basePreAmble;
+		jobs.emplace_back(std::move(job));
+	}
+	if (error)
+	{
+		LOG("failed reading shader directory \"", shaderDirectory, "\",", error.message());
+		return 1;
+	}
+
+	// FEATURE PERMUTATIONS
+	// what the renderers declare, plus what debug runs recorded for shaders outside the engine
+	std::set<std::pair<std::string, std::string>> queued;
+	for (const auto& job : jobs)
+	{
+		queued.emplace(job.path, job.preAmble);
+	}
+	auto permutations = ShaderCache::DeclaredPermutations();
+	for (auto& record : ShaderCache::LoadPermutations(permutationsPath))
+	{
+		permutations.emplace_back(std::move(record));
+	}
+	for (auto& record : permutations)
+	{
+		CompileJob job;
+		job.path = ShaderBundle::Name(record.path.c_str());
+		job.preAmble = ShaderCache::PreAmble(record.features);
+		if (!std::filesystem::exists(job.path))
+		{
+			LOG("skipping permutation of \"", job.path, "\", no such shader");
+			continue;
+		}
+		if (queued.emplace(job.path, job.preAmble).second)
+		{
+			jobs.emplace_back(std::move(job));
+		}
+	}
+
+	std::atomic<uint32_t> numFailed = 0;
+	neat::ParallelFor(0, jobs.size(), [&jobs, &numFailed](size_t jobIndex)
+	{
+		if (!Compile(jobs[jobIndex]))
+		{
+			++numFailed;
+		}
+	});
+	if (numFailed)
+	{
+		LOG(uint32_t(numFailed), "of", jobs.size(), "shaders failed, bundle not written");
+		return 1;
+	}
+
+	ShaderBundle bundle;
+	for (auto& job : jobs)
+	{
+		bundle.Add(job.path.c_str(), job.preAmble, std::move(job.dependencies), job.binary);
+	}
+	if (!bundle.Save(bundlePath))
+	{
+		return 1;
+	}
+	LOG("wrote", bundle.GetNumEntries(), "shaders to \"", bundlePath, "\"");
+	return 0;
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+#include "RFVK/SharedPrecompiled.h"
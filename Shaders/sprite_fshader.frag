@@ -0,0 +1,20 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout(set = 0, binding = 0) uniform sampler samplers[SET_SAMPLERS_COUNT];
+layout(set = 1, binding = 0) uniform texture2DArray images[SAMPLED_IMAGE_2D_ARRAY_COUNT];
+
+layout(location = 0) in vec2 inUV;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) flat in uint inImgArrID;
+layout(location = 3) flat in uint inImgArrIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+	// glyph pages are single channel, swizzled to white with coverage in alpha
+	vec4 texel = texture(sampler2DArray(images[nonuniformEXT(inImgArrID)], samplers[0]), vec3(inUV, inImgArrIndex));
+	outColor = texel * inColor;
+}
@@ -0,0 +1,58 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout(set = 0, binding = 0) uniform sampler samplers[SET_SAMPLERS_COUNT];
+layout(set = 1, binding = 0) uniform texture2DArray images[SAMPLED_IMAGE_2D_ARRAY_COUNT];
+
+layout(location = 0) in vec2 inUV;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec4 inOutlineColor;
+layout(location = 3) in vec4 inShadowColor;
+layout(location = 4) flat in vec4 inUVRect;
+layout(location = 5) flat in vec2 inShadowOffset;
+layout(location = 6) flat in uint inImgArrID;
+layout(location = 7) flat in float inOutlineWidth;
+
+// the spread the glyph pages were generated with, specialized by the pipeline
+layout(constant_id = 0) const uint SDF_SPREAD = 6;
+const float spread = float(SDF_SPREAD);
+
+layout(location = 0) out vec4 outColor;
+
+float SampleDistance(vec2 uv)
+{
+	// glyph pages are single channel, swizzled so the field is in alpha
+	return texture(sampler2DArray(images[nonuniformEXT(inImgArrID)], samplers[0]), vec3(uv, 0)).a;
+}
+
+// straight alpha to match the blend state
+vec4 Over(vec4 top, vec4 bottom)
+{
+	float alpha = top.a + bottom.a * (1.0 - top.a);
+	vec3 color = (top.rgb * top.a + bottom.rgb * bottom.a * (1.0 - top.a)) / max(alpha, 1e-4);
+	return vec4(color, alpha);
+}
+
+void main()
+{
+	// 0.5 is the outline, one unit of the field is 2 * spread texels
+	// outline width and shadow offset are in field texels and can't reach past the spread
+	float dist = SampleDistance(inUV);
+	float smoothing = max(fwidth(dist) * 0.5, 1e-4);
+	float outlineEdge = 0.5 - clamp(inOutlineWidth, 0.0, spread) / (2.0 * spread);
+
+	float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, dist);
+	float outline = smoothstep(outlineEdge - smoothing, outlineEdge + smoothing, dist);
+	vec4 text = Over(
+		vec4(inColor.rgb, inColor.a * fill),
+		vec4(inOutlineColor.rgb, inOutlineColor.a * outline));
+
+	// SHADOW
+	vec2 texelSize = 1.0 / vec2(textureSize(sampler2DArray(images[nonuniformEXT(inImgArrID)], samplers[0]), 0).xy);
+	vec2 shadowUV = clamp(inUV - inShadowOffset * texelSize, inUVRect.xy, inUVRect.xy + inUVRect.zw);
+	float shadowDist = SampleDistance(shadowUV);
+	float shadowAlpha = inShadowColor.a * smoothstep(outlineEdge - smoothing, outlineEdge + smoothing, shadowDist);
+
+	outColor = Over(text, vec4(inShadowColor.rgb, shadowAlpha));
+}
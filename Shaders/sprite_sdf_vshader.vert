@@ -0,0 +1,64 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+
+struct SDFSpriteInstance
+{
+	vec4	uvRect;
+	vec4	color;
+	vec4	outlineColor;
+	vec4	shadowColor;
+	vec2	pos;
+	vec2	pivot;
+	vec2	scale;
+	vec2	shadowOffset;
+	float	imgArrID;
+	float	outlineWidth;
+	float	padding0;
+	float	padding1;
+};
+
+// height over width of the target, pushed per draw instead of binding the globals
+layout(push_constant) uniform DrawConstants
+{
+	float	aspectRatio;
+} draw;
+
+layout(set = 2, binding = 0) uniform Instances
+{
+	SDFSpriteInstance instances[MAX_NUM_SDF_SPRITE_INSTANCES];
+};
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outColor;
+layout(location = 2) out vec4 outOutlineColor;
+layout(location = 3) out vec4 outShadowColor;
+layout(location = 4) flat out vec4 outUVRect;
+layout(location = 5) flat out vec2 outShadowOffset;
+layout(location = 6) flat out uint outImgArrID;
+layout(location = 7) flat out float outOutlineWidth;
+
+const vec2 corners[6] = vec2[](
+	vec2(0, 0), vec2(1, 0), vec2(0, 1),
+	vec2(0, 1), vec2(1, 0), vec2(1, 1));
+
+void main()
+{
+	SDFSpriteInstance instance = instances[gl_InstanceIndex];
+	vec2 corner = corners[gl_VertexIndex];
+
+	// scales are in screen height units
+	vec2 scale = instance.scale;
+	scale.x *= draw.aspectRatio;
+
+	vec2 vertex = instance.pos + (corner + instance.pivot) * scale;
+	gl_Position = vec4(vertex, 0, 1);
+
+	outUV = instance.uvRect.xy + corner * instance.uvRect.zw;
+	outColor = instance.color;
+	outOutlineColor = instance.outlineColor;
+	outShadowColor = instance.shadowColor;
+	outUVRect = instance.uvRect;
+	outShadowOffset = instance.shadowOffset;
+	outImgArrID = uint(instance.imgArrID);
+	outOutlineWidth = instance.outlineWidth;
+}
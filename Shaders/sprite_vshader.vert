@@ -0,0 +1,52 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+
+struct SpriteInstance
+{
+	vec4	uvRect;
+	vec4	color;
+	vec2	pos;
+	vec2	pivot;
+	vec2	scale;
+	float	imgArrID;
+	float	imgArrIndex;
+};
+
+// height over width of the target, pushed per draw instead of binding the globals
+layout(push_constant) uniform DrawConstants
+{
+	float	aspectRatio;
+} draw;
+
+layout(set = 2, binding = 0) uniform Instances
+{
+	SpriteInstance instances[MAX_NUM_SPRITE_INSTANCES];
+};
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outColor;
+layout(location = 2) flat out uint outImgArrID;
+layout(location = 3) flat out uint outImgArrIndex;
+
+const vec2 corners[6] = vec2[](
+	vec2(0, 0), vec2(1, 0), vec2(0, 1),
+	vec2(0, 1), vec2(1, 0), vec2(1, 1));
+
+void main()
+{
+	SpriteInstance instance = instances[gl_InstanceIndex];
+	vec2 corner = corners[gl_VertexIndex];
+
+	// scales are in screen height units
+	vec2 scale = instance.scale;
+	scale.x *= draw.aspectRatio;
+
+	vec2 vertex = instance.pos + (corner + instance.pivot) * scale;
+	gl_Position = vec4(vertex, 0, 1);
+
+	// glyphs and atlas entries are sub rects of their image, whole images use {0, 0, 1, 1}
+	outUV = instance.uvRect.xy + corner * instance.uvRect.zw;
+	outColor = instance.color;
+	outImgArrID = uint(instance.imgArrID);
+	outImgArrIndex = uint(instance.imgArrIndex);
+}
@@ -2,11 +2,36 @@
 //
 
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <latch>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#ifdef _WIN32
+#include <concurrent_queue.h>
+#include <concurrent_unordered_map.h>
+#endif
 
+#include "neat/Containers/concurrent_map.h"
+#include "neat/Containers/concurrent_queue.h"
 #include "neat/Containers/static_vector.h"
 #include "neat/Image/DDSReader.h"
+#include "neat/Misc/AllocationCounter.h"
+#include "neat/Misc/AtlasPacker.h"
+#include "neat/Misc/FrameArena.h"
+#include "neat/Misc/IDKeeper.h"
+#include "neat/Misc/Profiler.h"
 
 #ifdef _DEBUG
 #pragma comment(lib, "neat_Debugx64.lib")
@@ -16,10 +41,514 @@
 
 #include "neat/Image/ImageReader.h"
 
+namespace
+{
+	template<typename Func>
+	double
+	MeasureMs(
+		Func&& func)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	// runs work(threadIndex) on threads that are all started before the clock and released together
+	template<typename Func>
+	double
+	MeasureThreadsMs(
+		uint32_t	numThreads,
+		Func&&		work)
+	{
+		std::latch start(numThreads + 1);
+		std::vector<std::thread> threads;
+		for (uint32_t thread = 0; thread < numThreads; ++thread)
+		{
+			threads.emplace_back([&start, &work, thread]()
+			{
+				start.arrive_and_wait();
+				work(thread);
+			});
+		}
+		return MeasureMs([&]()
+		{
+			start.arrive_and_wait();
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		});
+	}
+
+	// the baseline off windows, where ppl isn't there to compare against
+	template<typename t>
+	class LockedQueue
+	{
+	public:
+		void push(const t& item)
+		{
+			std::scoped_lock lock(myMutex);
+			myQueue.push(item);
+		}
+		bool try_pop(t& outItem)
+		{
+			std::scoped_lock lock(myMutex);
+			if (myQueue.empty())
+			{
+				return false;
+			}
+			outItem = myQueue.front();
+			myQueue.pop();
+			return true;
+		}
+
+	private:
+		std::mutex		myMutex;
+		std::queue<t>	myQueue;
+	};
+
+	template<typename key, typename value>
+	class LockedMap
+	{
+	public:
+		value& operator[](const key& k)
+		{
+			std::scoped_lock lock(myMutex);
+			return myMap[k];
+		}
+
+	private:
+		std::mutex						myMutex;
+		std::unordered_map<key, value>	myMap;
+	};
+
+	// half the threads push, the other half pop until everything pushed came out
+	template<typename Queue>
+	void
+	BenchmarkQueue(
+		const char*	name,
+		uint32_t	numThreads)
+	{
+		constexpr uint32_t numItemsPerProducer = 1 << 16;
+		const uint32_t numProducers = numThreads / 2;
+		const uint64_t numItems = uint64_t(numItemsPerProducer) * numProducers;
+
+		Queue queue;
+		std::atomic<uint64_t> numPopped = 0;
+		const double ms = MeasureThreadsMs(numThreads, [&](uint32_t thread)
+		{
+			if (thread < numProducers)
+			{
+				for (uint32_t item = 0; item < numItemsPerProducer; ++item)
+				{
+					queue.push(int(item));
+				}
+				return;
+			}
+			int item;
+			while (numPopped.load(std::memory_order_relaxed) < numItems)
+			{
+				if (queue.try_pop(item))
+				{
+					numPopped.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+
+		std::cout << name << " queue, " << numThreads << " threads: "
+			<< ms * 1e6 / double(numItems) << " ns per push and pop\n";
+	}
+
+	// every thread looks up its own key, the thread keyed state the maps hold in rfvk
+	template<typename Map>
+	void
+	BenchmarkMap(
+		const char*	name,
+		uint32_t	numThreads)
+	{
+		constexpr uint32_t numLookups = 1 << 16;
+
+		Map map;
+		const double ms = MeasureThreadsMs(numThreads, [&map](uint32_t thread)
+		{
+			for (uint32_t lookup = 0; lookup < numLookups; ++lookup)
+			{
+				++map[thread];
+			}
+		});
+
+		std::cout << name << " map, " << numThreads << " threads: "
+			<< ms * 1e6 / (double(numLookups) * numThreads) << " ns per lookup\n";
+	}
+
+	// lowest free id behind a lock, how ids were handed out before the lock free free list
+	class LockedIDKeeper
+	{
+	public:
+		LockedIDKeeper(
+			unsigned numIDSlots)
+		{
+			for (unsigned id = 0; id < numIDSlots; ++id)
+			{
+				myFreeIDs.push(int(id));
+			}
+		}
+		int FetchFreeID()
+		{
+			std::scoped_lock lock(myMutex);
+			if (myFreeIDs.empty())
+			{
+				return INVALID_ID;
+			}
+			const int id = myFreeIDs.top();
+			myFreeIDs.pop();
+			return id;
+		}
+		void ReturnID(int id)
+		{
+			std::scoped_lock lock(myMutex);
+			myFreeIDs.push(id);
+		}
+
+	private:
+		std::mutex													myMutex;
+		std::priority_queue<int, std::vector<int>, std::greater<>>	myFreeIDs;
+	};
+
+	// every thread holds a few ids at a time, like handles being created and released while loading
+	template<typename Keeper>
+	void
+	BenchmarkIDKeeper(
+		const char*	name,
+		uint32_t	numThreads)
+	{
+		constexpr uint32_t numRounds = 1 << 14;
+		constexpr uint32_t numHeld = 4;
+
+		Keeper keeper(1024);
+		const double ms = MeasureThreadsMs(numThreads, [&keeper](uint32_t)
+		{
+			std::array<int, numHeld> ids;
+			for (uint32_t round = 0; round < numRounds; ++round)
+			{
+				for (auto& id : ids)
+				{
+					id = keeper.FetchFreeID();
+				}
+				for (auto& id : ids)
+				{
+					if (!BAD_ID(id))
+					{
+						keeper.ReturnID(id);
+					}
+				}
+			}
+		});
+
+		std::cout << name << " id keeper, " << numThreads << " threads: "
+			<< ms * 1e6 / (double(numRounds) * numHeld * numThreads) << " ns per fetch and return\n";
+	}
+
+	void
+	BenchmarkIDKeepers()
+	{
+		for (uint32_t numThreads : {1u, 2u, 4u, 8u, 16u})
+		{
+			BenchmarkIDKeeper<IDKeeper<int>>("lock free", numThreads);
+			BenchmarkIDKeeper<LockedIDKeeper>("locked", numThreads);
+		}
+	}
+
+	struct BenchmarkSubmission
+	{
+		void*		cmdBuffer;
+		uint64_t	signalValue;
+		uint32_t	queueFamily;
+	};
+
+	// returned by value like the RecordSubmit results
+	template<typename Vector>
+	Vector
+	RecordSubmissions(
+		uint32_t numSubmissions)
+	{
+		Vector submissions;
+		for (uint32_t submission = 0; submission < numSubmissions; ++submission)
+		{
+			submissions.push_back({ nullptr, submission, submission % 3 });
+		}
+		return submissions;
+	}
+
+	// a frame records its submissions and copies them into a wait list, as SubmitWorkerCmds does
+	template<typename Vector>
+	void
+	BenchmarkVector(
+		const char* name)
+	{
+		constexpr int numFrames = 1 << 14;
+		constexpr uint32_t numSubmissions = 16;
+
+		uint64_t checksum = 0;
+		const uint64_t numAllocationsBefore = neat::GetNumHeapAllocations();
+		const double ms = MeasureMs([&checksum]()
+		{
+			for (int frame = 0; frame < numFrames; ++frame)
+			{
+				Vector submissions = RecordSubmissions<Vector>(numSubmissions);
+				Vector waits = submissions;
+				checksum += waits[int(waits.size()) - 1].signalValue + submissions.size();
+			}
+		});
+		const uint64_t numAllocations = neat::GetNumHeapAllocations() - numAllocationsBefore;
+
+		std::cout << name << ": " << ms * 1e6 / numFrames << " ns per frame";
+		if (neat::IsCountingHeapAllocations())
+		{
+			std::cout << ", " << double(numAllocations) / numFrames << " allocations per frame";
+		}
+		std::cout << " (" << checksum << ")\n";
+	}
+
+	void
+	BenchmarkVectors()
+	{
+		BenchmarkVector<std::vector<BenchmarkSubmission>>("std::vector");
+		BenchmarkVector<neat::static_vector<BenchmarkSubmission, 16>>("static_vector");
+		BenchmarkVector<neat::static_vector<BenchmarkSubmission, 8, true>>("static_vector spilling to heap");
+	}
+
+	// the per frame work the renderer hands to neat, once warmed up a frame must not touch the heap
+	bool
+	TestZeroFrameAllocations()
+	{
+		if (!neat::IsCountingHeapAllocations())
+		{
+			std::cout << "zero frame allocations: skipped, neat is built without NEAT_COUNT_ALLOCATIONS\n";
+			return true;
+		}
+
+		constexpr int numWarmupFrames = 4;
+		constexpr int numFrames = 64;
+
+		neat::concurrent_queue<int> queue;
+		neat::concurrent_map<uint32_t, uint64_t> map;
+		IDKeeper<int> keeper(64);
+		map[0] = 0;
+
+		auto frame = [&queue, &map, &keeper]()
+		{
+			PROFILE_ZONE("Frame");
+
+			auto submissions = RecordSubmissions<neat::static_vector<BenchmarkSubmission, 16>>(16);
+			auto waits = submissions;
+
+			// grows well past the arena's first block so the overflow merge is covered too
+			neat::frame_vector<uint32_t> transient(neat::GetFrameResource());
+			for (uint32_t item = 0; item < 32 * 1024; ++item)
+			{
+				transient.push_back(item);
+			}
+
+			// the texture streamer's candidate sort, the per frame path in RFVK that runs on the arena
+			neat::frame_vector<std::tuple<uint32_t, uint32_t, float>> candidates(neat::GetFrameResource());
+			for (uint32_t image = 0; image < 256; ++image)
+			{
+				candidates.emplace_back(image, 1024u >> (image % 8), float((image * 37) % 256));
+			}
+			std::ranges::sort(candidates, [](const auto& left, const auto& right)
+			{
+				return std::get<2>(left) > std::get<2>(right);
+			});
+
+			queue.push(int(waits.size()));
+			int popped;
+			queue.try_pop(popped);
+			++map[0];
+			keeper.ReturnID(keeper.FetchFreeID());
+
+			neat::FrameArena::EndFrame();
+		};
+
+		for (int warmup = 0; warmup < numWarmupFrames; ++warmup)
+		{
+			frame();
+		}
+		const uint64_t numAllocationsBefore = neat::GetNumHeapAllocations();
+		for (int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+		{
+			frame();
+		}
+		const uint64_t numAllocations = neat::GetNumHeapAllocations() - numAllocationsBefore;
+
+		std::cout << "zero frame allocations: " << numAllocations << " allocations in " << numFrames << " frames, "
+			<< (numAllocations ? "FAILED" : "passed") << "\n";
+		return !numAllocations;
+	}
+
+	void
+	BenchmarkConcurrentContainers()
+	{
+		for (uint32_t numThreads : {2u, 4u, 8u})
+		{
+			BenchmarkQueue<neat::concurrent_queue<int>>("neat", numThreads);
+#ifdef _WIN32
+			BenchmarkQueue<concurrency::concurrent_queue<int>>("ppl", numThreads);
+#endif
+			BenchmarkQueue<LockedQueue<int>>("locked", numThreads);
+		}
+		for (uint32_t numThreads : {1u, 4u, 8u})
+		{
+			BenchmarkMap<neat::concurrent_map<uint32_t, uint64_t>>("neat", numThreads);
+#ifdef _WIN32
+			BenchmarkMap<concurrency::concurrent_unordered_map<uint32_t, uint64_t>>("ppl", numThreads);
+#endif
+			BenchmarkMap<LockedMap<uint32_t, uint64_t>>("locked", numThreads);
+		}
+	}
+
+	// glyph and sprite sized rects into one 2048 page until it's full, the atlas handler's worst case
+	void
+	BenchmarkAtlasPacking()
+	{
+		constexpr uint32_t pageDim = 2048;
+		constexpr int numRuns = 32;
+
+		std::mt19937 random(1337);
+		std::uniform_int_distribution<uint32_t> sizes(8, 96);
+		std::vector<std::pair<uint32_t, uint32_t>> rects(8192);
+		for (auto& [width, height] : rects)
+		{
+			width = sizes(random);
+			height = sizes(random);
+		}
+
+		neat::AtlasPacker packer(pageDim, pageDim);
+		size_t numPacked = 0;
+		const double ms = MeasureMs([&]()
+		{
+			for (int run = 0; run < numRuns; ++run)
+			{
+				packer.Clear();
+				numPacked = 0;
+				for (auto& [width, height] : rects)
+				{
+					numPacked += std::get<0>(packer.Pack(width, height));
+				}
+			}
+		});
+
+		std::cout << "atlas packing: " << numPacked << " of " << rects.size() << " rects per page, "
+			<< packer.GetOccupancy() * 100.f << "% occupancy, "
+			<< ms * 1e6 / (double(numRuns) * rects.size()) << " ns per pack\n";
+	}
+
+	// SpriteInstance from SpriteRenderer.h, RFVK can't be linked here
+	struct BenchmarkSpriteInstance
+	{
+		float	uvRect[4];
+		float	color[4];
+		float	pos[2];
+		float	pivot[2];
+		float	scale[2];
+		float	imgArrID;
+		float	imgArrIndex;
+	};
+
+	struct BenchmarkAtlasImage
+	{
+		uint32_t	page;
+		float		uvRect[4];
+	};
+
+	// atlas sprites resolved to their page and rect and written out as instances, the cpu side of every sprite drawn
+	void
+	BenchmarkSpriteThroughput()
+	{
+		constexpr uint32_t pageDim = 2048;
+		constexpr uint32_t numImages = 2048;
+		constexpr uint32_t numSpritesPerFrame = 1024;
+		constexpr int numFrames = 1 << 11;
+
+		// PACK
+		std::mt19937 random(1337);
+		std::uniform_int_distribution<uint32_t> sizes(8, 96);
+		std::vector<BenchmarkAtlasImage> atlasImages;
+		neat::AtlasPacker packer(pageDim, pageDim);
+		uint32_t numPages = 1;
+		for (uint32_t image = 0; image < numImages; ++image)
+		{
+			const uint32_t width = sizes(random);
+			const uint32_t height = sizes(random);
+			auto [isPacked, x, y] = packer.Pack(width, height);
+			if (!isPacked)
+			{
+				packer.Clear();
+				++numPages;
+				std::tie(isPacked, x, y) = packer.Pack(width, height);
+			}
+			atlasImages.push_back({numPages - 1, {
+				float(x) / pageDim, float(y) / pageDim, float(width) / pageDim, float(height) / pageDim}});
+		}
+
+		std::uniform_int_distribution<uint32_t> imageIDs(0, numImages - 1);
+		std::vector<uint32_t> commands(numSpritesPerFrame);
+		for (auto& imageID : commands)
+		{
+			imageID = imageIDs(random);
+		}
+
+		// DRAW
+		// the atlas handler locks its table per lookup
+		std::mutex atlasMutex;
+		std::vector<BenchmarkSpriteInstance> instances(numSpritesPerFrame);
+		float checksum = 0;
+		const double ms = MeasureMs([&]()
+		{
+			for (int frame = 0; frame < numFrames; ++frame)
+			{
+				for (uint32_t sprite = 0; sprite < numSpritesPerFrame; ++sprite)
+				{
+					BenchmarkAtlasImage atlasImage;
+					{
+						std::scoped_lock lock(atlasMutex);
+						atlasImage = atlasImages[commands[sprite]];
+					}
+					auto& instance = instances[sprite];
+					std::copy(std::begin(atlasImage.uvRect), std::end(atlasImage.uvRect), instance.uvRect);
+					std::fill(std::begin(instance.color), std::end(instance.color), 1.f);
+					instance.pos[0] = float(sprite % 32) / 16.f - 1.f;
+					instance.pos[1] = float(sprite / 32) / 16.f - 1.f;
+					instance.pivot[0] = 0.f;
+					instance.pivot[1] = 0.f;
+					instance.scale[0] = instance.uvRect[2];
+					instance.scale[1] = instance.uvRect[3];
+					instance.imgArrID = float(atlasImage.page);
+					instance.imgArrIndex = 0.f;
+				}
+				checksum += instances[frame % numSpritesPerFrame].imgArrID;
+			}
+		});
+
+		std::cout << "sprite throughput: " << numImages << " images on " << numPages << " atlas pages, "
+			<< ms * 1e6 / (double(numFrames) * numSpritesPerFrame) << " ns per sprite, "
+			<< double(numFrames) * numSpritesPerFrame / ms / 1000.0 << " million sprites per second"
+			<< " (" << checksum << ")\n";
+	}
+}
+
 int main()
 {
 	neat::Image image = neat::ReadImage("test.tga");
 
+	const bool isPassing = TestZeroFrameAllocations();
+
+	BenchmarkAtlasPacking();
+	BenchmarkSpriteThroughput();
+	BenchmarkConcurrentContainers();
+	BenchmarkIDKeepers();
+	BenchmarkVectors();
+
 	int val = 0;
+	return isPassing ? 0 : 1;
 }
-
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace neat
+{
+	// hash map split into shards, each behind its own mutex
+	// made for small maps such as per thread state, threads looking up different keys rarely share a lock
+	// a plain mutex is cheaper to take than a shared one and lookups are too short to gain from shared readers
+	// elements are never erased, references handed out stay valid while other threads insert
+	template<typename key, typename value, unsigned num_shards = 8>
+	class concurrent_map
+	{
+	public:
+		typedef key key_type;
+		typedef value mapped_type;
+
+		// default constructs the value in place when the key is missing
+		value& operator[](const key& k);
+		// leaves an existing value untouched, returns whether the item was inserted
+		bool insert(const std::pair<key, value>& item);
+		bool contains(const key& k) const;
+
+		// visits every element under its shard's lock
+		template<typename func>
+		void for_each(func&& visit);
+
+	private:
+		struct alignas(64) shard
+		{
+			mutable std::mutex				mutex;
+			std::unordered_map<key, value>	map;
+		};
+
+		shard& shard_of(const key& k)
+		{
+			return _shards[std::hash<key>()(k) % num_shards];
+		}
+		const shard& shard_of(const key& k) const
+		{
+			return _shards[std::hash<key>()(k) % num_shards];
+		}
+
+		std::array<shard, num_shards> _shards;
+
+	};
+
+	template<typename key, typename value, unsigned num_shards>
+	inline value& concurrent_map<key, value, num_shards>::operator[](const key& k)
+	{
+		shard& s = shard_of(k);
+		std::scoped_lock<std::mutex> lock(s.mutex);
+		return s.map.try_emplace(k).first->second;
+	}
+
+	template<typename key, typename value, unsigned num_shards>
+	inline bool concurrent_map<key, value, num_shards>::insert(const std::pair<key, value>& item)
+	{
+		shard& s = shard_of(item.first);
+		std::scoped_lock<std::mutex> lock(s.mutex);
+		return s.map.insert(item).second;
+	}
+
+	template<typename key, typename value, unsigned num_shards>
+	inline bool concurrent_map<key, value, num_shards>::contains(const key& k) const
+	{
+		const shard& s = shard_of(k);
+		std::scoped_lock<std::mutex> lock(s.mutex);
+		return s.map.find(k) != s.map.end();
+	}
+
+	template<typename key, typename value, unsigned num_shards>
+	template<typename func>
+	inline void concurrent_map<key, value, num_shards>::for_each(func&& visit)
+	{
+		for (auto& s : _shards)
+		{
+			std::scoped_lock<std::mutex> lock(s.mutex);
+			for (auto& [k, v] : s.map)
+			{
+				visit(k, v);
+			}
+		}
+	}
+}
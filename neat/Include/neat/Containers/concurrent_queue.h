@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace neat
+{
+	// multi producer multi consumer fifo, a bounded lock free ring (vyukov) with a locked spill list
+	// pushes that find the ring full go to the spill, so push never fails or blocks on a slow consumer
+	// once anything has spilled, later pushes follow it into the spill until it drains to keep fifo order
+	// a consumer emptying the ring moves a batch of the spill back into it, so consumers rarely take the lock
+	template<typename t, unsigned capacity = 256>
+	class concurrent_queue
+	{
+		static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0, "concurrent_queue capacity must be a power of two");
+
+	public:
+		typedef t value_type;
+
+		concurrent_queue();
+		concurrent_queue(const concurrent_queue&) = delete;
+		concurrent_queue& operator=(const concurrent_queue&) = delete;
+		~concurrent_queue();
+
+		void push(const t& item);
+		void push(t&& item);
+		bool try_pop(t& out_item);
+
+		// only a snapshot while other threads push or pop
+		bool empty() const;
+
+	private:
+		static constexpr size_t cache_line = 64;
+		static constexpr size_t mask = capacity - 1;
+
+		// one cell per cache line, neighbouring producers and consumers don't invalidate each other
+		struct alignas(cache_line) cell
+		{
+			std::atomic<size_t> sequence;
+			alignas(t) unsigned char storage[sizeof(t)];
+		};
+
+		template<typename u>
+		bool try_push_ring(u&& item);
+		bool try_pop_ring(t& out_item);
+		void push_spill(t&& item);
+		bool pop_spill(t& out_item);
+
+		t* item_at(cell& c)
+		{
+			return std::launder(reinterpret_cast<t*>(c.storage));
+		}
+
+		alignas(cache_line) cell _cells[capacity];
+		alignas(cache_line) std::atomic<size_t> _enqueue_pos;
+		alignas(cache_line) std::atomic<size_t> _dequeue_pos;
+		alignas(cache_line) std::atomic<size_t> _num_spilled;
+		alignas(cache_line) std::mutex _spill_mutex;
+		std::deque<t> _spill;
+
+	};
+
+	template<typename t, unsigned capacity>
+	inline concurrent_queue<t, capacity>::concurrent_queue()
+		: _enqueue_pos(0)
+		, _dequeue_pos(0)
+		, _num_spilled(0)
+	{
+		for (size_t i = 0; i < capacity; ++i)
+		{
+			_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	template<typename t, unsigned capacity>
+	inline concurrent_queue<t, capacity>::~concurrent_queue()
+	{
+		const size_t end = _enqueue_pos.load(std::memory_order_relaxed);
+		for (size_t pos = _dequeue_pos.load(std::memory_order_relaxed); pos != end; ++pos)
+		{
+			item_at(_cells[pos & mask])->~t();
+		}
+	}
+
+	template<typename t, unsigned capacity>
+	inline void concurrent_queue<t, capacity>::push(const t& item)
+	{
+		if (_num_spilled.load(std::memory_order_acquire) == 0 && try_push_ring(item))
+		{
+			return;
+		}
+		push_spill(t(item));
+	}
+
+	template<typename t, unsigned capacity>
+	inline void concurrent_queue<t, capacity>::push(t&& item)
+	{
+		// the ring only moves from item once it has claimed a cell
+		if (_num_spilled.load(std::memory_order_acquire) == 0 && try_push_ring(std::move(item)))
+		{
+			return;
+		}
+		push_spill(std::move(item));
+	}
+
+	template<typename t, unsigned capacity>
+	inline bool concurrent_queue<t, capacity>::try_pop(t& out_item)
+	{
+		if (try_pop_ring(out_item))
+		{
+			return true;
+		}
+		if (_num_spilled.load(std::memory_order_acquire) == 0)
+		{
+			return false;
+		}
+		return pop_spill(out_item);
+	}
+
+	template<typename t, unsigned capacity>
+	inline bool concurrent_queue<t, capacity>::empty() const
+	{
+		return _dequeue_pos.load(std::memory_order_acquire) == _enqueue_pos.load(std::memory_order_acquire)
+			&& _num_spilled.load(std::memory_order_acquire) == 0;
+	}
+
+	template<typename t, unsigned capacity>
+	template<typename u>
+	inline bool concurrent_queue<t, capacity>::try_push_ring(u&& item)
+	{
+		size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell& c = _cells[pos & mask];
+			const size_t sequence = c.sequence.load(std::memory_order_acquire);
+			const intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+			if (diff == 0)
+			{
+				if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					new (c.storage) t(std::forward<u>(item));
+					c.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// the cell still holds an item from the previous lap
+				return false;
+			}
+			else
+			{
+				pos = _enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template<typename t, unsigned capacity>
+	inline bool concurrent_queue<t, capacity>::try_pop_ring(t& out_item)
+	{
+		size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell& c = _cells[pos & mask];
+			const size_t sequence = c.sequence.load(std::memory_order_acquire);
+			const intptr_t diff = intptr_t(sequence) - intptr_t(pos + 1);
+			if (diff == 0)
+			{
+				if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					t* item = item_at(c);
+					out_item = std::move(*item);
+					item->~t();
+					c.sequence.store(pos + capacity, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = _dequeue_pos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template<typename t, unsigned capacity>
+	inline void concurrent_queue<t, capacity>::push_spill(t&& item)
+	{
+		std::scoped_lock<std::mutex> lock(_spill_mutex);
+		_spill.push_back(std::move(item));
+		_num_spilled.fetch_add(1, std::memory_order_release);
+	}
+
+	template<typename t, unsigned capacity>
+	inline bool concurrent_queue<t, capacity>::pop_spill(t& out_item)
+	{
+		std::scoped_lock<std::mutex> lock(_spill_mutex);
+		// another consumer may have refilled the ring while this one waited, those items come first
+		if (try_pop_ring(out_item))
+		{
+			return true;
+		}
+		if (_spill.empty())
+		{
+			return false;
+		}
+		out_item = std::move(_spill.front());
+		_spill.pop_front();
+
+		// everything in the ring is older than the spill, so the oldest spilled items can follow it
+		size_t num_moved = 1;
+		while (num_moved < capacity / 2 && !_spill.empty() && try_push_ring(std::move(_spill.front())))
+		{
+			_spill.pop_front();
+			++num_moved;
+		}
+		_num_spilled.fetch_sub(num_moved, std::memory_order_release);
+		return true;
+	}
+}
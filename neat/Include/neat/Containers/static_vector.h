@@ -1,9 +1,14 @@
-
 #pragma once
 
 #include "neat/defines.h"
+#include <algorithm>
 #include <assert.h>
+#include <climits>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
 
 using long_int = long long int;
 
@@ -24,18 +29,22 @@ namespace neat
 		}
 	};
 
-	template<typename t, int width>
+	// vector with room for width items stored inside the object itself, no allocations unless it spills
+	// by default a full vector rejects further pushes, with spill_to_heap it moves to a growing heap buffer instead
+	template<typename t, int width, bool spill_to_heap = false>
 	class static_vector
 	{
+		static_assert(width > 0, "static_vector needs room for at least one item");
+
 	public:
 		typedef t value_type;
-		
+
 		static_vector();
 		static_vector(std::initializer_list<t> init_list);
-		static_vector(const static_vector<t, width>& copy_from);
-		static_vector& operator=(const static_vector<t, width>& copy_from);
-		static_vector(static_vector<t, width>&& move_from) noexcept;
-		static_vector& operator=(static_vector<t, width>&& move_from) noexcept;
+		static_vector(const static_vector& copy_from);
+		static_vector& operator=(const static_vector& copy_from);
+		static_vector(static_vector&& move_from) noexcept;
+		static_vector& operator=(static_vector&& move_from) noexcept;
 		~static_vector();
 
 		template< typename ... args >
@@ -43,27 +52,29 @@ namespace neat
 		template< typename ... args >
 		bool emplace_front(args&& ... params);
 
-		bool append(const static_vector<t, width>& other_vector);
+		bool append(const static_vector& other_vector);
 
+		bool push_back(const t& item);
 		bool push_back(t&& item);
+		bool push_front(const t& item);
 		bool push_front(t&& item);
 
+		// swaps the last item into the erased slot, order is not kept
 		bool erase(t* item);
 		bool erase(int index);
 		void clear();
 
 		void resize(unsigned new_size);
-		void resize(unsigned new_size, t value);
+		void resize(unsigned new_size, const t& value);
 
-		unsigned int size();
 		unsigned int size() const;
-		bool empty();
 		bool empty() const;
 
 		unsigned int max_size() const;
+		unsigned int capacity() const;
 
 		t* data();
-		t* data() const;
+		const t* data() const;
 		t& operator[](int index);
 		const t& operator[](int index) const;
 
@@ -71,266 +82,373 @@ namespace neat
 
 		t& front()
 		{
-			return _buffer[0];
+			assert(!empty() && "front of empty static_vector");
+			return data()[0];
+		}
+		const t& front() const
+		{
+			assert(!empty() && "front of empty static_vector");
+			return data()[0];
 		}
 		t& back()
 		{
-			return _buffer[(_size - 1) * !empty()];
+			assert(!empty() && "back of empty static_vector");
+			return data()[_size - 1];
+		}
+		const t& back() const
+		{
+			assert(!empty() && "back of empty static_vector");
+			return data()[_size - 1];
 		}
 		t* begin()
 		{
-			return _buffer;
+			return data();
 		}
 		t* end()
 		{
-			return &_buffer[_size];
+			return data() + _size;
 		}
-		t* begin() const
+		const t* begin() const
 		{
-			return _buffer;
+			return data();
 		}
-		t* end() const
+		const t* end() const
 		{
-			return &_buffer[_size];
+			return data() + _size;
 		}
 
 	private:
-		t* _buffer = nullptr;
+		t* inline_buffer()
+		{
+			return std::launder(reinterpret_cast<t*>(_buffer));
+		}
+		const t* inline_buffer() const
+		{
+			return std::launder(reinterpret_cast<const t*>(_buffer));
+		}
+		// makes room for one more item, false when full and not allowed to spill
+		bool make_room();
+		void release_heap();
+
+		alignas(t) unsigned char _buffer[width * sizeof(t)];
+		t* _heap = nullptr;
+		int _capacity = width;
 		int _size = 0;
 
 	};
 
-	template<typename t, int width>
-	inline static_vector<t, width>::static_vector()
+	template<typename t, int width, bool spill_to_heap>
+	inline static_vector<t, width, spill_to_heap>::static_vector()
 	{
-		//static_assert(std::is_trivially_copyable<t>::value && "static_vector only supports trivially copiable types");
-		_buffer = (t*)malloc(width * sizeof t);
+		// user provided so value initializing a vector does not zero the whole buffer
 	}
 
-	template<typename t, int width>
-	inline static_vector<t, width>::static_vector(std::initializer_list<t> init_list) : static_vector()
+	template<typename t, int width, bool spill_to_heap>
+	inline static_vector<t, width, spill_to_heap>::static_vector(std::initializer_list<t> init_list)
 	{
-		int size = 0;
-		for (int i = 0; i < init_list.size() && i < width; ++i)
+		for (const t& item : init_list)
 		{
-			_buffer[i] = init_list.begin()[i];
-			size++;
+			if (!push_back(item))
+			{
+				break;
+			}
 		}
-		_size = size;
 	}
 
-	template<typename t, int width>
-	inline static_vector<t, width>::static_vector(const static_vector<t, width>& copy_from) : static_vector()
+	template<typename t, int width, bool spill_to_heap>
+	inline static_vector<t, width, spill_to_heap>::static_vector(const static_vector& copy_from)
 	{
-		memcpy(_buffer, copy_from._buffer, width * sizeof t);
+		if (copy_from._size > width)
+		{
+			_heap = std::allocator<t>().allocate(copy_from._size);
+			_capacity = copy_from._size;
+		}
+		std::uninitialized_copy_n(copy_from.data(), copy_from._size, data());
 		_size = copy_from._size;
 	}
 
-	template <typename t, int width>
-	static_vector<t, width>& static_vector<t, width>::operator=(const static_vector<t, width>& copy_from)
+	template<typename t, int width, bool spill_to_heap>
+	inline static_vector<t, width, spill_to_heap>& static_vector<t, width, spill_to_heap>::operator=(const static_vector& copy_from)
 	{
-		memcpy(_buffer, copy_from._buffer, width * sizeof t);
+		if (this == &copy_from)
+		{
+			return *this;
+		}
+		clear();
+		if (copy_from._size > _capacity)
+		{
+			release_heap();
+			_heap = std::allocator<t>().allocate(copy_from._size);
+			_capacity = copy_from._size;
+		}
+		std::uninitialized_copy_n(copy_from.data(), copy_from._size, data());
 		_size = copy_from._size;
 		return *this;
 	}
 
-	template<typename t, int width>
-	inline static_vector<t, width>::static_vector(static_vector<t, width>&& move_from) noexcept
-		: _buffer(std::exchange(move_from._buffer, nullptr))
-		, _size(std::exchange(move_from._size, 0))
+	template<typename t, int width, bool spill_to_heap>
+	inline static_vector<t, width, spill_to_heap>::static_vector(static_vector&& move_from) noexcept
 	{
+		if (move_from._heap)
+		{
+			_heap = std::exchange(move_from._heap, nullptr);
+			_capacity = std::exchange(move_from._capacity, width);
+			_size = std::exchange(move_from._size, 0);
+			return;
+		}
+		std::uninitialized_move_n(move_from.data(), move_from._size, data());
+		_size = move_from._size;
+		move_from.clear();
 	}
 
-	template <typename t, int width>
-	static_vector<t, width>& static_vector<t, width>::operator=(static_vector<t, width>&& move_from) noexcept
+	template<typename t, int width, bool spill_to_heap>
+	inline static_vector<t, width, spill_to_heap>& static_vector<t, width, spill_to_heap>::operator=(static_vector&& move_from) noexcept
 	{
-		_buffer = std::exchange(move_from._buffer, nullptr);
-		_size = std::exchange(move_from._size, 0);
+		if (this == &move_from)
+		{
+			return *this;
+		}
+		clear();
+		release_heap();
+		if (move_from._heap)
+		{
+			_heap = std::exchange(move_from._heap, nullptr);
+			_capacity = std::exchange(move_from._capacity, width);
+			_size = std::exchange(move_from._size, 0);
+			return *this;
+		}
+		std::uninitialized_move_n(move_from.data(), move_from._size, data());
+		_size = move_from._size;
+		move_from.clear();
 		return *this;
 	}
 
-	template<typename t, int width>
-	inline static_vector<t, width>::~static_vector()
+	template<typename t, int width, bool spill_to_heap>
+	inline static_vector<t, width, spill_to_heap>::~static_vector()
 	{
-		SAFE_DELETE_ARRAY(_buffer);
+		clear();
+		release_heap();
 	}
 
-	template<typename t, int width>
+	template<typename t, int width, bool spill_to_heap>
 	template< typename ... args >
-	inline bool static_vector<t, width>::emplace_back(args&& ... params)
+	inline bool static_vector<t, width, spill_to_heap>::emplace_back(args&& ... params)
 	{
-		//t tmp(params...);
-		/*
-		const bool valid_op = ( this_back < width - 1 );
-
-		const size_t copy_size = valid_op * sizeof( t );
-		this_back += valid_op;
-		memcpy( &this_buffer[this_back], &tmp, copy_size );*/
-
-		return push_back(t(params...));
+		if (_size < _capacity)
+		{
+			new (data() + _size) t(std::forward<args>(params)...);
+			++_size;
+			return true;
+		}
+		if constexpr (!spill_to_heap)
+		{
+			return false;
+		}
+		else
+		{
+			// params may refer to an item of this vector, build it before the old buffer goes away
+			t item(std::forward<args>(params)...);
+			make_room();
+			new (data() + _size) t(std::move(item));
+			++_size;
+			return true;
+		}
 	}
 
-	template<typename t, int width>
+	template<typename t, int width, bool spill_to_heap>
 	template< typename ... args >
-	inline bool static_vector<t, width>::emplace_front(args&& ... params)
+	inline bool static_vector<t, width, spill_to_heap>::emplace_front(args&& ... params)
 	{
-		//t tmp(params...);
-		/*const bool valid_op = ( this_back < width - 1 );
-
-		const size_t push_size = valid_op * sizeof( t ) * ( this_back + 1 );
-		memmove( &this_buffer[1], this_buffer, push_size );
-
-		const size_t copy_size = valid_op * sizeof( t );
-		memcpy( &this_buffer[0], &params, copy_size );
-
-		this_back += valid_op;*/
-
-		return push_front(t(params...));
+		if (!emplace_back(std::forward<args>(params)...))
+		{
+			return false;
+		}
+		std::rotate(begin(), end() - 1, end());
+		return true;
 	}
 
-	template<typename t, int width>
-	inline bool static_vector<t, width>::append(const static_vector<t, width>& other_vector)
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::append(const static_vector& other_vector)
 	{
-		size_t szLeft = width - _size;
-		size_t copy_size = szLeft < other_vector.size() ? szLeft : other_vector.size();
-
-		memcpy(&_buffer[_size], &other_vector.data(), copy_size * sizeof t);
-		_size += copy_size;
-		
-		return !!copy_size;
+		bool appended = false;
+		for (int i = 0; i < other_vector._size; ++i)
+		{
+			if (!push_back(other_vector.data()[i]))
+			{
+				break;
+			}
+			appended = true;
+		}
+		return appended;
 	}
 
-	template<typename t, int width>
-	inline bool static_vector<t, width>::push_back(t&& item)
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::push_back(const t& item)
 	{
-		const bool valid_op = (_size < width);
-
-		const size_t copy_size = valid_op * sizeof(t);
-		memcpy(&_buffer[_size], &item, copy_size);
-		_size += valid_op;
-
-		return !!copy_size;
+		return emplace_back(item);
 	}
 
-	template<typename t, int width>
-	inline bool static_vector<t, width>::push_front(t&& item)
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::push_back(t&& item)
 	{
-		const bool valid_op = (_buffer < width);
-
-		const size_t push_size = valid_op * sizeof(t) * (_size);
-		memmove(&_buffer[1], _buffer, push_size);
-
-		const size_t copy_size = valid_op * sizeof(t);
-		memcpy(&_buffer[0], &item, copy_size);
+		return emplace_back(std::move(item));
+	}
 
-		_size += valid_op;
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::push_front(const t& item)
+	{
+		return emplace_front(item);
+	}
 
-		return !!copy_size || !!push_size;
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::push_front(t&& item)
+	{
+		return emplace_front(std::move(item));
 	}
 
-	template<typename t, int width>
-	inline bool static_vector<t, width>::erase(t* item)
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::erase(t* item)
 	{
-		const int index = item - _buffer;
+		const int index = int(item - data());
 		return erase(index);
 	}
 
-	template<typename t, int width>
-	inline bool static_vector<t, width>::erase(int index)
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::erase(int index)
 	{
-		const bool valid_op = (index > -1) & (index < _size);
-		memcpy(_buffer + index, _buffer + (_size - 1), sizeof(t) * valid_op);
-
-		_size -= valid_op;
-		return valid_op;
+		if (index < 0 || index >= _size)
+		{
+			return false;
+		}
+		t* items = data();
+		if (index != _size - 1)
+		{
+			items[index] = std::move(items[_size - 1]);
+		}
+		std::destroy_at(items + _size - 1);
+		--_size;
+		return true;
 	}
 
-	template<typename t, int width>
-	inline void static_vector<t, width>::clear()
+	template<typename t, int width, bool spill_to_heap>
+	inline void static_vector<t, width, spill_to_heap>::clear()
 	{
+		std::destroy_n(data(), _size);
 		_size = 0;
 	}
 
-	template<typename t, int width>
-	inline void static_vector<t, width>::resize(unsigned new_size)
+	template<typename t, int width, bool spill_to_heap>
+	inline void static_vector<t, width, spill_to_heap>::resize(unsigned new_size)
 	{
-		_size = new_size;
-
+		while (_size > int(new_size))
+		{
+			std::destroy_at(data() + --_size);
+		}
+		while (_size < int(new_size) && emplace_back())
+		{
+		}
 	}
 
-	template<typename t, int width>
-	inline void static_vector<t, width>::resize(unsigned new_size, t value)
+	template<typename t, int width, bool spill_to_heap>
+	inline void static_vector<t, width, spill_to_heap>::resize(unsigned new_size, const t& value)
 	{
-		int old_size = _size;
-		_size = new_size;
-		for (int i = old_size; i < new_size; ++i)
+		while (_size > int(new_size))
+		{
+			std::destroy_at(data() + --_size);
+		}
+		while (_size < int(new_size) && emplace_back(value))
 		{
-			_buffer[i] = value;
 		}
 	}
 
-	template<typename t, int width>
-	inline unsigned int static_vector<t, width>::size()
+	template<typename t, int width, bool spill_to_heap>
+	inline unsigned int static_vector<t, width, spill_to_heap>::size() const
 	{
 		return _size;
 	}
 
-	template<typename t, int width>
-	inline unsigned int static_vector<t, width>::size() const
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::empty() const
 	{
-		return _size;
+		return _size == 0;
 	}
 
-	template<typename t, int width>
-	inline bool static_vector<t, width>::empty()
+	template<typename t, int width, bool spill_to_heap>
+	inline unsigned int static_vector<t, width, spill_to_heap>::max_size() const
 	{
-		return _size == 0;
+		return spill_to_heap ? unsigned(INT_MAX) : unsigned(width);
 	}
 
-	template<typename t, int width>
-	inline bool static_vector<t, width>::empty() const
+	template<typename t, int width, bool spill_to_heap>
+	inline unsigned int static_vector<t, width, spill_to_heap>::capacity() const
 	{
-		return _size == 0;
+		return _capacity;
 	}
 
-	template<typename t, int width>
-	inline unsigned int static_vector<t, width>::max_size() const
+	template<typename t, int width, bool spill_to_heap>
+	inline t* static_vector<t, width, spill_to_heap>::data()
 	{
-		return width;
+		return _heap ? _heap : inline_buffer();
 	}
 
-	template<typename t, int width>
-	inline t* static_vector<t, width>::data()
+	template<typename t, int width, bool spill_to_heap>
+	inline const t* static_vector<t, width, spill_to_heap>::data() const
 	{
-		return _buffer;
+		return _heap ? _heap : inline_buffer();
 	}
 
-	template<typename t, int width>
-	inline t* static_vector<t, width>::data() const
+	template<typename t, int width, bool spill_to_heap>
+	inline t& static_vector<t, width, spill_to_heap>::operator[](int index)
 	{
-		return _buffer;
+		assert(index > -1 && index < _size && "index out of range");
+		return data()[index];
 	}
 
-	template <typename t, int width>
-	t& static_vector<t, width>::operator[](int index)
+	template<typename t, int width, bool spill_to_heap>
+	inline const t& static_vector<t, width, spill_to_heap>::operator[](int index) const
 	{
-		const bool valid_op = index > -1 & index < _size;
-		assert(valid_op && "index out of range");
-		return _buffer[index];
+		assert(index > -1 && index < _size && "index out of range");
+		return data()[index];
 	}
 
-	template <typename t, int width>
-	const t& static_vector<t, width>::operator[](int index) const
+	template<typename t, int width, bool spill_to_heap>
+	inline reverse<t> static_vector<t, width, spill_to_heap>::reverse_iterate()
 	{
-		const bool valid_op = index > -1 & index < _size;
-		assert(valid_op && "index out of range");
-		return _buffer[index];
+		return { end(), begin() };
 	}
-	template<typename t, int width>
-	inline reverse<t> static_vector<t, width>::reverse_iterate()
+
+	template<typename t, int width, bool spill_to_heap>
+	inline bool static_vector<t, width, spill_to_heap>::make_room()
 	{
-		return { _buffer + _size, _buffer };
+		if (_size < _capacity)
+		{
+			return true;
+		}
+		if constexpr (!spill_to_heap)
+		{
+			return false;
+		}
+		else
+		{
+			const int new_capacity = _capacity * 2;
+			t* heap = std::allocator<t>().allocate(new_capacity);
+			std::uninitialized_move_n(data(), _size, heap);
+			std::destroy_n(data(), _size);
+			release_heap();
+			_heap = heap;
+			_capacity = new_capacity;
+			return true;
+		}
 	}
 
-
+	template<typename t, int width, bool spill_to_heap>
+	inline void static_vector<t, width, spill_to_heap>::release_heap()
+	{
+		if (_heap)
+		{
+			std::allocator<t>().deallocate(_heap, _capacity);
+			_heap = nullptr;
+			_capacity = width;
+		}
+	}
 }
@@ -1,13 +1,13 @@
 #include "pch.h"
 #include "FileUtil.h"
 
+#include <filesystem>
+
 long long neat::FileAgeDiff(const char* base, const char* ref)
 {
-	struct _stat result;
-	_stat( base, &result );
-	const auto lastModifiedBase = result.st_mtime;
-	_stat( ref, &result );
-	const auto lastModifiedReg = result.st_mtime;
+	std::error_code error;
+	const auto lastModifiedBase = std::filesystem::last_write_time( base, error );
+	const auto lastModifiedReg = std::filesystem::last_write_time( ref, error );
 
-	return lastModifiedBase - lastModifiedReg;
+	return std::chrono::duration_cast<std::chrono::seconds>( lastModifiedBase - lastModifiedReg ).count();
 }
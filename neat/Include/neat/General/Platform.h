@@ -0,0 +1,102 @@
+#pragma once
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#else
+
+#include <cstdint>
+
+// outside windows neat mirrors the subset of win32 it is written against
+// the xlib backend translates its events into these messages so input handling stays shared
+namespace neat
+{
+	// what a window handle points to, enough to create a VK_KHR_xlib_surface
+	struct NativeWindow
+	{
+		void*			display = nullptr;
+		unsigned long	window = 0;
+	};
+}
+
+typedef neat::NativeWindow*	HWND;
+typedef void*				HINSTANCE;
+typedef unsigned int		UINT;
+typedef uintptr_t			WPARAM;
+typedef intptr_t			LPARAM;
+typedef intptr_t			LRESULT;
+typedef long				HRESULT;
+
+#define CALLBACK
+#define S_OK HRESULT(0)
+
+struct POINT
+{
+	long x, y;
+};
+
+struct MSG
+{
+	HWND			hwnd;
+	UINT			message;
+	WPARAM			wParam;
+	LPARAM			lParam;
+	unsigned long	time;
+	POINT			pt;
+};
+
+// MESSAGES
+constexpr UINT WM_DESTROY		= 0x0002;
+constexpr UINT WM_QUIT			= 0x0012;
+constexpr UINT WM_KEYDOWN		= 0x0100;
+constexpr UINT WM_KEYUP			= 0x0101;
+constexpr UINT WM_MOUSEMOVE		= 0x0200;
+constexpr UINT WM_LBUTTONDOWN	= 0x0201;
+constexpr UINT WM_LBUTTONUP		= 0x0202;
+constexpr UINT WM_RBUTTONDOWN	= 0x0204;
+constexpr UINT WM_RBUTTONUP		= 0x0205;
+constexpr UINT WM_MBUTTONDOWN	= 0x0207;
+constexpr UINT WM_MBUTTONUP		= 0x0208;
+constexpr UINT WM_MOUSEWHEEL	= 0x020A;
+
+constexpr short WHEEL_DELTA		= 120;
+
+#define GET_X_LPARAM(lp)			int(short(uint16_t(uintptr_t(lp) & 0xffff)))
+#define GET_Y_LPARAM(lp)			int(short(uint16_t((uintptr_t(lp) >> 16) & 0xffff)))
+#define GET_WHEEL_DELTA_WPARAM(wp)	short(uint16_t((uintptr_t(wp) >> 16) & 0xffff))
+
+#define ARRAYSIZE(a)				(sizeof(a) / sizeof(*(a)))
+#define _ARRAYSIZE(a)				ARRAYSIZE(a)
+
+// VIRTUAL KEYS
+// letters and digits use their upper case ascii value like on windows
+constexpr int VK_LBUTTON	= 0x01;
+constexpr int VK_RBUTTON	= 0x02;
+constexpr int VK_MBUTTON	= 0x04;
+constexpr int VK_BACK		= 0x08;
+constexpr int VK_TAB		= 0x09;
+constexpr int VK_RETURN		= 0x0D;
+constexpr int VK_SHIFT		= 0x10;
+constexpr int VK_CONTROL	= 0x11;
+constexpr int VK_MENU		= 0x12;
+constexpr int VK_ESCAPE		= 0x1B;
+constexpr int VK_SPACE		= 0x20;
+constexpr int VK_LEFT		= 0x25;
+constexpr int VK_UP			= 0x26;
+constexpr int VK_RIGHT		= 0x27;
+constexpr int VK_DOWN		= 0x28;
+constexpr int VK_DELETE		= 0x2E;
+constexpr int VK_F1			= 0x70;
+
+// implemented by the xlib window backend
+void PostQuitMessage(int exitCode);
+bool GetCursorPos(POINT* point);
+
+#endif
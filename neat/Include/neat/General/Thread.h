@@ -1,8 +1,12 @@
 #pragma once
 
-#include <thread>
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <semaphore>
+#include <thread>
+#include <vector>
 
 // TODO: implement thread checker, constructor, join and start should be exclusive to one thread
 namespace neat
@@ -45,4 +49,34 @@ namespace neat
 		std::shared_ptr<std::binary_semaphore>	myNextSignal;
 		
 	};
+
+	// calls func(index) for every index in [begin, end), the calling thread works too and returns once all are done
+	template<typename Func>
+	void
+	ParallelFor(
+		size_t	begin,
+		size_t	end,
+		Func&&	func)
+	{
+		std::atomic<size_t> next = begin;
+		auto work = [&next, end, &func]()
+		{
+			for (size_t index = next++; index < end; index = next++)
+			{
+				func(index);
+			}
+		};
+
+		const size_t numThreads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), end > begin ? end - begin : 0);
+		std::vector<std::thread> helpers;
+		for (size_t thread = 1; thread < numThreads; ++thread)
+		{
+			helpers.emplace_back(work);
+		}
+		work();
+		for (auto& helper : helpers)
+		{
+			helper.join();
+		}
+	}
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 ﻿
 #include "pch.h"
 
+#ifdef _WIN32
+
 #include "Window.h"
 
 #include <cassert>
@@ -116,3 +118,5 @@ void neat::Window::RegisterMSGCallback(MSGListenCallback callback)
 {
 	myListenCallbacks.emplace_back(std::move(callback));
 }
+
+#endif
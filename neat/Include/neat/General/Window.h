@@ -1,8 +1,7 @@
 
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN
-
+#include "Platform.h"
 #include "WindowParams.h"
 
 using MSGListenCallback = std::function<void(MSG)>;
@@ -15,6 +14,9 @@ namespace neat {
 		static LRESULT CALLBACK WinProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 
 		Window(HINSTANCE hInstance, int nCmdShow, const WindowParams& parameters);
+#ifndef _WIN32
+		~Window();
+#endif
 
 
 		MSG HandleMessages();
@@ -26,7 +28,12 @@ namespace neat {
 
 	private:
 		HWND myHandle;
+#ifdef _WIN32
 		WNDCLASSEX myWindowClass;
+#else
+		NativeWindow myNativeWindow;
+		unsigned long myDeleteAtom;
+#endif
 		WindowParams myWindowParams;
 		std::vector<MSGListenCallback> myListenCallbacks;
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "Platform.h"
+#include <functional>
+
 namespace neat {
 	struct WindowParams
 	{
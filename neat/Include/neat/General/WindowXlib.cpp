@@ -0,0 +1,273 @@
+#include "pch.h"
+
+#ifndef _WIN32
+
+#include "Window.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+
+namespace
+{
+	// one connection serves every window, input handling reads the cursor through it too
+	Display*			gDisplay = nullptr;
+	int					gNumWindows = 0;
+	std::atomic_bool	gQuitPosted = false;
+	int					gQuitCode = 0;
+
+	int TranslateKey(KeySym sym)
+	{
+		if (sym >= XK_a && sym <= XK_z)
+		{
+			return int('A' + (sym - XK_a));
+		}
+		if (sym >= XK_0 && sym <= XK_9)
+		{
+			return int('0' + (sym - XK_0));
+		}
+		if (sym >= XK_F1 && sym <= XK_F12)
+		{
+			return int(VK_F1 + (sym - XK_F1));
+		}
+		switch (sym)
+		{
+			case XK_BackSpace:	return VK_BACK;
+			case XK_Tab:		return VK_TAB;
+			case XK_Return:		return VK_RETURN;
+			case XK_Shift_L:
+			case XK_Shift_R:	return VK_SHIFT;
+			case XK_Control_L:
+			case XK_Control_R:	return VK_CONTROL;
+			case XK_Alt_L:
+			case XK_Alt_R:		return VK_MENU;
+			case XK_Escape:		return VK_ESCAPE;
+			case XK_space:		return VK_SPACE;
+			case XK_Left:		return VK_LEFT;
+			case XK_Up:			return VK_UP;
+			case XK_Right:		return VK_RIGHT;
+			case XK_Down:		return VK_DOWN;
+			case XK_Delete:		return VK_DELETE;
+			default:			return 0;
+		}
+	}
+
+	LPARAM PackPosition(int x, int y)
+	{
+		return LPARAM((uint32_t(uint16_t(y)) << 16) | uint16_t(x));
+	}
+}
+
+void PostQuitMessage(int exitCode)
+{
+	gQuitCode = exitCode;
+	gQuitPosted = true;
+}
+
+bool GetCursorPos(POINT* point)
+{
+	if (!gDisplay)
+	{
+		return false;
+	}
+	::Window root, child;
+	int rootX, rootY, windowX, windowY;
+	unsigned int mask;
+	XQueryPointer(gDisplay, DefaultRootWindow(gDisplay), &root, &child, &rootX, &rootY, &windowX, &windowY, &mask);
+	point->x = rootX;
+	point->y = rootY;
+	return true;
+}
+
+std::function<bool( HWND, UINT, WPARAM, LPARAM )> neat::Window::ourOnWinProc;
+
+neat::Window::Window( HINSTANCE /*hInstance*/, int /*nCmdShow*/, const WindowParams& parameters ) :
+	myHandle( &myNativeWindow ),
+	myWindowParams( parameters )
+{
+	if ( !gDisplay )
+	{
+		gDisplay = XOpenDisplay( nullptr );
+	}
+	assert( gDisplay && "failed connecting to the x server" );
+	++gNumWindows;
+
+	assert( parameters.onWinProc != nullptr );
+	ourOnWinProc = parameters.onWinProc;
+
+	const int screen = DefaultScreen( gDisplay );
+	const int xPos = DisplayWidth( gDisplay, screen ) / 2 - myWindowParams.width / 2;
+	const int yPos = DisplayHeight( gDisplay, screen ) / 2 - myWindowParams.height / 2;
+
+	XSetWindowAttributes attributes{};
+	attributes.event_mask =
+		KeyPressMask | KeyReleaseMask |
+		ButtonPressMask | ButtonReleaseMask |
+		PointerMotionMask | StructureNotifyMask;
+
+	const ::Window window = XCreateWindow( gDisplay,
+										   RootWindow( gDisplay, screen ),
+										   xPos,
+										   yPos,
+										   myWindowParams.width,
+										   myWindowParams.height,
+										   0,
+										   CopyFromParent,
+										   InputOutput,
+										   CopyFromParent,
+										   CWEventMask,
+										   &attributes );
+
+	char title[256]{};
+	std::wcstombs( title, myWindowParams.title, sizeof( title ) - 1 );
+	XStoreName( gDisplay, window, title );
+
+	// closing goes through WM_DESTROY like on windows instead of killing the connection
+	Atom deleteAtom = XInternAtom( gDisplay, "WM_DELETE_WINDOW", False );
+	XSetWMProtocols( gDisplay, window, &deleteAtom, 1 );
+	myDeleteAtom = deleteAtom;
+
+	if ( parameters.windowedFullscreenFlag )
+	{
+		Atom fullscreen = XInternAtom( gDisplay, "_NET_WM_STATE_FULLSCREEN", False );
+		XChangeProperty( gDisplay, window, XInternAtom( gDisplay, "_NET_WM_STATE", False ), XA_ATOM, 32, PropModeReplace, reinterpret_cast<unsigned char*>( &fullscreen ), 1 );
+	}
+
+	// held keys otherwise report a release and press pair for every repeat
+	XkbSetDetectableAutoRepeat( gDisplay, True, nullptr );
+
+	XMapWindow( gDisplay, window );
+	XFlush( gDisplay );
+
+	myNativeWindow.display = gDisplay;
+	myNativeWindow.window = window;
+}
+
+neat::Window::~Window()
+{
+	XDestroyWindow( gDisplay, myNativeWindow.window );
+	if ( --gNumWindows == 0 )
+	{
+		XCloseDisplay( gDisplay );
+		gDisplay = nullptr;
+	}
+}
+
+LRESULT neat::Window::WinProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
+{
+	switch ( message )
+	{
+		case WM_DESTROY:
+			PostQuitMessage( 0 );
+			return 0;
+	}
+
+	ourOnWinProc( hwnd, message, wParam, lParam );
+	return 0;
+}
+
+MSG neat::Window::HandleMessages()
+{
+	MSG msg{};
+	while ( XPending( gDisplay ) )
+	{
+		XEvent event;
+		XNextEvent( gDisplay, &event );
+		if ( event.xany.window != myNativeWindow.window )
+		{
+			continue;
+		}
+
+		msg = { myHandle, 0, 0, 0, 0, { 0, 0 } };
+		switch ( event.type )
+		{
+			case KeyPress:
+			case KeyRelease:
+				msg.message = event.type == KeyPress ? WM_KEYDOWN : WM_KEYUP;
+				msg.wParam = WPARAM( TranslateKey( XLookupKeysym( &event.xkey, 0 ) ) );
+				msg.time = event.xkey.time;
+				msg.pt = { event.xkey.x_root, event.xkey.y_root };
+				if ( !msg.wParam )
+				{
+					continue;
+				}
+				break;
+			case ButtonPress:
+			case ButtonRelease:
+			{
+				const bool isPress = event.type == ButtonPress;
+				msg.lParam = PackPosition( event.xbutton.x, event.xbutton.y );
+				msg.time = event.xbutton.time;
+				msg.pt = { event.xbutton.x_root, event.xbutton.y_root };
+				switch ( event.xbutton.button )
+				{
+					case Button1: msg.message = isPress ? WM_LBUTTONDOWN : WM_LBUTTONUP; break;
+					case Button2: msg.message = isPress ? WM_MBUTTONDOWN : WM_MBUTTONUP; break;
+					case Button3: msg.message = isPress ? WM_RBUTTONDOWN : WM_RBUTTONUP; break;
+					case Button4:
+					case Button5:
+						// x reports each wheel notch as a press and release, keep only the press
+						if ( !isPress )
+						{
+							continue;
+						}
+						msg.message = WM_MOUSEWHEEL;
+						msg.wParam = WPARAM( uint16_t( event.xbutton.button == Button4 ? WHEEL_DELTA : -WHEEL_DELTA ) ) << 16;
+						break;
+					default:
+						continue;
+				}
+				break;
+			}
+			case MotionNotify:
+				msg.message = WM_MOUSEMOVE;
+				msg.lParam = PackPosition( event.xmotion.x, event.xmotion.y );
+				msg.time = event.xmotion.time;
+				msg.pt = { event.xmotion.x_root, event.xmotion.y_root };
+				break;
+			case ClientMessage:
+				if ( Atom( event.xclient.data.l[0] ) != myDeleteAtom )
+				{
+					continue;
+				}
+				msg.message = WM_DESTROY;
+				break;
+			default:
+				continue;
+		}
+
+		WinProc( msg.hwnd, msg.message, msg.wParam, msg.lParam );
+		for (auto& callback : myListenCallbacks)
+		{
+			callback(msg);
+		}
+	}
+
+	if ( gQuitPosted )
+	{
+		msg = { myHandle, WM_QUIT, WPARAM( gQuitCode ), 0, 0, { 0, 0 } };
+	}
+	return msg;
+}
+
+HWND neat::Window::GetWindowHandle() const
+{
+	return myHandle;
+}
+
+neat::WindowParams neat::Window::GetWindowParameters() const
+{
+	return myWindowParams;
+}
+
+void neat::Window::RegisterMSGCallback(MSGListenCallback callback)
+{
+	myListenCallbacks.emplace_back(std::move(callback));
+}
+
+#endif
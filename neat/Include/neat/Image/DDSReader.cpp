@@ -1,10 +1,10 @@
 #include "pch.h"
 #include "DDSReader.h"
 
+#include <cmath>
+#include <cstring>
 #include <fstream>
 
-#include <d3d11.h>
-
 struct DDS_PIXELFORMAT
 {
 	uint32_t dwSize;
@@ -37,8 +37,8 @@ typedef struct
 
 typedef struct
 {
-	DXGI_FORMAT              dxgiFormat;
-	D3D10_RESOURCE_DIMENSION resourceDimension;
+	uint32_t                     dxgiFormat;
+	uint32_t                     resourceDimension;
 	uint32_t                     miscFlag;
 	uint32_t                     arraySize;
 	uint32_t                     miscFlags2;
@@ -48,7 +48,7 @@ struct DDS
 {
 	uint32_t magic;
 	DDS_HEADER header;
-	byte data[];
+	uint8_t data[];
 };
 
 struct DDSDXT10
@@ -56,7 +56,7 @@ struct DDSDXT10
 	uint32_t magic;
 	DDS_HEADER header;
 	DDS_HEADER_DXT10 dxt10header;
-	byte data[];
+	uint8_t data[];
 };
 #define DDSCAPS2_CUBEMAP 0x200
 
@@ -4,6 +4,8 @@
 #include "DDSReader.h"
 #include "tga-main/tga.h"
 
+#include <cstring>
+
 namespace neat
 {
 void OpenTGA(Image & outImg, const char* path);
@@ -40,8 +40,8 @@ TGAOpen(const char *file,
 	
 	tga->off = 0;
 
-	auto error = fopen_s(&fd, file, mode);
-	if (error) {
+	fd = fopen(file, mode);
+	if (!fd) {
 		TGA_ERROR(tga, TGA_OPEN_FAIL);
 		free(tga);
 		return NULL;
@@ -22,6 +22,7 @@
 #include "pch.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "tga.h"
 
 
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "InputHandler.h"
+#ifdef _WIN32
 #include <Windowsx.h>
+#endif
 
 bool neat::InputHandler::TakeMessages( UINT msg, WPARAM wParam, LPARAM lParam )
 {
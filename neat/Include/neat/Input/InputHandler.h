@@ -1,8 +1,9 @@
 
 #pragma once
 
-#include <Windows.h>
+#include "neat/General/Platform.h"
 #include <array>
+#include <tuple>
 
 namespace neat
 {
@@ -0,0 +1,187 @@
+#include "pch.h"
+#include "AllocationCounter.h"
+
+#ifdef NEAT_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	thread_local uint64_t gNumHeapAllocations = 0;
+
+	void*
+	Allocate(
+		std::size_t size)
+	{
+		++gNumHeapAllocations;
+		return std::malloc(size ? size : 1);
+	}
+
+	void*
+	AllocateAligned(
+		std::size_t			size,
+		std::align_val_t	alignment)
+	{
+		++gNumHeapAllocations;
+		const std::size_t align = std::size_t(alignment);
+#ifdef _MSC_VER
+		return _aligned_malloc(size ? size : 1, align);
+#else
+		// aligned_alloc wants the size to be a multiple of the alignment
+		return std::aligned_alloc(align, ((size ? size : 1) + align - 1) & ~(align - 1));
+#endif
+	}
+
+	void
+	FreeAligned(
+		void* memory)
+	{
+#ifdef _MSC_VER
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+
+// every replaceable form is defined here, a standard library that doesn't forward
+// array, nothrow or aligned forms to the plain ones would otherwise bypass the count or mix allocators
+
+// NEW
+void* operator new(std::size_t size)
+{
+	if (void* memory = Allocate(size))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (void* memory = AllocateAligned(size, alignment))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateAligned(size, alignment);
+}
+
+// DELETE
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(memory);
+}
+
+uint64_t
+neat::GetNumHeapAllocations()
+{
+	return gNumHeapAllocations;
+}
+
+bool
+neat::IsCountingHeapAllocations()
+{
+	return true;
+}
+
+#else
+
+uint64_t
+neat::GetNumHeapAllocations()
+{
+	return 0;
+}
+
+bool
+neat::IsCountingHeapAllocations()
+{
+	return false;
+}
+
+#endif
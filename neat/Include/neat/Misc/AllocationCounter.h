@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+namespace neat
+{
+	// heap allocations made by the calling thread since it started
+	// only counts when neat is built with NEAT_COUNT_ALLOCATIONS, which replaces the global operator new and delete
+	uint64_t	GetNumHeapAllocations();
+	bool		IsCountingHeapAllocations();
+}
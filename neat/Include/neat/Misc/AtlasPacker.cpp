@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "AtlasPacker.h"
+
+#include <algorithm>
+
+neat::AtlasPacker::AtlasPacker(
+	uint32_t width,
+	uint32_t height)
+	: myWidth(width)
+	, myHeight(height)
+{
+	Clear();
+}
+
+std::tuple<bool, uint32_t, uint32_t>
+neat::AtlasPacker::Pack(
+	uint32_t width,
+	uint32_t height)
+{
+	int32_t bestY = INT32_MAX;
+	int32_t bestWidth = INT32_MAX;
+	size_t bestIndex = SIZE_MAX;
+
+	// BOTTOM LEFT
+	for (size_t nodeIndex = 0; nodeIndex < mySkyline.size(); ++nodeIndex)
+	{
+		auto [fits, y] = Fit(nodeIndex, width, height);
+		if (!fits)
+		{
+			continue;
+		}
+		const int32_t top = y + int32_t(height);
+		if (top < bestY
+			|| (top == bestY && mySkyline[nodeIndex].width < bestWidth))
+		{
+			bestY = top;
+			bestWidth = mySkyline[nodeIndex].width;
+			bestIndex = nodeIndex;
+		}
+	}
+
+	if (bestIndex == SIZE_MAX)
+	{
+		return {false, 0, 0};
+	}
+
+	const uint32_t x = uint32_t(mySkyline[bestIndex].x);
+	const uint32_t y = uint32_t(bestY) - height;
+	AddLevel(bestIndex, x, y, width, height);
+	myUsedArea += uint64_t(width) * height;
+
+	return {true, x, y};
+}
+
+void
+neat::AtlasPacker::Clear()
+{
+	mySkyline.clear();
+	mySkyline.push_back({0, 0, int32_t(myWidth)});
+	myUsedArea = 0;
+}
+
+float
+neat::AtlasPacker::GetOccupancy() const
+{
+	return float(double(myUsedArea) / (double(myWidth) * double(myHeight)));
+}
+
+uint32_t
+neat::AtlasPacker::GetWidth() const
+{
+	return myWidth;
+}
+
+uint32_t
+neat::AtlasPacker::GetHeight() const
+{
+	return myHeight;
+}
+
+std::tuple<bool, int32_t>
+neat::AtlasPacker::Fit(
+	size_t		nodeIndex,
+	uint32_t	width,
+	uint32_t	height) const
+{
+	const int32_t x = mySkyline[nodeIndex].x;
+	if (x + int32_t(width) > int32_t(myWidth))
+	{
+		return {false, 0};
+	}
+
+	int32_t y = 0;
+	int32_t widthLeft = int32_t(width);
+	for (size_t index = nodeIndex; widthLeft > 0; ++index)
+	{
+		if (index == mySkyline.size())
+		{
+			return {false, 0};
+		}
+		y = std::max(y, mySkyline[index].y);
+		if (y + int32_t(height) > int32_t(myHeight))
+		{
+			return {false, 0};
+		}
+		widthLeft -= mySkyline[index].width;
+	}
+	return {true, y};
+}
+
+void
+neat::AtlasPacker::AddLevel(
+	size_t		nodeIndex,
+	uint32_t	x,
+	uint32_t	y,
+	uint32_t	width,
+	uint32_t	height)
+{
+	mySkyline.insert(mySkyline.begin() + nodeIndex, {int32_t(x), int32_t(y + height), int32_t(width)});
+
+	// SHRINK COVERED NODES
+	for (size_t index = nodeIndex + 1; index < mySkyline.size(); ++index)
+	{
+		auto& prev = mySkyline[index - 1];
+		auto& node = mySkyline[index];
+		if (node.x >= prev.x + prev.width)
+		{
+			break;
+		}
+		const int32_t shrink = prev.x + prev.width - node.x;
+		node.x += shrink;
+		node.width -= shrink;
+		if (node.width > 0)
+		{
+			break;
+		}
+		mySkyline.erase(mySkyline.begin() + index);
+		--index;
+	}
+
+	// MERGE EQUAL LEVELS
+	for (size_t index = 0; index + 1 < mySkyline.size(); ++index)
+	{
+		if (mySkyline[index].y == mySkyline[index + 1].y)
+		{
+			mySkyline[index].width += mySkyline[index + 1].width;
+			mySkyline.erase(mySkyline.begin() + index + 1);
+			--index;
+		}
+	}
+}
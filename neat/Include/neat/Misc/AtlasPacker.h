@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace neat
+{
+	struct SkylineNode
+	{
+		int32_t	x;
+		int32_t	y;
+		int32_t	width;
+	};
+
+	// bottom left skyline packing, rects can't be freed one by one, only all at once by Clear
+	class AtlasPacker
+	{
+	public:
+										AtlasPacker(
+											uint32_t width,
+											uint32_t height);
+
+		// packed, x, y
+		std::tuple<bool, uint32_t, uint32_t>
+										Pack(
+											uint32_t width,
+											uint32_t height);
+		void							Clear();
+
+		[[nodiscard]] float				GetOccupancy() const;
+		[[nodiscard]] uint32_t			GetWidth() const;
+		[[nodiscard]] uint32_t			GetHeight() const;
+
+	private:
+		std::tuple<bool, int32_t>		Fit(
+											size_t		nodeIndex,
+											uint32_t	width,
+											uint32_t	height) const;
+		void							AddLevel(
+											size_t		nodeIndex,
+											uint32_t	x,
+											uint32_t	y,
+											uint32_t	width,
+											uint32_t	height);
+
+		uint32_t						myWidth = 0;
+		uint32_t						myHeight = 0;
+		uint64_t						myUsedArea = 0;
+		std::vector<SkylineNode>		mySkyline;
+
+	};
+}
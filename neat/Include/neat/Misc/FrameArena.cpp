@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <new>
+
+std::atomic<uint64_t> neat::FrameArena::ourFrame = 0;
+
+neat::FrameArena&
+neat::FrameArena::Get()
+{
+	thread_local FrameArena arena;
+	return arena;
+}
+
+void
+neat::FrameArena::EndFrame()
+{
+	ourFrame.fetch_add(1, std::memory_order_release);
+}
+
+void*
+neat::FrameArena::Allocate(
+	size_t size,
+	size_t alignment)
+{
+	const uint64_t frame = ourFrame.load(std::memory_order_acquire);
+	if (myFrame != frame)
+	{
+		Rewind();
+		myFrame = frame;
+	}
+
+	if (void* memory = AllocateFromBlock(size, alignment))
+	{
+		return memory;
+	}
+	while (++myBlockIndex < myBlocks.size())
+	{
+		myOffset = 0;
+		if (void* memory = AllocateFromBlock(size, alignment))
+		{
+			return memory;
+		}
+	}
+
+	// OVERFLOW
+	const size_t blockSize = std::max(DefaultBlockSize, size + alignment);
+	myBlocks.push_back({ static_cast<std::byte*>(::operator new(blockSize)), blockSize });
+	myBlockIndex = myBlocks.size() - 1;
+	myOffset = 0;
+	return AllocateFromBlock(size, alignment);
+}
+
+size_t
+neat::FrameArena::GetUsedBytes() const
+{
+	return myUsedBytes;
+}
+
+uint32_t
+neat::FrameArena::GetNumOverflows() const
+{
+	return myBlocks.empty() ? 0 : uint32_t(myBlocks.size() - 1);
+}
+
+neat::FrameArena::FrameArena()
+	: myFrame(ourFrame.load(std::memory_order_acquire))
+{
+	myBlocks.reserve(8);
+	myBlocks.push_back({ static_cast<std::byte*>(::operator new(DefaultBlockSize)), DefaultBlockSize });
+}
+
+neat::FrameArena::~FrameArena()
+{
+	for (auto& block : myBlocks)
+	{
+		::operator delete(block.memory);
+	}
+}
+
+void
+neat::FrameArena::Rewind()
+{
+	// a frame that needed several blocks gets them merged into one, so the next frames fit without allocating
+	if (myBlocks.size() > 1)
+	{
+		size_t totalSize = 0;
+		for (auto& block : myBlocks)
+		{
+			totalSize += block.size;
+			::operator delete(block.memory);
+		}
+		myBlocks.clear();
+		myBlocks.push_back({ static_cast<std::byte*>(::operator new(totalSize)), totalSize });
+	}
+	myBlockIndex = 0;
+	myOffset = 0;
+	myUsedBytes = 0;
+}
+
+void*
+neat::FrameArena::AllocateFromBlock(
+	size_t size,
+	size_t alignment)
+{
+	Block& block = myBlocks[myBlockIndex];
+	const uintptr_t base = reinterpret_cast<uintptr_t>(block.memory);
+	const uintptr_t aligned = (base + myOffset + alignment - 1) & ~uintptr_t(alignment - 1);
+	const size_t end = size_t(aligned - base) + size;
+	if (end > block.size)
+	{
+		return nullptr;
+	}
+	myUsedBytes += end - myOffset;
+	myOffset = end;
+	return reinterpret_cast<void*>(aligned);
+}
+
+void*
+neat::FrameResource::do_allocate(
+	size_t bytes,
+	size_t alignment)
+{
+	return FrameArena::Get().Allocate(bytes, alignment);
+}
+
+void
+neat::FrameResource::do_deallocate(
+	void*	/*p*/,
+	size_t	/*bytes*/,
+	size_t	/*alignment*/)
+{
+}
+
+bool
+neat::FrameResource::do_is_equal(
+	const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+std::pmr::memory_resource*
+neat::GetFrameResource()
+{
+	static FrameResource resource;
+	return &resource;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+#include <vector>
+
+namespace neat
+{
+	// per thread bump allocator for data that only has to live until the end of the frame
+	// EndFrame bumps a shared frame counter, each thread rewinds its own arena the next time it allocates after that
+	// so nothing taken from it may be kept across EndFrame, on any thread
+	class FrameArena
+	{
+	public:
+		static constexpr size_t					DefaultBlockSize = 64 * 1024;
+
+		static FrameArena&						Get();
+		static void								EndFrame();
+
+												FrameArena(const FrameArena&) = delete;
+												FrameArena& operator=(const FrameArena&) = delete;
+
+		void*									Allocate(
+													size_t size,
+													size_t alignment = alignof(std::max_align_t));
+		size_t									GetUsedBytes() const;
+		// blocks added on top of the first since the last rewind, zero once the arena has grown to fit a frame
+		uint32_t								GetNumOverflows() const;
+
+	private:
+												FrameArena();
+												~FrameArena();
+
+		void									Rewind();
+		void*									AllocateFromBlock(
+													size_t size,
+													size_t alignment);
+
+		struct Block
+		{
+			std::byte*	memory;
+			size_t		size;
+		};
+
+		static std::atomic<uint64_t>			ourFrame;
+
+		std::vector<Block>						myBlocks;
+		size_t									myBlockIndex = 0;
+		size_t									myOffset = 0;
+		size_t									myUsedBytes = 0;
+		uint64_t								myFrame = 0;
+
+	};
+
+	// std::pmr adapter over the calling thread's frame arena, deallocating is a no op
+	class FrameResource final : public std::pmr::memory_resource
+	{
+	private:
+		void*									do_allocate(
+													size_t bytes,
+													size_t alignment) override;
+		void									do_deallocate(
+													void*	p,
+													size_t	bytes,
+													size_t	alignment) override;
+		bool									do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+	};
+
+	std::pmr::memory_resource*					GetFrameResource();
+
+	template<typename t>
+	using frame_vector = std::pmr::vector<t>;
+
+	template<typename t>
+	frame_vector<t> make_frame_vector(std::initializer_list<t> items)
+	{
+		return frame_vector<t>(items, GetFrameResource());
+	}
+}
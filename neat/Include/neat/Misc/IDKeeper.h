@@ -1,12 +1,19 @@
-
 #pragma once
 
-#include <concurrent_priority_queue.h>
-#include <mutex>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
 
 #define INVALID_ID -1
 #define BAD_ID(id) (int(id) < 0)
 
+// hands out ids from [0, numIDSlots) through a lock free free list
+// the head packs a tag in the upper 32 bits with the slot index in the lower, bumping the tag on every swap avoids aba
+// every slot also counts a generation, odd while the id is handed out, so a handle that keeps the generation
+// it was given can tell its id has since been returned or reused
+// fresh ids come out ascending, but returned ids are pushed on the head and handed out again first (lifo),
+// not lowest free first, so ids don't stay packed toward 0 once some have been returned
 template<typename IDType>
 class IDKeeper
 {
@@ -14,59 +21,110 @@ public:
 	IDKeeper( unsigned numIDSlots );
 
 	IDType FetchFreeID();
+	IDType FetchFreeID( uint32_t& outGeneration );
 	void ReturnID( const IDType& id );
 
+	uint32_t GetGeneration( const IDType& id ) const;
+	bool IsCurrent( const IDType& id, uint32_t generation ) const;
+
 private:
-	concurrency::concurrent_priority_queue<IDType, std::greater<>>	myFreeIDs;
-#ifdef _DEBUG
-	std::mutex														myOccupiedTamperMutex;
-	std::vector<IDType>												myOccupiedIDs;
-#endif
+	static constexpr uint32_t	EndOfList = ~0u;
+
+	static uint64_t				Pack( uint32_t tag, uint32_t index ) { return ( uint64_t( tag ) << 32 ) | index; }
+	static uint32_t				TagOf( uint64_t head ) { return uint32_t( head >> 32 ); }
+	static uint32_t				IndexOf( uint64_t head ) { return uint32_t( head ); }
+
+	unsigned									myNumIDSlots;
+	std::unique_ptr<std::atomic<uint32_t>[]>	myNextFree;
+	std::unique_ptr<std::atomic<uint32_t>[]>	myGenerations;
+	std::atomic<uint64_t>						myFreeHead;
 
 };
 
 template<typename IDType>
 inline IDKeeper<IDType>::IDKeeper( unsigned numIDSlots )
+	: myNumIDSlots( numIDSlots )
+	, myNextFree( std::make_unique<std::atomic<uint32_t>[]>( numIDSlots ) )
+	, myGenerations( std::make_unique<std::atomic<uint32_t>[]>( numIDSlots ) )
+	, myFreeHead( Pack( 0, numIDSlots ? 0 : EndOfList ) )
 {
-	for ( int id = 0; id < numIDSlots; ++id )
+	// ascending so the first fetch gives id 0 like before
+	for ( unsigned id = 0; id < numIDSlots; ++id )
 	{
-		myFreeIDs.push( IDType( id ) );
+		myNextFree[id].store( id + 1 < numIDSlots ? id + 1 : EndOfList, std::memory_order_relaxed );
+		myGenerations[id].store( 0, std::memory_order_relaxed );
 	}
 }
 
 template<typename IDType>
 inline IDType IDKeeper<IDType>::FetchFreeID()
 {
-	IDType ret = IDType( INVALID_ID );
-	if ( !myFreeIDs.try_pop( ret ) )
-	{
-		return IDType( INVALID_ID );
-	}
-#ifdef _DEBUG
-	{
-		std::scoped_lock<std::mutex> lock( myOccupiedTamperMutex );
-		myOccupiedIDs.push_back( ret );
-	}
-#endif
-	return ret;
+	uint32_t generation;
+	return FetchFreeID( generation );
 }
 
 template<typename IDType>
-inline void IDKeeper<IDType>::ReturnID( const IDType& id )
+inline IDType IDKeeper<IDType>::FetchFreeID( uint32_t& outGeneration )
 {
-#ifdef _DEBUG
+	uint64_t head = myFreeHead.load( std::memory_order_acquire );
+	while ( true )
 	{
-		std::scoped_lock<std::mutex> lock( myOccupiedTamperMutex );
-		auto iter = std::find(myOccupiedIDs.begin(), myOccupiedIDs.end(), id);
-		if (iter == myOccupiedIDs.end())
+		const uint32_t index = IndexOf( head );
+		if ( index == EndOfList )
 		{
-			assert(false && "attempting to return unoccupied id");
+			return IDType( INVALID_ID );
 		}
-		else
+		// next may be stale if another thread won the race, the tag makes that cas fail
+		const uint32_t next = myNextFree[index].load( std::memory_order_relaxed );
+		if ( myFreeHead.compare_exchange_weak( head, Pack( TagOf( head ) + 1, next ), std::memory_order_acquire, std::memory_order_acquire ) )
 		{
-			myOccupiedIDs.erase(iter);
+			break;
 		}
 	}
-#endif
-	myFreeIDs.push(id);
+
+	const uint32_t index = IndexOf( head );
+	outGeneration = myGenerations[index].fetch_add( 1, std::memory_order_acq_rel ) + 1;
+	assert( ( outGeneration & 1 ) && "fetched an id that was already occupied" );
+	return IDType( index );
+}
+
+template<typename IDType>
+inline void IDKeeper<IDType>::ReturnID( const IDType& id )
+{
+	const uint32_t index = uint32_t( id );
+	if ( index >= myNumIDSlots )
+	{
+		assert( false && "attempting to return id out of range" );
+		return;
+	}
+	// only the owner flips an odd generation back to even, a failed swap means the id was already free
+	uint32_t generation = myGenerations[index].load( std::memory_order_relaxed );
+	if ( !( generation & 1 ) || !myGenerations[index].compare_exchange_strong( generation, generation + 1, std::memory_order_acq_rel ) )
+	{
+		assert( false && "attempting to return unoccupied id" );
+		return;
+	}
+
+	uint64_t head = myFreeHead.load( std::memory_order_relaxed );
+	do
+	{
+		myNextFree[index].store( IndexOf( head ), std::memory_order_relaxed );
+	}
+	while ( !myFreeHead.compare_exchange_weak( head, Pack( TagOf( head ) + 1, index ), std::memory_order_release, std::memory_order_relaxed ) );
+}
+
+template<typename IDType>
+inline uint32_t IDKeeper<IDType>::GetGeneration( const IDType& id ) const
+{
+	if ( BAD_ID( id ) || uint32_t( id ) >= myNumIDSlots )
+	{
+		return 0;
+	}
+	return myGenerations[uint32_t( id )].load( std::memory_order_acquire );
+}
+
+template<typename IDType>
+inline bool IDKeeper<IDType>::IsCurrent( const IDType& id, uint32_t generation ) const
+{
+	return ( generation & 1 ) && GetGeneration( id ) == generation;
 }
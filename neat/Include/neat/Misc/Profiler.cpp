@@ -0,0 +1,214 @@
+#include "pch.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+	// written by one thread, read by collectors
+	// sequence is odd while the slot is being written and 2 * (index + 1) once event index is in it
+	struct Slot
+	{
+		std::atomic<uint64_t>	sequence;
+		std::atomic<const char*>	name;
+		std::atomic<uint64_t>	beginNs;
+		std::atomic<uint64_t>	endNs;
+		std::atomic<uint32_t>	track;
+	};
+
+	struct Ring
+	{
+		std::unique_ptr<Slot[]>	slots;
+		std::atomic<uint64_t>	numWritten;
+		uint32_t				track;
+	};
+
+	std::mutex								gRegistryMutex;
+	std::vector<std::unique_ptr<Ring>>		gRings;
+	std::vector<std::string>				gTrackNames;
+
+	Ring&
+	GetThreadRing()
+	{
+		thread_local Ring* ring = nullptr;
+		if (!ring)
+		{
+			auto newRing = std::make_unique<Ring>();
+			newRing->slots.reset(new Slot[neat::Profiler::RingSize]());
+			newRing->numWritten.store(0, std::memory_order_relaxed);
+
+			std::lock_guard lock(gRegistryMutex);
+			newRing->track = uint32_t(gTrackNames.size());
+			gTrackNames.emplace_back("thread " + std::to_string(newRing->track));
+			ring = newRing.get();
+			gRings.emplace_back(std::move(newRing));
+		}
+		return *ring;
+	}
+
+	void
+	WriteEscaped(
+		std::ofstream&	file,
+		const char*		text)
+	{
+		for (const char* c = text; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				file << '\\' << *c;
+			}
+			else if (uint8_t(*c) >= 0x20)
+			{
+				file << *c;
+			}
+		}
+	}
+}
+
+uint64_t
+neat::Profiler::Now()
+{
+	using namespace std::chrono;
+	return uint64_t(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+void
+neat::Profiler::Record(
+	const char*	name,
+	uint64_t	beginNs,
+	uint64_t	endNs)
+{
+	Record(name, beginNs, endNs, GetThreadRing().track);
+}
+
+void
+neat::Profiler::Record(
+	const char*	name,
+	uint64_t	beginNs,
+	uint64_t	endNs,
+	uint32_t	track)
+{
+	Ring& ring = GetThreadRing();
+	const uint64_t index = ring.numWritten.load(std::memory_order_relaxed);
+	Slot& slot = ring.slots[index % RingSize];
+
+	slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.beginNs.store(beginNs, std::memory_order_relaxed);
+	slot.endNs.store(endNs, std::memory_order_relaxed);
+	slot.track.store(track, std::memory_order_relaxed);
+	slot.sequence.store(index * 2 + 2, std::memory_order_release);
+
+	ring.numWritten.store(index + 1, std::memory_order_release);
+}
+
+uint32_t
+neat::Profiler::RegisterTrack(
+	const char* name)
+{
+	std::lock_guard lock(gRegistryMutex);
+	gTrackNames.emplace_back(name);
+	return uint32_t(gTrackNames.size() - 1);
+}
+
+void
+neat::Profiler::SetThreadName(
+	const char* name)
+{
+	const uint32_t track = GetThreadRing().track;
+	std::lock_guard lock(gRegistryMutex);
+	gTrackNames[track] = name;
+}
+
+void
+neat::Profiler::Collect(
+	std::vector<ProfileEvent>&	outEvents,
+	uint64_t					sinceNs)
+{
+	std::lock_guard lock(gRegistryMutex);
+	for (auto& ring : gRings)
+	{
+		const uint64_t numWritten = ring->numWritten.load(std::memory_order_acquire);
+		const uint64_t first = numWritten > RingSize ? numWritten - RingSize : 0;
+		for (uint64_t index = first; index < numWritten; ++index)
+		{
+			const Slot& slot = ring->slots[index % RingSize];
+			const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+			ProfileEvent event;
+			event.name = slot.name.load(std::memory_order_relaxed);
+			event.beginNs = slot.beginNs.load(std::memory_order_relaxed);
+			event.endNs = slot.endNs.load(std::memory_order_relaxed);
+			event.track = slot.track.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			// the owner lapped the ring while this slot was read
+			if (sequence != index * 2 + 2 || slot.sequence.load(std::memory_order_relaxed) != sequence)
+			{
+				continue;
+			}
+			if (event.endNs >= sinceNs)
+			{
+				outEvents.emplace_back(event);
+			}
+		}
+	}
+}
+
+bool
+neat::Profiler::WriteChromeTrace(
+	const char*						path,
+	const std::vector<ProfileEvent>& events)
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	std::vector<std::string> trackNames;
+	{
+		std::lock_guard lock(gRegistryMutex);
+		trackNames = gTrackNames;
+	}
+
+	uint64_t originNs = UINT64_MAX;
+	for (auto& event : events)
+	{
+		originNs = std::min(originNs, event.beginNs);
+	}
+
+	char number[64];
+	bool isFirst = true;
+	file << "{\"traceEvents\":[\n";
+
+	// TRACK NAMES
+	for (uint32_t track = 0; track < trackNames.size(); ++track)
+	{
+		file << (isFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << track << ",\"args\":{\"name\":\"";
+		WriteEscaped(file, trackNames[track].c_str());
+		file << "\"}}";
+		isFirst = false;
+	}
+
+	// EVENTS
+	for (auto& event : events)
+	{
+		file << (isFirst ? "" : ",\n") << "{\"name\":\"";
+		WriteEscaped(file, event.name ? event.name : "unnamed");
+		snprintf(number, sizeof number, "%.3f", double(event.beginNs - originNs) / 1000.0);
+		file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.track << ",\"ts\":" << number;
+		snprintf(number, sizeof number, "%.3f", double(event.endNs > event.beginNs ? event.endNs - event.beginNs : 0) / 1000.0);
+		file << ",\"dur\":" << number << "}";
+		isFirst = false;
+	}
+
+	file << "\n]}\n";
+	return bool(file);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace neat
+{
+	struct ProfileEvent
+	{
+		// not copied, has to outlive the profiler, string literals in practice
+		const char*	name;
+		uint64_t	beginNs;
+		uint64_t	endNs;
+		uint32_t	track;
+	};
+
+	// every thread records into its own ring, the oldest events are overwritten once it wraps
+	// recording takes no locks, only a thread's first record and collecting do
+	class Profiler
+	{
+	public:
+		static constexpr uint32_t				RingSize = 8192;
+
+		// steady clock, the time base of every event
+		static uint64_t							Now();
+		static void								Record(
+													const char*	name,
+													uint64_t	beginNs,
+													uint64_t	endNs);
+		// for events timed elsewhere, like on the gpu, on a track from RegisterTrack
+		static void								Record(
+													const char*	name,
+													uint64_t	beginNs,
+													uint64_t	endNs,
+													uint32_t	track);
+		static uint32_t							RegisterTrack(const char* name);
+		// names the calling thread's track in exported traces
+		static void								SetThreadName(const char* name);
+
+		// appends the events still held by the rings that ended after sinceNs, each ring in record order
+		static void								Collect(
+													std::vector<ProfileEvent>&	outEvents,
+													uint64_t					sinceNs = 0);
+		// chrome://tracing and perfetto json, one row per track
+		static bool								WriteChromeTrace(
+													const char*						path,
+													const std::vector<ProfileEvent>& events);
+	};
+
+	class ProfileZone
+	{
+	public:
+												ProfileZone(const char* name)
+													: myName(name)
+													, myBeginNs(Profiler::Now())
+												{
+												}
+												~ProfileZone()
+												{
+													Profiler::Record(myName, myBeginNs, Profiler::Now());
+												}
+
+												ProfileZone(const ProfileZone&) = delete;
+												ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		const char*								myName;
+		uint64_t								myBeginNs;
+
+	};
+}
+
+#define NEAT_PROFILE_CONCAT_INNER(a, b) a##b
+#define NEAT_PROFILE_CONCAT(a, b) NEAT_PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) neat::ProfileZone NEAT_PROFILE_CONCAT(profileZone, __COUNTER__)(name)
@@ -6,7 +6,7 @@
 #define NOMINMAX
 #define _CRT_SECURE_NO_WARNINGS
 
-#include <windows.h>
+#include "neat/General/Platform.h"
 
 // STL
 #include <functional>